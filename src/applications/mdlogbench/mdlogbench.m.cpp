@@ -0,0 +1,528 @@
+// mdlogbench.m.cpp                                                     -*-c++-*-
+
+// Trace statements are compiled out, see the 'disabled' scenario.
+#define MDLOG_COMPILE_LEVEL 4
+
+#include <mdlog_binarylogger.h>
+#include <mdlog_category.h>
+#include <mdlog_fileobserver.h>
+#include <mdlog_logger.h>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace MvdS;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+MDLOG_SET_CATEGORY("mdlogbench");
+
+const char k_name[] = "order";
+
+// ==============
+// Struct Options
+// ==============
+
+struct Options
+{
+  // Command line options of the benchmark.
+
+  size_t      d_iterations = 200000; // Statements per thread.
+  size_t      d_sampleRate = 16;
+  size_t      d_threads    = std::max(1u, std::thread::hardware_concurrency());
+  size_t      d_sinkRate   = 16; // MiB/s of the slow sink.
+  std::string d_backend;
+  std::string d_scenario;
+  std::string d_output = "/dev/null";
+};
+
+// =====================
+// Class LatencyRecorder
+// =====================
+
+class LatencyRecorder
+{
+  // Collects latency samples in nanoseconds and reports percentiles.
+
+  std::vector<uint64_t> d_samples;
+
+public:
+  explicit LatencyRecorder(size_t capacity) { d_samples.reserve(capacity); }
+
+  void record(Clock::duration duration)
+  {
+    if (d_samples.size() < d_samples.capacity()) {
+      d_samples.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+              .count());
+    }
+  }
+
+  void append(const LatencyRecorder &other)
+  {
+    d_samples.insert(
+        d_samples.end(), other.d_samples.begin(), other.d_samples.end());
+  }
+
+  void finalize() { std::sort(d_samples.begin(), d_samples.end()); }
+
+  uint64_t percentile(double p) const
+  // Return the specified 'p'th percentile. Behavior is undefined unless
+  // 'finalize' was called after the last 'record'.
+  {
+    if (d_samples.empty()) {
+      return 0;
+    }
+    size_t index = static_cast<size_t>(p / 100.0 * (d_samples.size() - 1));
+    return d_samples[index];
+  }
+
+  uint64_t maximum() const
+  {
+    return d_samples.empty() ? 0 : d_samples.back();
+  }
+};
+
+// =============
+// Struct Result
+// =============
+
+struct Result
+{
+  double          d_opsPerSecond = 0;
+  LatencyRecorder d_latency;
+  double          d_flushMs = 0; // Time to deliver after the last statement.
+  uint64_t        d_dropped = 0;
+
+  Result()
+      : d_latency(0)
+  {}
+};
+
+// =============
+// Class Backend
+// =============
+
+class Backend
+{
+  // A logging backend under test, delivering to a sink file descriptor.
+
+public:
+  virtual ~Backend() {}
+
+  virtual void log(size_t i) = 0;
+  // Log one statement with the specified 'i' as argument.
+
+  virtual void flush() = 0;
+  // Block until all statements have been written to the sink.
+
+  virtual uint64_t dropped() const { return 0; }
+};
+
+class StreamBackend : public Backend
+{
+  // 'MDLOG_INFO' style statements, formatted on the calling thread.
+
+  mdlog::FileObserver d_observer;
+  mdlog::Logger       d_logger;
+
+public:
+  explicit StreamBackend(int fd)
+      : d_observer(fd)
+  {
+    d_logger.addObserver(&d_observer);
+    d_logger.start();
+  }
+
+  virtual void log(size_t i)
+  {
+    if (MDLOG_IS_ENABLED(mdlog::Level::e_info)) {
+      mdlog::RecordStream(mdlog::Level::e_info,
+                          __mdlog_logger_category.name(),
+                          &d_logger)
+              .stream()
+          << "value " << i << " of " << k_name << " ratio " << 0.5 * i;
+    }
+  }
+
+  virtual void flush() { d_logger.flush(); }
+};
+
+class BinaryBackend : public Backend
+{
+  // 'MDLOG_BINARY_INFO' style statements, formatted by the background
+  // thread, or written in binary if 'raw'.
+
+  mdlog::FileObserver d_observer;
+  mdlog::Logger       d_logger;
+  mdlog::BinaryLogger d_binary;
+
+  static mdlog::BinaryLogger::Configuration configuration(int  fd,
+                                                          bool raw,
+                                                          bool drop)
+  {
+    mdlog::BinaryLogger::Configuration config;
+    config.d_fd           = raw ? fd : -1;
+    config.d_dropWhenFull = drop;
+    return config;
+  }
+
+public:
+  BinaryBackend(int fd, bool raw, bool drop)
+      : d_observer(fd)
+      , d_binary(&d_logger, configuration(fd, raw, drop))
+  {
+    d_logger.addObserver(&d_observer);
+    d_logger.start();
+    d_binary.start();
+  }
+
+  virtual void log(size_t i)
+  {
+    if (MDLOG_IS_ENABLED(mdlog::Level::e_info)) {
+      static mdlog::BinaryLogSite site(
+          mdlog::Level::e_info,
+          &__mdlog_logger_category,
+          "value {} of {} ratio {}",
+          __FILE__,
+          __LINE__,
+          mdlog::BinaryLogTypes<size_t, const char *, double>());
+      d_binary.log(&site, i, k_name, 0.5 * i);
+    }
+  }
+
+  virtual void flush() { d_binary.flush(); }
+
+  virtual uint64_t dropped() const { return d_binary.droppedCount(); }
+};
+
+typedef std::function<std::unique_ptr<Backend>(int fd)> BackendFactory;
+
+// ==============
+// Class SlowSink
+// ==============
+
+class SlowSink
+{
+  // A pipe whose reader consumes at a limited rate, modelling a slow disk.
+
+  int         d_fds[2];
+  std::thread d_reader;
+
+public:
+  explicit SlowSink(size_t bytesPerSecond)
+  {
+    if (0 != pipe(d_fds)) {
+      std::perror("pipe");
+      std::exit(1);
+    }
+
+    d_reader = std::thread([this, bytesPerSecond]() {
+      std::vector<char> buffer(64 << 10);
+      const auto        pause = std::chrono::duration<double>(
+          double(buffer.size()) / bytesPerSecond);
+      while (0 < ::read(d_fds[0], buffer.data(), buffer.size())) {
+        std::this_thread::sleep_for(pause);
+      }
+    });
+  }
+
+  ~SlowSink()
+  {
+    ::close(d_fds[1]);
+    d_reader.join();
+    ::close(d_fds[0]);
+  }
+
+  int fd() const { return d_fds[1]; }
+};
+
+size_t peakRssKb()
+// Return the peak resident set size in KiB.
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+double opsPerSecond(size_t operations, Clock::duration elapsed)
+{
+  return operations / std::chrono::duration<double>(elapsed).count();
+}
+
+void runThreads(Result *       result,
+                Backend *      backend,
+                size_t         threads,
+                bool           includeFlush,
+                const Options &opt)
+// Log 'd_iterations' statements on each of the specified number of
+// 'threads', sampling the latency of the calls. The rate includes the time
+// to deliver everything if the specified 'includeFlush' is true.
+{
+  std::vector<LatencyRecorder> latencies;
+  std::vector<std::thread>     workers;
+  for (size_t t = 0; t < threads; ++t) {
+    // Not copied, a copy would not keep the reserved capacity.
+    latencies.emplace_back(opt.d_iterations / opt.d_sampleRate + 1);
+  }
+
+  const auto start = Clock::now();
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      LatencyRecorder &latency = latencies[t];
+      for (size_t i = 0; i < opt.d_iterations; ++i) {
+        if (0 == i % opt.d_sampleRate) {
+          const auto t0 = Clock::now();
+          backend->log(i);
+          latency.record(Clock::now() - t0);
+        } else {
+          backend->log(i);
+        }
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  const auto logged = Clock::now();
+  backend->flush();
+  const auto flushed = Clock::now();
+
+  result->d_opsPerSecond = opsPerSecond(threads * opt.d_iterations,
+                                        (includeFlush ? flushed : logged) -
+                                            start);
+  result->d_flushMs =
+      std::chrono::duration<double, std::milli>(flushed - logged).count();
+  result->d_dropped = backend->dropped();
+
+  for (const auto &latency : latencies) {
+    result->d_latency.append(latency);
+  }
+  result->d_latency.finalize();
+}
+
+void report(const char *  scenario,
+            const char *  backend,
+            size_t        threads,
+            size_t        statements,
+            const Result &r)
+// Print the specified result as a CSV line.
+{
+  std::printf("%s,%s,%zu,%zu,%.0f,%lu,%lu,%lu,%lu,%lu,%.3f,%lu,%zu\n",
+              scenario,
+              backend,
+              threads,
+              statements,
+              r.d_opsPerSecond,
+              r.d_latency.percentile(50),
+              r.d_latency.percentile(90),
+              r.d_latency.percentile(99),
+              r.d_latency.percentile(99.9),
+              r.d_latency.maximum(),
+              r.d_flushMs,
+              r.d_dropped,
+              peakRssKb());
+  std::fflush(stdout);
+}
+
+// ---------
+// Scenarios
+// ---------
+
+void runLatency(const std::string &   name,
+                const BackendFactory &factory,
+                int                   fd,
+                const Options &       opt)
+// Latency of the calls on a single thread, and the rate of the calls alone.
+{
+  Result r;
+  {
+    std::unique_ptr<Backend> backend = factory(fd);
+    runThreads(&r, backend.get(), 1, false, opt);
+  }
+  report("latency", name.c_str(), 1, opt.d_iterations, r);
+}
+
+void runThroughput(const std::string &   name,
+                   const BackendFactory &factory,
+                   int                   fd,
+                   const Options &       opt)
+// Sustained rate, including delivery to the sink, for 1, 2, 4 ... threads
+// up to 'd_threads'.
+{
+  for (size_t threads = 1;; threads = std::min(2 * threads, opt.d_threads)) {
+    Result r;
+    {
+      std::unique_ptr<Backend> backend = factory(fd);
+      runThreads(&r, backend.get(), threads, true, opt);
+    }
+    report("throughput", name.c_str(), threads, threads * opt.d_iterations, r);
+
+    if (threads == opt.d_threads) {
+      break;
+    }
+  }
+}
+
+void runSlowSink(const std::string &   name,
+                 const BackendFactory &factory,
+                 int,
+                 const Options &       opt)
+// Single thread logging to a sink slower than the statements: the calls
+// block, the statements are dropped, or memory grows and the delivery takes
+// long.
+{
+  Result r;
+  {
+    SlowSink                 sink(opt.d_sinkRate << 20);
+    std::unique_ptr<Backend> backend = factory(sink.fd());
+    runThreads(&r, backend.get(), 1, false, opt);
+  }
+  report("slowsink", name.c_str(), 1, opt.d_iterations, r);
+}
+
+void runDisabled(const Options &opt)
+// Cost of statements that are disabled for their category at runtime, or
+// compiled out. These are the macros themselves, no backend is involved.
+{
+  mdlog::Category::setThreshold("mdlogbench", mdlog::Level::e_info);
+
+  const std::vector<std::pair<const char *, std::function<void(size_t)>>>
+      statements = {
+          {"stream-disabled",
+           [](size_t i) {
+             MDLOG_DEBUG << "value " << i << " of " << k_name;
+           }},
+          {"binary-disabled",
+           [](size_t i) {
+             MDLOG_BINARY_DEBUG("value {} of {}", i, k_name);
+           }},
+          {"compiled-out",
+           [](size_t i) {
+             MDLOG_TRACE << "value " << i << " of " << k_name;
+           }},
+      };
+
+  // Many iterations inside one call, so the 'std::function' call does not
+  // dominate.
+  const size_t k_inner = 64;
+
+  for (const auto &statement : statements) {
+    Result     r;
+    const auto start = Clock::now();
+    for (size_t i = 0; i < opt.d_iterations; i += k_inner) {
+      for (size_t j = i; j < i + k_inner; ++j) {
+        statement.second(j);
+      }
+    }
+    r.d_opsPerSecond = opsPerSecond(opt.d_iterations, Clock::now() - start);
+    report("disabled", statement.first, 1, opt.d_iterations, r);
+  }
+}
+
+typedef void (*Scenario)(const std::string &,
+                         const BackendFactory &,
+                         int,
+                         const Options &);
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  Options opt;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if ("-n" == arg && i + 1 < argc) {
+      opt.d_iterations = std::strtoull(argv[++i], nullptr, 10);
+    } else if ("-t" == arg && i + 1 < argc) {
+      opt.d_threads = std::max(1ull, std::strtoull(argv[++i], nullptr, 10));
+    } else if ("-b" == arg && i + 1 < argc) {
+      opt.d_backend = argv[++i];
+    } else if ("-s" == arg && i + 1 < argc) {
+      opt.d_scenario = argv[++i];
+    } else if ("-o" == arg && i + 1 < argc) {
+      opt.d_output = argv[++i];
+    } else if ("-r" == arg && i + 1 < argc) {
+      opt.d_sinkRate = std::max(1ull, std::strtoull(argv[++i], nullptr, 10));
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [-n statements] [-t threads] [-b backend] [-s scenario]"
+                   " [-o sink] [-r slow sink MiB/s]\n";
+      return 1;
+    }
+  }
+  opt.d_sampleRate = std::max<size_t>(1, opt.d_sampleRate);
+
+  const int fd =
+      ::open(opt.d_output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    std::perror(opt.d_output.c_str());
+    return 1;
+  }
+
+  const std::vector<std::pair<std::string, BackendFactory>> backends = {
+      {"stream",
+       [](int fd) { return std::unique_ptr<Backend>(new StreamBackend(fd)); }},
+      {"binary",
+       [](int fd) {
+         return std::unique_ptr<Backend>(new BinaryBackend(fd, false, false));
+       }},
+      {"binaryraw",
+       [](int fd) {
+         return std::unique_ptr<Backend>(new BinaryBackend(fd, true, false));
+       }},
+      {"binaryraw-drop",
+       [](int fd) {
+         return std::unique_ptr<Backend>(new BinaryBackend(fd, true, true));
+       }},
+  };
+
+  const std::vector<std::pair<std::string, Scenario>> scenarios = {
+      {"latency", &runLatency},
+      {"throughput", &runThroughput},
+      {"slowsink", &runSlowSink},
+  };
+
+  // Note that the peak resident memory is a process wide measure: run a
+  // single backend per process ('-b') for numbers that can be compared.
+  std::printf("scenario,backend,threads,statements,ops_per_s,p50_ns,p90_ns,"
+              "p99_ns,p999_ns,max_ns,flush_ms,dropped,peak_rss_kib\n");
+
+  for (const auto &scenario : scenarios) {
+    if (!opt.d_scenario.empty() && opt.d_scenario != scenario.first) {
+      continue;
+    }
+
+    for (const auto &backend : backends) {
+      if (!opt.d_backend.empty() && opt.d_backend != backend.first) {
+        continue;
+      }
+
+      scenario.second(backend.first, backend.second, fd, opt);
+    }
+  }
+
+  if (opt.d_scenario.empty() || "disabled" == opt.d_scenario) {
+    runDisabled(opt);
+  }
+
+  ::close(fd);
+  return 0;
+}
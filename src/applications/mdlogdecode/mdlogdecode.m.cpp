@@ -0,0 +1,100 @@
+// mdlogdecode.m.cpp                                                    -*-c++-*-
+#include <mdlog_binarylog.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace MvdS;
+
+namespace {
+
+// ==============
+// Struct Options
+// ==============
+
+struct Options
+{
+  // Command line options of the decoder.
+
+  std::string d_path; // Standard input if empty.
+  bool        d_printTime = false;
+};
+
+int decode(int fd, const Options &opt)
+// Print the entries of the binary log read from the specified 'fd' as text
+// to standard output. Return 0 on success or a negative 'errno' value.
+{
+  mdlog::BinaryLogDecoder decoder(opt.d_printTime);
+
+  std::vector<char> buffer(1 << 20);
+  size_t            size = 0;
+
+  while (true) {
+    if (size == buffer.size()) {
+      buffer.resize(2 * buffer.size()); // An entry larger than the buffer.
+    }
+
+    const ssize_t rc = ::read(fd, buffer.data() + size, buffer.size() - size);
+    if (rc < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      return -errno;
+    }
+    if (0 == rc) {
+      break;
+    }
+    size += rc;
+
+    const size_t used = decoder.decode(buffer.data(), size, std::cout);
+    memmove(buffer.data(), buffer.data() + used, size - used);
+    size -= used;
+  }
+
+  std::cout.flush();
+  if (size) {
+    std::cerr << "Truncated entry of " << size << " bytes at the end\n";
+  }
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  Options opt;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if ("-t" == arg) {
+      opt.d_printTime = true;
+    } else if ('-' != arg[0] && opt.d_path.empty()) {
+      opt.d_path = arg;
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [-t] [file]\n"
+                << "Print a binary log written by mdlog::BinaryLogger as "
+                   "text, with -t prefixed by the time.\n";
+      return 1;
+    }
+  }
+
+  int fd = STDIN_FILENO;
+  if (!opt.d_path.empty() && 0 > (fd = ::open(opt.d_path.c_str(), O_RDONLY))) {
+    std::cerr << opt.d_path << ": " << strerror(errno) << '\n';
+    return 1;
+  }
+
+  const int rc = decode(fd, opt);
+  if (0 != rc) {
+    std::cerr << "Read failed: " << strerror(-rc) << '\n';
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,442 @@
+// mdmembench.m.cpp                                                     -*-c++-*-
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+#include <mdmem_fixedbufferpoolallocator.h>
+#include <mdmem_threadcachingallocator.h>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace MvdS;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// ==============
+// Struct Options
+// ==============
+
+struct Options
+{
+  // Command line options of the benchmark.
+
+  size_t      d_iterations = 1000000;
+  size_t      d_sampleRate = 64;
+  std::string d_resource;
+  std::string d_scenario;
+  bool        d_verbose = false;
+};
+
+// ===============
+// Struct Resource
+// ===============
+
+struct Resource
+{
+  // Holds an allocator under test, optionally owning it.
+
+  std::unique_ptr<mdmem::Allocator> d_owned;
+  mdmem::Allocator *                d_allocator_p = nullptr;
+};
+
+typedef std::function<Resource()> ResourceFactory;
+
+enum
+{
+  k_fixedSize     = 64,   // Allocation size for fixed size scenarios.
+  k_fixedPoolSize = 4096, // Number of buffers kept by the fixed pool.
+  k_liveSetSize   = 4096, // Number of live allocations in 'mixed'.
+  k_ringSize      = 1024  // Capacity of the cross thread hand-off ring.
+};
+
+// =====================
+// Class LatencyRecorder
+// =====================
+
+class LatencyRecorder
+{
+  // Collects latency samples in nanoseconds and reports percentiles.
+
+  std::vector<uint64_t> d_samples;
+
+public:
+  explicit LatencyRecorder(size_t capacity) { d_samples.reserve(capacity); }
+
+  void record(Clock::duration duration)
+  {
+    if (d_samples.size() < d_samples.capacity()) {
+      d_samples.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+              .count());
+    }
+  }
+
+  void finalize() { std::sort(d_samples.begin(), d_samples.end()); }
+
+  uint64_t percentile(double p) const
+  // Return the specified 'p'th percentile. Behavior is undefined unless
+  // 'finalize' was called after the last 'record'.
+  {
+    if (d_samples.empty()) {
+      return 0;
+    }
+    size_t index = static_cast<size_t>(p / 100.0 * (d_samples.size() - 1));
+    return d_samples[index];
+  }
+
+  uint64_t maximum() const
+  {
+    return d_samples.empty() ? 0 : d_samples.back();
+  }
+};
+
+// =============
+// Struct Result
+// =============
+
+struct Result
+{
+  double          d_opsPerSecond = 0;
+  LatencyRecorder d_latency;
+  size_t          d_rssKb = 0;
+
+  explicit Result(size_t samples)
+      : d_latency(samples)
+  {}
+};
+
+size_t currentRssKb()
+// Return the current resident set size in KiB.
+{
+  FILE *file = fopen("/proc/self/statm", "r");
+  if (!file) {
+    return 0;
+  }
+  unsigned long size = 0, resident = 0;
+  if (2 != fscanf(file, "%lu %lu", &size, &resident)) {
+    resident = 0;
+  }
+  fclose(file);
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+size_t peakRssKb()
+// Return the peak resident set size in KiB.
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+double opsPerSecond(size_t operations, Clock::duration elapsed)
+{
+  return operations / std::chrono::duration<double>(elapsed).count();
+}
+
+std::vector<size_t> mixedSizes(size_t count, uint64_t seed)
+// Return the specified 'count' allocation sizes drawn from a distribution
+// that resembles a message processing workload: mostly small objects, some
+// medium sized buffers and a few large ones.
+{
+  std::mt19937_64                       rng(seed);
+  std::discrete_distribution<int>       bucket({70, 25, 5});
+  std::uniform_int_distribution<size_t> small(16, 128);
+  std::uniform_int_distribution<size_t> medium(129, 4096);
+  std::uniform_int_distribution<size_t> large(4097, 65536);
+
+  std::vector<size_t> result(count);
+  for (auto &size : result) {
+    switch (bucket(rng)) {
+    case 0: size = small(rng); break;
+    case 1: size = medium(rng); break;
+    default: size = large(rng); break;
+    }
+  }
+  return result;
+}
+
+// ---------
+// Scenarios
+// ---------
+
+void runSingle(Result *result, mdmem::Allocator *allocator, const Options &opt)
+// Allocate and immediately free fixed size blocks on one thread.
+{
+  const auto start = Clock::now();
+  for (size_t i = 0; i < opt.d_iterations; ++i) {
+    if (0 == i % opt.d_sampleRate) {
+      const auto t0 = Clock::now();
+      char *     p  = static_cast<char *>(allocator->allocate(k_fixedSize));
+      p[0]          = 1;
+      allocator->deallocate(p, k_fixedSize);
+      result->d_latency.record(Clock::now() - t0);
+    } else {
+      char *p = static_cast<char *>(allocator->allocate(k_fixedSize));
+      p[0]    = 1;
+      allocator->deallocate(p, k_fixedSize);
+    }
+  }
+  result->d_opsPerSecond = opsPerSecond(opt.d_iterations, Clock::now() - start);
+}
+
+void runCrossThread(Result *          result,
+                    mdmem::Allocator *allocator,
+                    const Options &   opt)
+// Allocate fixed size blocks on one thread and free them on another, handing
+// them over through a single producer/single consumer ring.
+{
+  std::vector<std::atomic<void *>> ring(k_ringSize);
+  for (auto &slot : ring) {
+    slot.store(nullptr, std::memory_order_relaxed);
+  }
+
+  std::thread consumer([&]() {
+    size_t index = 0;
+    for (size_t i = 0; i < opt.d_iterations; ++i) {
+      std::atomic<void *> &slot = ring[index];
+      void *               p;
+      while (nullptr == (p = slot.load(std::memory_order_acquire))) {
+        std::this_thread::yield();
+      }
+      slot.store(nullptr, std::memory_order_relaxed);
+      allocator->deallocate(p, k_fixedSize);
+      index = (index + 1) % k_ringSize;
+    }
+  });
+
+  const auto start = Clock::now();
+  size_t     index = 0;
+  for (size_t i = 0; i < opt.d_iterations; ++i) {
+    std::atomic<void *> &slot = ring[index];
+    while (nullptr != slot.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+
+    void *p;
+    if (0 == i % opt.d_sampleRate) {
+      const auto t0 = Clock::now();
+      p             = allocator->allocate(k_fixedSize);
+      result->d_latency.record(Clock::now() - t0);
+    } else {
+      p = allocator->allocate(k_fixedSize);
+    }
+    static_cast<char *>(p)[0] = 1;
+    slot.store(p, std::memory_order_release);
+    index = (index + 1) % k_ringSize;
+  }
+  consumer.join();
+  result->d_opsPerSecond = opsPerSecond(opt.d_iterations, Clock::now() - start);
+}
+
+void runMixed(Result *result, mdmem::Allocator *allocator, const Options &opt)
+// Keep a live set of allocations with mixed sizes and randomly replace
+// members of the set.
+{
+  const std::vector<size_t> sizes = mixedSizes(opt.d_iterations, 1);
+  std::vector<size_t>       victims(opt.d_iterations);
+  {
+    std::mt19937_64                       rng(2);
+    std::uniform_int_distribution<size_t> pick(0, k_liveSetSize - 1);
+    for (auto &victim : victims) {
+      victim = pick(rng);
+    }
+  }
+
+  std::vector<std::pair<void *, size_t>> live(k_liveSetSize, {nullptr, 0});
+
+  const auto start = Clock::now();
+  for (size_t i = 0; i < opt.d_iterations; ++i) {
+    auto &      slot   = live[victims[i]];
+    const bool  sample = 0 == i % opt.d_sampleRate;
+    const auto  t0     = sample ? Clock::now() : Clock::time_point();
+    if (slot.first) {
+      allocator->deallocate(slot.first, slot.second);
+    }
+    slot.first                         = allocator->allocate(sizes[i]);
+    slot.second                        = sizes[i];
+    static_cast<char *>(slot.first)[0] = 1;
+    if (sample) {
+      result->d_latency.record(Clock::now() - t0);
+    }
+  }
+  const auto elapsed = Clock::now() - start;
+
+  for (auto &slot : live) {
+    if (slot.first) {
+      allocator->deallocate(slot.first, slot.second);
+    }
+  }
+  result->d_opsPerSecond = opsPerSecond(opt.d_iterations, elapsed);
+}
+
+void runFragmentation(Result *          result,
+                      mdmem::Allocator *allocator,
+                      const Options &   opt)
+// Repeatedly allocate a generation of mixed size blocks, free a random half
+// of everything that is live and report how resident memory evolves.
+{
+  const size_t rounds     = 16;
+  const size_t generation = std::max<size_t>(opt.d_iterations / rounds, 1);
+  const std::vector<size_t> sizes = mixedSizes(generation * rounds, 3);
+  std::mt19937_64           rng(4);
+
+  std::vector<std::pair<void *, size_t>> live;
+  live.reserve(generation * rounds);
+
+  size_t     operations = 0;
+  const auto start      = Clock::now();
+  for (size_t round = 0; round < rounds; ++round) {
+    for (size_t i = 0; i < generation; ++i) {
+      const size_t size   = sizes[round * generation + i];
+      const bool   sample = 0 == operations % opt.d_sampleRate;
+      const auto   t0     = sample ? Clock::now() : Clock::time_point();
+      void *       p      = allocator->allocate(size);
+      if (sample) {
+        result->d_latency.record(Clock::now() - t0);
+      }
+      static_cast<char *>(p)[0] = 1;
+      live.emplace_back(p, size);
+      ++operations;
+    }
+
+    std::shuffle(live.begin(), live.end(), rng);
+    const size_t keep = live.size() / 2;
+    for (size_t i = keep; i < live.size(); ++i) {
+      allocator->deallocate(live[i].first, live[i].second);
+      ++operations;
+    }
+    live.resize(keep);
+
+    if (opt.d_verbose) {
+      std::cout << "#   round " << round << ": live = " << live.size()
+                << ", rss = " << currentRssKb() << " KiB\n";
+    }
+  }
+  const auto elapsed = Clock::now() - start;
+
+  for (auto &block : live) {
+    allocator->deallocate(block.first, block.second);
+  }
+  result->d_opsPerSecond = opsPerSecond(operations, elapsed);
+}
+
+typedef void (*Scenario)(Result *, mdmem::Allocator *, const Options &);
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  Options opt;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if ("-n" == arg && i + 1 < argc) {
+      opt.d_iterations = std::strtoull(argv[++i], nullptr, 10);
+    } else if ("-r" == arg && i + 1 < argc) {
+      opt.d_resource = argv[++i];
+    } else if ("-s" == arg && i + 1 < argc) {
+      opt.d_scenario = argv[++i];
+    } else if ("-v" == arg) {
+      opt.d_verbose = true;
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [-n iterations] [-r resource] [-s scenario] [-v]\n";
+      return 1;
+    }
+  }
+
+  const std::vector<std::pair<std::string, ResourceFactory>> resources = {
+      {"default",
+       []() {
+         Resource r;
+         r.d_allocator_p = mdmem::AllocatorUtil::defaultAllocator();
+         return r;
+       }},
+      {"fixedpool",
+       []() {
+         Resource r;
+         r.d_owned.reset(
+             new mdmem::FixedBufferPoolAllocator(k_fixedPoolSize, k_fixedSize));
+         r.d_allocator_p = r.d_owned.get();
+         return r;
+       }},
+      {"threadcaching",
+       []() {
+         Resource r;
+         r.d_owned.reset(new mdmem::ThreadCachingAllocator());
+         r.d_allocator_p = r.d_owned.get();
+         return r;
+       }},
+  };
+
+  const std::vector<std::pair<std::string, Scenario>> scenarios = {
+      {"single", &runSingle},
+      {"crossthread", &runCrossThread},
+      {"mixed", &runMixed},
+      {"fragmentation", &runFragmentation},
+  };
+
+  // Note that resident memory is a process wide measure: run a single
+  // resource per process ('-r') for RSS numbers that can be compared.
+  std::printf("%-14s %-14s %14s %8s %8s %8s %8s %10s %10s %10s\n",
+              "resource",
+              "scenario",
+              "ops/s",
+              "p50(ns)",
+              "p90(ns)",
+              "p99(ns)",
+              "p999(ns)",
+              "max(ns)",
+              "rss(KiB)",
+              "peak(KiB)");
+
+  for (const auto &resource : resources) {
+    if (!opt.d_resource.empty() && opt.d_resource != resource.first) {
+      continue;
+    }
+
+    for (const auto &scenario : scenarios) {
+      if (!opt.d_scenario.empty() && opt.d_scenario != scenario.first) {
+        continue;
+      }
+
+      Result r(opt.d_iterations / opt.d_sampleRate + 1);
+      {
+        Resource res = resource.second();
+        scenario.second(&r, res.d_allocator_p, opt);
+        r.d_rssKb = currentRssKb();
+      }
+      r.d_latency.finalize();
+
+      std::printf("%-14s %-14s %14.0f %8lu %8lu %8lu %8lu %10lu %10lu %10lu\n",
+                  resource.first.c_str(),
+                  scenario.first.c_str(),
+                  r.d_opsPerSecond,
+                  r.d_latency.percentile(50),
+                  r.d_latency.percentile(90),
+                  r.d_latency.percentile(99),
+                  r.d_latency.percentile(99.9),
+                  r.d_latency.maximum(),
+                  r.d_rssKb,
+                  peakRssKb());
+      std::fflush(stdout);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,137 @@
+// mdio_binarycodec.cpp                                                 -*-c++-*-
+#include <mdio_binarycodec.h>
+
+#include <sys/uio.h>
+
+namespace MvdS {
+namespace mdio {
+
+// ------------------
+// Class BinaryWriter
+// ------------------
+
+// PRIVATE MANIPULATORS
+
+void BinaryWriter::nextWindow(size_t size)
+{
+  flush();
+
+  size_t available;
+  char * buffer = d_vector_p->writableBuffer(&available);
+  if (size <= available) {
+    d_begin = buffer;
+    d_limit = buffer + available;
+  } else {
+    // The value would span buffers, so stage it.
+    d_begin = d_staging;
+    d_limit = d_staging + k_maximumReserveSize;
+  }
+  d_cursor = d_begin;
+}
+
+// MANIPULATORS
+
+void BinaryWriter::writeRaw(const char *data, size_t size)
+{
+  if (size <= static_cast<size_t>(d_limit - d_cursor)) {
+    putRaw(data, size);
+    return;
+  }
+
+  flush();
+  d_vector_p->append(data, size);
+  d_begin = d_cursor = d_limit = nullptr;
+}
+
+void BinaryWriter::flush()
+{
+  const size_t size = d_cursor - d_begin;
+  if (d_staging == d_begin) {
+    d_vector_p->append(d_staging, size);
+
+    // Continue in the tail buffer.
+    d_begin = d_cursor = d_limit = nullptr;
+  } else {
+    d_vector_p->commit(size);
+    d_begin = d_cursor;
+  }
+}
+
+// ------------------
+// Class BinaryReader
+// ------------------
+
+// PRIVATE MANIPULATORS
+
+bool BinaryReader::nextWindow(size_t size)
+{
+  if (!d_vector_p) {
+    return false;
+  }
+
+  sync();
+
+  iovec iov;
+  if (0 == d_vector_p->iovecs(&iov, 1)) {
+    d_begin = d_cursor = d_end = nullptr;
+    return 0 == size;
+  }
+
+  if (size <= iov.iov_len || d_vector_p->size() == iov.iov_len) {
+    d_begin = static_cast<const char *>(iov.iov_base);
+    d_end   = d_begin + iov.iov_len;
+  } else {
+    // The value spans buffers, so stage a copy of the front.
+    d_begin = d_staging;
+    d_end   = d_staging + d_vector_p->copyOut(d_staging, k_maximumEnsureSize);
+  }
+  d_cursor = d_begin;
+
+  return size <= static_cast<size_t>(d_end - d_cursor);
+}
+
+// MANIPULATORS
+
+bool BinaryReader::readRaw(char *data, size_t size)
+{
+  if (remaining() < size) {
+    return false;
+  }
+
+  while (0 < size) {
+    if (d_cursor == d_end) {
+      nextWindow(1);
+    }
+
+    const size_t available = d_end - d_cursor;
+    const size_t count     = size < available ? size : available;
+    memcpy(data, d_cursor, count);
+
+    d_cursor += count;
+    data += count;
+    size -= count;
+  }
+  return true;
+}
+
+bool BinaryReader::readBytes(std::string *value)
+{
+  uint64_t size;
+  if (!readVarint(&size) || remaining() < size) {
+    return false;
+  }
+
+  value->resize(size);
+  return readRaw(&(*value)[0], size);
+}
+
+void BinaryReader::sync()
+{
+  if (d_vector_p) {
+    d_vector_p->consume(d_cursor - d_begin);
+    d_begin = d_cursor;
+  }
+}
+
+} // namespace mdio
+} // namespace MvdS
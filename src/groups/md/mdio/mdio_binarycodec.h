@@ -0,0 +1,625 @@
+// mdio_binarycodec.h                                                   -*-c++-*-
+#ifndef __INCLUDED_MDIO_BINARYCODEC
+#define __INCLUDED_MDIO_BINARYCODEC
+
+#include <mdio_buffer.h>
+#include <mdio_buffervector.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace MvdS {
+namespace mdio {
+
+// ==================
+// Class BinaryWriter
+// ==================
+
+class BinaryWriter
+{
+  // Provides encoding of integers, floating point numbers and byte strings
+  // into a 'BufferVector'.
+  //
+  // Values are written through a window of contiguous memory, normally the
+  // free space of the tail buffer of the vector. The 'put' functions write
+  // without any bounds check and must be preceded by a 'reserve' covering
+  // all of them; a struct of fixed fields is thereby encoded with a single
+  // check, see 'BinaryCodec'. The 'write' functions reserve on their own.
+  // Reservations that do not fit the tail buffer are staged in an internal
+  // buffer. Written bytes are committed to the vector by 'flush' and on
+  // destruction.
+  //
+  // Encodings: varints store 7 bits per byte, least significant group first,
+  // with the high bit set on all but the last byte. Zigzag maps signed
+  // integers of small magnitude to small varints. Fixed values are stored in
+  // little-endian byte order. Byte strings are prefixed with their length as
+  // a varint.
+
+public:
+  // PUBLIC CONSTANTS
+
+  enum
+  {
+    k_maximumVarintSize  = 10, // Encoded size of a 64 bit varint.
+    k_maximumReserveSize = 256 // Largest size that can be reserved.
+  };
+
+private:
+  // DATA
+
+  BufferVector *d_vector_p;
+  char *        d_begin;  // Start of the window.
+  char *        d_cursor; // Next byte to write.
+  char *        d_limit;  // End of the window.
+  char          d_staging[k_maximumReserveSize];
+
+  // PRIVATE MANIPULATORS
+
+  void nextWindow(size_t size);
+  // Flush and make room for at least the specified 'size' contiguous bytes.
+
+public:
+  BinaryWriter(const BinaryWriter &) = delete;
+  BinaryWriter &operator=(const BinaryWriter &) = delete;
+
+  // CREATORS
+
+  explicit BinaryWriter(BufferVector *vector)
+      // Create a writer that appends to the specified 'vector'.
+      : d_vector_p(vector)
+      , d_begin(nullptr)
+      , d_cursor(nullptr)
+      , d_limit(nullptr)
+  {}
+
+  ~BinaryWriter() { flush(); }
+  // Flush the written bytes.
+
+  // MANIPULATORS
+
+  void reserve(size_t size)
+  // Make sure the specified 'size' bytes can be written with the 'put'
+  // functions. Behavior is undefined unless
+  // 'size <= k_maximumReserveSize'.
+  {
+    if (static_cast<size_t>(d_limit - d_cursor) < size) {
+      nextWindow(size);
+    }
+  }
+
+  void putVarint(uint64_t value)
+  // Write the specified 'value' as varint without bounds check.
+  {
+    while (0x80 <= value) {
+      *d_cursor++ = static_cast<char>(value | 0x80);
+      value >>= 7;
+    }
+    *d_cursor++ = static_cast<char>(value);
+  }
+
+  void putZigZag(int64_t value)
+  // Write the specified 'value' zigzag encoded without bounds check.
+  {
+    putVarint((static_cast<uint64_t>(value) << 1) ^
+              static_cast<uint64_t>(value >> 63));
+  }
+
+  template <class TYPE>
+  void putFixed(TYPE value);
+  // Write the specified arithmetic 'value' in little-endian byte order
+  // without bounds check.
+
+  void putRaw(const char *data, size_t size)
+  // Write the specified 'data' with the specified 'size' without bounds
+  // check.
+  {
+    memcpy(d_cursor, data, size);
+    d_cursor += size;
+  }
+
+  void writeVarint(uint64_t value)
+  // Write the specified 'value' as varint.
+  {
+    reserve(k_maximumVarintSize);
+    putVarint(value);
+  }
+
+  void writeZigZag(int64_t value)
+  // Write the specified 'value' zigzag encoded.
+  {
+    reserve(k_maximumVarintSize);
+    putZigZag(value);
+  }
+
+  template <class TYPE>
+  void writeFixed(TYPE value)
+  // Write the specified arithmetic 'value' in little-endian byte order.
+  {
+    reserve(sizeof(TYPE));
+    putFixed(value);
+  }
+
+  void writeRaw(const char *data, size_t size);
+  // Write the specified 'data' with the specified 'size'.
+
+  void writeBytes(const char *data, size_t size)
+  // Write the specified 'data' with the specified 'size' prefixed with its
+  // length.
+  {
+    writeVarint(size);
+    writeRaw(data, size);
+  }
+
+  void writeBytes(const ConstBuffer &buffer)
+  // Write the specified 'buffer' prefixed with its length.
+  {
+    writeBytes(buffer.buffer(), buffer.size());
+  }
+
+  void flush();
+  // Commit the written bytes to the vector.
+
+  // ACCESSORS
+
+  size_t size() const
+  // Return the number of bytes in the vector including unflushed bytes.
+  {
+    return d_vector_p->size() + (d_cursor - d_begin);
+  }
+
+  BufferVector *vector() const
+  // Return the vector written to.
+  {
+    return d_vector_p;
+  }
+};
+
+// ==================
+// Class BinaryReader
+// ==================
+
+class BinaryReader
+{
+  // Provides decoding of the encodings of 'BinaryWriter' from a contiguous
+  // buffer or from a 'BufferVector'.
+  //
+  // Values are read through a window of contiguous memory. The 'get'
+  // functions of fixed size values read without any bounds check and must
+  // be preceded by a successful 'ensure' covering all of them. The 'read'
+  // functions check on their own and return false if the input is
+  // truncated or malformed. When reading from a vector the window is one of
+  // its buffers, or a staged copy if a value spans buffers, and bytes that
+  // have been read are consumed from the vector on 'sync' and on
+  // destruction.
+
+public:
+  // PUBLIC CONSTANTS
+
+  enum
+  {
+    k_maximumVarintSize = BinaryWriter::k_maximumVarintSize,
+    k_maximumEnsureSize = BinaryWriter::k_maximumReserveSize
+  };
+
+private:
+  // DATA
+
+  BufferVector *d_vector_p; // Null for a contiguous buffer.
+  const char *  d_begin;    // Start of the window.
+  const char *  d_cursor;   // Next byte to read.
+  const char *  d_end;      // End of the window.
+  char          d_staging[k_maximumEnsureSize];
+
+  // PRIVATE MANIPULATORS
+
+  bool nextWindow(size_t size);
+  // Consume the bytes read and load a window of at least the specified
+  // 'size' bytes. Return false if fewer bytes are left.
+
+public:
+  BinaryReader(const BinaryReader &) = delete;
+  BinaryReader &operator=(const BinaryReader &) = delete;
+
+  // CREATORS
+
+  BinaryReader(const char *buffer, size_t size)
+      // Create a reader of the specified 'buffer' with the specified 'size'.
+      : d_vector_p(nullptr)
+      , d_begin(buffer)
+      , d_cursor(buffer)
+      , d_end(buffer + size)
+  {}
+
+  explicit BinaryReader(const ConstBuffer &buffer)
+      // Create a reader of the specified 'buffer'.
+      : BinaryReader(buffer.buffer(), buffer.size())
+  {}
+
+  explicit BinaryReader(BufferVector *vector)
+      // Create a reader that consumes the specified 'vector'.
+      : d_vector_p(vector)
+      , d_begin(nullptr)
+      , d_cursor(nullptr)
+      , d_end(nullptr)
+  {}
+
+  ~BinaryReader() { sync(); }
+  // Consume the bytes read from the vector.
+
+  // MANIPULATORS
+
+  bool ensure(size_t size)
+  // Make sure the specified 'size' bytes can be read with the 'get'
+  // functions. Return false if fewer bytes are left. Behavior is undefined
+  // unless 'size <= k_maximumEnsureSize'.
+  {
+    return size <= static_cast<size_t>(d_end - d_cursor) || nextWindow(size);
+  }
+
+  bool getVarint(uint64_t *value);
+  // Load into the specified 'value' a varint from the window. Return false
+  // if it is longer than 'k_maximumVarintSize' or exceeds the window.
+
+  bool getZigZag(int64_t *value)
+  // Load into the specified 'value' a zigzag encoded integer from the
+  // window. Return false if it is malformed or exceeds the window.
+  {
+    uint64_t raw;
+    if (!getVarint(&raw)) {
+      return false;
+    }
+    *value = static_cast<int64_t>((raw >> 1) ^ (~(raw & 1) + 1));
+    return true;
+  }
+
+  template <class TYPE>
+  void getFixed(TYPE *value);
+  // Load into the specified 'value' an arithmetic value in little-endian
+  // byte order without bounds check.
+
+  bool readVarint(uint64_t *value)
+  // Load into the specified 'value' a varint. Return false if the input is
+  // truncated or malformed.
+  {
+    ensure(std::min<size_t>(k_maximumVarintSize, remaining()));
+    return getVarint(value);
+  }
+
+  bool readZigZag(int64_t *value)
+  // Load into the specified 'value' a zigzag encoded integer. Return false
+  // if the input is truncated or malformed.
+  {
+    ensure(std::min<size_t>(k_maximumVarintSize, remaining()));
+    return getZigZag(value);
+  }
+
+  template <class TYPE>
+  bool readFixed(TYPE *value)
+  // Load into the specified 'value' an arithmetic value in little-endian
+  // byte order. Return false if the input is truncated.
+  {
+    if (!ensure(sizeof(TYPE))) {
+      return false;
+    }
+    getFixed(value);
+    return true;
+  }
+
+  bool readRaw(char *data, size_t size);
+  // Copy the specified 'size' bytes to the specified 'data'. Return false,
+  // reading nothing, if the input is truncated.
+
+  bool readBytes(std::string *value);
+  // Load into the specified 'value' a length-prefixed byte string. Return
+  // false if the input is truncated or malformed.
+
+  void sync();
+  // Consume the bytes read from the vector.
+
+  // ACCESSORS
+
+  size_t remaining() const
+  // Return the number of bytes left to read.
+  {
+    return d_vector_p ? d_vector_p->size() - (d_cursor - d_begin)
+                      : d_end - d_cursor;
+  }
+};
+
+// ==================
+// Struct BinaryFixed
+// ==================
+
+struct BinaryFixed
+{
+  // Encoding of arithmetic fields in little-endian byte order.
+
+  template <class TYPE>
+  static constexpr size_t maximumSize()
+  {
+    return sizeof(TYPE);
+  }
+
+  template <class TYPE>
+  static void put(BinaryWriter *writer, TYPE value)
+  {
+    writer->putFixed(value);
+  }
+
+  template <class TYPE>
+  static bool get(BinaryReader *reader, TYPE *value)
+  {
+    reader->getFixed(value);
+    return true;
+  }
+
+  template <class TYPE>
+  static bool read(BinaryReader *reader, TYPE *value)
+  {
+    return reader->readFixed(value);
+  }
+};
+
+// ===================
+// Struct BinaryVarint
+// ===================
+
+template <class TYPE, bool IS_ENUM = std::is_enum<TYPE>::value>
+struct BinaryVarint_Unsigned
+{
+  // Unsigned type of the same size as the integral 'TYPE', so negative
+  // values are not sign extended to 64 bits.
+
+  typedef typename std::make_unsigned<TYPE>::type Type;
+};
+
+template <class TYPE>
+struct BinaryVarint_Unsigned<TYPE, true>
+{
+  typedef typename std::make_unsigned<
+      typename std::underlying_type<TYPE>::type>::type Type;
+};
+
+struct BinaryVarint
+{
+  // Encoding of integral and enumeration fields as varint. Negative values
+  // take the maximum size, use 'BinaryZigZag' for signed fields.
+
+  template <class TYPE>
+  static constexpr size_t maximumSize()
+  {
+    return (sizeof(TYPE) * 8 + 6) / 7;
+  }
+
+  template <class TYPE>
+  static void put(BinaryWriter *writer, TYPE value)
+  {
+    typedef typename BinaryVarint_Unsigned<TYPE>::Type Unsigned;
+    writer->putVarint(static_cast<Unsigned>(value));
+  }
+
+  template <class TYPE>
+  static bool get(BinaryReader *reader, TYPE *value)
+  {
+    uint64_t raw;
+    if (!reader->getVarint(&raw)) {
+      return false;
+    }
+    *value = static_cast<TYPE>(raw);
+    return true;
+  }
+
+  template <class TYPE>
+  static bool read(BinaryReader *reader, TYPE *value)
+  {
+    uint64_t raw;
+    if (!reader->readVarint(&raw)) {
+      return false;
+    }
+    *value = static_cast<TYPE>(raw);
+    return true;
+  }
+};
+
+// ===================
+// Struct BinaryZigZag
+// ===================
+
+struct BinaryZigZag
+{
+  // Encoding of signed integral fields as zigzag varint.
+
+  template <class TYPE>
+  static constexpr size_t maximumSize()
+  {
+    return (sizeof(TYPE) * 8 + 6) / 7;
+  }
+
+  template <class TYPE>
+  static void put(BinaryWriter *writer, TYPE value)
+  {
+    writer->putZigZag(value);
+  }
+
+  template <class TYPE>
+  static bool get(BinaryReader *reader, TYPE *value)
+  {
+    int64_t raw;
+    if (!reader->getZigZag(&raw)) {
+      return false;
+    }
+    *value = static_cast<TYPE>(raw);
+    return true;
+  }
+
+  template <class TYPE>
+  static bool read(BinaryReader *reader, TYPE *value)
+  {
+    int64_t raw;
+    if (!reader->readZigZag(&raw)) {
+      return false;
+    }
+    *value = static_cast<TYPE>(raw);
+    return true;
+  }
+};
+
+// ==================
+// Struct BinaryField
+// ==================
+
+template <class MEMBER>
+struct BinaryField_MemberTraits;
+
+template <class CLASS, class TYPE>
+struct BinaryField_MemberTraits<TYPE CLASS::*>
+{
+  typedef CLASS Class;
+  typedef TYPE  Type;
+};
+
+template <auto MEMBER, class ENCODING>
+struct BinaryField
+{
+  // Describes the data member 'MEMBER' encoded with 'ENCODING', one of
+  // 'BinaryFixed', 'BinaryVarint' and 'BinaryZigZag'.
+
+  typedef BinaryField_MemberTraits<decltype(MEMBER)> Traits;
+  typedef typename Traits::Class                      Class;
+  typedef typename Traits::Type                       Type;
+
+  static constexpr size_t k_maximumSize =
+      ENCODING::template maximumSize<Type>();
+
+  static void put(BinaryWriter *writer, const Class &object)
+  {
+    ENCODING::put(writer, object.*MEMBER);
+  }
+
+  static bool get(BinaryReader *reader, Class *object)
+  {
+    return ENCODING::get(reader, &(object->*MEMBER));
+  }
+
+  static bool read(BinaryReader *reader, Class *object)
+  {
+    return ENCODING::read(reader, &(object->*MEMBER));
+  }
+};
+
+// =================
+// Class BinaryCodec
+// =================
+
+template <class TYPE, class... FIELDS>
+struct BinaryCodec
+{
+  // Encodes and decodes objects of 'TYPE' as the sequence of 'FIELDS', each
+  // a 'BinaryField'. Since the maximum encoded size is known at compile
+  // time, encoding is a single reservation followed by straight-line
+  // stores, and decoding of input that is not near its end is a single
+  // check followed by straight-line loads. For example:
+  //..
+  //  struct Quote { uint32_t d_id; int64_t d_delta; double d_price; };
+  //
+  //  typedef BinaryCodec<Quote,
+  //                      BinaryField<&Quote::d_id,    BinaryVarint>,
+  //                      BinaryField<&Quote::d_delta, BinaryZigZag>,
+  //                      BinaryField<&Quote::d_price, BinaryFixed>>
+  //      QuoteCodec;
+  //..
+
+  static constexpr size_t k_maximumSize = (FIELDS::k_maximumSize + ...);
+
+  static_assert(k_maximumSize <= BinaryWriter::k_maximumReserveSize,
+                "Encoded size exceeds the reservation limit");
+
+  static void encode(BinaryWriter *writer, const TYPE &object)
+  // Write the fields of the specified 'object' to the specified 'writer'.
+  {
+    writer->reserve(k_maximumSize);
+    (FIELDS::put(writer, object), ...);
+  }
+
+  static bool decode(BinaryReader *reader, TYPE *object)
+  // Load the fields of the specified 'object' from the specified 'reader'.
+  // Return false if the input is truncated or malformed.
+  {
+    if (reader->ensure(k_maximumSize)) {
+      return (FIELDS::get(reader, object) && ...);
+    }
+    return (FIELDS::read(reader, object) && ...);
+  }
+};
+
+// ============================================================================
+//                            INLINE DEFINITIONS
+// ============================================================================
+
+// ------------------
+// Class BinaryWriter
+// ------------------
+
+// MANIPULATORS
+
+template <class TYPE>
+inline void BinaryWriter::putFixed(TYPE value)
+{
+  static_assert(std::is_arithmetic<TYPE>::value, "Arithmetic type required");
+
+  memcpy(d_cursor, &value, sizeof(TYPE));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  std::reverse(d_cursor, d_cursor + sizeof(TYPE));
+#endif
+  d_cursor += sizeof(TYPE);
+}
+
+// ------------------
+// Class BinaryReader
+// ------------------
+
+// MANIPULATORS
+
+inline bool BinaryReader::getVarint(uint64_t *value)
+{
+  const size_t available = d_end - d_cursor;
+  const size_t limit     = std::min<size_t>(available, k_maximumVarintSize);
+
+  uint64_t result = 0;
+  for (size_t i = 0; i < limit; ++i) {
+    const uint64_t byte = static_cast<unsigned char>(d_cursor[i]);
+    result |= (byte & 0x7f) << (7 * i);
+    if (byte < 0x80) {
+      if (k_maximumVarintSize - 1 == i && 1 < byte) {
+        return false;
+      }
+      d_cursor += i + 1;
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class TYPE>
+inline void BinaryReader::getFixed(TYPE *value)
+{
+  static_assert(std::is_arithmetic<TYPE>::value, "Arithmetic type required");
+
+  char bytes[sizeof(TYPE)];
+  memcpy(bytes, d_cursor, sizeof(TYPE));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  std::reverse(bytes, bytes + sizeof(TYPE));
+#endif
+  memcpy(value, bytes, sizeof(TYPE));
+  d_cursor += sizeof(TYPE);
+}
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_BINARYCODEC
@@ -0,0 +1,255 @@
+// mdio_binarycodec.t.cpp                                               -*-c++-*-
+#include <mdio_binarycodec.h>
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+std::string str(const BufferVector& vector)
+{
+  std::string result(vector.size(), '\0');
+  vector.copyOut(&result[0], result.size());
+  return result;
+}
+
+enum Side { e_buy = 1, e_sell = 2 };
+
+struct Quote {
+  uint32_t d_id;
+  int64_t  d_delta;
+  double   d_price;
+  Side     d_side;
+  int32_t  d_quantity;
+
+  bool operator==(const Quote& other) const
+  {
+    return d_id == other.d_id && d_delta == other.d_delta &&
+      d_price == other.d_price && d_side == other.d_side &&
+      d_quantity == other.d_quantity;
+  }
+};
+
+typedef BinaryCodec<Quote,
+		    BinaryField<&Quote::d_id,       BinaryVarint>,
+		    BinaryField<&Quote::d_delta,    BinaryZigZag>,
+		    BinaryField<&Quote::d_price,    BinaryFixed>,
+		    BinaryField<&Quote::d_side,     BinaryVarint>,
+		    BinaryField<&Quote::d_quantity, BinaryVarint>> QuoteCodec;
+
+static_assert(5 + 10 + 8 + 5 + 5 == QuoteCodec::k_maximumSize, "Size");
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 4:
+    {
+      // Truncated and malformed input.
+      uint64_t u;
+      int64_t  i;
+      uint32_t f;
+      std::string s;
+
+      {
+	const char data[] = "\x80\x80";
+	BinaryReader r(data, 2);
+	ASSERT(!r.readVarint(&u));
+      }
+      {
+	const char data[] = "\xff\xff\xff\xff\xff\xff\xff\xff\xff\x02";
+	BinaryReader r(data, 10);
+	ASSERT(!r.readVarint(&u));
+      }
+      {
+	const char data[] = "\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01";
+	BinaryReader r(data, 10);
+	ASSERT(r.readVarint(&u));
+	ASSERT(std::numeric_limits<uint64_t>::max() == u);
+	ASSERT(!r.readZigZag(&i));
+	ASSERT(!r.readFixed(&f));
+      }
+      {
+	const char data[] = "\x05" "abc";
+	BinaryReader r(data, 4);
+	ASSERT(!r.readBytes(&s));
+      }
+      {
+	BufferVector v(8);
+	v.append("\x01\x02\x03", 3);
+	BinaryReader r(&v);
+	ASSERT(!r.readFixed(&f));
+	ASSERT(3 == r.remaining());
+
+	Quote q;
+	ASSERT(!QuoteCodec::decode(&r, &q));
+      }
+    } break;
+
+  case 3:
+    {
+      // Structs round trip through small buffers, so fields span buffers.
+      std::mt19937_64    random(3);
+      std::vector<Quote> quotes;
+      for (size_t n = 0; n < 1000; ++n) {
+	Quote q;
+	q.d_id       = static_cast<uint32_t>(random() >> (random() % 64 / 2));
+	q.d_delta    = static_cast<int64_t>(random()) >> (random() % 64);
+	q.d_price    = static_cast<double>(random() % 100000) / 100;
+	q.d_side     = 0 == n % 2 ? e_buy : e_sell;
+	q.d_quantity = static_cast<int32_t>(random());
+	quotes.push_back(q);
+      }
+
+      BufferVector v(13);
+      {
+	BinaryWriter w(&v);
+	for (const Quote& q : quotes) {
+	  QuoteCodec::encode(&w, q);
+	  w.writeBytes("tag", 3);
+	}
+      }
+
+      BinaryReader r(&v);
+      for (const Quote& expected : quotes) {
+	Quote       q;
+	std::string tag;
+	ASSERT(QuoteCodec::decode(&r, &q));
+	ASSERT(expected == q);
+	ASSERT(r.readBytes(&tag));
+	ASSERT("tag" == tag);
+      }
+      ASSERT(0 == r.remaining());
+      r.sync();
+      ASSERT(v.empty());
+    } break;
+
+  case 2:
+    {
+      // Values round trip, including across buffer boundaries.
+      const uint64_t unsignedValues[] = {
+	0, 1, 127, 128, 300, 16383, 16384, uint64_t(1) << 35,
+	std::numeric_limits<uint64_t>::max()};
+      const int64_t signedValues[] = {
+	0, -1, 1, -64, 64, -65, std::numeric_limits<int64_t>::min(),
+	std::numeric_limits<int64_t>::max()};
+      const std::string bytes(1000, 'b');
+
+      for (size_t bufferSize = 1; bufferSize < 20; bufferSize += 3) {
+	BufferVector v(bufferSize);
+
+	{
+	  BinaryWriter w(&v);
+	  for (uint64_t value : unsignedValues) {
+	    w.writeVarint(value);
+	    w.writeFixed(value);
+	  }
+	  for (int64_t value : signedValues) {
+	    w.writeZigZag(value);
+	    w.writeFixed(static_cast<int32_t>(value));
+	  }
+	  w.writeFixed(3.25);
+	  w.writeFixed(-0.5f);
+	  w.writeBytes(bytes.data(), bytes.size());
+	  w.writeBytes(ConstBuffer("", 0));
+	  w.writeVarint(42);
+	}
+
+	BinaryReader r(&v);
+	for (uint64_t value : unsignedValues) {
+	  uint64_t u;
+	  ASSERT(r.readVarint(&u));
+	  ASSERT(value == u);
+	  ASSERT(r.readFixed(&u));
+	  ASSERT(value == u);
+	}
+	for (int64_t value : signedValues) {
+	  int64_t s;
+	  int32_t f;
+	  ASSERT(r.readZigZag(&s));
+	  ASSERT(value == s);
+	  ASSERT(r.readFixed(&f));
+	  ASSERT(static_cast<int32_t>(value) == f);
+	}
+	double d;
+	float  f;
+	std::string s;
+	ASSERT(r.readFixed(&d));
+	ASSERT(3.25 == d);
+	ASSERT(r.readFixed(&f));
+	ASSERT(-0.5f == f);
+	ASSERT(r.readBytes(&s));
+	ASSERT(bytes == s);
+	ASSERT(r.readBytes(&s));
+	ASSERT(s.empty());
+	uint64_t u;
+	ASSERT(r.readVarint(&u));
+	ASSERT(42 == u);
+	ASSERT(!r.readVarint(&u));
+      }
+    } break;
+
+  case 1:
+    {
+      // Breathing test: the wire format.
+      BufferVector v(64);
+      BinaryWriter w(&v);
+
+      w.writeVarint(300);
+      w.writeZigZag(-2);
+      w.writeFixed(uint32_t(0x01020304));
+      w.writeBytes("hi", 2);
+      ASSERT(10 == w.size());
+      w.flush();
+      ASSERT(std::string("\xac\x02\x03\x04\x03\x02\x01\x02hi", 10) == str(v));
+
+      const std::string data = str(v);
+      BinaryReader      r(data.data(), data.size());
+      uint64_t          u;
+      int64_t           i;
+      uint32_t          f;
+      std::string       s;
+      ASSERT(r.readVarint(&u));
+      ASSERT(300 == u);
+      ASSERT(r.readZigZag(&i));
+      ASSERT(-2 == i);
+      ASSERT(r.readFixed(&f));
+      ASSERT(0x01020304 == f);
+      ASSERT(r.readBytes(&s));
+      ASSERT("hi" == s);
+      ASSERT(0 == r.remaining());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -124,25 +124,77 @@ public:
   {}
 
   Buffer(const TemporaryBuffer& buffer)
-    // Copy from the specified 'buffer'.
+    // Take ownership of the memory referenced by the specified 'buffer'.
     : TemporaryBuffer(buffer)
   {
   }
 
-  ~Buffer() { d_allocator_p->deallocate(buffer(), size()); }
+  Buffer(const Buffer&) = delete;
+  // A buffer exclusively owns its memory and cannot be copied.
+
+  Buffer(Buffer&& other)
+    // Take ownership of the memory of the specified 'other' buffer, leaving
+    // 'other' empty.
+    : TemporaryBuffer(other)
+  {
+    other.d_buffer = 0;
+    other.d_size   = 0;
+  }
+
+  ~Buffer()
+  {
+    if (d_buffer) {
+      d_allocator_p->deallocate(buffer(), size());
+    }
+  }
 
   // MANIPULATORS
 
+  Buffer& operator=(const Buffer&) = delete;
+
+  Buffer& operator=(Buffer&& other)
+  // Release the current memory and take ownership of the memory of the
+  // specified 'other' buffer, leaving 'other' empty.
+  {
+    if (this != &other) {
+      if (d_buffer) {
+        d_allocator_p->deallocate(buffer(), size());
+      }
+      d_buffer       = other.d_buffer;
+      d_size         = other.d_size;
+      d_allocator_p  = other.d_allocator_p;
+      other.d_buffer = 0;
+      other.d_size   = 0;
+    }
+    return *this;
+  }
+
+  char *release()
+  // Return the buffer and give up its ownership, leaving this buffer empty.
+  // The memory must be deallocated with 'allocator()' by the caller.
+  {
+    char *result = buffer();
+    d_buffer     = 0;
+    d_size       = 0;
+    return result;
+  }
+
   // ACCESSORS
 
+  using TemporaryBuffer::buffer;
+
   char *buffer()
   // Return the buffer.
   {
     return const_cast<char *>(d_buffer);
   }
 
-
-  };
+  mdmem::Allocator *allocator() const
+  // Return the allocator used to deallocate the buffer.
+  {
+    return d_allocator_p;
+  }
+};
 
 } // namespace mdio
 } // namespace MvdS
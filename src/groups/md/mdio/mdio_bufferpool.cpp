@@ -0,0 +1,184 @@
+// mdio_bufferpool.cpp                                                  -*-c++-*-
+#include <mdio_bufferpool.h>
+
+#include <cstring>
+#include <experimental/vector>
+#include <iostream>
+#include <new>
+
+namespace MvdS {
+namespace mdio {
+
+// ------------------------
+// Struct BufferPoolMetrics
+// ------------------------
+
+void BufferPoolMetrics::print(std::ostream &stream,
+                              size_t        level,
+                              size_t        spacesPerLevel) const
+{
+#define P(x)                                                                   \
+  {                                                                            \
+    for (size_t i = 0; i < level * spacesPerLevel; ++i)                        \
+      stream << " ";                                                           \
+    stream << #x " = " << x.load(std::memory_order_relaxed) << "\n";           \
+  }
+  P(d_acquiredCount);
+  P(d_missCount);
+  P(d_inUseCount);
+  P(d_peakInUseCount);
+#undef P
+}
+
+// -------------------------------
+// Class BufferPool::TierAllocator
+// -------------------------------
+
+BufferPool::TierAllocator::TierAllocator(const Tier &       tier,
+                                         mdmem::Allocator *allocator)
+    : d_pool(tier.d_poolSize,
+             tier.d_bufferSize,
+             alignof(std::max_align_t),
+             allocator)
+{}
+
+void *BufferPool::TierAllocator::do_allocate(std::size_t bytes,
+                                             std::size_t alignment)
+{
+  if (bytes == d_pool.bufferSize() && alignment == d_pool.alignment()) {
+    d_metrics.acquire(0 == d_pool.available());
+  }
+  return d_pool.allocate(bytes, alignment);
+}
+
+void BufferPool::TierAllocator::do_deallocate(void *      p,
+                                              std::size_t bytes,
+                                              std::size_t alignment)
+{
+  if (bytes == d_pool.bufferSize() && alignment == d_pool.alignment()) {
+    d_metrics.release();
+  }
+  d_pool.deallocate(p, bytes, alignment);
+}
+
+void BufferPool::TierAllocator::prefill(size_t            count,
+                                        mdmem::Allocator *allocator)
+{
+  std::experimental::pmr::vector<void *> buffers(allocator);
+  buffers.reserve(count);
+
+  for (size_t i = 0; i < count; ++i) {
+    buffers.push_back(d_pool.allocate(d_pool.bufferSize(), d_pool.alignment()));
+  }
+
+  for (void *buffer : buffers) {
+    d_pool.deallocate(buffer, d_pool.bufferSize(), d_pool.alignment());
+  }
+}
+
+bool BufferPool::TierAllocator::do_is_equal(
+    const std::experimental::pmr::memory_resource &other) const noexcept
+{
+  return this == &other;
+}
+
+// ----------------
+// Class BufferPool
+// ----------------
+
+// CREATORS
+
+BufferPool::BufferPool(mdmem::Allocator *allocator)
+    : BufferPool(Configuration(), allocator)
+{}
+
+BufferPool::BufferPool(const Configuration &config,
+                       mdmem::Allocator *   allocator)
+    : d_tiers(nullptr)
+    , d_tierCount(config.d_tiers.size())
+    , d_oversizedCount(0)
+    , d_allocator_p(mdmem::AllocatorUtil::defaultAllocator(allocator))
+{
+  d_tiers = static_cast<TierAllocator *>(d_allocator_p->allocate(
+      sizeof(TierAllocator) * d_tierCount, alignof(TierAllocator)));
+
+  for (size_t i = 0; i < d_tierCount; ++i) {
+    new (d_tiers + i) TierAllocator(config.d_tiers[i], d_allocator_p);
+  }
+
+  if (!config.d_preallocate) {
+    return;
+  }
+
+  // Fill the pools, so the first buffers do not hit the backing allocator.
+  for (size_t i = 0; i < d_tierCount; ++i) {
+    d_tiers[i].prefill(config.d_tiers[i].d_poolSize, d_allocator_p);
+  }
+}
+
+BufferPool::~BufferPool()
+{
+  for (size_t i = 0; i < d_tierCount; ++i) {
+    d_tiers[i].~TierAllocator();
+  }
+
+  d_allocator_p->deallocate(
+      d_tiers, sizeof(TierAllocator) * d_tierCount, alignof(TierAllocator));
+}
+
+// MANIPULATORS
+
+Buffer BufferPool::acquire(size_t size)
+{
+  for (size_t i = 0; i < d_tierCount; ++i) {
+    TierAllocator &tier = d_tiers[i];
+    if (size <= tier.bufferSize()) {
+      return Buffer(static_cast<char *>(tier.allocate(tier.bufferSize())),
+                    tier.bufferSize(),
+                    &tier);
+    }
+  }
+
+  ++d_oversizedCount;
+  return Buffer(
+      static_cast<char *>(d_allocator_p->allocate(size)), size, d_allocator_p);
+}
+
+Buffer BufferPool::copy(const char *buffer, size_t size)
+{
+  Buffer result = acquire(size);
+  memcpy(result.buffer(), buffer, size);
+  return result;
+}
+
+mdmem::Allocator *BufferPool::tierAllocator(size_t size)
+{
+  for (size_t i = 0; i < d_tierCount; ++i) {
+    if (size <= d_tiers[i].bufferSize()) {
+      return d_tiers + i;
+    }
+  }
+
+  return d_allocator_p;
+}
+
+// ACCESSORS
+
+void BufferPool::print(std::ostream &stream,
+                       size_t        level,
+                       size_t        spacesPerLevel) const
+{
+  const std::string indent(level * spacesPerLevel, ' ');
+
+  for (size_t i = 0; i < d_tierCount; ++i) {
+    stream << indent << "tier " << d_tiers[i].bufferSize()
+           << " (available = " << d_tiers[i].available() << ")\n";
+    d_tiers[i].metrics().print(stream, level + 1, spacesPerLevel);
+  }
+
+  stream << indent << "d_oversizedCount = " << oversizedCount() << "\n";
+}
+
+} // namespace mdio
+} // namespace MvdS
+
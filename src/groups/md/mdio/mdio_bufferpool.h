@@ -0,0 +1,222 @@
+// mdio_bufferpool.h                                                    -*-c++-*-
+#ifndef __INCLUDED_MDIO_BUFFERPOOL
+#define __INCLUDED_MDIO_BUFFERPOOL
+
+#include <mdio_buffer.h>
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+#include <mdmem_fixedbufferpoolallocator.h>
+
+#include <atomic>
+#include <cstddef>
+#include <experimental/memory_resource>
+#include <iosfwd>
+#include <vector>
+
+namespace MvdS {
+namespace mdio {
+
+// ========================
+// Struct BufferPoolMetrics
+// ========================
+
+struct BufferPoolMetrics
+{
+  // Structure for keeping metrics on one tier of a buffer pool.
+
+  // DATA
+
+  std::atomic<size_t> d_acquiredCount  = 0; // Buffers handed out.
+  std::atomic<size_t> d_missCount      = 0; // Acquired with an empty pool.
+  std::atomic<size_t> d_inUseCount     = 0; // Buffers not yet returned.
+  std::atomic<size_t> d_peakInUseCount = 0; // Maximum of 'd_inUseCount'.
+
+  // MANIPULATORS
+
+  void acquire(bool miss)
+  {
+    ++d_acquiredCount;
+    if (miss) {
+      ++d_missCount;
+    }
+
+    const size_t inUse = ++d_inUseCount;
+    size_t       peak  = d_peakInUseCount.load(std::memory_order_relaxed);
+    while (peak < inUse &&
+           !d_peakInUseCount.compare_exchange_weak(
+               peak, inUse, std::memory_order_relaxed)) {
+    }
+  }
+
+  void release() { --d_inUseCount; }
+
+  // ACCESSORS
+
+  void print(std::ostream &stream,
+             size_t        level          = 0,
+             size_t        spacesPerLevel = 2) const;
+  // Print metrics to the specified 'stream'.
+};
+
+// ================
+// Class BufferPool
+// ================
+
+class BufferPool
+{
+  // Provides fixed capacity 'Buffer's from pooled memory.
+  //
+  // The pool has tiers of increasing buffer size, each backed by a
+  // 'mdmem::FixedBufferPoolAllocator'. A request is served by the smallest
+  // tier whose buffers are large enough; the returned 'Buffer' deallocates
+  // into that tier when destroyed, so memory is recycled while it is still
+  // warm in the cache. Requests larger than the largest tier are allocated
+  // from the backing allocator. The allocator of a tier can also be handed
+  // to a 'BufferVector' with the same buffer size. This class is
+  // thread-safe.
+
+public:
+  // PUBLIC TYPES
+
+  struct Tier
+  {
+    size_t d_bufferSize; // Capacity of the buffers of this tier.
+    size_t d_poolSize;   // Free buffers kept, rounded to a power of two.
+  };
+
+  struct Configuration
+  {
+    std::vector<Tier> d_tiers;       // Tiers, in increasing buffer size.
+    bool              d_preallocate; // Fill the pools on construction.
+
+    Configuration()
+        : d_tiers({{4096, 256}, {65536, 16}})
+        , d_preallocate(true)
+    {}
+  };
+
+private:
+  // PRIVATE TYPES
+
+  class TierAllocator : public mdmem::Allocator
+  {
+    // Allocator of one tier that keeps the metrics up to date.
+
+    mdmem::FixedBufferPoolAllocator d_pool;
+    BufferPoolMetrics               d_metrics;
+
+    virtual void *do_allocate(std::size_t bytes, std::size_t alignment);
+
+    virtual void do_deallocate(void *p, std::size_t bytes, std::size_t alignment);
+
+    virtual bool do_is_equal(
+        const std::experimental::pmr::memory_resource &other) const noexcept;
+
+  public:
+    TierAllocator(const Tier &tier, mdmem::Allocator *allocator);
+
+    void prefill(size_t count, mdmem::Allocator *allocator);
+    // Allocate the specified 'count' buffers and return them to the pool,
+    // using the specified 'allocator' for temporary memory.
+
+    size_t bufferSize() const { return d_pool.bufferSize(); }
+
+    size_t available() const { return d_pool.available(); }
+
+    const BufferPoolMetrics &metrics() const { return d_metrics; }
+  };
+
+  // DATA
+
+  TierAllocator *     d_tiers;
+  size_t              d_tierCount;
+  std::atomic<size_t> d_oversizedCount;
+  mdmem::Allocator *  d_allocator_p;
+
+public:
+  BufferPool(const BufferPool &) = delete;
+  BufferPool &operator=(const BufferPool &) = delete;
+
+  // CREATORS
+
+  explicit BufferPool(mdmem::Allocator *allocator = 0);
+  // Create a buffer pool with 4 KiB and 64 KiB tiers. Optionally the
+  // specified 'allocator' is used for memory allocation.
+
+  explicit BufferPool(const Configuration &config,
+                      mdmem::Allocator *   allocator = 0);
+  // Create a buffer pool with the tiers of the specified 'config'.
+  // Optionally the specified 'allocator' is used for memory allocation.
+
+  ~BufferPool();
+  // Destroy the pool. Behavior is undefined if buffers acquired from this
+  // pool are still in use.
+
+  // MANIPULATORS
+
+  Buffer acquire(size_t size);
+  // Return a buffer of at least the specified 'size' bytes. The size of the
+  // returned buffer is the buffer size of the tier that served it.
+
+  Buffer copy(const char *buffer, size_t size);
+  // Return a buffer of at least the specified 'size' bytes that starts with
+  // a copy of the specified 'buffer'.
+
+  mdmem::Allocator *tierAllocator(size_t size);
+  // Return the allocator of the smallest tier with buffers of at least the
+  // specified 'size' bytes, or the backing allocator if there is none.
+
+  // ACCESSORS
+
+  size_t tierCount() const
+  // Return the number of tiers.
+  {
+    return d_tierCount;
+  }
+
+  size_t bufferSize(size_t tier) const
+  // Return the buffer size of the specified 'tier'.
+  {
+    return d_tiers[tier].bufferSize();
+  }
+
+  size_t available(size_t tier) const
+  // Return an estimate of the number of free buffers of the specified
+  // 'tier'.
+  {
+    return d_tiers[tier].available();
+  }
+
+  const BufferPoolMetrics &metrics(size_t tier) const
+  // Return the metrics of the specified 'tier'.
+  {
+    return d_tiers[tier].metrics();
+  }
+
+  size_t oversizedCount() const
+  // Return the number of buffers allocated beyond the largest tier.
+  {
+    return d_oversizedCount.load(std::memory_order_relaxed);
+  }
+
+  void print(std::ostream &stream,
+             size_t        level          = 0,
+             size_t        spacesPerLevel = 2) const;
+  // Print the tiers and their metrics to the specified 'stream'.
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+// ------------------------
+// Struct BufferPoolMetrics
+// ------------------------
+
+inline std::ostream &operator<<(std::ostream &                       stream,
+                                const MvdS::mdio::BufferPoolMetrics &metrics)
+{
+  metrics.print(stream);
+  return stream;
+}
+
+#endif // __INCLUDED_MDIO_BUFFERPOOL
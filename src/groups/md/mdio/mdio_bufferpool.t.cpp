@@ -0,0 +1,249 @@
+// mdio_bufferpool.t.cpp                                                -*-c++-*-
+#include <mdio_bufferpool.h>
+
+#include <mdio_buffervector.h>
+#include <mdmem_testallocator.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+std::atomic<size_t> g_globalAllocationCount(0);
+// Number of allocations through the global 'operator new'.
+
+void *operator new(size_t size)
+{
+  ++g_globalAllocationCount;
+  void *p = std::malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+class MallocAllocator : public mdmem::Allocator {
+  // Allocator that bypasses the global 'operator new'.
+
+  virtual void *do_allocate(std::size_t bytes, std::size_t alignment)
+  {
+    void *p = std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+    if (!p) {
+      throw std::bad_alloc();
+    }
+    return p;
+  }
+
+  virtual void do_deallocate(void *p, std::size_t, std::size_t)
+  {
+    std::free(p);
+  }
+
+  virtual bool do_is_equal(const std::experimental::pmr::memory_resource& other) const noexcept
+  {
+    return this == &other;
+  }
+};
+
+BufferPool::Configuration smallConfig(bool preallocate)
+{
+  BufferPool::Configuration config;
+  config.d_tiers       = {{64, 4}, {256, 2}};
+  config.d_preallocate = preallocate;
+  return config;
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 5:
+    {
+      // Filling the pools only allocates from the given allocator.
+      MallocAllocator                 ma;
+      mdmem::TestAllocator            ta(&ma);
+      const BufferPool::Configuration config = smallConfig(true);
+
+      const size_t globalBefore = g_globalAllocationCount;
+      {
+	BufferPool pool(config, &ta);
+      }
+      ASSERT(globalBefore == g_globalAllocationCount);
+      ASSERT(0 < ta.allocationCount());
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 4:
+    {
+      // Concurrent acquisition keeps the metrics consistent.
+      mdmem::TestAllocator ta;
+
+      {
+	BufferPool pool(smallConfig(true), &ta);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+	  threads.emplace_back([&pool]() {
+	      for (int i = 0; i < 5000; ++i) {
+		Buffer b = pool.acquire(1 + i % 200);
+		b.buffer()[0] = 'x';
+	      }
+	    });
+	}
+
+	for (auto& thread : threads) {
+	  thread.join();
+	}
+
+	ASSERT(20000 == pool.metrics(0).d_acquiredCount +
+	                pool.metrics(1).d_acquiredCount);
+	ASSERT(0 == pool.metrics(0).d_inUseCount);
+	ASSERT(0 == pool.metrics(1).d_inUseCount);
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 3:
+    {
+      // A tier allocator serves a buffer vector of the same buffer size.
+      mdmem::TestAllocator ta;
+
+      {
+	BufferPool   pool(smallConfig(true), &ta);
+	BufferVector bv(64, pool.tierAllocator(64));
+
+	bv.append(std::string(200, 'a').data(), 200);
+	ASSERT(4 == pool.metrics(0).d_inUseCount);
+	ASSERT(0 == pool.metrics(0).d_missCount);
+
+	bv.consume(200);
+	bv.shrinkToFit();
+	ASSERT(0 == pool.metrics(0).d_inUseCount);
+	ASSERT(4 == pool.available(0));
+
+	ASSERT(pool.tierAllocator(1000) == &ta);
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 2:
+    {
+      // Metrics track use, misses and the peak.
+      mdmem::TestAllocator ta;
+
+      {
+	BufferPool pool(smallConfig(false), &ta);
+
+	{
+	  Buffer a = pool.acquire(64);
+	  Buffer b = pool.acquire(64);
+	  ASSERT(2 == pool.metrics(0).d_inUseCount);
+	  ASSERT(2 == pool.metrics(0).d_missCount);
+	}
+
+	ASSERT(0 == pool.metrics(0).d_inUseCount);
+	ASSERT(2 == pool.available(0));
+
+	{
+	  Buffer a = pool.acquire(10);
+	  ASSERT(2 == pool.metrics(0).d_missCount);
+	}
+
+	const BufferPoolMetrics& m = pool.metrics(0);
+	ASSERT(3 == m.d_acquiredCount);
+	ASSERT(2 == m.d_peakInUseCount);
+
+	std::ostringstream os;
+	os << m;
+	ASSERT(std::string::npos != os.str().find("d_peakInUseCount = 2"));
+	pool.print(os);
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 1:
+    {
+      // Buffers come from the smallest tier that fits and are recycled.
+      mdmem::TestAllocator ta;
+
+      {
+	BufferPool pool(smallConfig(true), &ta);
+	ASSERT(2 == pool.tierCount());
+	ASSERT(64 == pool.bufferSize(0));
+	ASSERT(256 == pool.bufferSize(1));
+	ASSERT(4 == pool.available(0));
+	ASSERT(2 == pool.available(1));
+
+	const size_t allocations = ta.allocationCount();
+	{
+	  Buffer b = pool.copy("hello", 5);
+	  ASSERT(64 == b.size());
+	  ASSERT(0 == memcmp("hello", b.buffer(), 5));
+	  ASSERT(3 == pool.available(0));
+	}
+	ASSERT(4 == pool.available(0));
+
+	for (int i = 0; i < 10; ++i) {
+	  Buffer b = pool.acquire(65);
+	  ASSERT(256 == b.size());
+	}
+	ASSERT(allocations == ta.allocationCount());
+
+	{
+	  Buffer b = pool.acquire(1000);
+	  ASSERT(1000 == b.size());
+	  ASSERT(1 == pool.oversizedCount());
+	}
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,376 @@
+// mdio_bufferscanner.cpp                                               -*-c++-*-
+#include <mdio_bufferscanner.h>
+
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MDIO_BUFFERSCANNER_X86 1
+#endif
+
+namespace MvdS {
+namespace mdio {
+
+namespace {
+
+struct Kernels
+{
+  // Table of the scanning functions of one instruction set.
+
+  BufferScanner::Isa d_isa;
+  size_t (*d_find)(const char *, size_t, char);
+  size_t (*d_findAny)(const char *, size_t, const BufferScanner::ByteSet &);
+  size_t (*d_count)(const char *, size_t, char);
+};
+
+// Scalar kernels.
+
+size_t findScalar(const char *data, size_t size, char byte)
+{
+  const void *match = memchr(data, byte, size);
+  return match ? static_cast<const char *>(match) - data : size;
+}
+
+size_t findAnyScalar(const char *                    data,
+                     size_t                          size,
+                     const BufferScanner::ByteSet &set)
+{
+  for (size_t i = 0; i < size; ++i) {
+    if (set.contains(data[i])) {
+      return i;
+    }
+  }
+  return size;
+}
+
+size_t countScalar(const char *data, size_t size, char byte)
+{
+  size_t result = 0;
+  for (size_t i = 0; i < size; ++i) {
+    result += byte == data[i];
+  }
+  return result;
+}
+
+const Kernels k_scalarKernels = {
+    BufferScanner::e_scalar, &findScalar, &findAnyScalar, &countScalar};
+
+#ifdef MDIO_BUFFERSCANNER_X86
+
+// SSE2 kernels.
+
+__attribute__((target("sse2"))) size_t
+findSse2(const char *data, size_t size, char byte)
+{
+  const __m128i needle = _mm_set1_epi8(byte);
+
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + findScalar(data + i, size - i, byte);
+}
+
+__attribute__((target("sse2"))) size_t
+findAnySse2(const char *data, size_t size, const BufferScanner::ByteSet &set)
+{
+  const unsigned char *bytes = set.bytes();
+  if (!bytes) {
+    return findAnyScalar(data, size, set);
+  }
+
+  __m128i needles[BufferScanner::ByteSet::k_maximumVectorSize];
+  for (size_t j = 0; j < set.size(); ++j) {
+    needles[j] = _mm_set1_epi8(static_cast<char>(bytes[j]));
+  }
+
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+
+    __m128i matches = _mm_setzero_si128();
+    for (size_t j = 0; j < set.size(); ++j) {
+      matches = _mm_or_si128(matches, _mm_cmpeq_epi8(chunk, needles[j]));
+    }
+
+    const int mask = _mm_movemask_epi8(matches);
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + findAnyScalar(data + i, size - i, set);
+}
+
+__attribute__((target("sse2"))) size_t
+countSse2(const char *data, size_t size, char byte)
+{
+  const __m128i needle = _mm_set1_epi8(byte);
+
+  size_t result = 0;
+  size_t i      = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    result += __builtin_popcount(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+  }
+
+  return result + countScalar(data + i, size - i, byte);
+}
+
+const Kernels k_sse2Kernels = {
+    BufferScanner::e_sse2, &findSse2, &findAnySse2, &countSse2};
+
+// AVX2 kernels.
+
+__attribute__((target("avx2"))) size_t
+findAvx2(const char *data, size_t size, char byte)
+{
+  const __m256i needle = _mm256_set1_epi8(byte);
+
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    const unsigned mask = static_cast<unsigned>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + findSse2(data + i, size - i, byte);
+}
+
+__attribute__((target("avx2"))) size_t
+findAnyAvx2(const char *data, size_t size, const BufferScanner::ByteSet &set)
+{
+  const unsigned char *bytes = set.bytes();
+  if (!bytes) {
+    return findAnyScalar(data, size, set);
+  }
+
+  __m256i needles[BufferScanner::ByteSet::k_maximumVectorSize];
+  for (size_t j = 0; j < set.size(); ++j) {
+    needles[j] = _mm256_set1_epi8(static_cast<char>(bytes[j]));
+  }
+
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+
+    __m256i matches = _mm256_setzero_si256();
+    for (size_t j = 0; j < set.size(); ++j) {
+      matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(chunk, needles[j]));
+    }
+
+    const unsigned mask =
+        static_cast<unsigned>(_mm256_movemask_epi8(matches));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + findAnySse2(data + i, size - i, set);
+}
+
+__attribute__((target("avx2,popcnt"))) size_t
+countAvx2(const char *data, size_t size, char byte)
+{
+  const __m256i needle = _mm256_set1_epi8(byte);
+
+  size_t result = 0;
+  size_t i      = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    result += __builtin_popcount(static_cast<unsigned>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle))));
+  }
+
+  return result + countSse2(data + i, size - i, byte);
+}
+
+const Kernels k_avx2Kernels = {
+    BufferScanner::e_avx2, &findAvx2, &findAnyAvx2, &countAvx2};
+
+#endif
+
+const Kernels *kernelsFor(BufferScanner::Isa isa)
+{
+#ifdef MDIO_BUFFERSCANNER_X86
+  switch (isa) {
+  case BufferScanner::e_avx2:
+    return __builtin_cpu_supports("avx2") ? &k_avx2Kernels : nullptr;
+  case BufferScanner::e_sse2:
+    return __builtin_cpu_supports("sse2") ? &k_sse2Kernels : nullptr;
+  case BufferScanner::e_scalar:
+    return &k_scalarKernels;
+  }
+  return nullptr;
+#else
+  return BufferScanner::e_scalar == isa ? &k_scalarKernels : nullptr;
+#endif
+}
+
+const Kernels *bestKernels()
+{
+  for (BufferScanner::Isa isa : {BufferScanner::e_avx2, BufferScanner::e_sse2}) {
+    if (const Kernels *kernels = kernelsFor(isa)) {
+      return kernels;
+    }
+  }
+  return &k_scalarKernels;
+}
+
+std::atomic<const Kernels *> s_kernels(nullptr);
+// Kernels in use, null until selected. It is constant-initialized, so
+// constructors of other static objects can scan.
+
+const Kernels *selectKernels()
+// Select the best kernels unless some are set already and return the ones
+// in use.
+{
+  const Kernels *expected = nullptr;
+  const Kernels *best     = bestKernels();
+  return s_kernels.compare_exchange_strong(
+             expected, best, std::memory_order_relaxed)
+             ? best
+             : expected;
+}
+
+inline const Kernels &kernels()
+{
+  const Kernels *result = s_kernels.load(std::memory_order_relaxed);
+  return result ? *result : *selectKernels();
+}
+
+} // namespace
+
+// ----------------------------
+// Class BufferScanner::ByteSet
+// ----------------------------
+
+// CREATORS
+
+BufferScanner::ByteSet::ByteSet(const char *bytes)
+    : ByteSet(bytes, strlen(bytes))
+{}
+
+BufferScanner::ByteSet::ByteSet(const char *bytes, size_t size)
+    : ByteSet()
+{
+  for (size_t i = 0; i < size; ++i) {
+    insert(bytes[i]);
+  }
+}
+
+// MANIPULATORS
+
+void BufferScanner::ByteSet::insert(char byte)
+{
+  if (contains(byte)) {
+    return;
+  }
+
+  const unsigned char value = static_cast<unsigned char>(byte);
+  d_table[value >> 6] |= uint64_t(1) << (value & 63);
+
+  if (d_size < k_maximumVectorSize) {
+    d_bytes[d_size] = value;
+  }
+  ++d_size;
+}
+
+// -------------------
+// Class BufferScanner
+// -------------------
+
+// CLASS METHODS
+
+size_t BufferScanner::find(const char *data, size_t size, char byte)
+{
+  return kernels().d_find(data, size, byte);
+}
+
+size_t BufferScanner::findAny(const char *data, size_t size, const ByteSet &set)
+{
+  return kernels().d_findAny(data, size, set);
+}
+
+size_t BufferScanner::count(const char *data, size_t size, char byte)
+{
+  return kernels().d_count(data, size, byte);
+}
+
+BufferScanner::Isa BufferScanner::isa()
+{
+  return kernels().d_isa;
+}
+
+bool BufferScanner::setIsa(Isa isa)
+{
+  const Kernels *kernels = kernelsFor(isa);
+  if (!kernels) {
+    return false;
+  }
+
+  s_kernels.store(kernels, std::memory_order_relaxed);
+  return true;
+}
+
+bool BufferScanner::isSupported(Isa isa)
+{
+  return nullptr != kernelsFor(isa);
+}
+
+// MANIPULATORS
+
+bool BufferScanner::nextLine(ConstBuffer *line)
+{
+  if (!nextToken('\n', line)) {
+    return false;
+  }
+
+  if (0 < line->size() && '\r' == line->buffer()[line->size() - 1]) {
+    *line = ConstBuffer(line->buffer(), line->size() - 1);
+  }
+  return true;
+}
+
+bool BufferScanner::nextToken(char delimiter, ConstBuffer *token)
+{
+  if (atEnd()) {
+    return false;
+  }
+
+  const size_t size = find(d_current, remainingSize(), delimiter);
+  *token            = ConstBuffer(d_current, size);
+  d_current += size < remainingSize() ? size + 1 : size;
+  return true;
+}
+
+bool BufferScanner::nextToken(const ByteSet &delimiters, ConstBuffer *token)
+{
+  if (atEnd()) {
+    return false;
+  }
+
+  const size_t size = findAny(d_current, remainingSize(), delimiters);
+  *token            = ConstBuffer(d_current, size);
+  d_current += size < remainingSize() ? size + 1 : size;
+  return true;
+}
+
+} // namespace mdio
+} // namespace MvdS
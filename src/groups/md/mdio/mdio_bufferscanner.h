@@ -0,0 +1,210 @@
+// mdio_bufferscanner.h                                                 -*-c++-*-
+#ifndef __INCLUDED_MDIO_BUFFERSCANNER
+#define __INCLUDED_MDIO_BUFFERSCANNER
+
+#include <mdio_buffer.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MvdS {
+namespace mdio {
+
+// ===================
+// Class BufferScanner
+// ===================
+
+class BufferScanner
+{
+  // Provides tokenization of a 'ConstBuffer' without copying.
+  //
+  // The scanner walks a buffer from the front and returns lines and
+  // delimiter separated tokens as 'ConstBuffer's that point into the
+  // scanned buffer, which must outlive them. Delimiters are located with
+  // vectorized kernels that test 16 (SSE2) or 32 (AVX2) bytes per
+  // instruction. The best kernel supported by the CPU is selected at run
+  // time, with a scalar fallback on other platforms. The class methods
+  // 'find', 'findAny' and 'count' give direct access to the kernels.
+
+public:
+  // PUBLIC TYPES
+
+  enum Isa
+  {
+    e_scalar, // Portable byte loop.
+    e_sse2,   // 16 byte vectors.
+    e_avx2    // 32 byte vectors.
+  };
+
+  class ByteSet
+  {
+    // Set of delimiter bytes. Sets of up to 'k_maximumVectorSize' bytes are
+    // matched with the vectorized kernels, larger sets with a lookup table.
+
+  public:
+    enum
+    {
+      k_maximumVectorSize = 16
+    };
+
+  private:
+    uint64_t      d_table[4];                  // Bitmap of all bytes.
+    unsigned char d_bytes[k_maximumVectorSize]; // Members, if few enough.
+    size_t        d_size;                      // Number of members.
+
+  public:
+    // CREATORS
+
+    ByteSet()
+        // Create an empty set.
+        : d_table()
+        , d_bytes()
+        , d_size(0)
+    {}
+
+    explicit ByteSet(const char *bytes);
+    // Create a set of the bytes of the specified null-terminated 'bytes'.
+
+    ByteSet(const char *bytes, size_t size);
+    // Create a set of the specified 'size' bytes at the specified 'bytes'.
+
+    // MANIPULATORS
+
+    void insert(char byte);
+    // Add the specified 'byte' to the set.
+
+    // ACCESSORS
+
+    bool contains(char byte) const
+    // Return true if the specified 'byte' is a member.
+    {
+      const unsigned char value = static_cast<unsigned char>(byte);
+      return 0 != (d_table[value >> 6] & (uint64_t(1) << (value & 63)));
+    }
+
+    size_t size() const
+    // Return the number of members.
+    {
+      return d_size;
+    }
+
+    const unsigned char *bytes() const
+    // Return the members, or null if there are more than
+    // 'k_maximumVectorSize'.
+    {
+      return d_size <= k_maximumVectorSize ? d_bytes : nullptr;
+    }
+  };
+
+private:
+  // DATA
+
+  const char *d_begin;
+  const char *d_current;
+  const char *d_end;
+
+public:
+  // CLASS METHODS
+
+  static size_t find(const char *data, size_t size, char byte);
+  // Return the offset of the first occurrence of the specified 'byte' in
+  // the specified 'size' bytes at the specified 'data', or 'size' if there
+  // is none.
+
+  static size_t findAny(const char *data, size_t size, const ByteSet &set);
+  // Return the offset of the first byte in the specified 'size' bytes at
+  // the specified 'data' that is a member of the specified 'set', or 'size'
+  // if there is none.
+
+  static size_t count(const char *data, size_t size, char byte);
+  // Return the number of occurrences of the specified 'byte' in the
+  // specified 'size' bytes at the specified 'data'.
+
+  static Isa isa();
+  // Return the instruction set of the kernels in use.
+
+  static bool setIsa(Isa isa);
+  // Use the kernels for the specified 'isa' from now on. Return false,
+  // keeping the current kernels, if the CPU does not support 'isa'.
+
+  static bool isSupported(Isa isa);
+  // Return true if the CPU supports the specified 'isa'.
+
+  // CREATORS
+
+  explicit BufferScanner(const ConstBuffer &buffer)
+      // Create a scanner positioned at the start of the specified 'buffer'.
+      : d_begin(buffer.buffer())
+      , d_current(buffer.buffer())
+      , d_end(buffer.buffer() + buffer.size())
+  {}
+
+  BufferScanner(const char *buffer, size_t size)
+      // Create a scanner positioned at the start of the specified 'buffer'
+      // with the specified 'size'.
+      : d_begin(buffer)
+      , d_current(buffer)
+      , d_end(buffer + size)
+  {}
+
+  // MANIPULATORS
+
+  bool nextLine(ConstBuffer *line);
+  // Load into the specified 'line' the bytes up to the next '\n', or up to
+  // the end of the buffer for an unterminated last line, and move past the
+  // terminator. A '\r' before the '\n' is removed as well. Return false if
+  // the end has been reached.
+
+  bool nextToken(char delimiter, ConstBuffer *token);
+  // Load into the specified 'token' the bytes up to the next specified
+  // 'delimiter', or up to the end of the buffer, and move past the
+  // delimiter. Return false if the end has been reached.
+
+  bool nextToken(const ByteSet &delimiters, ConstBuffer *token);
+  // Load into the specified 'token' the bytes up to the next member of the
+  // specified 'delimiters', or up to the end of the buffer, and move past
+  // the delimiter. Return false if the end has been reached.
+
+  void skip(size_t count)
+  // Move forward by up to the specified 'count' bytes.
+  {
+    d_current += count < remainingSize() ? count : remainingSize();
+  }
+
+  void reset()
+  // Move back to the start of the buffer.
+  {
+    d_current = d_begin;
+  }
+
+  // ACCESSORS
+
+  bool atEnd() const
+  // Return true if all bytes have been scanned.
+  {
+    return d_current == d_end;
+  }
+
+  size_t position() const
+  // Return the offset of the next byte to scan.
+  {
+    return d_current - d_begin;
+  }
+
+  size_t remainingSize() const
+  // Return the number of bytes not yet scanned.
+  {
+    return d_end - d_current;
+  }
+
+  ConstBuffer remaining() const
+  // Return the bytes not yet scanned.
+  {
+    return ConstBuffer(d_current, d_end - d_current);
+  }
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_BUFFERSCANNER
@@ -0,0 +1,196 @@
+// mdio_bufferscanner.t.cpp                                             -*-c++-*-
+#include <mdio_bufferscanner.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+typedef BufferScanner Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+// Counted before 'main', possibly before the component is initialized.
+const size_t g_staticCount = Obj::count("a,b,c", 5, ',');
+
+std::string str(const ConstBuffer& buffer)
+{
+  return std::string(buffer.buffer(), buffer.size());
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  const Obj::Isa isas[] = {Obj::e_scalar, Obj::e_sse2, Obj::e_avx2};
+  const Obj::Isa best   = Obj::isa();
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 4:
+    {
+      // Throughput of line counting and splitting.
+      std::string data;
+      while (data.size() < (64 << 20)) {
+	data += "2024-01-01T00:00:00.000 INFO some log message with a payload\n";
+      }
+
+      for (Obj::Isa isa : isas) {
+	if (!Obj::setIsa(isa)) {
+	  continue;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	size_t      lines = 0;
+	Obj         scanner(data.data(), data.size());
+	ConstBuffer line(0, 0);
+	while (scanner.nextLine(&line)) {
+	  ++lines;
+	}
+
+	const double seconds = std::chrono::duration<double>(
+	    std::chrono::steady_clock::now() - start).count();
+
+	ASSERT(Obj::count(data.data(), data.size(), '\n') == lines);
+	if (verbose) {
+	  cerr << "isa " << isa << ": " << data.size() / seconds / 1e9
+	       << " GB/s" << endl;
+	}
+      }
+
+      Obj::setIsa(best);
+    } break;
+
+  case 3:
+    {
+      // All kernels agree with a reference implementation.
+      std::mt19937 random(3);
+
+      const Obj::ByteSet small(",;\t");
+      Obj::ByteSet       large;
+      for (int c = 'a'; c <= 'z'; ++c) {
+	large.insert(static_cast<char>(c));
+      }
+      ASSERT(3 == small.size());
+      ASSERT(nullptr != small.bytes());
+      ASSERT(26 == large.size());
+      ASSERT(nullptr == large.bytes());
+
+      for (size_t iteration = 0; iteration < 2000; ++iteration) {
+	std::string data(random() % 200, '\0');
+	for (char& c : data) {
+	  // Mostly uninteresting bytes, including ones with the top bit set.
+	  c = static_cast<char>(0 == random() % 40 ? ",;\tx"[random() % 4]
+			                           : 0x80 + random() % 64);
+	}
+
+	const size_t offset = random() % (data.size() + 1);
+	const char  *p      = data.data() + offset;
+	const size_t n      = data.size() - offset;
+
+	const size_t expectedFind  = std::min(data.find(',', offset), data.size()) - offset;
+	const size_t expectedSmall = std::min(data.find_first_of(",;\t", offset), data.size()) - offset;
+	const size_t expectedLarge = std::min(data.find_first_of("abcdefghijklmnopqrstuvwxyz", offset), data.size()) - offset;
+	const size_t expectedCount = std::count(data.begin() + offset, data.end(), ';');
+
+	for (Obj::Isa isa : isas) {
+	  if (!Obj::setIsa(isa)) {
+	    continue;
+	  }
+	  ASSERT(isa == Obj::isa());
+	  ASSERT(expectedFind == Obj::find(p, n, ','));
+	  ASSERT(expectedSmall == Obj::findAny(p, n, small));
+	  ASSERT(expectedLarge == Obj::findAny(p, n, large));
+	  ASSERT(expectedCount == Obj::count(p, n, ';'));
+	}
+      }
+
+      Obj::setIsa(best);
+    } break;
+
+  case 2:
+    {
+      // Tokens.
+      const std::string data = "a,b;;c\td,";
+      Obj               scanner(data.data(), data.size());
+      ConstBuffer       token(0, 0);
+
+      ASSERT(scanner.nextToken(',', &token));
+      ASSERT("a" == str(token));
+      ASSERT(2 == scanner.position());
+
+      const Obj::ByteSet delimiters(";\t");
+      ASSERT(scanner.nextToken(delimiters, &token));
+      ASSERT("b" == str(token));
+      ASSERT(scanner.nextToken(delimiters, &token));
+      ASSERT("" == str(token));
+      ASSERT(scanner.nextToken(delimiters, &token));
+      ASSERT("c" == str(token));
+      ASSERT(scanner.nextToken(delimiters, &token));
+      ASSERT("d," == str(token));
+      ASSERT(scanner.atEnd());
+      ASSERT(!scanner.nextToken(',', &token));
+
+      scanner.reset();
+      scanner.skip(4);
+      ASSERT(";c\td," == str(scanner.remaining()));
+      scanner.skip(100);
+      ASSERT(scanner.atEnd());
+    } break;
+
+  case 1:
+    {
+      // Breathing test: lines point into the buffer.
+      const std::string data = "first\nsecond\r\n\nlast";
+      Obj               scanner(ConstBuffer(data.data(), data.size()));
+      ConstBuffer       line(0, 0);
+
+      ASSERT(2 == g_staticCount);
+      ASSERT(Obj::isSupported(Obj::e_scalar));
+      ASSERT(Obj::isSupported(Obj::isa()));
+
+      ASSERT(scanner.nextLine(&line));
+      ASSERT("first" == str(line));
+      ASSERT(data.data() == line.buffer());
+      ASSERT(scanner.nextLine(&line));
+      ASSERT("second" == str(line));
+      ASSERT(scanner.nextLine(&line));
+      ASSERT("" == str(line));
+      ASSERT(scanner.nextLine(&line));
+      ASSERT("last" == str(line));
+      ASSERT(data.data() + 15 == line.buffer());
+      ASSERT(!scanner.nextLine(&line));
+      ASSERT(data.size() == scanner.position());
+      ASSERT(0 == scanner.remainingSize());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
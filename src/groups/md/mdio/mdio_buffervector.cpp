@@ -0,0 +1,293 @@
+// mdio_buffervector.cpp                                                -*-c++-*-
+#include <mdio_buffervector.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace MvdS {
+namespace mdio {
+
+// ------------------
+// Class BufferVector
+// ------------------
+
+// PRIVATE MANIPULATORS
+
+Buffer BufferVector::newBuffer()
+{
+  return Buffer(static_cast<char *>(d_allocator_p->allocate(d_bufferSize)),
+                d_bufferSize,
+                d_allocator_p);
+}
+
+void BufferVector::advanceTail()
+{
+  if (d_buffers.empty()) {
+    d_buffers.push_back(newBuffer());
+    d_tail  = 0;
+    d_begin = 0;
+    d_end   = 0;
+    return;
+  }
+
+  if (d_tail + 1 == d_buffers.size()) {
+    d_buffers.push_back(newBuffer());
+  }
+
+  ++d_tail;
+  d_end = 0;
+}
+
+// CREATORS
+
+BufferVector::BufferVector(size_t bufferSize, mdmem::Allocator *allocator)
+    : d_bufferSize(bufferSize)
+    , d_buffers(mdmem::AllocatorUtil::defaultAllocator(allocator))
+    , d_begin(0)
+    , d_tail(0)
+    , d_end(0)
+    , d_size(0)
+    , d_allocator_p(mdmem::AllocatorUtil::defaultAllocator(allocator))
+{}
+
+BufferVector::BufferVector(BufferVector &&other)
+    : d_bufferSize(other.d_bufferSize)
+    , d_buffers(std::move(other.d_buffers))
+    , d_begin(other.d_begin)
+    , d_tail(other.d_tail)
+    , d_end(other.d_end)
+    , d_size(other.d_size)
+    , d_allocator_p(other.d_allocator_p)
+{
+  other.d_buffers.clear();
+  other.d_begin = 0;
+  other.d_tail  = 0;
+  other.d_end   = 0;
+  other.d_size  = 0;
+}
+
+BufferVector::~BufferVector() {}
+
+// MANIPULATORS
+
+void BufferVector::append(const char *data, size_t size)
+{
+  d_size += size;
+
+  while (0 < size) {
+    if (d_buffers.empty() || d_bufferSize == d_end) {
+      advanceTail();
+    }
+
+    const size_t count = std::min(size, d_bufferSize - d_end);
+    memcpy(d_buffers[d_tail].buffer() + d_end, data, count);
+
+    d_end += count;
+    data += count;
+    size -= count;
+  }
+}
+
+void BufferVector::prepend(const char *data, size_t size)
+{
+  if (d_buffers.empty()) {
+    d_buffers.push_back(newBuffer());
+  }
+
+  if (0 == d_size) {
+    // Start at the end of the first buffer to leave room for the prefix.
+    d_tail  = 0;
+    d_begin = d_bufferSize;
+    d_end   = d_bufferSize;
+  }
+
+  d_size += size;
+
+  while (0 < size) {
+    if (0 == d_begin) {
+      d_buffers.push_front(newBuffer());
+      ++d_tail;
+      d_begin = d_bufferSize;
+    }
+
+    const size_t count = std::min(size, d_begin);
+    memcpy(d_buffers.front().buffer() + d_begin - count,
+           data + size - count,
+           count);
+
+    d_begin -= count;
+    size -= count;
+  }
+}
+
+void BufferVector::consume(size_t size)
+{
+  size = std::min(size, d_size);
+  d_size -= size;
+
+  size_t consumed = 0; // Number of fully consumed buffers.
+
+  while (0 < size) {
+    const size_t limit     = consumed == d_tail ? d_end : d_bufferSize;
+    const size_t available = limit - d_begin;
+
+    if (size < available) {
+      d_begin += size;
+      break;
+    }
+
+    size -= available;
+    d_begin = 0;
+
+    if (consumed == d_tail) {
+      d_end = 0;
+      break;
+    }
+
+    ++consumed;
+  }
+
+  if (0 < consumed) {
+    // Recycle the consumed buffers as spares at the back. Rotating keeps
+    // the nodes of the chain in place, unlike popping and pushing.
+    std::rotate(d_buffers.begin(), d_buffers.begin() + consumed, d_buffers.end());
+    d_tail -= consumed;
+  }
+
+  if (0 == d_size) {
+    d_tail  = 0;
+    d_begin = 0;
+    d_end   = 0;
+  }
+}
+
+void BufferVector::reserve(size_t size)
+{
+  if (d_buffers.empty()) {
+    advanceTail();
+  }
+
+  size_t writable = d_bufferSize - d_end +
+                    (d_buffers.size() - d_tail - 1) * d_bufferSize;
+
+  while (writable < size) {
+    d_buffers.push_back(newBuffer());
+    writable += d_bufferSize;
+  }
+}
+
+size_t
+BufferVector::writableIovecs(iovec *iovecs, size_t count, size_t size) const
+{
+  size_t n = 0;
+
+  for (size_t i = d_tail; i < d_buffers.size() && n < count && 0 < size; ++i) {
+    const size_t offset = i == d_tail ? d_end : 0;
+    const size_t length = std::min(size, d_bufferSize - offset);
+
+    if (0 == length) {
+      continue;
+    }
+
+    iovecs[n].iov_base = const_cast<char *>(d_buffers[i].buffer()) + offset;
+    iovecs[n].iov_len  = length;
+    ++n;
+    size -= length;
+  }
+
+  return n;
+}
+
+void BufferVector::commit(size_t size)
+{
+  d_size += size;
+
+  while (true) {
+    const size_t count = std::min(size, d_bufferSize - d_end);
+    d_end += count;
+    size -= count;
+
+    if (0 == size) {
+      return;
+    }
+
+    ++d_tail;
+    d_end = 0;
+  }
+}
+
+char *BufferVector::writableBuffer(size_t *size)
+{
+  if (d_buffers.empty() || d_bufferSize == d_end) {
+    advanceTail();
+  }
+
+  *size = d_bufferSize - d_end;
+  return d_buffers[d_tail].buffer() + d_end;
+}
+
+void BufferVector::clear()
+{
+  d_begin = 0;
+  d_tail  = 0;
+  d_end   = 0;
+  d_size  = 0;
+}
+
+void BufferVector::shrinkToFit()
+{
+  if (0 == d_size) {
+    clear();
+    d_buffers.clear();
+    return;
+  }
+
+  d_buffers.erase(d_buffers.begin() + d_tail + 1, d_buffers.end());
+}
+
+// ACCESSORS
+
+size_t BufferVector::iovecs(iovec *iovecs, size_t count) const
+{
+  size_t n = 0;
+
+  if (0 == d_size) {
+    return n;
+  }
+
+  for (size_t i = 0; i <= d_tail && n < count; ++i) {
+    const size_t begin = 0 == i ? d_begin : 0;
+    const size_t end   = d_tail == i ? d_end : d_bufferSize;
+
+    if (begin == end) {
+      continue;
+    }
+
+    iovecs[n].iov_base = const_cast<char *>(d_buffers[i].buffer()) + begin;
+    iovecs[n].iov_len  = end - begin;
+    ++n;
+  }
+
+  return n;
+}
+
+size_t BufferVector::copyOut(char *destination, size_t size) const
+{
+  size = std::min(size, d_size);
+
+  size_t copied = 0;
+  for (size_t i = 0; copied < size; ++i) {
+    const size_t begin = 0 == i ? d_begin : 0;
+    const size_t end   = d_tail == i ? d_end : d_bufferSize;
+    const size_t count = std::min(size - copied, end - begin);
+
+    memcpy(destination + copied, d_buffers[i].buffer() + begin, count);
+    copied += count;
+  }
+
+  return copied;
+}
+
+} // namespace mdio
+} // namespace MvdS
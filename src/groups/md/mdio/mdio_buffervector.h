@@ -0,0 +1,201 @@
+// mdio_buffervector.h                                                  -*-c++-*-
+#ifndef __INCLUDED_MDIO_BUFFERVECTOR
+#define __INCLUDED_MDIO_BUFFERVECTOR
+
+#include <mdio_buffer.h>
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <cstddef>
+#include <deque>
+#include <experimental/memory_resource>
+
+#include <sys/uio.h>
+
+namespace MvdS {
+namespace mdio {
+
+// ==================
+// Class BufferVector
+// ==================
+
+class BufferVector
+{
+  // Provides a byte sequence stored in a chain of fixed-size buffers.
+  //
+  // Data is appended at the back and consumed from the front without ever
+  // moving bytes that are already stored: a buffer that fills up is
+  // followed by a new one, and fully consumed buffers are recycled at the
+  // back of the chain for later appends. Headroom in front of the data can
+  // be used to 'prepend' headers once the payload size is known. The
+  // stored data and the free space after it can be exported as 'iovec'
+  // arrays for scatter-gather I/O, see 'BufferVectorUtil'.
+  //
+  // Buffers are allocated with 'bufferSize()' bytes from the allocator of
+  // the vector, so a 'mdmem::FixedBufferPoolAllocator' with the same buffer
+  // size serves them from a pool.
+
+public:
+  // PUBLIC TYPES
+
+  typedef std::deque<Buffer, std::experimental::pmr::polymorphic_allocator<Buffer>>
+      Chain;
+
+private:
+  // DATA
+
+  size_t            d_bufferSize; // Capacity of every buffer.
+  Chain             d_buffers;    // Data buffers followed by spare buffers.
+  size_t            d_begin;      // Offset of the data in the first buffer.
+  size_t            d_tail;       // Index of the buffer with the data end.
+  size_t            d_end;        // Offset of the data end in the tail.
+  size_t            d_size;       // Number of bytes stored.
+  mdmem::Allocator *d_allocator_p;
+
+  // PRIVATE MANIPULATORS
+
+  Buffer newBuffer();
+  // Return a new buffer of 'd_bufferSize' bytes.
+
+  void advanceTail();
+  // Move the end of the data to the start of the next buffer, allocating
+  // one if there are no spare buffers.
+
+public:
+  BufferVector(const BufferVector &) = delete;
+  BufferVector &operator=(const BufferVector &) = delete;
+
+  // CREATORS
+
+  explicit BufferVector(size_t bufferSize, mdmem::Allocator *allocator = 0);
+  // Create an empty vector of buffers with the specified 'bufferSize'.
+  // Optionally the specified 'allocator' is used for memory allocation.
+
+  BufferVector(BufferVector &&other);
+  // Take over the buffers of the specified 'other' vector, leaving 'other'
+  // empty.
+
+  ~BufferVector();
+
+  // MANIPULATORS
+
+  void append(const char *data, size_t size);
+  // Append a copy of the specified 'data' with the specified 'size'.
+
+  void append(const ConstBuffer &buffer)
+  // Append a copy of the specified 'buffer'.
+  {
+    append(buffer.buffer(), buffer.size());
+  }
+
+  void prepend(const char *data, size_t size);
+  // Insert a copy of the specified 'data' with the specified 'size' in
+  // front of the stored data.
+
+  void consume(size_t size);
+  // Remove up to the specified 'size' bytes from the front.
+
+  void reserve(size_t size);
+  // Make sure at least the specified 'size' bytes can be written after
+  // the data without allocating.
+
+  size_t writableIovecs(iovec *iovecs, size_t count, size_t size) const;
+  // Load into the specified 'iovecs', holding up to the specified 'count'
+  // entries, the free space after the data, up to the specified 'size'
+  // bytes. Return the number of entries loaded. Call 'reserve' first to
+  // make room.
+
+  void commit(size_t size);
+  // Add the specified 'size' bytes, written to the space returned by
+  // 'writableIovecs', to the data. Behavior is undefined unless that space
+  // is at least 'size' bytes.
+
+  char *writableBuffer(size_t *size);
+  // Return the free space after the data in the tail buffer and load its
+  // size into the specified 'size', allocating a buffer if the tail is
+  // full. The returned size is never 0. Use 'commit' to add written bytes.
+
+  void clear();
+  // Remove all data, keeping the buffers for reuse.
+
+  void shrinkToFit();
+  // Free all spare buffers.
+
+  // ACCESSORS
+
+  size_t iovecs(iovec *iovecs, size_t count) const;
+  // Load into the specified 'iovecs', holding up to the specified 'count'
+  // entries, the stored data from the front. Return the number of entries
+  // loaded.
+
+  size_t copyOut(char *destination, size_t size) const;
+  // Copy up to the specified 'size' bytes from the front to the specified
+  // 'destination'. Return the number of bytes copied.
+
+  template <class VISITOR>
+  void forEachSegment(VISITOR &&visitor) const;
+  // Invoke the specified 'visitor' as 'visitor(const char *data, size_t
+  // size)' for every contiguous range of the stored data, front to back.
+
+  size_t size() const
+  // Return the number of bytes stored.
+  {
+    return d_size;
+  }
+
+  bool empty() const
+  // Return true if no bytes are stored.
+  {
+    return 0 == d_size;
+  }
+
+  size_t bufferSize() const
+  // Return the capacity of every buffer.
+  {
+    return d_bufferSize;
+  }
+
+  size_t bufferCount() const
+  // Return the number of allocated buffers, including spare buffers.
+  {
+    return d_buffers.size();
+  }
+
+  mdmem::Allocator *allocator() const
+  // Return the allocator used by this vector.
+  {
+    return d_allocator_p;
+  }
+};
+
+// ============================================================================
+//                            INLINE DEFINITIONS
+// ============================================================================
+
+// ------------------
+// Class BufferVector
+// ------------------
+
+// ACCESSORS
+
+template <class VISITOR>
+void BufferVector::forEachSegment(VISITOR &&visitor) const
+{
+  if (0 == d_size) {
+    return;
+  }
+
+  for (size_t i = 0; i <= d_tail; ++i) {
+    const size_t begin = 0 == i ? d_begin : 0;
+    const size_t end   = d_tail == i ? d_end : d_bufferSize;
+
+    if (begin != end) {
+      visitor(d_buffers[i].buffer() + begin, end - begin);
+    }
+  }
+}
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_BUFFERVECTOR
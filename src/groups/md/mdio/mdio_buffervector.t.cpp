@@ -0,0 +1,253 @@
+// mdio_buffervector.t.cpp                                              -*-c++-*-
+#include <mdio_buffervector.h>
+
+#include <mdmem_fixedbufferpoolallocator.h>
+#include <mdmem_testallocator.h>
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+std::string str(const BufferVector& buffers)
+{
+  std::string result(buffers.size(), '\0');
+  buffers.copyOut(&result[0], result.size());
+  return result;
+}
+
+std::string str(const iovec *iovecs, size_t count)
+{
+  std::string result;
+  for (size_t i = 0; i < count; ++i) {
+    result.append(static_cast<const char *>(iovecs[i].iov_base), iovecs[i].iov_len);
+  }
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 6:
+    {
+      // Segments are visited front to back, skipping consumed bytes.
+      BufferVector bv(4);
+      bv.append("0123456789", 10);
+      bv.consume(5);
+
+      std::string visited;
+      size_t      segments = 0;
+      bv.forEachSegment([&](const char *data, size_t size) {
+	  visited.append(data, size);
+	  ++segments;
+	});
+      ASSERT("56789" == visited);
+      ASSERT(2 == segments);
+
+      bv.clear();
+      bv.forEachSegment([&](const char *, size_t) { ++segments; });
+      ASSERT(2 == segments);
+    } break;
+
+  case 5:
+    {
+      // Buffers can come from a fixed buffer pool and are reused.
+      mdmem::TestAllocator ta;
+
+      {
+	mdmem::FixedBufferPoolAllocator pool(4, 8, alignof(std::max_align_t), &ta);
+	BufferVector bv(8, &pool);
+
+	// Warm up the pool and the chain.
+	bv.append("0123456789", 10);
+	bv.consume(10);
+	const size_t allocations = ta.allocationCount();
+
+	for (int i = 0; i < 100; ++i) {
+	  bv.append("0123456789", 10);
+	  bv.consume(10);
+	}
+
+	ASSERT(allocations == ta.allocationCount());
+	ASSERT(0 == bv.size());
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 4:
+    {
+      // Free space can be written in place and committed.
+      mdmem::TestAllocator ta;
+
+      {
+	BufferVector bv(4, &ta);
+	bv.append("ab", 2);
+	bv.reserve(7);
+	ASSERT(3 == bv.bufferCount());
+
+	iovec  iov[8];
+	size_t n = bv.writableIovecs(iov, 8, 7);
+	ASSERT(3 == n);
+	ASSERT(2 == iov[0].iov_len);
+	ASSERT(4 == iov[1].iov_len);
+	ASSERT(1 == iov[2].iov_len);
+
+	const char *text = "cdefghi";
+	size_t      offset = 0;
+	for (size_t i = 0; i < n; ++i) {
+	  memcpy(iov[i].iov_base, text + offset, iov[i].iov_len);
+	  offset += iov[i].iov_len;
+	}
+	bv.commit(7);
+	ASSERT("abcdefghi" == str(bv));
+
+	size_t size;
+	char  *p = bv.writableBuffer(&size);
+	ASSERT(3 == size);
+	*p = 'j';
+	bv.commit(1);
+	ASSERT("abcdefghij" == str(bv));
+	ASSERT(3 == bv.bufferCount());
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 3:
+    {
+      // Prepend uses headroom and adds buffers in front as needed.
+      mdmem::TestAllocator ta;
+
+      {
+	BufferVector bv(4, &ta);
+	bv.prepend("body", 4);
+	ASSERT("body" == str(bv));
+
+	bv.prepend("header:", 7);
+	ASSERT("header:body" == str(bv));
+	ASSERT(3 == bv.bufferCount());
+
+	bv.append("!", 1);
+	ASSERT("header:body!" == str(bv));
+
+	bv.consume(7);
+	bv.prepend("H:", 2);
+	ASSERT("H:body!" == str(bv));
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 2:
+    {
+      // Consumed buffers are recycled and iovecs cover the data.
+      mdmem::TestAllocator ta;
+
+      {
+	BufferVector bv(4, &ta);
+	bv.append("0123456789", 10);
+	ASSERT(3 == bv.bufferCount());
+
+	iovec iov[8];
+	ASSERT(3 == bv.iovecs(iov, 8));
+	ASSERT("0123456789" == str(iov, 3));
+	ASSERT(2 == bv.iovecs(iov, 2));
+	ASSERT("01234567" == str(iov, 2));
+
+	bv.consume(5);
+	ASSERT("56789" == str(bv));
+	ASSERT(2 == bv.iovecs(iov, 8));
+	ASSERT("567" == str(iov, 1));
+
+	const size_t allocations = ta.allocationCount();
+	bv.append("abcdef", 6);
+	ASSERT("56789abcdef" == str(bv));
+	ASSERT(allocations == ta.allocationCount());
+
+	bv.consume(100);
+	ASSERT(bv.empty());
+	ASSERT(0 == bv.iovecs(iov, 8));
+	ASSERT(3 == bv.bufferCount());
+
+	const size_t deallocations = ta.deallocationCount();
+	bv.shrinkToFit();
+	ASSERT(0 == bv.bufferCount());
+	ASSERT(deallocations + 3 == ta.deallocationCount());
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 1:
+    {
+      // Appending spans buffers without moving stored bytes.
+      mdmem::TestAllocator ta;
+
+      {
+	BufferVector bv(8, &ta);
+	ASSERT(bv.empty());
+	ASSERT(8 == bv.bufferSize());
+	ASSERT(0 == bv.bufferCount());
+
+	bv.append("hello", 5);
+	ASSERT(1 == bv.bufferCount());
+
+	iovec iov[4];
+	bv.iovecs(iov, 4);
+	const void *first = iov[0].iov_base;
+
+	bv.append(ConstBuffer(" world", 6));
+	ASSERT(11 == bv.size());
+	ASSERT(2 == bv.bufferCount());
+	ASSERT("hello world" == str(bv));
+
+	bv.iovecs(iov, 4);
+	ASSERT(first == iov[0].iov_base);
+
+	char out[4];
+	ASSERT(4 == bv.copyOut(out, 4));
+	ASSERT("hell" == std::string(out, 4));
+
+	BufferVector moved(std::move(bv));
+	ASSERT("hello world" == str(moved));
+	ASSERT(bv.empty());
+	ASSERT(0 == bv.bufferCount());
+
+	bv.append("x", 1);
+	ASSERT("x" == str(bv));
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,62 @@
+// mdio_buffervectorutil.cpp                                            -*-c++-*-
+#include <mdio_buffervectorutil.h>
+
+#include <cerrno>
+
+#include <sys/uio.h>
+
+namespace MvdS {
+namespace mdio {
+
+// -----------------------
+// Struct BufferVectorUtil
+// -----------------------
+
+// CLASS METHODS
+
+ssize_t BufferVectorUtil::writev(int fd, BufferVector *buffers)
+{
+  iovec        iovecs[k_maximumIovecs];
+  const size_t count = buffers->iovecs(iovecs, k_maximumIovecs);
+
+  if (0 == count) {
+    return 0;
+  }
+
+  ssize_t rc;
+  do {
+    rc = ::writev(fd, iovecs, static_cast<int>(count));
+  } while (-1 == rc && EINTR == errno);
+
+  if (0 < rc) {
+    buffers->consume(rc);
+  }
+
+  return rc;
+}
+
+ssize_t BufferVectorUtil::readv(int fd, BufferVector *buffers, size_t size)
+{
+  buffers->reserve(size);
+
+  iovec        iovecs[k_maximumIovecs];
+  const size_t count = buffers->writableIovecs(iovecs, k_maximumIovecs, size);
+
+  if (0 == count) {
+    return 0;
+  }
+
+  ssize_t rc;
+  do {
+    rc = ::readv(fd, iovecs, static_cast<int>(count));
+  } while (-1 == rc && EINTR == errno);
+
+  if (0 < rc) {
+    buffers->commit(rc);
+  }
+
+  return rc;
+}
+
+} // namespace mdio
+} // namespace MvdS
@@ -0,0 +1,47 @@
+// mdio_buffervectorutil.h                                              -*-c++-*-
+#ifndef __INCLUDED_MDIO_BUFFERVECTORUTIL
+#define __INCLUDED_MDIO_BUFFERVECTORUTIL
+
+#include <mdio_buffervector.h>
+
+#include <cstddef>
+
+#include <sys/types.h>
+
+namespace MvdS {
+namespace mdio {
+
+// =======================
+// Struct BufferVectorUtil
+// =======================
+
+struct BufferVectorUtil
+{
+  // Provides scatter-gather I/O of a 'BufferVector' to and from file
+  // descriptors. Every call issues a single 'writev' or 'readv' covering
+  // up to 'k_maximumIovecs' buffers, retried only when interrupted.
+
+  // PUBLIC CONSTANTS
+
+  enum
+  {
+    k_maximumIovecs = 64 // Buffers transferred per call.
+  };
+
+  // CLASS METHODS
+
+  static ssize_t writev(int fd, BufferVector *buffers);
+  // Write the data of the specified 'buffers' to the specified 'fd' and
+  // consume the bytes written. Return the number of bytes written, or -1
+  // with 'errno' set on error.
+
+  static ssize_t readv(int fd, BufferVector *buffers, size_t size);
+  // Read up to the specified 'size' bytes from the specified 'fd' and
+  // append them to the specified 'buffers'. Return the number of bytes
+  // read, 0 on end of file, or -1 with 'errno' set on error.
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_BUFFERVECTORUTIL
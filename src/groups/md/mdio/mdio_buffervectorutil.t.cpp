@@ -0,0 +1,93 @@
+// mdio_buffervectorutil.t.cpp                                          -*-c++-*-
+#include <mdio_buffervectorutil.h>
+
+#include <mdmem_testallocator.h>
+
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+std::string str(const BufferVector& buffers)
+{
+  std::string result(buffers.size(), '\0');
+  buffers.copyOut(&result[0], result.size());
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 1:
+    {
+      // A chain is written and read back through a pipe in single calls.
+      mdmem::TestAllocator ta;
+
+      {
+	int fds[2];
+	ASSERT(0 == pipe(fds));
+
+	BufferVector out(16, &ta);
+	std::string  expected;
+	for (int i = 0; i < 20; ++i) {
+	  const std::string fragment = "fragment " + std::to_string(i) + ";";
+	  out.append(fragment.data(), fragment.size());
+	  expected += fragment;
+	}
+	ASSERT(1 < out.bufferCount());
+
+	ASSERT(ssize_t(expected.size()) == BufferVectorUtil::writev(fds[1], &out));
+	ASSERT(out.empty());
+	ASSERT(0 == BufferVectorUtil::writev(fds[1], &out));
+	close(fds[1]);
+
+	BufferVector in(16, &ta);
+	in.append("<", 1);
+	ASSERT(10 == BufferVectorUtil::readv(fds[0], &in, 10));
+	ASSERT("<fragment 0" == str(in));
+
+	ssize_t rc;
+	while (0 < (rc = BufferVectorUtil::readv(fds[0], &in, 100))) {
+	}
+	ASSERT(0 == rc);
+	ASSERT("<" + expected == str(in));
+	close(fds[0]);
+
+	ASSERT(-1 == BufferVectorUtil::readv(fds[0], &in, 10));
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,366 @@
+// mdio_chunkedfilereader.cpp                                           -*-c++-*-
+#include <mdio_chunkedfilereader.h>
+
+#include <mdio_bufferscanner.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <experimental/memory_resource>
+#include <experimental/vector>
+#include <mutex>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MvdS {
+namespace mdio {
+
+// -----------------------------
+// Struct ChunkedFileReader_Slot
+// -----------------------------
+
+struct ChunkedFileReader_Slot
+{
+  // State of a chunk that has been started and not yet completed.
+
+  ChunkedFileReader::Chunk d_chunk;
+  Buffer                   d_buffer; // Data of the chunk in 'e_read' mode.
+  int                      d_error = 0;
+  bool                     d_done  = false;
+};
+
+// ------------------------------
+// Struct ChunkedFileReader_State
+// ------------------------------
+
+struct ChunkedFileReader_State
+{
+  // State of one 'read' call shared with the chunk jobs.
+
+  int                                         d_fd;
+  size_t                                      d_fileSize;
+  const MappedFile *                          d_mapping_p; // Null in 'e_read'.
+  const ChunkedFileReader::Callback *         d_process_p;
+  bool                                        d_keepData; // For 'complete'.
+  std::mutex                                  d_mutex;
+  std::condition_variable                     d_condition;
+  std::experimental::pmr::vector<ChunkedFileReader_Slot> d_slots;
+
+  ChunkedFileReader_State(size_t slotCount, mdmem::Allocator *allocator)
+      : d_slots(slotCount, allocator)
+  {}
+};
+
+namespace {
+
+class Window
+{
+  // Provides the bytes of a file from an offset on, either from a mapping
+  // or read on demand into a growing buffer.
+
+  const char *      d_data;
+  size_t            d_base;     // File offset of 'd_data'.
+  size_t            d_filled;   // Bytes available at 'd_data'.
+  size_t            d_fileSize;
+  int               d_fd;
+  Buffer            d_buffer;
+  mdmem::Allocator *d_allocator_p;
+
+public:
+  Window(const MappedFile &mapping)
+      : d_data(mapping.buffer())
+      , d_base(0)
+      , d_filled(mapping.size())
+      , d_fileSize(mapping.size())
+      , d_fd(-1)
+      , d_allocator_p(nullptr)
+  {}
+
+  Window(int fd, size_t fileSize, size_t base, mdmem::Allocator *allocator)
+      : d_data(nullptr)
+      , d_base(base)
+      , d_filled(0)
+      , d_fileSize(fileSize)
+      , d_fd(fd)
+      , d_buffer(allocator)
+      , d_allocator_p(allocator)
+  {}
+
+  int ensure(size_t end)
+  // Make the bytes up to the specified 'end' file offset, or up to the end
+  // of the file, available. Return 0 on success or a negative 'errno'
+  // value.
+  {
+    end = std::min(end, d_fileSize);
+    if (end <= d_base + d_filled) {
+      return 0;
+    }
+
+    if (d_buffer.size() < end - d_base) {
+      const size_t capacity = std::max(end - d_base, 2 * d_buffer.size());
+      Buffer       buffer(static_cast<char *>(d_allocator_p->allocate(capacity)),
+                    capacity,
+                    d_allocator_p);
+      memcpy(buffer.buffer(), d_buffer.buffer(), d_filled);
+      d_buffer = std::move(buffer);
+      d_data   = d_buffer.buffer();
+    }
+
+    while (d_base + d_filled < end) {
+      const ssize_t result = pread(d_fd,
+                                   d_buffer.buffer() + d_filled,
+                                   end - d_base - d_filled,
+                                   static_cast<off_t>(d_base + d_filled));
+      if (result < 0) {
+        if (EINTR == errno) {
+          continue;
+        }
+        return -errno;
+      }
+      if (0 == result) {
+        // The file has been truncated since its size was taken.
+        d_fileSize = d_base + d_filled;
+        break;
+      }
+      d_filled += static_cast<size_t>(result);
+    }
+    return 0;
+  }
+
+  int boundary(size_t nominal, char delimiter, size_t *result)
+  // Load into the specified 'result' the file offset just past the first
+  // specified 'delimiter' at or after the byte before the specified
+  // 'nominal' offset, 0 if 'nominal' is 0, or the file size if there is
+  // none. Return 0 on success or a negative 'errno' value.
+  {
+    if (0 == nominal || d_fileSize <= nominal) {
+      *result = std::min(nominal, d_fileSize);
+      return 0;
+    }
+
+    size_t from = nominal - 1;
+    while (true) {
+      const int error = ensure(from + 1);
+      if (0 != error) {
+        return error;
+      }
+
+      const size_t end = std::min(d_base + d_filled, d_fileSize);
+      if (end <= from) {
+        *result = d_fileSize;
+        return 0;
+      }
+
+      const size_t offset =
+          BufferScanner::find(at(from), end - from, delimiter);
+      if (offset < end - from) {
+        *result = from + offset + 1;
+        return 0;
+      }
+
+      // A record crosses the end of the window, read further.
+      from = end;
+      if (from < d_fileSize) {
+        const int error = ensure(from + std::max(d_filled, MappedFile::pageSize()));
+        if (0 != error) {
+          return error;
+        }
+      }
+    }
+  }
+
+  const char *at(size_t offset) const { return d_data + (offset - d_base); }
+
+  Buffer &buffer() { return d_buffer; }
+};
+
+} // namespace
+
+// -----------------------
+// Class ChunkedFileReader
+// -----------------------
+
+// PRIVATE MANIPULATORS
+
+void ChunkedFileReader::runChunk(ChunkedFileReader_State *state, size_t index)
+{
+  ChunkedFileReader_Slot &slot =
+      state->d_slots[index % state->d_slots.size()];
+
+  const size_t nominal    = index * d_config.d_chunkSize;
+  const size_t nominalEnd = std::min(nominal + d_config.d_chunkSize,
+                                     state->d_fileSize);
+
+  int error = 0;
+  {
+    // The window, and with it the data, is released before the chunk is
+    // marked done, unless it is kept for 'complete'.
+    Window window = state->d_mapping_p
+                        ? Window(*state->d_mapping_p)
+                        : Window(state->d_fd,
+                                 state->d_fileSize,
+                                 0 == nominal ? 0 : nominal - 1,
+                                 d_allocator_p);
+
+    // Read the chunk and a page of the next one in one call, which usually
+    // covers the end of its last record.
+    error = window.ensure(nominalEnd + MappedFile::pageSize());
+
+    size_t begin = 0;
+    size_t end   = 0;
+    if (0 == error) {
+      error = window.boundary(nominal, d_config.d_delimiter, &begin);
+    }
+    if (0 == error) {
+      if (nominalEnd <= begin) {
+        end = begin;
+      }
+      else {
+        error = window.boundary(nominalEnd, d_config.d_delimiter, &end);
+      }
+    }
+
+    if (0 == error && begin < end) {
+      slot.d_chunk.d_index  = index;
+      slot.d_chunk.d_offset = static_cast<off_t>(begin);
+      slot.d_chunk.d_data   = ConstBuffer(window.at(begin), end - begin);
+
+      (*state->d_process_p)(slot.d_chunk);
+
+      if (state->d_keepData) {
+        slot.d_buffer = std::move(window.buffer());
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lk(state->d_mutex);
+  slot.d_error = error;
+  slot.d_done  = true;
+  state->d_condition.notify_all();
+}
+
+// CREATORS
+
+ChunkedFileReader::ChunkedFileReader(Executor *        executor,
+                                     mdmem::Allocator *allocator)
+    : ChunkedFileReader(Configuration(), executor, allocator)
+{}
+
+ChunkedFileReader::ChunkedFileReader(const Configuration &config,
+                                     Executor *           executor,
+                                     mdmem::Allocator *   allocator)
+    : d_config(config)
+    , d_executor_p(executor)
+    , d_allocator_p(mdmem::AllocatorUtil::defaultAllocator(allocator))
+{
+  const size_t pageSize = MappedFile::pageSize();
+  d_config.d_chunkSize =
+      std::max<size_t>(1, (d_config.d_chunkSize + pageSize - 1) / pageSize) *
+      pageSize;
+  d_config.d_maximumInFlight = std::max<size_t>(1, d_config.d_maximumInFlight);
+}
+
+// MANIPULATORS
+
+int ChunkedFileReader::read(const char *    path,
+                            const Callback &process,
+                            const Callback &complete)
+{
+  const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -errno;
+  }
+
+  const int result = read(fd, process, complete);
+  ::close(fd);
+  return result;
+}
+
+int ChunkedFileReader::read(int             fd,
+                            const Callback &process,
+                            const Callback &complete)
+{
+  struct stat status;
+  if (0 != fstat(fd, &status)) {
+    return -errno;
+  }
+
+  MappedFile mapping(d_allocator_p);
+  size_t     fileSize = static_cast<size_t>(status.st_size);
+
+  if (e_map == d_config.d_mode) {
+    MappedFile::Configuration config;
+    config.d_advice = MappedFile::e_sequential;
+
+    const int error = mapping.open(fd, config);
+    if (0 != error) {
+      return error;
+    }
+    fileSize = mapping.size();
+  }
+  else {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+
+  ChunkedFileReader_State state(d_config.d_maximumInFlight, d_allocator_p);
+  state.d_fd        = fd;
+  state.d_fileSize  = fileSize;
+  state.d_mapping_p = e_map == d_config.d_mode ? &mapping : nullptr;
+  state.d_process_p = &process;
+  state.d_keepData  = static_cast<bool>(complete);
+
+  const size_t count     = (fileSize + d_config.d_chunkSize - 1) / d_config.d_chunkSize;
+  size_t       submitted = 0;
+  size_t       completed = 0;
+  int          error     = 0;
+
+  while (true) {
+    // Start chunks until the limit is reached. A slot is reused only after
+    // its previous chunk has been completed.
+    while (0 == error && submitted < count &&
+           submitted - completed < d_config.d_maximumInFlight) {
+      ChunkedFileReader_Slot &slot =
+          state.d_slots[submitted % state.d_slots.size()];
+      slot.d_chunk = Chunk();
+      slot.d_error = 0;
+      slot.d_done  = false;
+
+      const size_t index = submitted++;
+      if (!d_executor_p ||
+          !d_executor_p->execute([this, &state, index]() {
+            runChunk(&state, index);
+          })) {
+        runChunk(&state, index);
+      }
+    }
+
+    if (completed == submitted) {
+      break;
+    }
+
+    ChunkedFileReader_Slot &slot =
+        state.d_slots[completed % state.d_slots.size()];
+    {
+      std::unique_lock<std::mutex> lk(state.d_mutex);
+      state.d_condition.wait(lk, [&slot]() { return slot.d_done; });
+    }
+
+    if (0 == error) {
+      error = slot.d_error;
+    }
+    if (0 == error && complete && 0 < slot.d_chunk.d_data.size()) {
+      complete(slot.d_chunk);
+    }
+    slot.d_buffer = Buffer();
+    ++completed;
+  }
+
+  return error;
+}
+
+} // namespace mdio
+} // namespace MvdS
@@ -0,0 +1,139 @@
+// mdio_chunkedfilereader.h                                             -*-c++-*-
+#ifndef __INCLUDED_MDIO_CHUNKEDFILEREADER
+#define __INCLUDED_MDIO_CHUNKEDFILEREADER
+
+#include <mdio_buffer.h>
+#include <mdio_executor.h>
+#include <mdio_mappedfile.h>
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <cstddef>
+#include <functional>
+
+#include <sys/types.h>
+
+namespace MvdS {
+namespace mdio {
+
+struct ChunkedFileReader_State;
+
+// =======================
+// Class ChunkedFileReader
+// =======================
+
+class ChunkedFileReader
+{
+  // Provides a scan of a file in chunks that are processed concurrently.
+  //
+  // The file is divided at multiples of the chunk size, and each division
+  // point is moved forward to just past the next record delimiter, so every
+  // chunk holds whole records and the chunks together cover the file
+  // exactly once. A chunk finds its own boundaries, so chunks are loaded and
+  // processed independently as jobs of the executor, for example a thread
+  // pool. The data is either mapped, or read with 'pread' into buffers of
+  // the allocator. At most 'd_maximumInFlight' chunks are loaded at a time,
+  // which bounds the memory in use.
+  //
+  // The 'process' callback runs for every chunk, concurrently. If a
+  // 'complete' callback is given, it runs on the calling thread for every
+  // chunk in file order, after 'process' returned for that chunk, so
+  // per-chunk results can be merged in order. Chunks that do not contain the
+  // start of a record, because a record is longer than a chunk, are
+  // skipped.
+
+public:
+  // PUBLIC TYPES
+
+  enum Mode
+  {
+    e_map, // Map the file, chunks refer to the page cache.
+    e_read // Read each chunk into a buffer with 'pread'.
+  };
+
+  struct Configuration
+  {
+    size_t d_chunkSize       = 4 << 20; // Rounded up to the page size.
+    size_t d_maximumInFlight = 8;       // Chunks loaded at the same time.
+    char   d_delimiter       = '\n';    // Last byte of every record.
+    Mode   d_mode            = e_map;
+  };
+
+  struct Chunk
+  {
+    size_t      d_index;  // Position of the chunk in the file.
+    off_t       d_offset; // File offset of the first byte.
+    ConstBuffer d_data;   // The records of the chunk.
+
+    Chunk()
+        : d_index(0)
+        , d_offset(0)
+        , d_data(0, 0)
+    {}
+  };
+
+  typedef std::function<void(const Chunk &chunk)> Callback;
+
+private:
+  // DATA
+
+  Configuration     d_config;
+  Executor *        d_executor_p;
+  mdmem::Allocator *d_allocator_p;
+
+  // PRIVATE MANIPULATORS
+
+  void runChunk(ChunkedFileReader_State *state, size_t index);
+  // Load the chunk with the specified 'index' of the specified 'state',
+  // process it and mark it done.
+
+public:
+  ChunkedFileReader(const ChunkedFileReader &) = delete;
+  ChunkedFileReader &operator=(const ChunkedFileReader &) = delete;
+
+  // CREATORS
+
+  explicit ChunkedFileReader(Executor *        executor  = 0,
+                             mdmem::Allocator *allocator = 0);
+  // Create a reader with the default configuration that processes chunks as
+  // jobs of the optionally specified 'executor', or on the calling thread if
+  // there is none. Optionally the specified 'allocator' is used for memory
+  // allocation.
+
+  ChunkedFileReader(const Configuration &config,
+                    Executor *           executor,
+                    mdmem::Allocator *   allocator = 0);
+  // Create a reader with the specified 'config' that processes chunks as
+  // jobs of the specified 'executor', if not null. Optionally the specified
+  // 'allocator' is used for memory allocation.
+
+  // MANIPULATORS
+
+  int read(const char *    path,
+           const Callback &process,
+           const Callback &complete = Callback());
+  // Scan the file with the specified 'path', calling the specified
+  // 'process' for every chunk and, if set, the specified 'complete' for
+  // every chunk in order. Block until all callbacks returned. Return 0 on
+  // success or a negative 'errno' value; on error no further chunks are
+  // started or completed.
+
+  int read(int             fd,
+           const Callback &process,
+           const Callback &complete = Callback());
+  // Scan the file open for reading on the specified 'fd' like the other
+  // 'read'. The file offset of 'fd' is not used or changed.
+
+  // ACCESSORS
+
+  const Configuration &configuration() const
+  // Return the configuration, with the chunk size rounded up.
+  {
+    return d_config;
+  }
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_CHUNKEDFILEREADER
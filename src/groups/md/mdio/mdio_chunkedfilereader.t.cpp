@@ -0,0 +1,262 @@
+// mdio_chunkedfilereader.t.cpp                                         -*-c++-*-
+#include <mdio_chunkedfilereader.h>
+
+#include <mdmem_testallocator.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+typedef ChunkedFileReader Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+class ThreadsExecutor : public Executor {
+  // Executor running jobs on a number of threads.
+
+  std::mutex               d_mutex;
+  std::condition_variable  d_condition;
+  std::deque<Job>          d_jobs;
+  bool                     d_stop;
+  std::vector<std::thread> d_threads;
+
+  void run()
+  {
+    std::unique_lock<std::mutex> lk(d_mutex);
+    while (true) {
+      d_condition.wait(lk, [this]() { return d_stop || !d_jobs.empty(); });
+      if (d_jobs.empty()) {
+	return;
+      }
+      Job job = std::move(d_jobs.front());
+      d_jobs.pop_front();
+      lk.unlock();
+      job();
+      lk.lock();
+    }
+  }
+
+public:
+  explicit ThreadsExecutor(int count)
+    : d_stop(false)
+  {
+    for (int i = 0; i < count; ++i) {
+      d_threads.emplace_back(&ThreadsExecutor::run, this);
+    }
+  }
+
+  ~ThreadsExecutor()
+  {
+    {
+      std::lock_guard<std::mutex> lk(d_mutex);
+      d_stop = true;
+    }
+    d_condition.notify_all();
+    for (auto& thread : d_threads) {
+      thread.join();
+    }
+  }
+
+  virtual bool execute(Job&& job)
+  {
+    {
+      std::lock_guard<std::mutex> lk(d_mutex);
+      d_jobs.push_back(std::move(job));
+    }
+    d_condition.notify_one();
+    return true;
+  }
+};
+
+struct TemporaryFile {
+  std::string d_path;
+  int         d_fd;
+
+  explicit TemporaryFile(const std::string& contents)
+    : d_path("/tmp/mdio_chunkedfilereader.XXXXXX")
+  {
+    d_fd = mkstemp(&d_path[0]);
+    ASSERT(ssize_t(contents.size()) == write(d_fd, contents.data(), contents.size()));
+  }
+
+  ~TemporaryFile()
+  {
+    close(d_fd);
+    unlink(d_path.c_str());
+  }
+};
+
+std::string records(size_t count)
+{
+  // Return 'count' lines of varying length, some longer than a page.
+  std::string result;
+  for (size_t i = 0; i < count; ++i) {
+    result += std::to_string(i) + ':' + std::string(i * 37 % 300 + (0 == i % 97 ? 9000 : 0), 'x') + '\n';
+  }
+  return result;
+}
+
+void testScan(Obj::Mode mode, Executor *executor, const std::string& contents)
+{
+  TemporaryFile file(contents);
+
+  Obj::Configuration config;
+  config.d_chunkSize       = 1;
+  config.d_maximumInFlight = 3;
+  config.d_mode            = mode;
+
+  mdmem::TestAllocator ta;
+  {
+    Obj o(config, executor, &ta);
+    ASSERT(4096 <= o.configuration().d_chunkSize);
+
+    std::mutex                    mutex;
+    std::map<size_t, std::string> chunks;
+    std::atomic<int>              inFlight(0);
+    std::atomic<int>              peak(0);
+    std::vector<size_t>           order;
+    size_t                        wrong = 0;
+
+    const int rc = o.read(
+	file.d_path.c_str(),
+	[&](const Obj::Chunk& chunk) {
+	  const int n = ++inFlight;
+	  for (int p = peak; p < n && !peak.compare_exchange_weak(p, n);) {
+	  }
+	  const std::string data(chunk.d_data.buffer(), chunk.d_data.size());
+	  if (0 == data.size() || contents.compare(chunk.d_offset, data.size(), data) ||
+	      ('\n' != data.back() && size_t(chunk.d_offset) + data.size() != contents.size())) {
+	    ++wrong;
+	  }
+	  std::this_thread::yield();
+	  std::lock_guard<std::mutex> lk(mutex);
+	  chunks[chunk.d_index] = data;
+	  --inFlight;
+	},
+	[&](const Obj::Chunk& chunk) {
+	  // On the calling thread, in order, with the data still valid.
+	  if (chunks[chunk.d_index] != std::string(chunk.d_data.buffer(), chunk.d_data.size())) {
+	    ++wrong;
+	  }
+	  order.push_back(chunk.d_index);
+	});
+    ASSERT(0 == rc);
+    ASSERT(0 == wrong);
+    ASSERT(peak <= 3);
+
+    std::string joined;
+    for (auto& chunk : chunks) {
+      joined += chunk.second;
+    }
+    ASSERT(contents == joined);
+
+    ASSERT(chunks.size() == order.size());
+    for (size_t i = 1; i < order.size(); ++i) {
+      ASSERT(order[i - 1] < order[i]);
+    }
+
+    // Without 'complete'.
+    std::atomic<size_t> total(0);
+    ASSERT(0 == o.read(file.d_fd, [&](const Obj::Chunk& chunk) {
+	  total += chunk.d_data.size();
+	}));
+    ASSERT(contents.size() == total);
+  }
+  ASSERT(ta.allocationCount() == ta.deallocationCount());
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 3:
+    {
+      // Edge cases.
+      Obj o;
+      ASSERT(-ENOENT == o.read("/nonexistent/file", [](const Obj::Chunk&) {}));
+
+      for (Obj::Mode mode : {Obj::e_map, Obj::e_read}) {
+	Obj::Configuration config;
+	config.d_mode = mode;
+	Obj r(config, nullptr);
+
+	int calls = 0;
+	{
+	  TemporaryFile empty("");
+	  ASSERT(0 == r.read(empty.d_fd, [&](const Obj::Chunk&) { ++calls; }));
+	  ASSERT(0 == calls);
+	}
+
+	// A single record without delimiter.
+	TemporaryFile file(std::string(10000, 'y'));
+	config.d_chunkSize = 4096;
+	Obj s(config, nullptr);
+	std::string data;
+	ASSERT(0 == s.read(file.d_fd, [&](const Obj::Chunk& chunk) {
+	      ++calls;
+	      data.assign(chunk.d_data.buffer(), chunk.d_data.size());
+	    }));
+	ASSERT(1 == calls);
+	ASSERT(std::string(10000, 'y') == data);
+      }
+    } break;
+
+  case 2:
+    {
+      // Chunks processed on threads.
+      ThreadsExecutor executor(4);
+      const std::string contents = records(3000);
+      testScan(Obj::e_map, &executor, contents);
+      testScan(Obj::e_read, &executor, contents);
+      testScan(Obj::e_read, &executor, contents + "unterminated");
+    } break;
+
+  case 1:
+    {
+      // Breathing test: chunks processed on the calling thread.
+      const std::string contents = records(1000);
+      testScan(Obj::e_map, nullptr, contents);
+      testScan(Obj::e_read, nullptr, contents);
+
+      InlineExecutor executor;
+      testScan(Obj::e_map, &executor, contents + "unterminated");
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,363 @@
+// mdio_crc32c.cpp                                                      -*-c++-*-
+#include <mdio_crc32c.h>
+
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define MDIO_CRC32C_X86 1
+#endif
+
+namespace MvdS {
+namespace mdio {
+
+namespace {
+
+const uint32_t k_polynomial = 0x82f63b78; // Reflected Castagnoli polynomial.
+
+// Polynomial arithmetic modulo the CRC polynomial, in the reflected bit
+// order of the checksums: bit 31 is the coefficient of x^0.
+
+uint32_t multiply(uint32_t a, uint32_t b)
+// Return 'a * b' modulo the polynomial.
+{
+  uint32_t result = 0;
+  for (uint32_t mask = uint32_t(1) << 31; mask; mask >>= 1) {
+    if (a & mask) {
+      result ^= b;
+    }
+    b = (b & 1) ? (b >> 1) ^ k_polynomial : b >> 1;
+  }
+  return result;
+}
+
+struct Tables
+{
+  // Tables computed once on first use.
+
+  uint32_t d_slices[8][256]; // Slicing-by-8 tables.
+  uint32_t d_powers[64];     // x^(2^k) modulo the polynomial.
+
+  Tables()
+  {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc & 1) ? (crc >> 1) ^ k_polynomial : crc >> 1;
+      }
+      d_slices[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+      for (int slice = 1; slice < 8; ++slice) {
+        const uint32_t previous = d_slices[slice - 1][i];
+        d_slices[slice][i] = (previous >> 8) ^ d_slices[0][previous & 0xff];
+      }
+    }
+
+    d_powers[0] = uint32_t(1) << 30; // x^1
+    for (int k = 1; k < 64; ++k) {
+      d_powers[k] = multiply(d_powers[k - 1], d_powers[k - 1]);
+    }
+  }
+
+  uint32_t power(uint64_t exponent) const
+  // Return x^exponent modulo the polynomial.
+  {
+    uint32_t result = uint32_t(1) << 31; // x^0
+    for (int k = 0; exponent; ++k, exponent >>= 1) {
+      if (exponent & 1) {
+        result = multiply(d_powers[k], result);
+      }
+    }
+    return result;
+  }
+};
+
+const Tables &tables()
+{
+  static const Tables s_tables;
+  return s_tables;
+}
+
+uint32_t shift(uint32_t crc, size_t size)
+// Return the raw checksum 'crc' extended by 'size' zero bytes.
+{
+  return multiply(tables().power(8 * uint64_t(size)), crc);
+}
+
+// Implementations operate on the raw, unconditioned checksum.
+
+uint32_t updateScalar(uint32_t crc, const char *data, size_t size)
+{
+  const unsigned char *p      = reinterpret_cast<const unsigned char *>(data);
+  const auto &         slices = tables().d_slices;
+
+  while (size && 0 != reinterpret_cast<uintptr_t>(p) % 8) {
+    crc = (crc >> 8) ^ slices[0][(crc ^ *p++) & 0xff];
+    --size;
+  }
+
+  while (8 <= size) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    word ^= crc;
+    crc = slices[7][word & 0xff] ^ slices[6][(word >> 8) & 0xff] ^
+          slices[5][(word >> 16) & 0xff] ^ slices[4][(word >> 24) & 0xff] ^
+          slices[3][(word >> 32) & 0xff] ^ slices[2][(word >> 40) & 0xff] ^
+          slices[1][(word >> 48) & 0xff] ^ slices[0][word >> 56];
+    p += 8;
+    size -= 8;
+  }
+
+  while (size--) {
+    crc = (crc >> 8) ^ slices[0][(crc ^ *p++) & 0xff];
+  }
+  return crc;
+}
+
+#ifdef MDIO_CRC32C_X86
+
+const size_t k_longBlock  = 8192; // Bytes per stream of a long block.
+const size_t k_shortBlock = 256;  // Bytes per stream of a short block.
+
+struct Constants
+{
+  // Multipliers that extend a checksum over a block of zeros.
+
+  uint32_t d_long;         // x^(8 * k_longBlock) for 'multiply'.
+  uint32_t d_short;        // x^(8 * k_shortBlock) for 'multiply'.
+  uint64_t d_longPclmul;   // x^(8 * k_longBlock - 33) for PCLMUL.
+  uint64_t d_shortPclmul;  // x^(8 * k_shortBlock - 33) for PCLMUL.
+
+  Constants()
+      : d_long(tables().power(8 * k_longBlock))
+      , d_short(tables().power(8 * k_shortBlock))
+      , d_longPclmul(tables().power(8 * k_longBlock - 33))
+      , d_shortPclmul(tables().power(8 * k_shortBlock - 33))
+  {}
+};
+
+const Constants &constants()
+{
+  static const Constants s_constants;
+  return s_constants;
+}
+
+__attribute__((target("sse4.2"))) inline uint32_t
+shiftTable(uint32_t crc, uint32_t multiplier, uint64_t)
+{
+  return multiply(multiplier, crc);
+}
+
+__attribute__((target("sse4.2,pclmul"))) inline uint32_t
+shiftPclmul(uint32_t crc, uint32_t, uint64_t multiplier)
+{
+  // The carry-less product of two reflected values is the product times x;
+  // 'crc32' of the 64 bit product multiplies by x^32 and reduces it.
+  const __m128i product = _mm_clmulepi64_si128(
+      _mm_cvtsi32_si128(static_cast<int>(crc)),
+      _mm_cvtsi64_si128(static_cast<long long>(multiplier)),
+      0);
+  return static_cast<uint32_t>(
+      _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(product))));
+}
+
+template <uint32_t (*SHIFT)(uint32_t, uint32_t, uint64_t)>
+__attribute__((target("sse4.2"))) uint32_t
+updateHardware(uint32_t crc, const char *data, size_t size)
+{
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+
+  while (size && 0 != reinterpret_cast<uintptr_t>(p) % 8) {
+    crc = _mm_crc32_u8(crc, *p++);
+    --size;
+  }
+
+  const Constants &c = constants();
+  uint64_t         crc0 = crc;
+
+  // Three independent streams keep the 'crc32' unit busy: its latency is
+  // three cycles at a throughput of one per cycle.
+  for (const size_t block : {k_longBlock, k_shortBlock}) {
+    while (3 * block <= size) {
+      uint64_t crc1 = 0;
+      uint64_t crc2 = 0;
+
+      for (size_t i = 0; i < block; i += 8) {
+        uint64_t w0, w1, w2;
+        memcpy(&w0, p + i, 8);
+        memcpy(&w1, p + block + i, 8);
+        memcpy(&w2, p + 2 * block + i, 8);
+        crc0 = _mm_crc32_u64(crc0, w0);
+        crc1 = _mm_crc32_u64(crc1, w1);
+        crc2 = _mm_crc32_u64(crc2, w2);
+      }
+
+      const uint32_t multiplier = k_longBlock == block ? c.d_long : c.d_short;
+      const uint64_t pclmul =
+          k_longBlock == block ? c.d_longPclmul : c.d_shortPclmul;
+
+      crc0 = SHIFT(static_cast<uint32_t>(crc0), multiplier, pclmul) ^ crc1;
+      crc0 = SHIFT(static_cast<uint32_t>(crc0), multiplier, pclmul) ^ crc2;
+
+      p += 3 * block;
+      size -= 3 * block;
+    }
+  }
+
+  while (8 <= size) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    crc0 = _mm_crc32_u64(crc0, word);
+    p += 8;
+    size -= 8;
+  }
+
+  crc = static_cast<uint32_t>(crc0);
+  while (size--) {
+    crc = _mm_crc32_u8(crc, *p++);
+  }
+  return crc;
+}
+
+#endif
+
+typedef uint32_t (*Update)(uint32_t crc, const char *data, size_t size);
+
+struct Implementation
+{
+  Crc32c::Isa d_isa;
+  Update      d_update;
+};
+
+const Implementation k_scalar = {Crc32c::e_scalar, &updateScalar};
+
+#ifdef MDIO_CRC32C_X86
+const Implementation k_sse42 = {Crc32c::e_sse42,
+                                &updateHardware<&shiftTable>};
+const Implementation k_sse42Pclmul = {Crc32c::e_sse42Pclmul,
+                                      &updateHardware<&shiftPclmul>};
+#endif
+
+const Implementation *implementationFor(Crc32c::Isa isa)
+{
+#ifdef MDIO_CRC32C_X86
+  switch (isa) {
+  case Crc32c::e_sse42Pclmul:
+    return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul")
+               ? &k_sse42Pclmul
+               : nullptr;
+  case Crc32c::e_sse42:
+    return __builtin_cpu_supports("sse4.2") ? &k_sse42 : nullptr;
+  case Crc32c::e_scalar:
+    return &k_scalar;
+  }
+  return nullptr;
+#else
+  return Crc32c::e_scalar == isa ? &k_scalar : nullptr;
+#endif
+}
+
+const Implementation *bestImplementation()
+{
+  for (Crc32c::Isa isa : {Crc32c::e_sse42Pclmul, Crc32c::e_sse42}) {
+    if (const Implementation *implementation = implementationFor(isa)) {
+      return implementation;
+    }
+  }
+  return &k_scalar;
+}
+
+std::atomic<const Implementation *> s_implementation(nullptr);
+// Implementation in use, null until selected. It is constant-initialized,
+// so checksums computed by constructors of other static objects work.
+
+const Implementation *selectImplementation()
+// Select the best implementation unless one is set already and return the
+// one in use.
+{
+  const Implementation *expected = nullptr;
+  const Implementation *best     = bestImplementation();
+  return s_implementation.compare_exchange_strong(
+             expected, best, std::memory_order_relaxed)
+             ? best
+             : expected;
+}
+
+inline const Implementation &implementation()
+{
+  const Implementation *result =
+      s_implementation.load(std::memory_order_relaxed);
+  return result ? *result : *selectImplementation();
+}
+
+inline Update update() { return implementation().d_update; }
+
+} // namespace
+
+// -------------
+// Struct Crc32c
+// -------------
+
+// CLASS METHODS
+
+uint32_t Crc32c::compute(const char *data, size_t size, uint32_t crc)
+{
+  return ~update()(~crc, data, size);
+}
+
+uint32_t Crc32c::compute(const iovec *iovecs, size_t count, uint32_t crc)
+{
+  const Update function = update();
+
+  crc = ~crc;
+  for (size_t i = 0; i < count; ++i) {
+    crc = function(
+        crc, static_cast<const char *>(iovecs[i].iov_base), iovecs[i].iov_len);
+  }
+  return ~crc;
+}
+
+uint32_t Crc32c::compute(const BufferVector &buffers, uint32_t crc)
+{
+  const Update function = update();
+
+  crc = ~crc;
+  buffers.forEachSegment([&crc, function](const char *data, size_t size) {
+    crc = function(crc, data, size);
+  });
+  return ~crc;
+}
+
+uint32_t Crc32c::combine(uint32_t first, uint32_t second, size_t secondSize)
+{
+  return shift(first, secondSize) ^ second;
+}
+
+Crc32c::Isa Crc32c::isa()
+{
+  return implementation().d_isa;
+}
+
+bool Crc32c::setIsa(Isa isa)
+{
+  const Implementation *implementation = implementationFor(isa);
+  if (!implementation) {
+    return false;
+  }
+
+  s_implementation.store(implementation, std::memory_order_relaxed);
+  return true;
+}
+
+bool Crc32c::isSupported(Isa isa)
+{
+  return nullptr != implementationFor(isa);
+}
+
+} // namespace mdio
+} // namespace MvdS
@@ -0,0 +1,86 @@
+// mdio_crc32c.h                                                        -*-c++-*-
+#ifndef __INCLUDED_MDIO_CRC32C
+#define __INCLUDED_MDIO_CRC32C
+
+#include <mdio_buffer.h>
+#include <mdio_buffervector.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/uio.h>
+
+namespace MvdS {
+namespace mdio {
+
+// =============
+// Struct Crc32c
+// =============
+
+struct Crc32c
+{
+  // Provides CRC-32C (Castagnoli) checksums of buffers and buffer chains.
+  //
+  // Checksums are computed incrementally: passing the checksum of the
+  // preceding bytes as 'crc' continues it, so fragments of a chain are
+  // processed in place, in order. Checksums of fragments computed
+  // independently are joined with 'combine'.
+  //
+  // On x86 CPUs with SSE4.2 the 'crc32' instruction processes 8 bytes at a
+  // time on three interleaved streams to hide its latency; the partial
+  // results are merged with a carry-less multiplication (PCLMUL) when
+  // available. Other CPUs use a slicing-by-8 table implementation. The
+  // implementation is selected at run time.
+
+  // PUBLIC TYPES
+
+  enum Isa
+  {
+    e_scalar,      // Slicing-by-8 tables.
+    e_sse42,       // 'crc32' instruction, table based merging.
+    e_sse42Pclmul  // 'crc32' instruction, carry-less multiply merging.
+  };
+
+  // CLASS METHODS
+
+  static uint32_t compute(const char *data, size_t size, uint32_t crc = 0);
+  // Return the checksum of the specified 'size' bytes at the specified
+  // 'data', continuing the optionally specified checksum 'crc' of the
+  // preceding bytes.
+
+  static uint32_t compute(const ConstBuffer &buffer, uint32_t crc = 0)
+  // Return the checksum of the specified 'buffer', continuing the
+  // optionally specified checksum 'crc' of the preceding bytes.
+  {
+    return compute(buffer.buffer(), buffer.size(), crc);
+  }
+
+  static uint32_t compute(const iovec *iovecs, size_t count, uint32_t crc = 0);
+  // Return the checksum of the data of the specified 'count' 'iovecs',
+  // continuing the optionally specified checksum 'crc' of the preceding
+  // bytes.
+
+  static uint32_t compute(const BufferVector &buffers, uint32_t crc = 0);
+  // Return the checksum of the data of the specified 'buffers', continuing
+  // the optionally specified checksum 'crc' of the preceding bytes.
+
+  static uint32_t combine(uint32_t first, uint32_t second, size_t secondSize);
+  // Return the checksum of the concatenation of two byte sequences given
+  // the checksum 'first' of the first sequence and the checksum 'second' of
+  // the second sequence of the specified 'secondSize' bytes.
+
+  static Isa isa();
+  // Return the instruction set of the implementation in use.
+
+  static bool setIsa(Isa isa);
+  // Use the implementation for the specified 'isa' from now on. Return
+  // false, keeping the current one, if the CPU does not support 'isa'.
+
+  static bool isSupported(Isa isa);
+  // Return true if the CPU supports the specified 'isa'.
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_CRC32C
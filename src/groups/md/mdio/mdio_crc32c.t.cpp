@@ -0,0 +1,173 @@
+// mdio_crc32c.t.cpp                                                    -*-c++-*-
+#include <mdio_crc32c.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+typedef Crc32c Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+// Computed before 'main', possibly before the component is initialized.
+const uint32_t g_staticCrc = Obj::compute("123456789", 9);
+
+uint32_t reference(const std::string& data)
+  // Bitwise CRC-32C.
+{
+  uint32_t crc = ~0u;
+  for (unsigned char c : data) {
+    crc ^= c;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+    }
+  }
+  return ~crc;
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  const Obj::Isa isas[] = {Obj::e_scalar, Obj::e_sse42, Obj::e_sse42Pclmul};
+  const Obj::Isa best   = Obj::isa();
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 4:
+    {
+      // Throughput.
+      const std::string data(64 << 20, 'd');
+
+      for (Obj::Isa isa : isas) {
+	if (!Obj::setIsa(isa)) {
+	  continue;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const uint32_t crc = Obj::compute(data.data(), data.size());
+	const double seconds = std::chrono::duration<double>(
+	    std::chrono::steady_clock::now() - start).count();
+
+	ASSERT(0 != crc);
+	if (verbose) {
+	  cerr << "isa " << isa << ": " << data.size() / seconds / 1e9
+	       << " GB/s" << endl;
+	}
+      }
+
+      Obj::setIsa(best);
+    } break;
+
+  case 3:
+    {
+      // Chains and combination of independently computed fragments.
+      std::mt19937 random(3);
+      std::string  data(100000, '\0');
+      for (char& c : data) {
+	c = static_cast<char>(random());
+      }
+      const uint32_t expected = reference(data);
+
+      for (size_t bufferSize : {1, 7, 4096, 30000}) {
+	BufferVector bv(bufferSize);
+	bv.append(data.data(), data.size());
+	ASSERT(expected == Obj::compute(bv));
+
+	iovec iov[3] = {{&data[0], 10}, {&data[10], 50000}, {&data[50010], 49990}};
+	ASSERT(expected == Obj::compute(iov, 3));
+      }
+
+      for (size_t i = 0; i < 50; ++i) {
+	const size_t split = random() % (data.size() + 1);
+	const uint32_t first  = Obj::compute(data.data(), split);
+	const uint32_t second = Obj::compute(data.data() + split, data.size() - split);
+	ASSERT(expected == Obj::combine(first, second, data.size() - split));
+      }
+      ASSERT(0x1234 == Obj::combine(0x1234, 0, 0));
+    } break;
+
+  case 2:
+    {
+      // All implementations agree with the bitwise reference for lengths
+      // around the block sizes and unaligned starts.
+      std::mt19937 random(2);
+      std::string  data(3 * 8192 * 2 + 3 * 256 * 2 + 64, '\0');
+      for (char& c : data) {
+	c = static_cast<char>(random());
+      }
+
+      const size_t sizes[] = {0, 1, 7, 8, 9, 63, 767, 768, 769, 1536, 24575,
+			      24576, 24577, 24576 + 768 + 13, data.size() - 8};
+
+      for (size_t size : sizes) {
+	for (size_t offset : {0, 1, 5}) {
+	  const std::string slice = data.substr(offset, size);
+	  const uint32_t    expected = reference(slice);
+
+	  for (Obj::Isa isa : isas) {
+	    if (!Obj::setIsa(isa)) {
+	      continue;
+	    }
+	    ASSERT(expected == Obj::compute(slice.data(), slice.size()));
+
+	    const size_t split = size / 3;
+	    ASSERT(expected == Obj::compute(slice.data() + split, size - split,
+					    Obj::compute(slice.data(), split)));
+	  }
+	}
+      }
+
+      Obj::setIsa(best);
+    } break;
+
+  case 1:
+    {
+      // Breathing test: known check values.
+      ASSERT(0xe3069283 == g_staticCrc);
+      ASSERT(Obj::isSupported(Obj::e_scalar));
+      ASSERT(Obj::isSupported(Obj::isa()));
+
+      for (Obj::Isa isa : isas) {
+	if (!Obj::setIsa(isa)) {
+	  continue;
+	}
+	ASSERT(isa == Obj::isa());
+	ASSERT(0 == Obj::compute("", 0));
+	ASSERT(0xe3069283 == Obj::compute("123456789", 9));
+	ASSERT(0xe3069283 == Obj::compute(ConstBuffer("123456789", 9)));
+	ASSERT(0x8a9136aa == Obj::compute(std::string(32, '\0').data(), 32));
+	ASSERT(0x62a8ab43 == Obj::compute(std::string(32, '\xff').data(), 32));
+      }
+
+      Obj::setIsa(best);
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
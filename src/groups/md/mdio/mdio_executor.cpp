@@ -0,0 +1,24 @@
+// mdio_executor.cpp                                                    -*-c++-*-
+#include <mdio_executor.h>
+
+namespace MvdS {
+namespace mdio {
+
+// --------------
+// Class Executor
+// --------------
+
+Executor::~Executor() {}
+
+// --------------------
+// Class InlineExecutor
+// --------------------
+
+bool InlineExecutor::execute(Job &&job)
+{
+  job();
+  return true;
+}
+
+} // namespace mdio
+} // namespace MvdS
@@ -0,0 +1,54 @@
+// mdio_executor.h                                                      -*-c++-*-
+#ifndef __INCLUDED_MDIO_EXECUTOR
+#define __INCLUDED_MDIO_EXECUTOR
+
+#include <functional>
+
+namespace MvdS {
+namespace mdio {
+
+// ==============
+// Class Executor
+// ==============
+
+class Executor
+{
+  // Provides the protocol used by I/O components to run completion
+  // callbacks and blocking work, for example on a thread pool.
+
+public:
+  // PUBLIC TYPES
+
+  typedef std::function<void()> Job;
+
+  // CREATORS
+
+  virtual ~Executor();
+
+  // MANIPULATORS
+
+  virtual bool execute(Job &&job) = 0;
+  // Arrange for the specified 'job' to be run. Return false if it cannot
+  // be accepted, in which case 'job' may have been moved from and the
+  // caller has to do the work otherwise.
+};
+
+// ====================
+// Class InlineExecutor
+// ====================
+
+class InlineExecutor : public Executor
+{
+  // Provides an executor that runs jobs immediately on the calling thread.
+
+public:
+  // MANIPULATORS
+
+  virtual bool execute(Job &&job);
+  // Run the specified 'job' and return true.
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_EXECUTOR
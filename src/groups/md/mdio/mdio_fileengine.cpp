@@ -0,0 +1,784 @@
+// mdio_fileengine.cpp                                                  -*-c++-*-
+#include <mdio_fileengine.h>
+
+#include <mdio_iouring.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace MvdS {
+namespace mdio {
+
+// ===========================
+// Struct FileEngine_Operation
+// ===========================
+
+struct FileEngine_Operation
+{
+  // One asynchronous operation. The iovec array follows the structure in
+  // the same allocation. Operations use the io_uring opcodes with both
+  // backends.
+
+  FileEngine::Callback  d_callback;
+  FileEngine_Backend *  d_backend_p;
+  mdmem::Allocator *    d_allocator_p;
+  ssize_t               d_result;
+  int                   d_opcode;
+  int                   d_fd;
+  off_t                 d_offset;
+  unsigned              d_bufferIndex;
+  size_t                d_iovecCount;
+  size_t                d_iovecCapacity;
+  FileEngine_Operation *d_next_p; // Links used by the backend.
+  FileEngine_Operation *d_prev_p;
+
+  static size_t allocationSize(size_t iovecCapacity)
+  {
+    return sizeof(FileEngine_Operation) + iovecCapacity * sizeof(iovec);
+  }
+
+  iovec *iovecs() { return reinterpret_cast<iovec *>(this + 1); }
+
+  void destroy()
+  {
+    mdmem::Allocator *allocator = d_allocator_p;
+    const size_t      size      = allocationSize(d_iovecCapacity);
+
+    this->~FileEngine_Operation();
+    allocator->deallocate(this, size, alignof(FileEngine_Operation));
+  }
+};
+
+// ========================
+// Class FileEngine_Backend
+// ========================
+
+class FileEngine_Backend
+{
+  // Base of the backends: tracks outstanding operations and delivers
+  // completions.
+
+  // DATA
+
+  std::mutex              d_mutex;
+  std::condition_variable d_condition;
+  size_t                  d_outstanding;
+
+protected:
+  // PROTECTED DATA
+
+  Executor *d_executor_p;
+
+  // PROTECTED MANIPULATORS
+
+  void begin(FileEngine_Operation *operation)
+  // Account for the specified 'operation' that is about to start.
+  {
+    operation->d_backend_p = this;
+    std::lock_guard<std::mutex> lk(d_mutex);
+    ++d_outstanding;
+  }
+
+  static void finish(FileEngine_Operation *operation)
+  // Invoke the callback of the specified 'operation' and destroy it.
+  {
+    FileEngine_Backend *backend = operation->d_backend_p;
+
+    operation->d_callback(operation->d_result);
+    operation->destroy();
+
+    std::lock_guard<std::mutex> lk(backend->d_mutex);
+    if (0 == --backend->d_outstanding) {
+      backend->d_condition.notify_all();
+    }
+  }
+
+  void waitForOutstanding()
+  // Block until all started operations have finished.
+  {
+    std::unique_lock<std::mutex> lk(d_mutex);
+    d_condition.wait(lk, [this]() { return 0 == d_outstanding; });
+  }
+
+  void complete(FileEngine_Operation *operation, ssize_t result)
+  // Deliver the specified 'result' of the specified 'operation' through
+  // the executor, or inline if there is none or it rejects the job.
+  {
+    operation->d_result = result;
+
+    if (d_executor_p) {
+      Executor::Job job([operation]() { finish(operation); });
+      if (d_executor_p->execute(std::move(job))) {
+        return;
+      }
+    }
+
+    finish(operation);
+  }
+
+public:
+  // PUBLIC DATA
+
+  size_t d_footprint; // Size of the allocation holding the backend.
+  size_t d_alignment; // Alignment of the allocation holding the backend.
+
+  // CREATORS
+
+  explicit FileEngine_Backend(Executor *executor)
+      : d_outstanding(0)
+      , d_executor_p(executor)
+      , d_footprint(0)
+      , d_alignment(0)
+  {}
+
+  virtual ~FileEngine_Backend() {}
+
+  // MANIPULATORS
+
+  virtual void start(FileEngine_Operation *operation) = 0;
+
+  virtual void submit() = 0;
+
+  virtual int registerBuffers(const iovec *buffers, size_t count) = 0;
+
+  virtual void drain()
+  {
+    submit();
+    waitForOutstanding();
+  }
+
+  // ACCESSORS
+
+  virtual FileEngine::Backend type() const = 0;
+
+  size_t outstanding()
+  {
+    std::lock_guard<std::mutex> lk(d_mutex);
+    return d_outstanding;
+  }
+};
+
+namespace {
+
+// =====================
+// Class ThreadedBackend
+// =====================
+
+class ThreadedBackend : public FileEngine_Backend
+{
+  // Runs blocking system calls as jobs of the executor.
+
+  static void run(FileEngine_Operation *operation)
+  {
+    ssize_t rc = -1;
+    iovec * iov = operation->iovecs();
+
+    do {
+      switch (operation->d_opcode) {
+      case IORING_OP_READV:
+      case IORING_OP_READ_FIXED:
+        rc = preadv(operation->d_fd,
+                    iov,
+                    static_cast<int>(operation->d_iovecCount),
+                    operation->d_offset);
+        break;
+      case IORING_OP_WRITEV:
+      case IORING_OP_WRITE_FIXED:
+        rc = pwritev(operation->d_fd,
+                     iov,
+                     static_cast<int>(operation->d_iovecCount),
+                     operation->d_offset);
+        break;
+      case IORING_OP_FSYNC:
+        rc = ::fsync(operation->d_fd);
+        break;
+      default:
+        errno = EINVAL;
+      }
+    } while (-1 == rc && EINTR == errno);
+
+    operation->d_result = 0 > rc ? -errno : rc;
+    finish(operation);
+  }
+
+public:
+  explicit ThreadedBackend(Executor *executor)
+      : FileEngine_Backend(executor)
+  {}
+
+  virtual void start(FileEngine_Operation *operation)
+  {
+    begin(operation);
+
+    if (d_executor_p) {
+      Executor::Job job([operation]() { run(operation); });
+      if (d_executor_p->execute(std::move(job))) {
+        return;
+      }
+    }
+
+    run(operation);
+  }
+
+  virtual void submit() {}
+
+  virtual int registerBuffers(const iovec *, size_t) { return 0; }
+
+  virtual FileEngine::Backend type() const { return FileEngine::e_threaded; }
+};
+
+// ====================
+// Class IoUringBackend
+// ====================
+
+class IoUringBackend : public FileEngine_Backend
+{
+  // Submits operations to an io_uring instance and reaps completions on a
+  // dedicated thread.
+  //
+  // Operations that cannot be handed to the kernel are failed with the
+  // error instead: when 'submit' fails the prepared entries are taken back,
+  // and when waiting for completions fails the ring is unusable and all
+  // operations in flight and started later fail. The callbacks of failed
+  // operations are invoked after the submission mutex is released, as they
+  // may start new operations.
+
+  enum : uint64_t
+  {
+    k_stop = 0 // User data of the operation that stops the reaper.
+  };
+
+  IoUring                 d_ring;
+  std::mutex              d_submitMutex;   // Protects the members below.
+  std::condition_variable d_inFlightCondition;
+  size_t                  d_inFlight;      // Submitted but not reaped.
+  size_t                  d_queueDepth;
+  FileEngine_Operation *  d_inFlightList;  // Doubly linked.
+  FileEngine_Operation *  d_backlogHead;   // Started by the reaper thread
+  FileEngine_Operation *  d_backlogTail;   // while the ring was full.
+  FileEngine_Operation *  d_failed;        // Callbacks still to invoke.
+  int                     d_error;         // Of the ring, 0 if usable.
+  size_t                  d_drainers;      // Threads in 'drain'.
+  std::thread             d_reaper;
+
+  void failLocked(FileEngine_Operation *operation, int error)
+  {
+    operation->d_result = error;
+    operation->d_next_p = d_failed;
+    d_failed            = operation;
+  }
+
+  void unlinkLocked(FileEngine_Operation *operation)
+  {
+    if (operation->d_prev_p) {
+      operation->d_prev_p->d_next_p = operation->d_next_p;
+    } else {
+      d_inFlightList = operation->d_next_p;
+    }
+    if (operation->d_next_p) {
+      operation->d_next_p->d_prev_p = operation->d_prev_p;
+    }
+    --d_inFlight;
+  }
+
+  void submitLocked()
+  {
+    while (0 < d_ring.pending()) {
+      const int rc = d_ring.submit();
+      if (0 <= rc) {
+        continue;
+      }
+      if (-EINTR == rc) {
+        continue;
+      }
+      if (-EAGAIN == rc || -EBUSY == rc) {
+        // Completions must be reaped first.
+        std::this_thread::yield();
+        continue;
+      }
+
+      d_ring.discardPending([this, rc](const io_uring_sqe &sqe) {
+        if (k_stop != sqe.user_data) {
+          FileEngine_Operation *operation =
+              reinterpret_cast<FileEngine_Operation *>(sqe.user_data);
+          unlinkLocked(operation);
+          failLocked(operation, rc);
+        }
+      });
+      d_inFlightCondition.notify_all();
+      break;
+    }
+  }
+
+  io_uring_sqe *getSqeLocked()
+  {
+    io_uring_sqe *sqe;
+    while (nullptr == (sqe = d_ring.getSqe())) {
+      submitLocked();
+    }
+    return sqe;
+  }
+
+  void prepareLocked(FileEngine_Operation *operation)
+  {
+    io_uring_sqe *sqe = getSqeLocked();
+    sqe->opcode       = static_cast<uint8_t>(operation->d_opcode);
+    sqe->fd           = operation->d_fd;
+    sqe->user_data    = reinterpret_cast<uint64_t>(operation);
+
+    switch (operation->d_opcode) {
+    case IORING_OP_READV:
+    case IORING_OP_WRITEV:
+      sqe->off  = operation->d_offset;
+      sqe->addr = reinterpret_cast<uint64_t>(operation->iovecs());
+      sqe->len  = static_cast<uint32_t>(operation->d_iovecCount);
+      break;
+    case IORING_OP_READ_FIXED:
+    case IORING_OP_WRITE_FIXED:
+      sqe->off       = operation->d_offset;
+      sqe->addr      = reinterpret_cast<uint64_t>(operation->iovecs()[0].iov_base);
+      sqe->len       = static_cast<uint32_t>(operation->iovecs()[0].iov_len);
+      sqe->buf_index = static_cast<uint16_t>(operation->d_bufferIndex);
+      break;
+    }
+
+    operation->d_prev_p = nullptr;
+    operation->d_next_p = d_inFlightList;
+    if (d_inFlightList) {
+      d_inFlightList->d_prev_p = operation;
+    }
+    d_inFlightList = operation;
+    ++d_inFlight;
+  }
+
+  void startBacklogLocked()
+  {
+    if (!d_backlogHead) {
+      return;
+    }
+
+    while (d_backlogHead && d_inFlight < d_queueDepth) {
+      FileEngine_Operation *operation = d_backlogHead;
+      d_backlogHead                   = operation->d_next_p;
+      prepareLocked(operation);
+    }
+    if (!d_backlogHead) {
+      d_backlogTail = nullptr;
+    }
+    submitLocked();
+  }
+
+  void completeFailed()
+  {
+    FileEngine_Operation *failed;
+    {
+      std::lock_guard<std::mutex> lk(d_submitMutex);
+      failed   = d_failed;
+      d_failed = nullptr;
+    }
+
+    // Complete in the order the operations failed.
+    FileEngine_Operation *ordered = nullptr;
+    while (failed) {
+      FileEngine_Operation *next = failed->d_next_p;
+      failed->d_next_p           = ordered;
+      ordered                    = failed;
+      failed                     = next;
+    }
+    while (ordered) {
+      FileEngine_Operation *next = ordered->d_next_p;
+      complete(ordered, ordered->d_result);
+      ordered = next;
+    }
+  }
+
+  void fail(int error)
+  {
+    // The ring cannot deliver completions anymore.
+    {
+      std::lock_guard<std::mutex> lk(d_submitMutex);
+      d_error = error;
+
+      // Entries not submitted yet belong to operations in the list.
+      d_ring.discardPending([](const io_uring_sqe &) {});
+
+      while (FileEngine_Operation *operation = d_inFlightList) {
+        unlinkLocked(operation);
+        failLocked(operation, error);
+      }
+      while (FileEngine_Operation *operation = d_backlogHead) {
+        d_backlogHead = operation->d_next_p;
+        failLocked(operation, error);
+      }
+      d_backlogTail = nullptr;
+    }
+    d_inFlightCondition.notify_all();
+
+    completeFailed();
+  }
+
+  void reap()
+  {
+    bool stop = false;
+
+    while (!stop) {
+      const int rc = d_ring.wait();
+      if (0 > rc && -EINTR != rc && -EAGAIN != rc && -EBUSY != rc) {
+        fail(rc);
+        return;
+      }
+
+      d_ring.reap([this, &stop](const io_uring_cqe &cqe) {
+        if (k_stop == cqe.user_data) {
+          stop = true;
+          return;
+        }
+
+        FileEngine_Operation *operation =
+            reinterpret_cast<FileEngine_Operation *>(cqe.user_data);
+        {
+          std::lock_guard<std::mutex> lk(d_submitMutex);
+          unlinkLocked(operation);
+        }
+        d_inFlightCondition.notify_one();
+
+        complete(operation, cqe.res);
+      });
+
+      {
+        std::lock_guard<std::mutex> lk(d_submitMutex);
+        startBacklogLocked();
+      }
+      completeFailed();
+    }
+  }
+
+public:
+  IoUringBackend(Executor *executor, unsigned queueDepth)
+      : FileEngine_Backend(executor)
+      , d_inFlight(0)
+      , d_queueDepth(queueDepth ? queueDepth : 1)
+      , d_inFlightList(nullptr)
+      , d_backlogHead(nullptr)
+      , d_backlogTail(nullptr)
+      , d_failed(nullptr)
+      , d_error(0)
+      , d_drainers(0)
+  {}
+
+  ~IoUringBackend()
+  {
+    if (d_reaper.joinable()) {
+      drain();
+
+      {
+        // A reaper that failed has exited already.
+        std::lock_guard<std::mutex> lk(d_submitMutex);
+        if (0 == d_error) {
+          io_uring_sqe *sqe = getSqeLocked();
+          sqe->opcode       = IORING_OP_NOP;
+          sqe->user_data    = k_stop;
+          submitLocked();
+        }
+      }
+
+      d_reaper.join();
+    }
+  }
+
+  int open()
+  {
+    const int rc = d_ring.open(static_cast<unsigned>(d_queueDepth));
+    if (0 == rc) {
+      d_reaper = std::thread(&IoUringBackend::reap, this);
+    }
+    return rc;
+  }
+
+  virtual void start(FileEngine_Operation *operation)
+  {
+    begin(operation);
+
+    {
+      std::unique_lock<std::mutex> lk(d_submitMutex);
+
+      if (std::this_thread::get_id() == d_reaper.get_id() &&
+          (d_backlogHead || d_inFlight >= d_queueDepth)) {
+        // A callback on the reaper thread must not wait for the reaper,
+        // the operation is started after the next completions instead.
+        operation->d_next_p = nullptr;
+        if (d_backlogTail) {
+          d_backlogTail->d_next_p = operation;
+        } else {
+          d_backlogHead = operation;
+        }
+        d_backlogTail = operation;
+        return;
+      }
+
+      if (0 == d_error && d_inFlight >= d_queueDepth) {
+        submitLocked();
+        d_inFlightCondition.wait(lk, [this]() {
+          return d_inFlight < d_queueDepth || 0 != d_error;
+        });
+      }
+
+      if (0 != d_error) {
+        failLocked(operation, d_error);
+      } else {
+        prepareLocked(operation);
+
+        // Operations started by callbacks while draining would otherwise
+        // never be submitted.
+        if (0 < d_drainers) {
+          submitLocked();
+        }
+      }
+    }
+
+    completeFailed();
+  }
+
+  virtual void submit()
+  {
+    {
+      std::lock_guard<std::mutex> lk(d_submitMutex);
+      submitLocked();
+    }
+    completeFailed();
+  }
+
+  virtual void drain()
+  {
+    {
+      std::lock_guard<std::mutex> lk(d_submitMutex);
+      ++d_drainers;
+      submitLocked();
+    }
+    completeFailed();
+
+    waitForOutstanding();
+
+    std::lock_guard<std::mutex> lk(d_submitMutex);
+    --d_drainers;
+  }
+
+  virtual int registerBuffers(const iovec *buffers, size_t count)
+  {
+    std::lock_guard<std::mutex> lk(d_submitMutex);
+    d_ring.unregisterBuffers();
+    return 0 == count
+               ? 0
+               : d_ring.registerBuffers(buffers, static_cast<unsigned>(count));
+  }
+
+  virtual FileEngine::Backend type() const { return FileEngine::e_ioUring; }
+};
+
+template <class BACKEND, class... ARGS>
+BACKEND *createBackend(mdmem::Allocator *allocator, ARGS &&... args)
+{
+  void *memory = allocator->allocate(sizeof(BACKEND), alignof(BACKEND));
+  BACKEND *backend     = new (memory) BACKEND(std::forward<ARGS>(args)...);
+  backend->d_footprint = sizeof(BACKEND);
+  backend->d_alignment = alignof(BACKEND);
+  return backend;
+}
+
+} // namespace
+
+// ----------------
+// Class FileEngine
+// ----------------
+
+// PRIVATE MANIPULATORS
+
+FileEngine_Operation *FileEngine::createOperation(int       opcode,
+                                                  int       fd,
+                                                  off_t     offset,
+                                                  size_t    iovecCount,
+                                                  Callback &&callback)
+{
+  void *memory =
+      d_allocator_p->allocate(FileEngine_Operation::allocationSize(iovecCount),
+                              alignof(FileEngine_Operation));
+
+  FileEngine_Operation *operation = new (memory) FileEngine_Operation();
+  operation->d_callback           = std::move(callback);
+  operation->d_backend_p          = d_backend_p;
+  operation->d_allocator_p        = d_allocator_p;
+  operation->d_result             = 0;
+  operation->d_opcode             = opcode;
+  operation->d_fd                 = fd;
+  operation->d_offset             = offset;
+  operation->d_bufferIndex        = 0;
+  operation->d_iovecCount         = iovecCount;
+  operation->d_iovecCapacity      = iovecCount;
+  operation->d_next_p             = nullptr;
+  operation->d_prev_p             = nullptr;
+  return operation;
+}
+
+// CREATORS
+
+FileEngine::FileEngine(Executor *executor, mdmem::Allocator *allocator)
+    : FileEngine(Configuration(), executor, allocator)
+{}
+
+FileEngine::FileEngine(const Configuration &config,
+                       Executor *           executor,
+                       mdmem::Allocator *   allocator)
+    : d_backend_p(nullptr)
+    , d_allocator_p(mdmem::AllocatorUtil::defaultAllocator(allocator))
+{
+  if (e_threaded != config.d_backend) {
+    IoUringBackend *backend =
+        createBackend<IoUringBackend>(d_allocator_p, executor, config.d_queueDepth);
+
+    if (0 == backend->open()) {
+      d_backend_p = backend;
+      return;
+    }
+
+    backend->~IoUringBackend();
+    d_allocator_p->deallocate(backend, sizeof(IoUringBackend), alignof(IoUringBackend));
+  }
+
+  d_backend_p = createBackend<ThreadedBackend>(d_allocator_p, executor);
+}
+
+FileEngine::~FileEngine()
+{
+  d_backend_p->drain();
+
+  const size_t footprint = d_backend_p->d_footprint;
+  const size_t alignment = d_backend_p->d_alignment;
+  d_backend_p->~FileEngine_Backend();
+  d_allocator_p->deallocate(d_backend_p, footprint, alignment);
+}
+
+// MANIPULATORS
+
+void FileEngine::read(
+    int fd, off_t offset, char *buffer, size_t size, Callback callback)
+{
+  FileEngine_Operation *operation =
+      createOperation(IORING_OP_READV, fd, offset, 1, std::move(callback));
+  operation->iovecs()[0].iov_base = buffer;
+  operation->iovecs()[0].iov_len  = size;
+  d_backend_p->start(operation);
+}
+
+void FileEngine::write(
+    int fd, off_t offset, const char *buffer, size_t size, Callback callback)
+{
+  FileEngine_Operation *operation =
+      createOperation(IORING_OP_WRITEV, fd, offset, 1, std::move(callback));
+  operation->iovecs()[0].iov_base = const_cast<char *>(buffer);
+  operation->iovecs()[0].iov_len  = size;
+  d_backend_p->start(operation);
+}
+
+void FileEngine::readv(int          fd,
+                       off_t        offset,
+                       const iovec *iovecs,
+                       size_t       count,
+                       Callback     callback)
+{
+  FileEngine_Operation *operation =
+      createOperation(IORING_OP_READV, fd, offset, count, std::move(callback));
+  std::copy(iovecs, iovecs + count, operation->iovecs());
+  d_backend_p->start(operation);
+}
+
+void FileEngine::writev(int          fd,
+                        off_t        offset,
+                        const iovec *iovecs,
+                        size_t       count,
+                        Callback     callback)
+{
+  FileEngine_Operation *operation =
+      createOperation(IORING_OP_WRITEV, fd, offset, count, std::move(callback));
+  std::copy(iovecs, iovecs + count, operation->iovecs());
+  d_backend_p->start(operation);
+}
+
+void FileEngine::write(int                 fd,
+                       off_t               offset,
+                       const BufferVector &buffers,
+                       Callback            callback)
+{
+  FileEngine_Operation *operation = createOperation(
+      IORING_OP_WRITEV, fd, offset, buffers.bufferCount(), std::move(callback));
+  operation->d_iovecCount =
+      buffers.iovecs(operation->iovecs(), operation->d_iovecCapacity);
+  d_backend_p->start(operation);
+}
+
+void FileEngine::fsync(int fd, Callback callback)
+{
+  d_backend_p->start(
+      createOperation(IORING_OP_FSYNC, fd, 0, 0, std::move(callback)));
+}
+
+int FileEngine::registerBuffers(Buffer *buffers, size_t count)
+{
+  std::vector<iovec> iovecs(count);
+  for (size_t i = 0; i < count; ++i) {
+    iovecs[i].iov_base = buffers[i].buffer();
+    iovecs[i].iov_len  = buffers[i].size();
+  }
+
+  return d_backend_p->registerBuffers(iovecs.data(), count);
+}
+
+void FileEngine::readFixed(int      fd,
+                           off_t    offset,
+                           unsigned bufferIndex,
+                           char *   buffer,
+                           size_t   size,
+                           Callback callback)
+{
+  FileEngine_Operation *operation =
+      createOperation(IORING_OP_READ_FIXED, fd, offset, 1, std::move(callback));
+  operation->d_bufferIndex        = bufferIndex;
+  operation->iovecs()[0].iov_base = buffer;
+  operation->iovecs()[0].iov_len  = size;
+  d_backend_p->start(operation);
+}
+
+void FileEngine::writeFixed(int         fd,
+                            off_t       offset,
+                            unsigned    bufferIndex,
+                            const char *buffer,
+                            size_t      size,
+                            Callback    callback)
+{
+  FileEngine_Operation *operation =
+      createOperation(IORING_OP_WRITE_FIXED, fd, offset, 1, std::move(callback));
+  operation->d_bufferIndex        = bufferIndex;
+  operation->iovecs()[0].iov_base = const_cast<char *>(buffer);
+  operation->iovecs()[0].iov_len  = size;
+  d_backend_p->start(operation);
+}
+
+void FileEngine::submit() { d_backend_p->submit(); }
+
+void FileEngine::drain() { d_backend_p->drain(); }
+
+// ACCESSORS
+
+FileEngine::Backend FileEngine::backend() const { return d_backend_p->type(); }
+
+size_t FileEngine::outstanding() const { return d_backend_p->outstanding(); }
+
+} // namespace mdio
+} // namespace MvdS
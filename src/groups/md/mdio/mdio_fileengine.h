@@ -0,0 +1,180 @@
+// mdio_fileengine.h                                                    -*-c++-*-
+#ifndef __INCLUDED_MDIO_FILEENGINE
+#define __INCLUDED_MDIO_FILEENGINE
+
+#include <mdio_buffer.h>
+#include <mdio_buffervector.h>
+#include <mdio_executor.h>
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <cstddef>
+#include <functional>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+namespace MvdS {
+namespace mdio {
+
+class FileEngine_Backend;
+struct FileEngine_Operation;
+
+// ================
+// Class FileEngine
+// ================
+
+class FileEngine
+{
+  // Provides asynchronous positional file I/O with completion callbacks.
+  //
+  // With the io_uring backend operations are collected in the submission
+  // queue and handed to the kernel in one system call by 'submit', or when
+  // the queue is full; a completion thread reaps the results. Buffers that
+  // are used for many operations can be registered with the kernel once and
+  // then used with the 'Fixed' operations. When io_uring is not available,
+  // or not requested, the threaded backend runs blocking 'preadv' and
+  // 'pwritev' calls as jobs of the executor instead.
+  //
+  // Callbacks receive the number of bytes transferred or a negative 'errno'
+  // value. Partial transfers are reported as is. Callbacks run as jobs of
+  // the executor, for example a thread pool, or on the completion thread if
+  // there is no executor or it rejects the job. The memory of an operation
+  // must stay valid until its callback is invoked. This class is
+  // thread-safe.
+
+public:
+  // PUBLIC TYPES
+
+  typedef std::function<void(ssize_t result)> Callback;
+
+  enum Backend
+  {
+    e_auto,     // io_uring if available, threaded otherwise.
+    e_ioUring,  // io_uring, or threaded if not available.
+    e_threaded  // Blocking calls on the executor.
+  };
+
+  struct Configuration
+  {
+    Backend  d_backend    = e_auto;
+    unsigned d_queueDepth = 256; // Operations in flight in the kernel.
+  };
+
+private:
+  // DATA
+
+  FileEngine_Backend *d_backend_p;
+  mdmem::Allocator *  d_allocator_p;
+
+  // PRIVATE MANIPULATORS
+
+  FileEngine_Operation *createOperation(int       opcode,
+                                        int       fd,
+                                        off_t     offset,
+                                        size_t    iovecCount,
+                                        Callback &&callback);
+
+public:
+  FileEngine(const FileEngine &) = delete;
+  FileEngine &operator=(const FileEngine &) = delete;
+
+  // CREATORS
+
+  explicit FileEngine(Executor *executor = 0, mdmem::Allocator *allocator = 0);
+  // Create an engine using the best available backend that delivers
+  // completions to the optionally specified 'executor'. Optionally the
+  // specified 'allocator' is used for memory allocation.
+
+  FileEngine(const Configuration &config,
+             Executor *           executor,
+             mdmem::Allocator *   allocator = 0);
+  // Create an engine with the specified 'config' that delivers completions
+  // to the specified 'executor', if not null. Optionally the specified
+  // 'allocator' is used for memory allocation.
+
+  ~FileEngine();
+  // Submit pending operations, wait for all callbacks and destroy the
+  // engine.
+
+  // MANIPULATORS
+
+  void read(int fd, off_t offset, char *buffer, size_t size, Callback callback);
+  // Read up to the specified 'size' bytes at the specified 'offset' of the
+  // specified 'fd' into the specified 'buffer'.
+
+  void
+  write(int fd, off_t offset, const char *buffer, size_t size, Callback callback);
+  // Write the specified 'size' bytes of the specified 'buffer' at the
+  // specified 'offset' of the specified 'fd'.
+
+  void readv(int          fd,
+             off_t        offset,
+             const iovec *iovecs,
+             size_t       count,
+             Callback     callback);
+  // Read at the specified 'offset' of the specified 'fd' into the specified
+  // 'count' 'iovecs'. The iovec array itself is copied.
+
+  void writev(int          fd,
+              off_t        offset,
+              const iovec *iovecs,
+              size_t       count,
+              Callback     callback);
+  // Write the specified 'count' 'iovecs' at the specified 'offset' of the
+  // specified 'fd'. The iovec array itself is copied.
+
+  void
+  write(int fd, off_t offset, const BufferVector &buffers, Callback callback);
+  // Write the data of the specified 'buffers' at the specified 'offset' of
+  // the specified 'fd'. The buffers must not change until 'callback' runs.
+
+  void fsync(int fd, Callback callback);
+  // Flush the data and metadata of the specified 'fd' to storage.
+
+  int registerBuffers(Buffer *buffers, size_t count);
+  // Register the specified 'count' 'buffers' for the 'Fixed' operations,
+  // replacing earlier registrations. Return 0 on success or a negative
+  // 'errno' value. Behavior is undefined if operations are in progress.
+
+  void readFixed(int      fd,
+                 off_t    offset,
+                 unsigned bufferIndex,
+                 char *   buffer,
+                 size_t   size,
+                 Callback callback);
+  // Read up to the specified 'size' bytes at the specified 'offset' of the
+  // specified 'fd' into the specified 'buffer', which must lie within the
+  // registered buffer with the specified 'bufferIndex'.
+
+  void writeFixed(int         fd,
+                  off_t       offset,
+                  unsigned    bufferIndex,
+                  const char *buffer,
+                  size_t      size,
+                  Callback    callback);
+  // Write the specified 'size' bytes of the specified 'buffer', which must
+  // lie within the registered buffer with the specified 'bufferIndex', at
+  // the specified 'offset' of the specified 'fd'.
+
+  void submit();
+  // Start all operations collected since the last call.
+
+  void drain();
+  // Submit pending operations and block until all callbacks have returned,
+  // submitting the operations they start as well. Behavior is undefined if
+  // called from a callback.
+
+  // ACCESSORS
+
+  Backend backend() const;
+  // Return the backend in use, 'e_ioUring' or 'e_threaded'.
+
+  size_t outstanding() const;
+  // Return the number of operations whose callback has not returned yet.
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_FILEENGINE
@@ -0,0 +1,357 @@
+// mdio_fileengine.t.cpp                                                -*-c++-*-
+#include <mdio_fileengine.h>
+
+#include <mdio_iouring.h>
+#include <mdmem_testallocator.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+class ThreadExecutor : public Executor {
+  // Executor running jobs on one thread, in order.
+
+  std::mutex              d_mutex;
+  std::condition_variable d_condition;
+  std::deque<Job>         d_jobs;
+  bool                    d_stop;
+  std::thread::id         d_id;
+  std::thread             d_thread;
+
+  void run()
+  {
+    std::unique_lock<std::mutex> lk(d_mutex);
+    while (true) {
+      d_condition.wait(lk, [this]() { return d_stop || !d_jobs.empty(); });
+      if (d_jobs.empty()) {
+	return;
+      }
+      Job job = std::move(d_jobs.front());
+      d_jobs.pop_front();
+      lk.unlock();
+      job();
+      lk.lock();
+    }
+  }
+
+public:
+  ThreadExecutor()
+    : d_stop(false)
+    , d_thread(&ThreadExecutor::run, this)
+  {
+    d_id = d_thread.get_id();
+  }
+
+  ~ThreadExecutor()
+  {
+    {
+      std::lock_guard<std::mutex> lk(d_mutex);
+      d_stop = true;
+    }
+    d_condition.notify_all();
+    d_thread.join();
+  }
+
+  virtual bool execute(Job&& job)
+  {
+    {
+      std::lock_guard<std::mutex> lk(d_mutex);
+      d_jobs.push_back(std::move(job));
+    }
+    d_condition.notify_all();
+    return true;
+  }
+
+  std::thread::id id() const { return d_id; }
+};
+
+struct TemporaryFile {
+  std::string d_path;
+  int         d_fd;
+
+  TemporaryFile()
+    : d_path("/tmp/mdio_fileengine.XXXXXX")
+  {
+    d_fd = mkstemp(&d_path[0]);
+  }
+
+  ~TemporaryFile()
+  {
+    close(d_fd);
+    unlink(d_path.c_str());
+  }
+};
+
+std::string readAll(int fd)
+{
+  std::string result;
+  char        buffer[4096];
+  ssize_t     rc;
+  off_t       offset = 0;
+  while (0 < (rc = pread(fd, buffer, sizeof(buffer), offset))) {
+    result.append(buffer, rc);
+    offset += rc;
+  }
+  return result;
+}
+
+void testBackend(FileEngine::Backend backend)
+{
+  if (FileEngine::e_ioUring == backend && !IoUring::isSupported()) {
+    cerr << "io_uring is not supported, skipping." << endl;
+    return;
+  }
+
+  FileEngine::Configuration config;
+  config.d_backend    = backend;
+  config.d_queueDepth = 4;
+
+  {
+    // Write and read back, completions arrive on the executor.
+    mdmem::TestAllocator ta;
+    TemporaryFile        file;
+    ThreadExecutor       executor;
+
+    {
+      FileEngine engine(config, &executor, &ta);
+      ASSERT(backend == engine.backend());
+
+      std::atomic<int> wrong(0);
+      std::atomic<int> done(0);
+
+      std::vector<std::string> lines;
+      for (int i = 0; i < 100; ++i) {
+	lines.push_back("line " + std::to_string(1000 + i) + "\n");
+      }
+
+      for (int i = 0; i < 100; ++i) {
+	engine.write(file.d_fd, i * 10, lines[i].data(), 10,
+		     [&, i](ssize_t result) {
+		       if (10 != result || std::this_thread::get_id() != executor.id()) {
+			 ++wrong;
+		       }
+		       ++done;
+		     });
+      }
+      engine.submit();
+      engine.drain();
+
+      ASSERT(100 == done);
+      ASSERT(0 == wrong);
+      ASSERT(0 == engine.outstanding());
+
+      std::string expected;
+      for (auto& line : lines) {
+	expected += line;
+      }
+      ASSERT(expected == readAll(file.d_fd));
+
+      char    buffer[10];
+      ssize_t readResult = 0;
+      engine.read(file.d_fd, 50, buffer, 10, [&](ssize_t result) {
+	  readResult = result;
+	});
+      engine.drain();
+      ASSERT(10 == readResult);
+      ASSERT("line 1005\n" == std::string(buffer, 10));
+
+      // Errors are reported as negative errno values.
+      ssize_t badResult = 0;
+      engine.read(-1, 0, buffer, 10, [&](ssize_t result) {
+	  badResult = result;
+	});
+      engine.drain();
+      ASSERT(-EBADF == badResult);
+    }
+
+    ASSERT(ta.allocationCount() == ta.deallocationCount());
+  }
+
+  {
+    // Chains, vectors, fsync and fixed buffers, completions inline.
+    mdmem::TestAllocator ta;
+    TemporaryFile        file;
+
+    {
+      FileEngine engine(config, nullptr, &ta);
+
+      BufferVector bv(4, &ta);
+      bv.append("0123456789", 10);
+
+      ssize_t r0 = 0, r1 = 0, r2 = 0, r3 = 0, r4 = 0;
+      engine.write(file.d_fd, 0, bv, [&](ssize_t result) { r0 = result; });
+
+      iovec iov[2] = {{const_cast<char *>("ab"), 2}, {const_cast<char *>("cd"), 2}};
+      engine.writev(file.d_fd, 10, iov, 2, [&](ssize_t result) { r1 = result; });
+      engine.drain();
+
+      engine.fsync(file.d_fd, [&](ssize_t result) { r2 = result; });
+      engine.drain();
+
+      ASSERT(10 == r0);
+      ASSERT(4 == r1);
+      ASSERT(0 == r2);
+      ASSERT("0123456789abcd" == readAll(file.d_fd));
+
+      Buffer fixed[1] = {Buffer(static_cast<char *>(ta.allocate(64)), 64, &ta)};
+      ASSERT(0 == engine.registerBuffers(fixed, 1));
+
+      memcpy(fixed[0].buffer(), "FIXED", 5);
+      engine.writeFixed(file.d_fd, 14, 0, fixed[0].buffer(), 5,
+			[&](ssize_t result) { r3 = result; });
+      engine.drain();
+      ASSERT(5 == r3);
+
+      engine.readFixed(file.d_fd, 0, 0, fixed[0].buffer() + 8, 4,
+		       [&](ssize_t result) { r4 = result; });
+      engine.drain();
+      ASSERT(4 == r4);
+      ASSERT("0123" == std::string(fixed[0].buffer() + 8, 4));
+      ASSERT("0123456789abcdFIXED" == readAll(file.d_fd));
+
+      ASSERT(0 == engine.registerBuffers(nullptr, 0));
+    }
+
+    ASSERT(ta.allocationCount() == ta.deallocationCount());
+  }
+
+  {
+    // Inline completions start new operations while another thread keeps
+    // the queue full.
+    mdmem::TestAllocator ta;
+    TemporaryFile        file;
+
+    FileEngine::Configuration small = config;
+    small.d_queueDepth              = 2;
+
+    {
+      FileEngine engine(small, nullptr, &ta);
+
+      const int        k_count = 200;
+      std::atomic<int> chained(0);
+      std::atomic<int> done(0);
+      std::atomic<int> wrong(0);
+
+      std::function<void(ssize_t)> chain = [&](ssize_t result) {
+	if (1 != result) {
+	  ++wrong;
+	}
+	if (++chained < k_count) {
+	  engine.write(file.d_fd, chained, "c", 1, chain);
+	  engine.submit();
+	}
+      };
+
+      engine.write(file.d_fd, 0, "c", 1, chain);
+      engine.submit();
+      for (int i = 0; i < k_count; ++i) {
+	engine.write(file.d_fd, k_count + i, "m", 1, [&](ssize_t result) {
+	    if (1 != result) {
+	      ++wrong;
+	    }
+	    ++done;
+	  });
+	engine.submit();
+      }
+      engine.drain();
+
+      ASSERT(k_count == chained);
+      ASSERT(k_count == done);
+      ASSERT(0 == wrong);
+      ASSERT(0 == engine.outstanding());
+    }
+
+    ASSERT(ta.allocationCount() == ta.deallocationCount());
+  }
+
+  {
+    // 'drain' submits the reads that callbacks chain without calling
+    // 'submit', inline and on the executor.
+    mdmem::TestAllocator ta;
+    TemporaryFile        file;
+    ThreadExecutor       executor;
+    ASSERT(8 == pwrite(file.d_fd, "01234567", 8, 0));
+
+    for (Executor *e : {static_cast<Executor *>(nullptr),
+			static_cast<Executor *>(&executor)}) {
+      FileEngine engine(config, e, &ta);
+
+      char    buffer[8];
+      ssize_t first  = 0;
+      ssize_t second = 0;
+      engine.read(file.d_fd, 0, buffer, 4, [&](ssize_t result) {
+	  first = result;
+	  engine.read(file.d_fd, 4, buffer + 4, 4, [&](ssize_t result) {
+	      second = result;
+	    });
+	});
+      engine.drain();
+
+      ASSERT(4 == first);
+      ASSERT(4 == second);
+      ASSERT("01234567" == std::string(buffer, 8));
+      ASSERT(0 == engine.outstanding());
+    }
+
+    ASSERT(ta.allocationCount() == ta.deallocationCount());
+  }
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 2:
+    {
+      // The io_uring backend.
+      testBackend(FileEngine::e_ioUring);
+    } break;
+
+  case 1:
+    {
+      // The threaded backend.
+      testBackend(FileEngine::e_threaded);
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,238 @@
+// mdio_iouring.cpp                                                     -*-c++-*-
+#include <mdio_iouring.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace MvdS {
+namespace mdio {
+
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params *params)
+{
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+  return static_cast<int>(syscall(
+      __NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void *arg, unsigned count)
+{
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+template <class TYPE>
+TYPE *at(void *base, unsigned offset)
+{
+  return reinterpret_cast<TYPE *>(static_cast<char *>(base) + offset);
+}
+
+} // namespace
+
+// -------------
+// Class IoUring
+// -------------
+
+// CLASS METHODS
+
+bool IoUring::isSupported()
+{
+  IoUring ring;
+  return 0 == ring.open(1);
+}
+
+// CREATORS
+
+IoUring::IoUring()
+    : d_fd(-1)
+    , d_sqRing(nullptr)
+    , d_sqRingSize(0)
+    , d_cqRing(nullptr)
+    , d_cqRingSize(0)
+    , d_sqes(nullptr)
+    , d_sqesSize(0)
+    , d_sqHead(nullptr)
+    , d_sqTail(nullptr)
+    , d_sqArray(nullptr)
+    , d_sqMask(0)
+    , d_sqEntries(0)
+    , d_sqLocalTail(0)
+    , d_sqPending(0)
+    , d_cqHead(nullptr)
+    , d_cqTail(nullptr)
+    , d_cqes(nullptr)
+    , d_cqMask(0)
+{}
+
+IoUring::~IoUring() { close(); }
+
+// MANIPULATORS
+
+int IoUring::open(unsigned entries)
+{
+  close();
+
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  d_fd = ioUringSetup(entries, &params);
+  if (0 > d_fd) {
+    const int error = errno;
+    d_fd            = -1;
+    return -error;
+  }
+
+  d_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  d_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  const bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single) {
+    d_sqRingSize = d_cqRingSize = std::max(d_sqRingSize, d_cqRingSize);
+  }
+
+  d_sqRing = mmap(nullptr,
+                  d_sqRingSize,
+                  PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE,
+                  d_fd,
+                  IORING_OFF_SQ_RING);
+  if (MAP_FAILED == d_sqRing) {
+    const int error = errno;
+    d_sqRing        = nullptr;
+    close();
+    return -error;
+  }
+
+  if (single) {
+    d_cqRing = d_sqRing;
+  } else {
+    d_cqRing = mmap(nullptr,
+                    d_cqRingSize,
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE,
+                    d_fd,
+                    IORING_OFF_CQ_RING);
+    if (MAP_FAILED == d_cqRing) {
+      const int error = errno;
+      d_cqRing        = nullptr;
+      close();
+      return -error;
+    }
+  }
+
+  d_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr,
+                    d_sqesSize,
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE,
+                    d_fd,
+                    IORING_OFF_SQES);
+  if (MAP_FAILED == sqes) {
+    const int error = errno;
+    close();
+    return -error;
+  }
+  d_sqes = static_cast<io_uring_sqe *>(sqes);
+
+  d_sqHead      = at<unsigned>(d_sqRing, params.sq_off.head);
+  d_sqTail      = at<unsigned>(d_sqRing, params.sq_off.tail);
+  d_sqArray     = at<unsigned>(d_sqRing, params.sq_off.array);
+  d_sqMask      = *at<unsigned>(d_sqRing, params.sq_off.ring_mask);
+  d_sqEntries   = params.sq_entries;
+  d_sqLocalTail = *d_sqTail;
+  d_sqPending   = 0;
+
+  d_cqHead = at<unsigned>(d_cqRing, params.cq_off.head);
+  d_cqTail = at<unsigned>(d_cqRing, params.cq_off.tail);
+  d_cqes   = at<io_uring_cqe>(d_cqRing, params.cq_off.cqes);
+  d_cqMask = *at<unsigned>(d_cqRing, params.cq_off.ring_mask);
+
+  return 0;
+}
+
+void IoUring::close()
+{
+  if (d_sqes) {
+    munmap(d_sqes, d_sqesSize);
+  }
+  if (d_cqRing && d_cqRing != d_sqRing) {
+    munmap(d_cqRing, d_cqRingSize);
+  }
+  if (d_sqRing) {
+    munmap(d_sqRing, d_sqRingSize);
+  }
+  if (0 <= d_fd) {
+    ::close(d_fd);
+  }
+
+  d_fd        = -1;
+  d_sqRing    = nullptr;
+  d_cqRing    = nullptr;
+  d_sqes      = nullptr;
+  d_sqEntries = 0;
+  d_sqPending = 0;
+}
+
+io_uring_sqe *IoUring::getSqe()
+{
+  const unsigned head = __atomic_load_n(d_sqHead, __ATOMIC_ACQUIRE);
+
+  if (d_sqLocalTail - head >= d_sqEntries) {
+    return nullptr;
+  }
+
+  const unsigned index = d_sqLocalTail & d_sqMask;
+  io_uring_sqe  *sqe   = d_sqes + index;
+  memset(sqe, 0, sizeof(*sqe));
+
+  d_sqArray[index] = index;
+  ++d_sqLocalTail;
+  ++d_sqPending;
+
+  return sqe;
+}
+
+int IoUring::submit(unsigned waitCount)
+{
+  __atomic_store_n(d_sqTail, d_sqLocalTail, __ATOMIC_RELEASE);
+
+  const int rc = ioUringEnter(
+      d_fd, d_sqPending, waitCount, waitCount ? IORING_ENTER_GETEVENTS : 0);
+  if (0 > rc) {
+    return -errno;
+  }
+
+  d_sqPending -= std::min<unsigned>(rc, d_sqPending);
+  return rc;
+}
+
+int IoUring::wait()
+{
+  const int rc = ioUringEnter(d_fd, 0, 1, IORING_ENTER_GETEVENTS);
+  return 0 > rc ? -errno : 0;
+}
+
+int IoUring::registerBuffers(const iovec *buffers, unsigned count)
+{
+  const int rc = ioUringRegister(d_fd, IORING_REGISTER_BUFFERS, buffers, count);
+  return 0 > rc ? -errno : 0;
+}
+
+int IoUring::unregisterBuffers()
+{
+  const int rc = ioUringRegister(d_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+  return 0 > rc ? -errno : 0;
+}
+
+} // namespace mdio
+} // namespace MvdS
@@ -0,0 +1,177 @@
+// mdio_iouring.h                                                       -*-c++-*-
+#ifndef __INCLUDED_MDIO_IOURING
+#define __INCLUDED_MDIO_IOURING
+
+#include <cstddef>
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+namespace MvdS {
+namespace mdio {
+
+// =============
+// Class IoUring
+// =============
+
+class IoUring
+{
+  // Provides a minimal io_uring instance on top of the raw system calls,
+  // without depending on liburing.
+  //
+  // Submission queue entries are obtained with 'getSqe', filled in, and
+  // handed to the kernel in batches with 'submit'. Completions are consumed
+  // with 'reap'. This class is not thread-safe, except that one thread may
+  // 'wait' and 'reap' while another thread prepares and submits entries.
+
+  // DATA
+
+  int           d_fd;           // Ring file descriptor, or -1.
+  void *        d_sqRing;       // Mapped submission queue ring.
+  size_t        d_sqRingSize;
+  void *        d_cqRing;       // Mapped completion queue ring.
+  size_t        d_cqRingSize;
+  io_uring_sqe *d_sqes;         // Mapped submission queue entries.
+  size_t        d_sqesSize;
+  unsigned *    d_sqHead;
+  unsigned *    d_sqTail;
+  unsigned *    d_sqArray;
+  unsigned      d_sqMask;
+  unsigned      d_sqEntries;
+  unsigned      d_sqLocalTail;  // Tail including unpublished entries.
+  unsigned      d_sqPending;    // Entries prepared but not submitted.
+  unsigned *    d_cqHead;
+  unsigned *    d_cqTail;
+  io_uring_cqe *d_cqes;
+  unsigned      d_cqMask;
+
+public:
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+
+  // CLASS METHODS
+
+  static bool isSupported();
+  // Return true if the running kernel allows creating io_uring instances.
+
+  // CREATORS
+
+  IoUring();
+  // Create a closed ring.
+
+  ~IoUring();
+  // Close the ring.
+
+  // MANIPULATORS
+
+  int open(unsigned entries);
+  // Create a ring with at least the specified 'entries' submission queue
+  // entries. Return 0 on success or a negative 'errno' value.
+
+  void close();
+  // Release the ring. Outstanding operations are cancelled by the kernel.
+
+  io_uring_sqe *getSqe();
+  // Return a cleared submission queue entry, or null if the submission
+  // queue is full and 'submit' must be called first.
+
+  int submit(unsigned waitCount = 0);
+  // Hand all prepared entries to the kernel and, optionally, wait for the
+  // specified 'waitCount' completions. Return the number of entries
+  // submitted or a negative 'errno' value.
+
+  int wait();
+  // Block until at least one completion is available. Return 0 on success
+  // or a negative 'errno' value.
+
+  template <class VISITOR>
+  unsigned reap(VISITOR &&visitor);
+  // Invoke the specified 'visitor' with every available completion queue
+  // entry and release the entries. Return the number of entries visited.
+
+  template <class VISITOR>
+  unsigned discardPending(VISITOR &&visitor);
+  // Take back the prepared entries that the kernel has not consumed,
+  // invoking the specified 'visitor' with every entry, and return the
+  // number of entries discarded. Used after 'submit' failed, so the
+  // operations of the entries can be failed instead of retried forever.
+
+  int registerBuffers(const iovec *buffers, unsigned count);
+  // Register the specified 'count' 'buffers' for fixed buffer operations.
+  // Return 0 on success or a negative 'errno' value.
+
+  int unregisterBuffers();
+  // Unregister the registered buffers. Return 0 on success or a negative
+  // 'errno' value.
+
+  // ACCESSORS
+
+  bool isOpen() const
+  // Return true if the ring is open.
+  {
+    return 0 <= d_fd;
+  }
+
+  unsigned entries() const
+  // Return the number of submission queue entries.
+  {
+    return d_sqEntries;
+  }
+
+  unsigned pending() const
+  // Return the number of prepared entries not yet submitted.
+  {
+    return d_sqPending;
+  }
+};
+
+// ============================================================================
+//                            INLINE DEFINITIONS
+// ============================================================================
+
+// -------------
+// Class IoUring
+// -------------
+
+// MANIPULATORS
+
+template <class VISITOR>
+unsigned IoUring::reap(VISITOR &&visitor)
+{
+  unsigned       head  = __atomic_load_n(d_cqHead, __ATOMIC_RELAXED);
+  const unsigned tail  = __atomic_load_n(d_cqTail, __ATOMIC_ACQUIRE);
+  unsigned       count = 0;
+
+  while (head != tail) {
+    visitor(d_cqes[head & d_cqMask]);
+    ++head;
+    ++count;
+  }
+
+  __atomic_store_n(d_cqHead, head, __ATOMIC_RELEASE);
+  return count;
+}
+
+template <class VISITOR>
+unsigned IoUring::discardPending(VISITOR &&visitor)
+{
+  // Without a kernel polling thread the kernel only consumes entries while
+  // 'submit' runs, so the entries after the head can be taken back.
+  const unsigned head  = __atomic_load_n(d_sqHead, __ATOMIC_ACQUIRE);
+  unsigned       count = 0;
+
+  for (unsigned i = head; i != d_sqLocalTail; ++i) {
+    visitor(d_sqes[d_sqArray[i & d_sqMask]]);
+    ++count;
+  }
+
+  d_sqLocalTail = head;
+  d_sqPending   = 0;
+  __atomic_store_n(d_sqTail, head, __ATOMIC_RELEASE);
+  return count;
+}
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_IOURING
@@ -0,0 +1,140 @@
+// mdio_iouring.t.cpp                                                   -*-c++-*-
+#include <mdio_iouring.h>
+
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  if (!IoUring::isSupported()) {
+    cerr << "io_uring is not supported, skipping." << endl;
+    return 0;
+  }
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 3:
+    {
+      // Prepared entries that were not submitted can be taken back.
+      IoUring ring;
+      ASSERT(0 == ring.open(4));
+
+      for (uint64_t i = 1; i <= 2; ++i) {
+	io_uring_sqe *sqe = ring.getSqe();
+	sqe->opcode       = IORING_OP_NOP;
+	sqe->user_data    = i;
+      }
+      ASSERT(2 == ring.submit());
+
+      for (uint64_t i = 3; i <= 5; ++i) {
+	io_uring_sqe *sqe = ring.getSqe();
+	sqe->opcode       = IORING_OP_NOP;
+	sqe->user_data    = i;
+      }
+
+      uint64_t sum = 0;
+      ASSERT(3 == ring.discardPending([&sum](const io_uring_sqe& sqe) {
+	    sum += sqe.user_data;
+	  }));
+      ASSERT(12 == sum);
+      ASSERT(0 == ring.pending());
+      ASSERT(0 == ring.submit());
+
+      // Only the submitted entries complete.
+      sum = 0;
+      unsigned count = 0;
+      while (count < 2) {
+	ASSERT(0 == ring.wait());
+	count += ring.reap([&sum](const io_uring_cqe& cqe) {
+	    sum += cqe.user_data;
+	  });
+      }
+      ASSERT(3 == sum);
+      ASSERT(0 == ring.reap([](const io_uring_cqe&) {}));
+    } break;
+
+  case 2:
+    {
+      // A full submission queue is reported and drained by 'submit'.
+      IoUring ring;
+      ASSERT(0 == ring.open(4));
+
+      unsigned prepared = 0;
+      while (io_uring_sqe *sqe = ring.getSqe()) {
+	sqe->opcode    = IORING_OP_NOP;
+	sqe->user_data = ++prepared;
+      }
+      ASSERT(ring.entries() == prepared);
+      ASSERT(prepared == ring.pending());
+
+      ASSERT(int(prepared) == ring.submit(prepared));
+      ASSERT(nullptr != ring.getSqe());
+
+      unsigned reaped = ring.reap([](const io_uring_cqe&) {});
+      ASSERT(prepared == reaped);
+    } break;
+
+  case 1:
+    {
+      // Batched no-op entries complete with their user data.
+      IoUring ring;
+      ASSERT(!ring.isOpen());
+      ASSERT(0 == ring.open(8));
+      ASSERT(ring.isOpen());
+      ASSERT(8 <= ring.entries());
+
+      for (uint64_t i = 1; i <= 3; ++i) {
+	io_uring_sqe *sqe = ring.getSqe();
+	ASSERT(sqe);
+	sqe->opcode    = IORING_OP_NOP;
+	sqe->user_data = i;
+      }
+
+      ASSERT(3 == ring.submit());
+      ASSERT(0 == ring.pending());
+
+      uint64_t sum   = 0;
+      unsigned count = 0;
+      while (count < 3) {
+	ASSERT(0 == ring.wait());
+	count += ring.reap([&sum](const io_uring_cqe& cqe) {
+	    sum += cqe.user_data;
+	  });
+      }
+      ASSERT(6 == sum);
+
+      ring.close();
+      ASSERT(!ring.isOpen());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,170 @@
+// mdio_mappedfile.cpp                                                  -*-c++-*-
+#include <mdio_mappedfile.h>
+
+#include <cerrno>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MvdS {
+namespace mdio {
+
+namespace {
+
+int adviceFlag(MappedFile::Advice advice)
+{
+  switch (advice) {
+  case MappedFile::e_sequential:
+    return MADV_SEQUENTIAL;
+  case MappedFile::e_random:
+    return MADV_RANDOM;
+  case MappedFile::e_willNeed:
+    return MADV_WILLNEED;
+  case MappedFile::e_normal:
+  default:
+    return MADV_NORMAL;
+  }
+}
+
+} // namespace
+
+// ----------------
+// Class MappedFile
+// ----------------
+
+// PRIVATE CLASS METHODS
+
+void MappedFile::releaseMapping(SharedBuffer_Rep *rep)
+{
+  munmap(rep->d_data, rep->d_size);
+
+  mdmem::Allocator *allocator = rep->d_allocator_p;
+  rep->~SharedBuffer_Rep();
+  allocator->deallocate(rep, sizeof(SharedBuffer_Rep), alignof(SharedBuffer_Rep));
+}
+
+// CLASS METHODS
+
+size_t MappedFile::pageSize()
+{
+  static const size_t s_pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return s_pageSize;
+}
+
+// MANIPULATORS
+
+int MappedFile::open(const char *path, const Configuration &config)
+{
+  const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -errno;
+  }
+
+  const int result = open(fd, config);
+  ::close(fd);
+  return result;
+}
+
+int MappedFile::open(int fd, const Configuration &config)
+{
+  close();
+
+  struct stat status;
+  if (0 != fstat(fd, &status)) {
+    return -errno;
+  }
+
+  const size_t fileSize = static_cast<size_t>(status.st_size);
+  const size_t offset   = static_cast<size_t>(config.d_offset);
+  if (config.d_offset < 0 || fileSize < offset) {
+    return -EINVAL;
+  }
+
+  const size_t length = config.d_length < fileSize - offset
+                            ? config.d_length
+                            : fileSize - offset;
+  if (0 == length) {
+    return 0;
+  }
+
+  // The mapping has to start on a page boundary.
+  const size_t delta = offset % pageSize();
+
+  int flags = MAP_SHARED;
+  if (config.d_populate) {
+    flags |= MAP_POPULATE;
+  }
+
+  void *address = mmap(nullptr,
+                       length + delta,
+                       PROT_READ,
+                       flags,
+                       fd,
+                       static_cast<off_t>(offset - delta));
+  if (MAP_FAILED == address) {
+    return -errno;
+  }
+
+  SharedBuffer_Rep *rep;
+  try {
+    rep = new (d_allocator_p->allocate(sizeof(SharedBuffer_Rep),
+                                       alignof(SharedBuffer_Rep)))
+        SharedBuffer_Rep();
+  } catch (...) {
+    munmap(address, length + delta);
+    throw;
+  }
+
+  rep->d_refCount.store(1, std::memory_order_relaxed);
+  rep->d_releaser    = &releaseMapping;
+  rep->d_data        = static_cast<char *>(address);
+  rep->d_size        = length + delta;
+  rep->d_context_p   = nullptr;
+  rep->d_allocator_p = d_allocator_p;
+
+  d_rep_p  = rep;
+  d_buffer = rep->d_data + delta;
+  d_size   = length;
+
+  if (e_normal != config.d_advice) {
+    advise(config.d_advice);
+  }
+
+  return 0;
+}
+
+void MappedFile::close()
+{
+  if (d_rep_p) {
+    d_rep_p->release();
+    d_rep_p = nullptr;
+  }
+  d_buffer = 0;
+  d_size   = 0;
+}
+
+// ACCESSORS
+
+int MappedFile::advise(Advice advice, size_t offset, size_t length) const
+{
+  if (0 == length) {
+    return 0;
+  }
+
+  // 'madvise' requires a page aligned address.
+  const size_t start = reinterpret_cast<size_t>(d_buffer + offset);
+  const size_t delta = start % pageSize();
+
+  if (0 != madvise(const_cast<char *>(d_buffer + offset - delta),
+                   length + delta,
+                   adviceFlag(advice))) {
+    return -errno;
+  }
+  return 0;
+}
+
+} // namespace mdio
+} // namespace MvdS
@@ -0,0 +1,189 @@
+// mdio_mappedfile.h                                                    -*-c++-*-
+#ifndef __INCLUDED_MDIO_MAPPEDFILE
+#define __INCLUDED_MDIO_MAPPEDFILE
+
+#include <mdio_buffer.h>
+#include <mdio_sharedbuffer.h>
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <cstddef>
+#include <utility>
+
+#include <sys/types.h>
+
+namespace MvdS {
+namespace mdio {
+
+// ================
+// Class MappedFile
+// ================
+
+class MappedFile : public ConstBuffer
+{
+  // Provides a read-only memory mapping of a file, or of a range of it, as
+  // a 'ConstBuffer'.
+  //
+  // The contents are paged in on first access and live in the page cache,
+  // so they are shared with every other process mapping the same file
+  // instead of being copied to the heap. The mapping is reference counted
+  // like a 'SharedBuffer': copies of the object and 'BufferSlice's created
+  // by 'slice' keep it alive, and it is unmapped when the last of them is
+  // dropped. Kernel readahead can be steered with 'advise', and
+  // 'd_populate' prefaults the whole range when the mapping is created.
+
+public:
+  // PUBLIC TYPES
+
+  enum Advice
+  {
+    e_normal,     // Default readahead.
+    e_sequential, // Aggressive readahead, pages may be dropped after use.
+    e_random,     // No readahead.
+    e_willNeed    // Start reading the range in the background.
+  };
+
+  struct Configuration
+  {
+    off_t  d_offset;   // Start of the mapped range in the file.
+    size_t d_length;   // Bytes to map, 'npos' to map up to the end.
+    Advice d_advice;   // Initial advice for the mapped range.
+    bool   d_populate; // Prefault all pages, see 'MAP_POPULATE'.
+
+    Configuration()
+        : d_offset(0)
+        , d_length(npos)
+        , d_advice(e_normal)
+        , d_populate(false)
+    {}
+  };
+
+  // PUBLIC CONSTANTS
+
+  static const size_t npos = size_t(-1);
+
+private:
+  // DATA
+
+  SharedBuffer_Rep *d_rep_p;
+  mdmem::Allocator *d_allocator_p; // Allocator of the control block.
+
+  // PRIVATE CLASS METHODS
+
+  static void releaseMapping(SharedBuffer_Rep *rep);
+
+public:
+  // CLASS METHODS
+
+  static size_t pageSize();
+  // Return the page size of the system.
+
+  // CREATORS
+
+  explicit MappedFile(mdmem::Allocator *allocator = 0)
+      // Create an unmapped file. Optionally the specified 'allocator' is used
+      // for the control block of mappings.
+      : ConstBuffer(0, 0)
+      , d_rep_p(nullptr)
+      , d_allocator_p(mdmem::AllocatorUtil::defaultAllocator(allocator))
+  {}
+
+  MappedFile(const MappedFile &other)
+      // Create a mapped file sharing the mapping of the specified 'other'.
+      : ConstBuffer(other.d_buffer, other.d_size)
+      , d_rep_p(other.d_rep_p)
+      , d_allocator_p(other.d_allocator_p)
+  {
+    if (d_rep_p) {
+      d_rep_p->acquire();
+    }
+  }
+
+  MappedFile(MappedFile &&other) noexcept
+      // Take over the mapping of the specified 'other', leaving 'other'
+      // unmapped.
+      : ConstBuffer(other.d_buffer, other.d_size)
+      , d_rep_p(other.d_rep_p)
+      , d_allocator_p(other.d_allocator_p)
+  {
+    other.d_buffer = 0;
+    other.d_size   = 0;
+    other.d_rep_p  = nullptr;
+  }
+
+  ~MappedFile() { close(); }
+
+  // MANIPULATORS
+
+  MappedFile &operator=(MappedFile other) noexcept
+  {
+    swap(other);
+    return *this;
+  }
+
+  void swap(MappedFile &other) noexcept
+  {
+    std::swap(d_buffer, other.d_buffer);
+    std::swap(d_size, other.d_size);
+    std::swap(d_rep_p, other.d_rep_p);
+    std::swap(d_allocator_p, other.d_allocator_p);
+  }
+
+  int open(const char *path, const Configuration &config = Configuration());
+  // Map the range of the file with the specified 'path' described by the
+  // specified 'config', replacing the current mapping. Return 0 on success
+  // or a negative 'errno' value. An empty range is not mapped but opens
+  // successfully with a size of 0.
+
+  int open(int fd, const Configuration &config = Configuration());
+  // Map the range of the file open for reading on the specified 'fd'
+  // described by the specified 'config'. The descriptor may be closed
+  // afterwards. Return 0 on success or a negative 'errno' value.
+
+  void close();
+  // Drop the reference to the mapping and make this object empty. The
+  // mapping stays alive as long as slices refer to it.
+
+  // ACCESSORS
+
+  int advise(Advice advice) const
+  // Apply the specified 'advice' to the whole mapped range. Return 0 on
+  // success or a negative 'errno' value.
+  {
+    return advise(advice, 0, d_size);
+  }
+
+  int advise(Advice advice, size_t offset, size_t length) const;
+  // Apply the specified 'advice' to the specified 'length' bytes at the
+  // specified 'offset' of the mapped range. Return 0 on success or a
+  // negative 'errno' value. Behavior is undefined unless
+  // 'offset + length <= size()'.
+
+  BufferSlice slice(size_t offset = 0, size_t length = npos) const
+  // Return a slice of at most 'length' bytes starting at the specified
+  // 'offset' that keeps the mapping alive. Behavior is undefined unless
+  // 'offset <= size()'.
+  {
+    const size_t remaining = d_size - offset;
+    return BufferSlice(
+        d_rep_p, d_buffer + offset, length < remaining ? length : remaining);
+  }
+
+  bool isMapped() const
+  // Return true if a non-empty range is mapped.
+  {
+    return nullptr != d_rep_p;
+  }
+
+  size_t useCount() const
+  // Return the number of references to the mapping, or 0 if nothing is
+  // mapped. Note that the value may be stale when returned.
+  {
+    return d_rep_p ? d_rep_p->d_refCount.load(std::memory_order_relaxed) : 0;
+  }
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_MAPPEDFILE
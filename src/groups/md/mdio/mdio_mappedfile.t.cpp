@@ -0,0 +1,179 @@
+// mdio_mappedfile.t.cpp                                                -*-c++-*-
+#include <mdio_mappedfile.h>
+
+#include <mdmem_testallocator.h>
+
+#include <cerrno>
+#include <iostream>
+#include <string>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+typedef MappedFile::Configuration Conf;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+std::string str(const ConstBuffer& buffer)
+{
+  return std::string(buffer.buffer(), buffer.size());
+}
+
+class TemporaryFile {
+  // Creates a file with the given contents and removes it on destruction.
+
+  std::string d_path;
+
+public:
+  explicit TemporaryFile(const std::string& contents)
+    : d_path("/tmp/mdio_mappedfile.XXXXXX")
+  {
+    const int fd = mkstemp(&d_path[0]);
+    ASSERT(0 <= fd);
+    ASSERT(ssize_t(contents.size()) == write(fd, contents.data(), contents.size()));
+    close(fd);
+  }
+
+  ~TemporaryFile() { unlink(d_path.c_str()); }
+
+  const char *path() const { return d_path.c_str(); }
+};
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 4:
+    {
+      // Errors and empty ranges.
+      MappedFile o;
+
+      ASSERT(-ENOENT == o.open("/nonexistent/mdio_mappedfile"));
+      ASSERT(!o.isMapped());
+
+      TemporaryFile empty("");
+      ASSERT(0 == o.open(empty.path()));
+      ASSERT(!o.isMapped());
+      ASSERT(0 == o.size());
+      ASSERT(0 == o.slice().size());
+
+      TemporaryFile file("abc");
+      Conf conf;
+      conf.d_offset = 4;
+      ASSERT(-EINVAL == o.open(file.path(), conf));
+      conf.d_offset = 3;
+      ASSERT(0 == o.open(file.path(), conf));
+      ASSERT(0 == o.size());
+    } break;
+
+  case 3:
+    {
+      // Slices keep the mapping alive after the file is closed.
+      mdmem::TestAllocator ta;
+      TemporaryFile        file("The quick brown fox");
+
+      BufferSlice slice;
+      {
+	MappedFile o(&ta);
+	ASSERT(0 == o.open(file.path()));
+	ASSERT(1 == ta.allocationCount());
+
+	slice = o.slice(4, 5);
+	ASSERT(2 == o.useCount());
+
+	MappedFile copy(o);
+	ASSERT(3 == o.useCount());
+	ASSERT(copy.buffer() == o.buffer());
+      }
+
+      ASSERT("quick" == str(slice));
+      ASSERT(1 == slice.useCount());
+      ASSERT(0 == ta.deallocationCount());
+
+      slice.reset();
+      ASSERT(1 == ta.deallocationCount());
+    } break;
+
+  case 2:
+    {
+      // Ranges at unaligned offsets, with hints and population.
+      std::string contents;
+      for (size_t i = 0; contents.size() < 3 * MappedFile::pageSize(); ++i) {
+	contents += std::to_string(i) + ',';
+      }
+      TemporaryFile file(contents);
+
+      Conf conf;
+      conf.d_offset   = MappedFile::pageSize() + 7;
+      conf.d_length   = 100;
+      conf.d_advice   = MappedFile::e_willNeed;
+      conf.d_populate = true;
+
+      MappedFile o;
+      ASSERT(0 == o.open(file.path(), conf));
+      ASSERT(100 == o.size());
+      ASSERT(contents.substr(conf.d_offset, 100) == str(o));
+
+      ASSERT(0 == o.advise(MappedFile::e_sequential));
+      ASSERT(0 == o.advise(MappedFile::e_random, 10, 20));
+      ASSERT(0 == o.advise(MappedFile::e_normal));
+
+      // The length is clipped to the end of the file.
+      conf.d_length = MappedFile::npos;
+      conf.d_advice = MappedFile::e_sequential;
+      ASSERT(0 == o.open(file.path(), conf));
+      ASSERT(contents.substr(conf.d_offset) == str(o));
+    } break;
+
+  case 1:
+    {
+      // Breathing test.
+      TemporaryFile file("Hello, world!");
+
+      MappedFile o;
+      ASSERT(!o.isMapped());
+      ASSERT(0 == o.open(file.path()));
+      ASSERT(o.isMapped());
+      ASSERT(1 == o.useCount());
+      ASSERT("Hello, world!" == str(o));
+      ASSERT("world" == str(o.slice(7, 5)));
+      ASSERT("world!" == str(o.slice(7)));
+
+      MappedFile other(std::move(o));
+      ASSERT(!o.isMapped());
+      ASSERT("Hello, world!" == str(other));
+
+      other.close();
+      ASSERT(!other.isMapped());
+      ASSERT(0 == other.size());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,728 @@
+// mdio_reactor.cpp                                                     -*-c++-*-
+#include <mdio_reactor.h>
+
+#include <mdio_buffervectorutil.h>
+
+#include <cerrno>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace MvdS {
+namespace mdio {
+
+namespace {
+
+const uint32_t k_connectionEvents =
+    EPOLLIN | EPOLLRDHUP | EPOLLET | EPOLLONESHOT;
+// Events of interest of an idle connection.
+
+int setNonBlocking(int fd)
+{
+  const int flags = fcntl(fd, F_GETFL);
+  if (flags < 0 || 0 != fcntl(fd, F_SETFL, flags | O_NONBLOCK)) {
+    return -errno;
+  }
+  return 0;
+}
+
+} // namespace
+
+// ===============
+// Struct Listener
+// ===============
+
+struct Reactor::Listener
+{
+  Reactor_Handle            d_handle;
+  std::shared_ptr<Handlers> d_handlers;
+};
+
+// -----------------------
+// Class ReactorConnection
+// -----------------------
+
+// PRIVATE MANIPULATORS
+
+int ReactorConnection::flush()
+{
+  while (!d_output.empty()) {
+    iovec  iovecs[BufferVectorUtil::k_maximumIovecs];
+    msghdr message    = msghdr();
+    message.msg_iov    = iovecs;
+    message.msg_iovlen = d_output.iovecs(iovecs, BufferVectorUtil::k_maximumIovecs);
+
+    const ssize_t result =
+        sendmsg(d_handle.d_fd, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (result < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      return EAGAIN == errno || EWOULDBLOCK == errno ? 0 : errno;
+    }
+
+    d_output.consume(result);
+  }
+  return 0;
+}
+
+// CREATORS
+
+ReactorConnection::ReactorConnection(
+    Reactor *                                 reactor,
+    int                                       fd,
+    const std::shared_ptr<Reactor::Handlers> &handlers,
+    mdmem::Allocator *                        allocator)
+    : d_handle{Reactor_Handle::e_connection, fd, this}
+    , d_reactor_p(reactor)
+    , d_handlers(handlers)
+    , d_output(reactor->d_config.d_readBufferSize, allocator)
+    , d_busy(false)
+    , d_pendingEvents(0)
+    , d_closed(false)
+    , d_input(reactor->d_config.d_readBufferSize, allocator)
+    , d_userData_p(nullptr)
+{}
+
+ReactorConnection::~ReactorConnection()
+{
+  if (!d_closed) {
+    ::close(d_handle.d_fd);
+  }
+}
+
+// MANIPULATORS
+
+bool ReactorConnection::write(const char *data, size_t size)
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+
+  if (d_closed) {
+    return false;
+  }
+
+  if (d_output.empty()) {
+    while (0 < size) {
+      const ssize_t result =
+          send(d_handle.d_fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (result < 0) {
+        if (EINTR == errno) {
+          continue;
+        }
+        if (EAGAIN != errno && EWOULDBLOCK != errno) {
+          // The error is reported by the reactor.
+          return true;
+        }
+        break;
+      }
+      data += result;
+      size -= result;
+    }
+
+    if (0 == size) {
+      return true;
+    }
+  }
+
+  const bool wasEmpty = d_output.empty();
+  d_output.append(data, size);
+
+  if (wasEmpty && !d_busy) {
+    d_reactor_p->rearm(this);
+  }
+  return true;
+}
+
+void ReactorConnection::close()
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+
+  if (!d_closed) {
+    d_output.clear();
+    shutdown(d_handle.d_fd, SHUT_RDWR);
+  }
+}
+
+// ACCESSORS
+
+bool ReactorConnection::isClosed() const
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  return d_closed;
+}
+
+size_t ReactorConnection::pendingOutput() const
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  return d_output.size();
+}
+
+// -------------
+// Class Reactor
+// -------------
+
+// PRIVATE MANIPULATORS
+
+void Reactor::armTimer()
+{
+  itimerspec spec = itimerspec();
+
+  if (!d_timers.empty()) {
+    const auto deadline = d_timers.begin()->first.first.time_since_epoch();
+    const auto seconds =
+        std::chrono::duration_cast<std::chrono::seconds>(deadline);
+
+    spec.it_value.tv_sec = seconds.count();
+    spec.it_value.tv_nsec =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - seconds)
+            .count();
+    if (0 == spec.it_value.tv_sec && 0 == spec.it_value.tv_nsec) {
+      spec.it_value.tv_nsec = 1;
+    }
+  }
+
+  timerfd_settime(d_timer.d_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void Reactor::onWakeup()
+{
+  uint64_t count;
+  while (0 > read(d_wakeup.d_fd, &count, sizeof(count)) && EINTR == errno) {
+  }
+
+  std::experimental::pmr::vector<Job> posted(d_allocator_p);
+  {
+    std::lock_guard<std::mutex> lock(d_mutex);
+    posted.swap(d_posted);
+  }
+
+  for (Job &job : posted) {
+    job();
+  }
+}
+
+void Reactor::onTimer()
+{
+  uint64_t count;
+  while (0 > read(d_timer.d_fd, &count, sizeof(count)) && EINTR == errno) {
+  }
+
+  std::experimental::pmr::vector<Job> expired(d_allocator_p);
+  {
+    std::lock_guard<std::mutex> lock(d_mutex);
+
+    const TimePoint now = std::chrono::steady_clock::now();
+    while (!d_timers.empty() && d_timers.begin()->first.first <= now) {
+      d_timerIndex.erase(d_timers.begin()->first.second);
+      expired.push_back(std::move(d_timers.begin()->second));
+      d_timers.erase(d_timers.begin());
+    }
+
+    armTimer();
+  }
+
+  for (Job &job : expired) {
+    dispatch(std::move(job));
+  }
+}
+
+void Reactor::onAccept(Listener *listener)
+{
+  while (true) {
+    const int fd = accept4(
+        listener->d_handle.d_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (EINTR == errno || ECONNABORTED == errno) {
+        continue;
+      }
+      // EAGAIN when drained. Resource exhaustion leaves the connection in
+      // the backlog until the next connection arrives.
+      return;
+    }
+
+    addConnection(fd, listener->d_handlers);
+  }
+}
+
+void Reactor::onConnection(ReactorConnection *connection, uint32_t events)
+{
+  {
+    std::lock_guard<std::mutex> lock(connection->d_mutex);
+    if (connection->d_busy) {
+      // Re-armed by a concurrent 'write' while a job is in progress: leave
+      // the events to that job.
+      connection->d_pendingEvents |= events;
+      return;
+    }
+    connection->d_busy = true;
+  }
+
+  ConnectionPtr pointer = connection->shared_from_this();
+
+  ++d_pendingJobs;
+  if (d_executor_p) {
+    Job job([this, pointer, events]() mutable {
+      process(pointer, events);
+
+      // Drop the reference before the reactor may be destroyed.
+      pointer.reset();
+      --d_pendingJobs;
+    });
+    if (d_executor_p->execute(std::move(job))) {
+      return;
+    }
+  }
+
+  process(pointer, events);
+  --d_pendingJobs;
+}
+
+void Reactor::process(const ConnectionPtr &connection, uint32_t events)
+{
+  ReactorConnection *c = connection.get();
+
+  while (true) {
+    int  error = 0;
+    bool done  = false;
+
+    if (events & EPOLLERR) {
+      socklen_t length = sizeof(error);
+      getsockopt(c->d_handle.d_fd, SOL_SOCKET, SO_ERROR, &error, &length);
+      done = true;
+    }
+
+    if (!done && (events & EPOLLOUT)) {
+      std::lock_guard<std::mutex> lock(c->d_mutex);
+      error = c->flush();
+      done  = 0 != error;
+    }
+
+    if (!done && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))) {
+      while (true) {
+        const ssize_t result = BufferVectorUtil::readv(
+            c->d_handle.d_fd, &c->d_input, d_config.d_maximumReadSize);
+        if (0 < result) {
+          // A short read drained the socket. Re-arming reports data that
+          // arrives later.
+          if (static_cast<size_t>(result) < d_config.d_maximumReadSize) {
+            break;
+          }
+          continue;
+        }
+        if (0 == result) {
+          done = true;
+        } else if (EAGAIN != errno && EWOULDBLOCK != errno) {
+          error = errno;
+          done  = true;
+        }
+        break;
+      }
+    }
+
+    if (!c->d_input.empty() && c->d_handlers->d_data) {
+      c->d_handlers->d_data(connection, &c->d_input);
+    }
+
+    if (done) {
+      finish(connection, error);
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(c->d_mutex);
+    if (0 == c->d_pendingEvents) {
+      c->d_busy = false;
+      rearm(c);
+      return;
+    }
+    events              = c->d_pendingEvents;
+    c->d_pendingEvents = 0;
+  }
+}
+
+void Reactor::rearm(ReactorConnection *connection)
+{
+  if (connection->d_closed) {
+    return;
+  }
+
+  epoll_event event;
+  event.events   = k_connectionEvents;
+  event.data.ptr = &connection->d_handle;
+  if (!connection->d_output.empty()) {
+    event.events |= EPOLLOUT;
+  }
+
+  epoll_ctl(d_epollFd, EPOLL_CTL_MOD, connection->d_handle.d_fd, &event);
+}
+
+void Reactor::finish(const ConnectionPtr &connection, int error)
+{
+  {
+    std::lock_guard<std::mutex> lock(connection->d_mutex);
+    connection->d_closed = true;
+    connection->d_busy   = false;
+    connection->d_output.clear();
+    epoll_ctl(d_epollFd, EPOLL_CTL_DEL, connection->d_handle.d_fd, nullptr);
+    ::close(connection->d_handle.d_fd);
+  }
+
+  if (connection->d_handlers->d_close) {
+    connection->d_handlers->d_close(connection, error);
+  }
+
+  std::lock_guard<std::mutex> lock(d_mutex);
+  d_connections.erase(connection.get());
+}
+
+Reactor::ConnectionPtr
+Reactor::addConnection(int fd, const std::shared_ptr<Handlers> &handlers)
+{
+  if (d_config.d_noDelay) {
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+
+  mdmem::Allocator *allocator =
+      d_config.d_bufferPool_p
+          ? d_config.d_bufferPool_p->tierAllocator(d_config.d_readBufferSize)
+          : d_allocator_p;
+
+  ConnectionPtr connection = std::allocate_shared<ReactorConnection>(
+      std::experimental::pmr::polymorphic_allocator<ReactorConnection>(
+          d_allocator_p),
+      this,
+      fd,
+      handlers,
+      allocator);
+
+  {
+    std::lock_guard<std::mutex> lock(d_mutex);
+    d_connections.emplace(connection.get(), connection);
+  }
+
+  if (handlers->d_open) {
+    handlers->d_open(connection);
+  }
+
+  epoll_event event;
+  event.events   = k_connectionEvents;
+  event.data.ptr = &connection->d_handle;
+  {
+    std::lock_guard<std::mutex> lock(connection->d_mutex);
+    if (!connection->d_output.empty()) {
+      event.events |= EPOLLOUT;
+    }
+    if (0 == epoll_ctl(d_epollFd, EPOLL_CTL_ADD, fd, &event)) {
+      return connection;
+    }
+    connection->d_closed = true;
+  }
+
+  const int error = errno;
+  ::close(fd);
+  {
+    std::lock_guard<std::mutex> lock(d_mutex);
+    d_connections.erase(connection.get());
+  }
+  errno = error;
+  return ConnectionPtr();
+}
+
+void Reactor::dispatch(Job &&job)
+{
+  if (d_executor_p && d_executor_p->execute(Job(job))) {
+    return;
+  }
+  job();
+}
+
+// CLASS METHODS
+
+int Reactor::localPort(int fd)
+{
+  sockaddr_storage address;
+  socklen_t        length = sizeof(address);
+  if (0 != getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length)) {
+    return -errno;
+  }
+
+  switch (address.ss_family) {
+  case AF_INET:
+    return ntohs(reinterpret_cast<sockaddr_in *>(&address)->sin_port);
+  case AF_INET6:
+    return ntohs(reinterpret_cast<sockaddr_in6 *>(&address)->sin6_port);
+  }
+  return -EAFNOSUPPORT;
+}
+
+// CREATORS
+
+Reactor::Reactor(Executor *executor, mdmem::Allocator *allocator)
+    : Reactor(Configuration(), executor, allocator)
+{}
+
+Reactor::Reactor(const Configuration &config,
+                 Executor *           executor,
+                 mdmem::Allocator *   allocator)
+    : d_config(config)
+    , d_executor_p(executor)
+    , d_epollFd(-1)
+    , d_wakeup{Reactor_Handle::e_wakeup, -1, nullptr}
+    , d_timer{Reactor_Handle::e_timer, -1, nullptr}
+    , d_events(mdmem::AllocatorUtil::defaultAllocator(allocator))
+    , d_stopped(false)
+    , d_pendingJobs(0)
+    , d_posted(mdmem::AllocatorUtil::defaultAllocator(allocator))
+    , d_timers(mdmem::AllocatorUtil::defaultAllocator(allocator))
+    , d_timerIndex(mdmem::AllocatorUtil::defaultAllocator(allocator))
+    , d_nextTimerId(0)
+    , d_connections(mdmem::AllocatorUtil::defaultAllocator(allocator))
+    , d_listeners(mdmem::AllocatorUtil::defaultAllocator(allocator))
+    , d_allocator_p(mdmem::AllocatorUtil::defaultAllocator(allocator))
+{}
+
+Reactor::~Reactor()
+{
+  while (0 != d_pendingJobs.load()) {
+    std::this_thread::yield();
+  }
+
+  for (auto &entry : d_connections) {
+    std::lock_guard<std::mutex> lock(entry.first->d_mutex);
+    entry.first->d_closed = true;
+    ::close(entry.first->d_handle.d_fd);
+  }
+  d_connections.clear();
+
+  for (Listener *listener : d_listeners) {
+    ::close(listener->d_handle.d_fd);
+    listener->~Listener();
+    d_allocator_p->deallocate(listener, sizeof(Listener), alignof(Listener));
+  }
+
+  for (int fd : {d_epollFd, d_wakeup.d_fd, d_timer.d_fd}) {
+    if (0 <= fd) {
+      ::close(fd);
+    }
+  }
+}
+
+// MANIPULATORS
+
+int Reactor::open()
+{
+  if (0 <= d_epollFd) {
+    return -EALREADY;
+  }
+
+  d_epollFd    = epoll_create1(EPOLL_CLOEXEC);
+  d_wakeup.d_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  d_timer.d_fd =
+      timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (d_epollFd < 0 || d_wakeup.d_fd < 0 || d_timer.d_fd < 0) {
+    return -errno;
+  }
+
+  for (Reactor_Handle *handle : {&d_wakeup, &d_timer}) {
+    epoll_event event;
+    event.events   = EPOLLIN;
+    event.data.ptr = handle;
+    if (0 != epoll_ctl(d_epollFd, EPOLL_CTL_ADD, handle->d_fd, &event)) {
+      return -errno;
+    }
+  }
+
+  d_events.resize(d_config.d_maximumEvents);
+  return 0;
+}
+
+int Reactor::listen(const sockaddr *address,
+                    socklen_t       length,
+                    const Handlers &handlers,
+                    bool            reusePort,
+                    int             backlog)
+{
+  const int fd =
+      socket(address->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -errno;
+  }
+
+  const int one = 1;
+  if (0 != setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) ||
+      (reusePort &&
+       0 != setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one))) ||
+      0 != bind(fd, address, length) || 0 != ::listen(fd, backlog)) {
+    const int error = errno;
+    ::close(fd);
+    return -error;
+  }
+
+  Listener *listener = new (
+      d_allocator_p->allocate(sizeof(Listener), alignof(Listener))) Listener{
+      {Reactor_Handle::e_listener, fd, nullptr},
+      std::allocate_shared<Handlers>(
+          std::experimental::pmr::polymorphic_allocator<Handlers>(
+              d_allocator_p),
+          handlers)};
+  listener->d_handle.d_object_p = listener;
+
+  epoll_event event;
+  event.events   = EPOLLIN | EPOLLET;
+  event.data.ptr = &listener->d_handle;
+  if (0 != epoll_ctl(d_epollFd, EPOLL_CTL_ADD, fd, &event)) {
+    const int error = errno;
+    ::close(fd);
+    listener->~Listener();
+    d_allocator_p->deallocate(listener, sizeof(Listener), alignof(Listener));
+    return -error;
+  }
+
+  std::lock_guard<std::mutex> lock(d_mutex);
+  d_listeners.push_back(listener);
+  return fd;
+}
+
+Reactor::ConnectionPtr Reactor::connect(const sockaddr *address,
+                                        socklen_t       length,
+                                        const Handlers &handlers)
+{
+  const int fd = socket(address->sa_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return ConnectionPtr();
+  }
+
+  if (0 != ::connect(fd, address, length)) {
+    const int error = errno;
+    ::close(fd);
+    errno = error;
+    return ConnectionPtr();
+  }
+
+  return adopt(fd, handlers);
+}
+
+Reactor::ConnectionPtr Reactor::adopt(int fd, const Handlers &handlers)
+{
+  const int result = setNonBlocking(fd);
+  if (0 != result) {
+    ::close(fd);
+    errno = -result;
+    return ConnectionPtr();
+  }
+
+  return addConnection(
+      fd,
+      std::allocate_shared<Handlers>(
+          std::experimental::pmr::polymorphic_allocator<Handlers>(
+              d_allocator_p),
+          handlers));
+}
+
+void Reactor::post(Job job)
+{
+  bool wake;
+  {
+    std::lock_guard<std::mutex> lock(d_mutex);
+    wake = d_posted.empty();
+    d_posted.push_back(std::move(job));
+  }
+
+  if (wake) {
+    const uint64_t one = 1;
+    while (0 > write(d_wakeup.d_fd, &one, sizeof(one)) && EINTR == errno) {
+    }
+  }
+}
+
+Reactor::TimerId Reactor::runAfter(std::chrono::nanoseconds delay, Job job)
+{
+  const TimePoint deadline = std::chrono::steady_clock::now() + delay;
+
+  std::lock_guard<std::mutex> lock(d_mutex);
+
+  const TimerId id = ++d_nextTimerId;
+  const auto    it = d_timers.emplace(TimerKey(deadline, id), std::move(job)).first;
+  d_timerIndex.emplace(id, deadline);
+
+  if (d_timers.begin() == it) {
+    armTimer();
+  }
+  return id;
+}
+
+bool Reactor::cancel(TimerId timer)
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+
+  const auto it = d_timerIndex.find(timer);
+  if (d_timerIndex.end() == it) {
+    return false;
+  }
+
+  d_timers.erase(TimerKey(it->second, timer));
+  d_timerIndex.erase(it);
+  return true;
+}
+
+int Reactor::poll(int timeout)
+{
+  const int count =
+      epoll_wait(d_epollFd, d_events.data(), d_events.size(), timeout);
+  if (count < 0) {
+    return EINTR == errno ? 0 : -errno;
+  }
+
+  for (int i = 0; i < count; ++i) {
+    Reactor_Handle *handle = static_cast<Reactor_Handle *>(d_events[i].data.ptr);
+
+    switch (handle->d_kind) {
+    case Reactor_Handle::e_wakeup:
+      onWakeup();
+      break;
+    case Reactor_Handle::e_timer:
+      onTimer();
+      break;
+    case Reactor_Handle::e_listener:
+      onAccept(static_cast<Listener *>(handle->d_object_p));
+      break;
+    case Reactor_Handle::e_connection:
+      onConnection(static_cast<ReactorConnection *>(handle->d_object_p),
+                   d_events[i].events);
+      break;
+    }
+  }
+
+  return count;
+}
+
+void Reactor::run()
+{
+  while (!d_stopped.load(std::memory_order_acquire)) {
+    poll(-1);
+  }
+  d_stopped.store(false, std::memory_order_release);
+}
+
+void Reactor::stop()
+{
+  d_stopped.store(true, std::memory_order_release);
+  post([]() {});
+}
+
+// ACCESSORS
+
+size_t Reactor::connectionCount() const
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  return d_connections.size();
+}
+
+} // namespace mdio
+} // namespace MvdS
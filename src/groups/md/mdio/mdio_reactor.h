@@ -0,0 +1,346 @@
+// mdio_reactor.h                                                       -*-c++-*-
+#ifndef __INCLUDED_MDIO_REACTOR
+#define __INCLUDED_MDIO_REACTOR
+
+#include <mdio_buffer.h>
+#include <mdio_bufferpool.h>
+#include <mdio_buffervector.h>
+#include <mdio_executor.h>
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <experimental/map>
+#include <experimental/unordered_map>
+#include <experimental/vector>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+namespace MvdS {
+namespace mdio {
+
+class ReactorConnection;
+
+// =====================
+// Struct Reactor_Handle
+// =====================
+
+struct Reactor_Handle
+{
+  // Registration of a file descriptor with the epoll instance of a reactor.
+
+  enum Kind
+  {
+    e_wakeup,
+    e_timer,
+    e_listener,
+    e_connection
+  };
+
+  Kind  d_kind;
+  int   d_fd;
+  void *d_object_p; // Listener or connection.
+};
+
+// =============
+// Class Reactor
+// =============
+
+class Reactor
+{
+  // Provides an event loop for non-blocking sockets based on epoll.
+  //
+  // A reactor is driven by one thread calling 'run'. Connections are
+  // registered edge-triggered and one-shot: when a connection becomes
+  // ready, the loop hands it to the executor, for example a thread pool,
+  // where a job reads everything available into the input 'BufferVector'
+  // of the connection, calls the data handler and re-arms the connection.
+  // Each connection is thereby processed by at most one thread at a time,
+  // in order, while different connections are processed in parallel.
+  // Without executor, or if it rejects a job, the job runs on the loop
+  // thread. Input buffers are taken from the configured 'BufferPool'.
+  //
+  // Writes are sent immediately if possible; the remainder is queued and
+  // sent when the socket becomes writable. Other threads can wake the loop
+  // with 'post' (via an eventfd) and schedule jobs with 'runAfter' (via a
+  // timerfd). To spread connections over several threads, run one reactor
+  // per thread and 'listen' on the same address in each of them: the
+  // sockets use 'SO_REUSEPORT', so the kernel balances incoming
+  // connections between them.
+
+public:
+  // PUBLIC TYPES
+
+  typedef Executor::Job                      Job;
+  typedef std::shared_ptr<ReactorConnection> ConnectionPtr;
+  typedef uint64_t                           TimerId;
+
+  struct Handlers
+  {
+    std::function<void(const ConnectionPtr &)> d_open;
+    // Called on the loop thread before the connection is registered.
+
+    std::function<void(const ConnectionPtr &, BufferVector *input)> d_data;
+    // Called with the input of the connection after data arrived. Bytes
+    // left in 'input' are kept for the next call.
+
+    std::function<void(const ConnectionPtr &, int error)> d_close;
+    // Called once when the connection is closed, with an 'errno' value or 0
+    // for an orderly close.
+  };
+
+  struct Configuration
+  {
+    int         d_maximumEvents   = 256;   // Events per 'epoll_wait'.
+    size_t      d_readBufferSize  = 4096;  // Size of input buffers.
+    size_t      d_maximumReadSize = 65536; // Bytes per 'readv' call.
+    bool        d_noDelay         = true;  // Set 'TCP_NODELAY'.
+    BufferPool *d_bufferPool_p    = nullptr;
+  };
+
+private:
+  // PRIVATE TYPES
+
+  struct Listener;
+
+  typedef std::chrono::steady_clock::time_point TimePoint;
+  typedef std::pair<TimePoint, TimerId>         TimerKey;
+
+  // DATA
+
+  Configuration                                d_config;
+  Executor *                                   d_executor_p;
+  int                                          d_epollFd;
+  Reactor_Handle                               d_wakeup;
+  Reactor_Handle                               d_timer;
+  std::experimental::pmr::vector<epoll_event>  d_events;
+  std::atomic<bool>                            d_stopped;
+  std::atomic<size_t>                          d_pendingJobs;
+  mutable std::mutex                           d_mutex;
+  std::experimental::pmr::vector<Job>          d_posted;
+  std::experimental::pmr::map<TimerKey, Job>   d_timers;
+  std::experimental::pmr::unordered_map<TimerId, TimePoint> d_timerIndex;
+  TimerId                                      d_nextTimerId;
+  std::experimental::pmr::unordered_map<ReactorConnection *, ConnectionPtr>
+                                               d_connections;
+  std::experimental::pmr::vector<Listener *>   d_listeners;
+  mdmem::Allocator *                           d_allocator_p;
+
+  // PRIVATE MANIPULATORS
+
+  void armTimer();
+  // Set the timerfd to the earliest deadline. The mutex must be locked.
+
+  void onWakeup();
+  void onTimer();
+  void onAccept(Listener *listener);
+  void onConnection(ReactorConnection *connection, uint32_t events);
+
+  void process(const ConnectionPtr &connection, uint32_t events);
+  // Handle the specified 'events' of the specified 'connection'.
+
+  void rearm(ReactorConnection *connection);
+  // Register interest in the next events. The mutex of 'connection' must
+  // be locked.
+
+  void finish(const ConnectionPtr &connection, int error);
+  // Close the specified 'connection' and report the specified 'error'.
+
+  ConnectionPtr addConnection(int                              fd,
+                              const std::shared_ptr<Handlers> &handlers);
+
+  void dispatch(Job &&job);
+  // Run the specified 'job' on the executor, or inline.
+
+  friend class ReactorConnection;
+
+public:
+  Reactor(const Reactor &) = delete;
+  Reactor &operator=(const Reactor &) = delete;
+
+  // CLASS METHODS
+
+  static int localPort(int fd);
+  // Return the port the socket with the specified 'fd' is bound to, or a
+  // negative 'errno' value.
+
+  // CREATORS
+
+  explicit Reactor(Executor *executor = 0, mdmem::Allocator *allocator = 0);
+  // Create a closed reactor that runs connection jobs on the optionally
+  // specified 'executor'. Optionally the specified 'allocator' is used for
+  // memory allocation.
+
+  Reactor(const Configuration &config,
+          Executor *           executor,
+          mdmem::Allocator *   allocator = 0);
+  // Create a closed reactor with the specified 'config' that runs
+  // connection jobs on the specified 'executor', if not null. Optionally
+  // the specified 'allocator' is used for memory allocation.
+
+  ~Reactor();
+  // Wait for the jobs in progress and close all sockets without invoking
+  // handlers. Behavior is undefined if 'run' is in progress.
+
+  // MANIPULATORS
+
+  int open();
+  // Create the epoll instance. Return 0 on success or a negative 'errno'
+  // value.
+
+  int listen(const sockaddr *  address,
+             socklen_t         length,
+             const Handlers &  handlers,
+             bool              reusePort = true,
+             int               backlog   = SOMAXCONN);
+  // Accept connections on the specified 'address' of the specified
+  // 'length' and handle them with the specified 'handlers'. Return the
+  // listening socket on success or a negative 'errno' value.
+
+  ConnectionPtr
+  connect(const sockaddr *address, socklen_t length, const Handlers &handlers);
+  // Connect to the specified 'address' of the specified 'length' and handle
+  // the connection with the specified 'handlers'. Return the connection, or
+  // null with 'errno' set on failure.
+
+  ConnectionPtr adopt(int fd, const Handlers &handlers);
+  // Take ownership of the connected socket with the specified 'fd' and
+  // handle it with the specified 'handlers'. Return the connection, or null
+  // with 'errno' set on failure.
+
+  void post(Job job);
+  // Run the specified 'job' on the loop thread. May be called from any
+  // thread.
+
+  TimerId runAfter(std::chrono::nanoseconds delay, Job job);
+  // Run the specified 'job' on the executor after the specified 'delay'.
+  // Return an id for 'cancel'. May be called from any thread.
+
+  bool cancel(TimerId timer);
+  // Cancel the specified 'timer'. Return false if it already ran.
+
+  int poll(int timeout);
+  // Wait up to the specified 'timeout' milliseconds, or indefinitely if
+  // negative, and handle the events. Return the number of events or a
+  // negative 'errno' value.
+
+  void run();
+  // Handle events until 'stop' is called.
+
+  void stop();
+  // Make 'run' return. May be called from any thread.
+
+  // ACCESSORS
+
+  size_t connectionCount() const;
+  // Return the number of open connections.
+
+  const Configuration &configuration() const
+  // Return the configuration.
+  {
+    return d_config;
+  }
+};
+
+// =======================
+// Class ReactorConnection
+// =======================
+
+class ReactorConnection
+    : public std::enable_shared_from_this<ReactorConnection>
+{
+  // Provides a connected socket driven by a 'Reactor'. The input is only
+  // accessed by the handlers; 'write' and 'close' may be called from any
+  // thread, also after the connection was closed.
+
+  friend class Reactor;
+
+  // DATA
+
+  Reactor_Handle                     d_handle;
+  Reactor *                          d_reactor_p;
+  std::shared_ptr<Reactor::Handlers> d_handlers;
+  mutable std::mutex                 d_mutex; // Protects the state below.
+  BufferVector                       d_output;
+  bool                               d_busy;   // A job is in progress.
+  uint32_t                           d_pendingEvents; // Left to the job.
+  bool                               d_closed;
+  BufferVector                       d_input;
+  std::atomic<void *>                d_userData_p;
+
+  // PRIVATE MANIPULATORS
+
+  int flush();
+  // Send queued output. Return 0 or an 'errno' value. The mutex must be
+  // locked.
+
+public:
+  ReactorConnection(const ReactorConnection &) = delete;
+  ReactorConnection &operator=(const ReactorConnection &) = delete;
+
+  // CREATORS
+
+  ReactorConnection(Reactor *                                 reactor,
+                    int                                       fd,
+                    const std::shared_ptr<Reactor::Handlers> &handlers,
+                    mdmem::Allocator *                        allocator);
+  // Create a connection of the specified 'reactor' for the specified 'fd'
+  // handled by the specified 'handlers'. Use 'Reactor::adopt' instead.
+
+  ~ReactorConnection();
+
+  // MANIPULATORS
+
+  bool write(const char *data, size_t size);
+  // Send the specified 'data' with the specified 'size', queuing what
+  // cannot be sent immediately. Return false if the connection is closed.
+
+  bool write(const ConstBuffer &buffer)
+  // Send the specified 'buffer'. Return false if the connection is closed.
+  {
+    return write(buffer.buffer(), buffer.size());
+  }
+
+  void close();
+  // Shut the socket down. Queued output is discarded. The close handler
+  // runs once the reactor observes the shutdown.
+
+  void setUserData(void *userData)
+  // Attach the specified 'userData' to the connection.
+  {
+    d_userData_p.store(userData, std::memory_order_release);
+  }
+
+  // ACCESSORS
+
+  void *userData() const
+  // Return the attached user data.
+  {
+    return d_userData_p.load(std::memory_order_acquire);
+  }
+
+  int fd() const
+  // Return the socket.
+  {
+    return d_handle.d_fd;
+  }
+
+  bool isClosed() const;
+  // Return true if the connection has been closed.
+
+  size_t pendingOutput() const;
+  // Return the number of bytes queued for sending.
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_REACTOR
@@ -0,0 +1,392 @@
+// mdio_reactor.t.cpp                                                   -*-c++-*-
+#include <mdio_reactor.h>
+
+#include <mdio_bufferpool.h>
+#include <mdmem_testallocator.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+typedef Reactor Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+class PoolExecutor : public Executor {
+  // Executor running jobs on a number of threads.
+
+  std::mutex               d_mutex;
+  std::condition_variable  d_condition;
+  std::deque<Job>          d_jobs;
+  bool                     d_stop;
+  std::vector<std::thread> d_threads;
+
+  void run()
+  {
+    std::unique_lock<std::mutex> lk(d_mutex);
+    while (true) {
+      d_condition.wait(lk, [this]() { return d_stop || !d_jobs.empty(); });
+      if (d_jobs.empty()) {
+	return;
+      }
+      Job job = std::move(d_jobs.front());
+      d_jobs.pop_front();
+      lk.unlock();
+      job();
+      lk.lock();
+    }
+  }
+
+public:
+  explicit PoolExecutor(size_t threads)
+    : d_stop(false)
+  {
+    for (size_t i = 0; i < threads; ++i) {
+      d_threads.emplace_back(&PoolExecutor::run, this);
+    }
+  }
+
+  ~PoolExecutor()
+  {
+    {
+      std::lock_guard<std::mutex> lk(d_mutex);
+      d_stop = true;
+    }
+    d_condition.notify_all();
+    for (auto& thread : d_threads) {
+      thread.join();
+    }
+  }
+
+  virtual bool execute(Job&& job)
+  {
+    {
+      std::lock_guard<std::mutex> lk(d_mutex);
+      d_jobs.push_back(std::move(job));
+    }
+    d_condition.notify_one();
+    return true;
+  }
+};
+
+sockaddr_in loopback(int port)
+{
+  sockaddr_in address = sockaddr_in();
+  address.sin_family      = AF_INET;
+  address.sin_port        = htons(static_cast<uint16_t>(port));
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return address;
+}
+
+Obj::Handlers echoHandlers()
+{
+  Obj::Handlers handlers;
+  handlers.d_data = [](const Obj::ConnectionPtr& c, BufferVector *input) {
+    iovec iovecs[16];
+    const size_t count = input->iovecs(iovecs, 16);
+    for (size_t i = 0; i < count; ++i) {
+      c->write(static_cast<const char *>(iovecs[i].iov_base), iovecs[i].iov_len);
+      input->consume(iovecs[i].iov_len);
+    }
+  };
+  return handlers;
+}
+
+template <class PREDICATE>
+bool waitFor(PREDICATE predicate)
+{
+  for (int i = 0; i < 10000; ++i) {
+    if (predicate()) {
+      return true;
+    }
+    this_thread::sleep_for(1ms);
+  }
+  return false;
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 4:
+    {
+      // Reactors on several threads share a port through 'SO_REUSEPORT'.
+      const size_t k_reactors    = 3;
+      const size_t k_connections = 300;
+
+      std::atomic<size_t> accepted[k_reactors] = {};
+      std::vector<std::unique_ptr<Obj>> servers;
+      std::vector<std::thread>          threads;
+
+      int port = 0;
+      for (size_t r = 0; r < k_reactors; ++r) {
+	servers.emplace_back(new Obj());
+	ASSERT(0 == servers.back()->open());
+
+	Obj::Handlers handlers = echoHandlers();
+	handlers.d_open = [&accepted, r](const Obj::ConnectionPtr&) {
+	  ++accepted[r];
+	};
+
+	const sockaddr_in address = loopback(port);
+	const int fd = servers.back()->listen(
+	    reinterpret_cast<const sockaddr *>(&address), sizeof(address), handlers);
+	ASSERT(0 <= fd);
+	port = Obj::localPort(fd);
+	ASSERT(0 < port);
+      }
+      for (auto& server : servers) {
+	threads.emplace_back([&server]() { server->run(); });
+      }
+
+      Obj client;
+      ASSERT(0 == client.open());
+      std::thread clientThread([&client]() { client.run(); });
+
+      std::atomic<size_t> echoed(0);
+      Obj::Handlers handlers;
+      handlers.d_data = [&echoed](const Obj::ConnectionPtr& c, BufferVector *input) {
+	echoed += input->size();
+	input->consume(input->size());
+	c->close();
+      };
+
+      const sockaddr_in address = loopback(port);
+      std::vector<Obj::ConnectionPtr> connections;
+      for (size_t i = 0; i < k_connections; ++i) {
+	connections.push_back(client.connect(
+	    reinterpret_cast<const sockaddr *>(&address), sizeof(address), handlers));
+	ASSERT(connections.back());
+	ASSERT(connections.back()->write("x", 1));
+      }
+
+      ASSERT(waitFor([&]() { return k_connections == echoed; }));
+      ASSERT(waitFor([&]() { return 0 == client.connectionCount(); }));
+
+      size_t total = 0;
+      for (size_t r = 0; r < k_reactors; ++r) {
+	ASSERT(waitFor([&]() { return 0 == servers[r]->connectionCount(); }));
+	ASSERT(0 < accepted[r]);
+	total += accepted[r];
+	if (verbose) {
+	  cerr << "reactor " << r << ": " << accepted[r] << endl;
+	}
+      }
+      ASSERT(k_connections == total);
+
+      client.stop();
+      clientThread.join();
+      for (size_t r = 0; r < k_reactors; ++r) {
+	servers[r]->stop();
+	threads[r].join();
+      }
+    } break;
+
+  case 3:
+    {
+      // Many concurrent connections processed on an executor with pooled
+      // input buffers. Large replies are queued and sent on writability.
+      const size_t k_connections = 500;
+      const size_t k_replySize   = 256 * 1024;
+
+      mdmem::TestAllocator ta;
+      BufferPool::Configuration poolConfig;
+      poolConfig.d_tiers = {{4096, 1024}};
+      BufferPool   pool(poolConfig, &ta);
+      PoolExecutor executor(4);
+
+      Obj::Configuration config;
+      config.d_bufferPool_p = &pool;
+
+      {
+	Obj server(config, &executor, &ta);
+	ASSERT(0 == server.open());
+
+	Obj::Handlers serverHandlers;
+	serverHandlers.d_data = [](const Obj::ConnectionPtr& c, BufferVector *input) {
+	  // A request is a single byte; reply with a large payload.
+	  while (!input->empty()) {
+	    input->consume(1);
+	    static const std::string reply(k_replySize, 'r');
+	    c->write(reply.data(), reply.size());
+	  }
+	};
+
+	const sockaddr_in any = loopback(0);
+	const int fd = server.listen(
+	    reinterpret_cast<const sockaddr *>(&any), sizeof(any), serverHandlers);
+	ASSERT(0 <= fd);
+	std::thread serverThread([&server]() { server.run(); });
+
+	Obj client(Obj::Configuration(), &executor);
+	ASSERT(0 == client.open());
+	std::thread clientThread([&client]() { client.run(); });
+
+	std::atomic<size_t> received(0);
+	std::atomic<size_t> completed(0);
+	Obj::Handlers clientHandlers;
+	clientHandlers.d_open = [](const Obj::ConnectionPtr& c) {
+	  c->setUserData(new size_t(0));
+	};
+	clientHandlers.d_data = [&](const Obj::ConnectionPtr& c, BufferVector *input) {
+	  size_t *count = static_cast<size_t *>(c->userData());
+	  *count += input->size();
+	  received += input->size();
+	  input->consume(input->size());
+	  if (k_replySize == *count) {
+	    ++completed;
+	    c->close();
+	  }
+	};
+	clientHandlers.d_close = [](const Obj::ConnectionPtr& c, int) {
+	  delete static_cast<size_t *>(c->userData());
+	};
+
+	const sockaddr_in address = loopback(Obj::localPort(fd));
+	for (size_t i = 0; i < k_connections; ++i) {
+	  Obj::ConnectionPtr c = client.connect(
+	      reinterpret_cast<const sockaddr *>(&address), sizeof(address), clientHandlers);
+	  ASSERT(c);
+	  ASSERT(c->write("?", 1));
+	}
+
+	ASSERT(waitFor([&]() { return k_connections == completed; }));
+	ASSERT(k_connections * k_replySize == received);
+	ASSERT(waitFor([&]() { return 0 == server.connectionCount(); }));
+	ASSERT(waitFor([&]() { return 0 == client.connectionCount(); }));
+
+	if (verbose) {
+	  cerr << pool.metrics(0) << endl;
+	}
+	ASSERT(0 < pool.metrics(0).d_acquiredCount);
+
+	client.stop();
+	server.stop();
+	clientThread.join();
+	serverThread.join();
+      }
+
+      ASSERT(0 == pool.metrics(0).d_inUseCount);
+    } break;
+
+  case 2:
+    {
+      // Posted jobs and timers.
+      Obj o;
+      ASSERT(0 == o.open());
+
+      std::thread::id     loopId;
+      std::atomic<int>    posted(0);
+      std::atomic<int>    fired(0);
+      std::thread         loop([&]() { loopId = this_thread::get_id(); o.run(); });
+
+      std::thread::id postedId;
+      o.post([&]() { postedId = this_thread::get_id(); ++posted; });
+
+      const auto start = std::chrono::steady_clock::now();
+      std::chrono::steady_clock::time_point firedAt;
+      o.runAfter(50ms, [&]() { firedAt = std::chrono::steady_clock::now(); ++fired; });
+      const Obj::TimerId cancelled = o.runAfter(20ms, [&]() { fired += 100; });
+      o.runAfter(10ms, [&]() { ++fired; });
+      ASSERT(o.cancel(cancelled));
+      ASSERT(!o.cancel(cancelled));
+
+      ASSERT(waitFor([&]() { return 2 == fired; }));
+      ASSERT(firedAt - start >= 50ms);
+      ASSERT(1 == posted);
+      ASSERT(loopId == postedId);
+
+      this_thread::sleep_for(30ms);
+      ASSERT(2 == fired);
+
+      o.stop();
+      loop.join();
+    } break;
+
+  case 1:
+    {
+      // Breathing test: echo over loopback.
+      Obj o;
+      ASSERT(0 == o.open());
+
+      std::atomic<int> opened(0);
+      std::atomic<int> closed(0);
+      Obj::Handlers handlers = echoHandlers();
+      handlers.d_open  = [&](const Obj::ConnectionPtr&) { ++opened; };
+      handlers.d_close = [&](const Obj::ConnectionPtr&, int error) {
+	ASSERT(0 == error);
+	++closed;
+      };
+
+      const sockaddr_in any = loopback(0);
+      const int fd = o.listen(reinterpret_cast<const sockaddr *>(&any), sizeof(any), handlers);
+      ASSERT(0 <= fd);
+
+      std::thread loop([&o]() { o.run(); });
+
+      const sockaddr_in address = loopback(Obj::localPort(fd));
+      const int client = socket(AF_INET, SOCK_STREAM, 0);
+      ASSERT(0 == connect(client, reinterpret_cast<const sockaddr *>(&address), sizeof(address)));
+
+      ASSERT(5 == send(client, "hello", 5, 0));
+      char buffer[16];
+      size_t size = 0;
+      while (size < 5) {
+	const ssize_t result = recv(client, buffer + size, sizeof(buffer) - size, 0);
+	ASSERT(0 < result);
+	if (result <= 0) {
+	  break;
+	}
+	size += result;
+      }
+      ASSERT("hello" == std::string(buffer, size));
+      ASSERT(1 == opened);
+      ASSERT(1 == o.connectionCount());
+
+      close(client);
+      ASSERT(waitFor([&]() { return 1 == closed; }));
+      ASSERT(0 == o.connectionCount());
+
+      o.stop();
+      loop.join();
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
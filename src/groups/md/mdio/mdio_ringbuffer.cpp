@@ -0,0 +1,151 @@
+// mdio_ringbuffer.cpp                                                  -*-c++-*-
+#include <mdio_ringbuffer.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace MvdS {
+namespace mdio {
+
+// ----------------
+// Class RingBuffer
+// ----------------
+
+// CLASS METHODS
+
+bool RingBuffer::isSupported()
+{
+  static const bool s_supported = []() {
+    RingBuffer buffer;
+    return 0 == buffer.open(1);
+  }();
+  return s_supported;
+}
+
+// CREATORS
+
+RingBuffer::RingBuffer()
+    : d_buffer(nullptr)
+    , d_capacity(0)
+    , d_head(0)
+    , d_tail(0)
+{}
+
+RingBuffer::~RingBuffer() { close(); }
+
+// MANIPULATORS
+
+int RingBuffer::open(size_t capacity)
+{
+  close();
+
+  const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t       size     = pageSize;
+  while (size < capacity) {
+    size *= 2;
+  }
+
+  const int fd = memfd_create("mdio_ringbuffer", MFD_CLOEXEC);
+  if (fd < 0) {
+    return -errno;
+  }
+
+  if (0 != ftruncate(fd, static_cast<off_t>(size))) {
+    const int error = errno;
+    ::close(fd);
+    return -error;
+  }
+
+  // Reserve the address range for both mappings first, so the second one
+  // cannot collide with an unrelated mapping, then map the file over both
+  // halves.
+  void *address =
+      mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (MAP_FAILED == address) {
+    const int error = errno;
+    ::close(fd);
+    return -error;
+  }
+
+  char *buffer = static_cast<char *>(address);
+  for (int i = 0; i < 2; ++i) {
+    if (MAP_FAILED == mmap(buffer + i * size,
+                           size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_FIXED,
+                           fd,
+                           0)) {
+      const int error = errno;
+      munmap(address, 2 * size);
+      ::close(fd);
+      return -error;
+    }
+  }
+
+  // The mappings keep the file alive.
+  ::close(fd);
+
+  d_buffer   = buffer;
+  d_capacity = size;
+  return 0;
+}
+
+void RingBuffer::close()
+{
+  if (d_buffer) {
+    munmap(d_buffer, 2 * d_capacity);
+  }
+  d_buffer   = nullptr;
+  d_capacity = 0;
+  d_head.store(0, std::memory_order_relaxed);
+  d_tail.store(0, std::memory_order_relaxed);
+}
+
+ssize_t RingBuffer::readFrom(int fd, size_t size)
+{
+  size_t available;
+  char * buffer = writableBuffer(&available);
+  size          = std::min(size, available);
+  if (0 == size) {
+    return 0;
+  }
+
+  ssize_t result;
+  do {
+    result = ::read(fd, buffer, size);
+  } while (result < 0 && EINTR == errno);
+
+  if (result < 0) {
+    return -errno;
+  }
+
+  commit(static_cast<size_t>(result));
+  return result;
+}
+
+ssize_t RingBuffer::writeTo(int fd, size_t size)
+{
+  const ConstBuffer data = readable();
+  size                   = std::min(size, data.size());
+  if (0 == size) {
+    return 0;
+  }
+
+  ssize_t result;
+  do {
+    result = ::write(fd, data.buffer(), size);
+  } while (result < 0 && EINTR == errno);
+
+  if (result < 0) {
+    return -errno;
+  }
+
+  consume(static_cast<size_t>(result));
+  return result;
+}
+
+} // namespace mdio
+} // namespace MvdS
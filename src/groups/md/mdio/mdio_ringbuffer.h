@@ -0,0 +1,155 @@
+// mdio_ringbuffer.h                                                    -*-c++-*-
+#ifndef __INCLUDED_MDIO_RINGBUFFER
+#define __INCLUDED_MDIO_RINGBUFFER
+
+#include <mdio_buffer.h>
+
+#include <atomic>
+#include <cstddef>
+
+#include <sys/types.h>
+
+namespace MvdS {
+namespace mdio {
+
+// ================
+// Class RingBuffer
+// ================
+
+class RingBuffer
+{
+  // Provides a circular byte buffer whose readable and writable regions are
+  // always contiguous in memory.
+  //
+  // The pages of an anonymous memory file are mapped twice, back to back, so
+  // a region that wraps around the end of the buffer continues in the
+  // second mapping at the same contents. Parsers, for example a
+  // 'BufferScanner', can therefore run over 'readable()' directly and
+  // system calls can read into 'writableBuffer' without splitting the call
+  // at the wrap point or copying fragments into a temporary buffer.
+  //
+  // One producer thread may call 'writableBuffer', 'commit' and 'readFrom'
+  // while one consumer thread calls 'readable', 'consume' and 'writeTo'.
+  // Data committed by the producer is visible to the consumer once 'commit'
+  // returns, and space consumed is available to the producer once
+  // 'consume' returns.
+
+  // DATA
+
+  char * d_buffer;   // Start of the first of the two mappings.
+  size_t d_capacity; // Size of one mapping, a power of two.
+
+  alignas(64) std::atomic<size_t> d_head; // Total bytes committed.
+  alignas(64) std::atomic<size_t> d_tail; // Total bytes consumed.
+
+public:
+  RingBuffer(const RingBuffer &) = delete;
+  RingBuffer &operator=(const RingBuffer &) = delete;
+
+  // CLASS METHODS
+
+  static bool isSupported();
+  // Return true if the mirrored mapping can be created on this system.
+
+  // CREATORS
+
+  RingBuffer();
+  // Create a ring buffer without memory, see 'open'.
+
+  ~RingBuffer();
+  // Unmap the memory of the buffer.
+
+  // MANIPULATORS
+
+  int open(size_t capacity);
+  // Map a buffer of at least the specified 'capacity' bytes, rounded up to a
+  // power of two multiple of the page size, discarding the current
+  // contents. Return 0 on success or a negative 'errno' value. Behavior is
+  // undefined if other threads use the buffer concurrently.
+
+  void close();
+  // Unmap the memory of the buffer, leaving it with a capacity of 0.
+
+  char *writableBuffer(size_t *size)
+  // Return the start of the free space of the buffer and load its size into
+  // the specified 'size'. The space is contiguous. Called by the producer.
+  {
+    const size_t head = d_head.load(std::memory_order_relaxed);
+    *size = d_capacity - (head - d_tail.load(std::memory_order_acquire));
+    return d_buffer + (head & (d_capacity - 1));
+  }
+
+  void commit(size_t size)
+  // Make the specified 'size' bytes written at 'writableBuffer' readable.
+  // Behavior is undefined unless 'size' is at most the free space. Called by
+  // the producer.
+  {
+    d_head.store(d_head.load(std::memory_order_relaxed) + size,
+                 std::memory_order_release);
+  }
+
+  void consume(size_t size)
+  // Release the first specified 'size' readable bytes. Behavior is undefined
+  // unless 'size <= size()'. Called by the consumer.
+  {
+    d_tail.store(d_tail.load(std::memory_order_relaxed) + size,
+                 std::memory_order_release);
+  }
+
+  ssize_t readFrom(int fd, size_t size = size_t(-1));
+  // Read up to the specified 'size' bytes from the specified 'fd' into the
+  // free space of the buffer with a single call and commit them. Return the
+  // number of bytes read, 0 at end of file or if the buffer is full, or a
+  // negative 'errno' value, '-EAGAIN' if the read would block. Called by the
+  // producer.
+
+  ssize_t writeTo(int fd, size_t size = size_t(-1));
+  // Write up to the specified 'size' readable bytes to the specified 'fd'
+  // with a single call and consume them. Return the number of bytes written
+  // or a negative 'errno' value, '-EAGAIN' if the write would block. Called
+  // by the consumer.
+
+  // ACCESSORS
+
+  ConstBuffer readable() const
+  // Return the readable bytes of the buffer. The view stays valid until
+  // the bytes are consumed. Called by the consumer.
+  {
+    const size_t tail = d_tail.load(std::memory_order_relaxed);
+    return ConstBuffer(d_buffer + (tail & (d_capacity - 1)),
+                       d_head.load(std::memory_order_acquire) - tail);
+  }
+
+  size_t size() const
+  // Return the number of readable bytes. Note that the value may be stale
+  // when returned if called from another thread than the consumer.
+  {
+    // The tail is loaded first; the head can only have moved past it since.
+    const size_t tail = d_tail.load(std::memory_order_acquire);
+    return d_head.load(std::memory_order_acquire) - tail;
+  }
+
+  size_t available() const
+  // Return the number of bytes that can be written. Note that the value may
+  // be stale when returned if called from another thread than the producer.
+  {
+    return d_capacity - size();
+  }
+
+  size_t capacity() const
+  // Return the capacity of the buffer.
+  {
+    return d_capacity;
+  }
+
+  bool empty() const
+  // Return true if there are no readable bytes.
+  {
+    return 0 == size();
+  }
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_RINGBUFFER
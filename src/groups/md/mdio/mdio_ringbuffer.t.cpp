@@ -0,0 +1,218 @@
+// mdio_ringbuffer.t.cpp                                                -*-c++-*-
+#include <mdio_ringbuffer.h>
+
+#include <mdio_bufferscanner.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+typedef RingBuffer Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  if (!Obj::isSupported()) {
+    cerr << "Mirrored mappings are not supported, skipping." << endl;
+    return 0;
+  }
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 3:
+    {
+      // One producer and one consumer.
+      Obj o;
+      ASSERT(0 == o.open(4096));
+
+      const size_t total = 10 * 1000 * 1000;
+      size_t       wrong = 0;
+
+      std::thread producer([&]() {
+	  size_t written = 0;
+	  while (written < total) {
+	    size_t size;
+	    char * buffer = o.writableBuffer(&size);
+	    size          = std::min(size, std::min<size_t>(total - written, 1000));
+	    for (size_t i = 0; i < size; ++i) {
+	      buffer[i] = static_cast<char>((written + i) % 251);
+	    }
+	    o.commit(size);
+	    written += size;
+	    if (0 == size) {
+	      std::this_thread::yield();
+	    }
+	  }
+	});
+
+      size_t read = 0;
+      while (read < total) {
+	const ConstBuffer data = o.readable();
+	for (size_t i = 0; i < data.size(); ++i) {
+	  if (data.buffer()[i] != static_cast<char>((read + i) % 251)) {
+	    ++wrong;
+	  }
+	}
+	o.consume(data.size());
+	read += data.size();
+	if (0 == data.size()) {
+	  std::this_thread::yield();
+	}
+      }
+      producer.join();
+
+      ASSERT(0 == wrong);
+      ASSERT(o.empty());
+    } break;
+
+  case 2:
+    {
+      // Reading from a socket and parsing lines across the wrap point.
+      int sockets[2];
+      ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+      Obj o;
+      ASSERT(0 == o.open(4096));
+
+      std::string expected;
+      for (int i = 0; i < 2000; ++i) {
+	expected += "line " + std::to_string(i) + "\n";
+      }
+
+      std::thread writer([&]() {
+	  ASSERT(ssize_t(expected.size()) ==
+		 write(sockets[0], expected.data(), expected.size()));
+	  close(sockets[0]);
+	});
+
+      std::string received;
+      int         lines = 0;
+      while (true) {
+	const ssize_t result = o.readFrom(sockets[1], 1000);
+	ASSERT(0 <= result);
+	if (result <= 0) {
+	  break;
+	}
+
+	// Parse the complete lines in place; a partial line stays in the
+	// buffer until the rest has arrived.
+	const ConstBuffer data = o.readable();
+	size_t            end  = data.size();
+	while (0 < end && '\n' != data.buffer()[end - 1]) {
+	  --end;
+	}
+
+	BufferScanner scanner(data.buffer(), end);
+	ConstBuffer   line(0, 0);
+	while (scanner.nextLine(&line)) {
+	  ASSERT(0 == memcmp(line.buffer(), "line ", 5));
+	  received.append(line.buffer(), line.size()).append("\n");
+	  ++lines;
+	}
+	o.consume(end);
+      }
+      writer.join();
+
+      ASSERT(2000 == lines);
+      ASSERT(expected == received);
+      ASSERT(o.empty());
+
+      // Writing out.
+      int pipes[2];
+      ASSERT(0 == pipe(pipes));
+      ASSERT(0 == o.writeTo(pipes[1]));
+      size_t size;
+      memcpy(o.writableBuffer(&size), "hello", 5);
+      o.commit(5);
+      ASSERT(3 == o.writeTo(pipes[1], 3));
+      ASSERT(2 == o.writeTo(pipes[1]));
+      ASSERT(o.empty());
+      char output[5];
+      ASSERT(5 == read(pipes[0], output, 5));
+      ASSERT("hello" == std::string(output, 5));
+      close(pipes[0]);
+      close(pipes[1]);
+      close(sockets[1]);
+    } break;
+
+  case 1:
+    {
+      // Breathing test.
+      Obj o;
+      ASSERT(0 == o.capacity());
+      ASSERT(o.empty());
+
+      ASSERT(0 == o.open(5000));
+      const size_t capacity = o.capacity();
+      ASSERT(5000 <= capacity);
+      ASSERT(0 == (capacity & (capacity - 1)));
+      ASSERT(capacity == o.available());
+
+      // Move the positions close to the end of the buffer.
+      size_t size;
+      char * buffer = o.writableBuffer(&size);
+      ASSERT(capacity == size);
+      o.commit(capacity - 10);
+      o.consume(capacity - 10);
+      ASSERT(o.empty());
+
+      // A write across the wrap point is contiguous.
+      buffer = o.writableBuffer(&size);
+      ASSERT(capacity == size);
+      memcpy(buffer, "abcdefghijklmnopqrstuvwxyz", 26);
+      o.commit(26);
+      ASSERT(26 == o.size());
+      ASSERT(capacity - 26 == o.available());
+
+      const ConstBuffer data = o.readable();
+      ASSERT(26 == data.size());
+      ASSERT("abcdefghijklmnopqrstuvwxyz" == std::string(data.buffer(), 26));
+
+      // The wrapped part is visible at the start of the buffer as well.
+      ASSERT(0 == memcmp(data.buffer() + 10 - capacity, "klmnopqrstuvwxyz", 16));
+
+      o.consume(20);
+      ASSERT("uvwxyz" == std::string(o.readable().buffer(), 6));
+
+      // Reopening discards the contents.
+      ASSERT(0 == o.open(1));
+      ASSERT(o.empty());
+      o.close();
+      ASSERT(0 == o.capacity());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
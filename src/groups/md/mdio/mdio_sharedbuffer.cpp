@@ -0,0 +1,98 @@
+// mdio_sharedbuffer.cpp                                                -*-c++-*-
+#include <mdio_sharedbuffer.h>
+
+#include <cstring>
+#include <new>
+
+namespace MvdS {
+namespace mdio {
+
+namespace {
+
+const size_t k_headerSize =
+    (sizeof(SharedBuffer_Rep) + alignof(std::max_align_t) - 1) /
+    alignof(std::max_align_t) * alignof(std::max_align_t);
+// Size of the control block in front of inline data.
+
+} // namespace
+
+// ------------------
+// Class SharedBuffer
+// ------------------
+
+// PRIVATE CLASS METHODS
+
+void SharedBuffer::releaseInline(SharedBuffer_Rep *rep)
+{
+  mdmem::Allocator *allocator = rep->d_allocator_p;
+  const size_t      size      = k_headerSize + rep->d_size;
+
+  rep->~SharedBuffer_Rep();
+  allocator->deallocate(rep, size, alignof(std::max_align_t));
+}
+
+void SharedBuffer::releaseAdopted(SharedBuffer_Rep *rep)
+{
+  static_cast<mdmem::Allocator *>(rep->d_context_p)
+      ->deallocate(rep->d_data, rep->d_size);
+
+  mdmem::Allocator *allocator = rep->d_allocator_p;
+  rep->~SharedBuffer_Rep();
+  allocator->deallocate(rep, sizeof(SharedBuffer_Rep), alignof(SharedBuffer_Rep));
+}
+
+// CLASS METHODS
+
+SharedBuffer SharedBuffer::allocate(size_t size, mdmem::Allocator *allocator)
+{
+  allocator = mdmem::AllocatorUtil::defaultAllocator(allocator);
+
+  char *memory = static_cast<char *>(
+      allocator->allocate(k_headerSize + size, alignof(std::max_align_t)));
+
+  SharedBuffer_Rep *rep = new (memory) SharedBuffer_Rep();
+  rep->d_refCount.store(1, std::memory_order_relaxed);
+  rep->d_releaser    = &releaseInline;
+  rep->d_data        = memory + k_headerSize;
+  rep->d_size        = size;
+  rep->d_context_p   = nullptr;
+  rep->d_allocator_p = allocator;
+
+  return SharedBuffer(rep);
+}
+
+SharedBuffer SharedBuffer::copy(const char *      buffer,
+                                size_t            size,
+                                mdmem::Allocator *allocator)
+{
+  SharedBuffer result = allocate(size, allocator);
+  memcpy(result.buffer(), buffer, size);
+  return result;
+}
+
+// CREATORS
+
+SharedBuffer::SharedBuffer(Buffer &&buffer, mdmem::Allocator *allocator)
+    : ConstBuffer(0, 0)
+    , d_rep_p(nullptr)
+{
+  allocator = mdmem::AllocatorUtil::defaultAllocator(allocator);
+
+  void *memory =
+      allocator->allocate(sizeof(SharedBuffer_Rep), alignof(SharedBuffer_Rep));
+
+  SharedBuffer_Rep *rep = new (memory) SharedBuffer_Rep();
+  rep->d_refCount.store(1, std::memory_order_relaxed);
+  rep->d_releaser    = &releaseAdopted;
+  rep->d_size        = buffer.size();
+  rep->d_context_p   = buffer.allocator();
+  rep->d_allocator_p = allocator;
+  rep->d_data        = buffer.release();
+
+  d_rep_p  = rep;
+  d_buffer = rep->d_data;
+  d_size   = rep->d_size;
+}
+
+} // namespace mdio
+} // namespace MvdS
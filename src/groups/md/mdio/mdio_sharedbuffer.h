@@ -0,0 +1,313 @@
+// mdio_sharedbuffer.h                                                  -*-c++-*-
+#ifndef __INCLUDED_MDIO_SHAREDBUFFER
+#define __INCLUDED_MDIO_SHAREDBUFFER
+
+#include <mdio_buffer.h>
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace MvdS {
+namespace mdio {
+
+// ========================
+// Struct SharedBuffer_Rep
+// ========================
+
+struct SharedBuffer_Rep
+{
+  // Intrusive control block of a reference counted buffer. The releaser is
+  // invoked when the last reference is dropped and must free the data and
+  // the control block itself.
+
+  // PUBLIC TYPES
+
+  typedef void (*Releaser)(SharedBuffer_Rep *rep);
+
+  // DATA
+
+  std::atomic<size_t> d_refCount;
+  Releaser            d_releaser;
+  char *              d_data;
+  size_t              d_size;
+  void *              d_context_p;   // Releaser specific.
+  mdmem::Allocator *  d_allocator_p; // Allocator of the control block.
+
+  // MANIPULATORS
+
+  void acquire()
+  // Add a reference.
+  {
+    d_refCount.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void release()
+  // Drop a reference and release the buffer if it was the last one.
+  {
+    if (1 == d_refCount.fetch_sub(1, std::memory_order_acq_rel)) {
+      d_releaser(this);
+    }
+  }
+};
+
+// =================
+// Class BufferSlice
+// =================
+
+class BufferSlice : public ConstBuffer
+{
+  // Provides a read-only view of a range of a reference counted buffer.
+  // Copying and slicing are O(1) and share the underlying memory, which is
+  // released when the last slice or 'SharedBuffer' referring to it is
+  // destroyed. The reference count is thread-safe, so slices of one buffer
+  // can be handed to different threads.
+
+  friend class MappedFile;
+  friend class SharedBuffer;
+
+  // DATA
+
+  SharedBuffer_Rep *d_rep_p;
+
+  // PRIVATE CREATORS
+
+  BufferSlice(SharedBuffer_Rep *rep, const char *buffer, size_t size)
+      // Create a slice of the specified 'rep' and add a reference.
+      : ConstBuffer(buffer, size)
+      , d_rep_p(rep)
+  {
+    if (d_rep_p) {
+      d_rep_p->acquire();
+    }
+  }
+
+public:
+  // PUBLIC CONSTANTS
+
+  static const size_t npos = size_t(-1);
+
+  // CREATORS
+
+  BufferSlice()
+      // Create an empty slice.
+      : ConstBuffer(0, 0)
+      , d_rep_p(nullptr)
+  {}
+
+  BufferSlice(const BufferSlice &other)
+      // Create a slice sharing the memory of the specified 'other' slice.
+      : BufferSlice(other.d_rep_p, other.d_buffer, other.d_size)
+  {}
+
+  BufferSlice(BufferSlice &&other) noexcept
+      // Take over the reference of the specified 'other' slice, leaving
+      // 'other' empty.
+      : ConstBuffer(other.d_buffer, other.d_size)
+      , d_rep_p(other.d_rep_p)
+  {
+    other.d_buffer = 0;
+    other.d_size   = 0;
+    other.d_rep_p  = nullptr;
+  }
+
+  ~BufferSlice() { reset(); }
+
+  // MANIPULATORS
+
+  BufferSlice &operator=(BufferSlice other) noexcept
+  {
+    swap(other);
+    return *this;
+  }
+
+  void swap(BufferSlice &other) noexcept
+  {
+    std::swap(d_buffer, other.d_buffer);
+    std::swap(d_size, other.d_size);
+    std::swap(d_rep_p, other.d_rep_p);
+  }
+
+  void reset()
+  // Drop the reference and make this slice empty.
+  {
+    if (d_rep_p) {
+      d_rep_p->release();
+      d_rep_p = nullptr;
+    }
+    d_buffer = 0;
+    d_size   = 0;
+  }
+
+  void removePrefix(size_t count)
+  // Remove the first 'count' bytes from the view. Behavior is undefined
+  // unless 'count <= size()'.
+  {
+    d_buffer += count;
+    d_size -= count;
+  }
+
+  void removeSuffix(size_t count)
+  // Remove the last 'count' bytes from the view. Behavior is undefined
+  // unless 'count <= size()'.
+  {
+    d_size -= count;
+  }
+
+  // ACCESSORS
+
+  BufferSlice slice(size_t offset, size_t length = npos) const
+  // Return a slice of at most 'length' bytes starting at the specified
+  // 'offset' of this slice. Behavior is undefined unless
+  // 'offset <= size()'.
+  {
+    const size_t remaining = d_size - offset;
+    return BufferSlice(
+        d_rep_p, d_buffer + offset, length < remaining ? length : remaining);
+  }
+
+  size_t useCount() const
+  // Return the number of references to the underlying memory, or 0 if this
+  // slice is empty. Note that the value may be stale when returned.
+  {
+    return d_rep_p ? d_rep_p->d_refCount.load(std::memory_order_relaxed) : 0;
+  }
+};
+
+// ==================
+// Class SharedBuffer
+// ==================
+
+class SharedBuffer : public ConstBuffer
+{
+  // Provides a writable, reference counted buffer. Copies share the same
+  // memory. The control block is allocated together with the data, or
+  // separately when adopting an exclusively owned 'Buffer'. Read-only
+  // 'BufferSlice' views of any range can be created in O(1).
+
+  // DATA
+
+  SharedBuffer_Rep *d_rep_p;
+
+  // PRIVATE CLASS METHODS
+
+  static void releaseInline(SharedBuffer_Rep *rep);
+  static void releaseAdopted(SharedBuffer_Rep *rep);
+
+public:
+  // CLASS METHODS
+
+  static SharedBuffer allocate(size_t size, mdmem::Allocator *allocator = 0);
+  // Return a buffer of the specified 'size' bytes with uninitialized
+  // contents. Optionally the specified 'allocator' is used for memory
+  // allocation.
+
+  static SharedBuffer
+  copy(const char *buffer, size_t size, mdmem::Allocator *allocator = 0);
+  // Return a buffer containing a copy of the specified 'buffer' with the
+  // specified 'size'. Optionally the specified 'allocator' is used for
+  // memory allocation.
+
+  // CREATORS
+
+  SharedBuffer()
+      // Create an empty buffer.
+      : ConstBuffer(0, 0)
+      , d_rep_p(nullptr)
+  {}
+
+  explicit SharedBuffer(SharedBuffer_Rep *rep)
+      // Create a buffer over the data of the specified 'rep', taking over
+      // one of its references.
+      : ConstBuffer(rep->d_data, rep->d_size)
+      , d_rep_p(rep)
+  {}
+
+  explicit SharedBuffer(Buffer &&buffer, mdmem::Allocator *allocator = 0);
+  // Take ownership of the memory of the specified 'buffer', which is
+  // deallocated using the allocator of 'buffer' once the last reference is
+  // dropped. Optionally the specified 'allocator' is used for the control
+  // block.
+
+  SharedBuffer(const SharedBuffer &other)
+      // Create a buffer sharing the memory of the specified 'other' buffer.
+      : ConstBuffer(other.d_buffer, other.d_size)
+      , d_rep_p(other.d_rep_p)
+  {
+    if (d_rep_p) {
+      d_rep_p->acquire();
+    }
+  }
+
+  SharedBuffer(SharedBuffer &&other) noexcept
+      // Take over the reference of the specified 'other' buffer, leaving
+      // 'other' empty.
+      : ConstBuffer(other.d_buffer, other.d_size)
+      , d_rep_p(other.d_rep_p)
+  {
+    other.d_buffer = 0;
+    other.d_size   = 0;
+    other.d_rep_p  = nullptr;
+  }
+
+  ~SharedBuffer() { reset(); }
+
+  // MANIPULATORS
+
+  SharedBuffer &operator=(SharedBuffer other) noexcept
+  {
+    swap(other);
+    return *this;
+  }
+
+  void swap(SharedBuffer &other) noexcept
+  {
+    std::swap(d_buffer, other.d_buffer);
+    std::swap(d_size, other.d_size);
+    std::swap(d_rep_p, other.d_rep_p);
+  }
+
+  void reset()
+  // Drop the reference and make this buffer empty.
+  {
+    if (d_rep_p) {
+      d_rep_p->release();
+      d_rep_p = nullptr;
+    }
+    d_buffer = 0;
+    d_size   = 0;
+  }
+
+  char *buffer()
+  // Return the buffer.
+  {
+    return const_cast<char *>(d_buffer);
+  }
+
+  // ACCESSORS
+
+  using ConstBuffer::buffer;
+
+  BufferSlice slice(size_t offset = 0, size_t length = BufferSlice::npos) const
+  // Return a read-only slice of at most 'length' bytes starting at the
+  // specified 'offset'. Behavior is undefined unless 'offset <= size()'.
+  {
+    const size_t remaining = d_size - offset;
+    return BufferSlice(
+        d_rep_p, d_buffer + offset, length < remaining ? length : remaining);
+  }
+
+  size_t useCount() const
+  // Return the number of references to the underlying memory, or 0 if this
+  // buffer is empty. Note that the value may be stale when returned.
+  {
+    return d_rep_p ? d_rep_p->d_refCount.load(std::memory_order_relaxed) : 0;
+  }
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_SHAREDBUFFER
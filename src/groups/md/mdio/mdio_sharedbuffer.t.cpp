@@ -0,0 +1,183 @@
+// mdio_sharedbuffer.t.cpp                                              -*-c++-*-
+#include <mdio_sharedbuffer.h>
+
+#include <mdmem_testallocator.h>
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+std::string str(const ConstBuffer& buffer)
+{
+  return std::string(buffer.buffer(), buffer.size());
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 4:
+    {
+      // Slices can be copied and dropped concurrently.
+      mdmem::TestAllocator ta;
+
+      {
+	SharedBuffer sb = SharedBuffer::copy("0123456789", 10, &ta);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+	  threads.emplace_back([slice = sb.slice(t, 4)]() {
+	      for (int i = 0; i < 10000; ++i) {
+		BufferSlice copy(slice);
+		BufferSlice sub = copy.slice(1, 2);
+		(void)sub;
+	      }
+	    });
+	}
+
+	for (auto& thread : threads) {
+	  thread.join();
+	}
+
+	ASSERT(1 == sb.useCount());
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 3:
+    {
+      // A shared buffer can adopt an exclusively owned buffer.
+      mdmem::TestAllocator data;
+      mdmem::TestAllocator control;
+
+      {
+	Buffer b = Buffer::copy("adopted", 7, &data);
+	SharedBuffer sb(std::move(b), &control);
+
+	ASSERT(0 == b.size());
+	ASSERT(0 == b.buffer());
+	ASSERT("adopted" == str(sb));
+	ASSERT(1 == control.allocationCount());
+
+	BufferSlice s = sb.slice(2);
+	sb.reset();
+	ASSERT(0 == data.deallocationCount());
+	ASSERT("opted" == str(s));
+      }
+
+      ASSERT(1 == data.allocationCount());
+      ASSERT(1 == data.deallocationCount());
+      ASSERT(control.allocationCount() == control.deallocationCount());
+    } break;
+
+  case 2:
+    {
+      // Slices share memory and keep it alive.
+      mdmem::TestAllocator ta;
+      BufferSlice          outer;
+
+      {
+	SharedBuffer sb = SharedBuffer::copy("hello world", 11, &ta);
+	ASSERT(1 == ta.allocationCount());
+	ASSERT(1 == sb.useCount());
+
+	BufferSlice all = sb.slice();
+	ASSERT(sb.buffer() == all.buffer());
+	ASSERT(11 == all.size());
+	ASSERT(2 == sb.useCount());
+
+	BufferSlice world = all.slice(6);
+	ASSERT("world" == str(world));
+	ASSERT("wor" == str(world.slice(0, 3)));
+	ASSERT("" == str(world.slice(5)));
+
+	BufferSlice copy(world);
+	copy.removePrefix(1);
+	copy.removeSuffix(1);
+	ASSERT("orl" == str(copy));
+	ASSERT("world" == str(world));
+
+	sb.buffer()[6] = 'W';
+	ASSERT("World" == str(world));
+
+	outer = std::move(world);
+	ASSERT(0 == world.size());
+	ASSERT(0 == world.useCount());
+
+	ASSERT(1 == ta.allocationCount());
+      }
+
+      ASSERT(0 == ta.deallocationCount());
+      ASSERT("World" == str(outer));
+
+      outer.reset();
+      ASSERT(1 == ta.deallocationCount());
+    } break;
+
+  case 1:
+    {
+      // Buffer is move-only and releases its memory exactly once.
+      mdmem::TestAllocator ta;
+
+      {
+	Buffer b0 = Buffer::copy("hello", 5, &ta);
+	Buffer b1(std::move(b0));
+	ASSERT(0 == b0.size());
+	ASSERT("hello" == str(b1));
+
+	Buffer b2(&ta);
+	b2 = std::move(b1);
+	ASSERT(0 == b1.size());
+	ASSERT("hello" == str(b2));
+	ASSERT(&ta == b2.allocator());
+
+	char *raw = b2.release();
+	ASSERT(0 == b2.size());
+	ASSERT(0 == ta.deallocationCount());
+	ta.deallocate(raw, 5);
+      }
+
+      ASSERT(1 == ta.allocationCount());
+      ASSERT(1 == ta.deallocationCount());
+
+      {
+	SharedBuffer empty;
+	ASSERT(0 == empty.size());
+	ASSERT(0 == empty.useCount());
+	ASSERT(0 == empty.slice().size());
+      }
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
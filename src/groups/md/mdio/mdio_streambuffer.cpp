@@ -0,0 +1,131 @@
+// mdio_streambuffer.cpp                                                -*-c++-*-
+#include <mdio_streambuffer.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <sys/uio.h>
+
+namespace MvdS {
+namespace mdio {
+
+// ------------------------
+// Class OutputStreamBuffer
+// ------------------------
+
+// PRIVATE MANIPULATORS
+
+void OutputStreamBuffer::nextPutArea()
+{
+  commit();
+
+  size_t size;
+  char * buffer = d_vector_p->writableBuffer(&size);
+  setp(buffer, buffer + size);
+}
+
+// PROTECTED MANIPULATORS
+
+OutputStreamBuffer::int_type OutputStreamBuffer::overflow(int_type character)
+{
+  nextPutArea();
+
+  if (!traits_type::eq_int_type(character, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(character);
+    pbump(1);
+  }
+
+  return traits_type::not_eof(character);
+}
+
+std::streamsize OutputStreamBuffer::xsputn(const char_type *data,
+                                           std::streamsize  size)
+{
+  std::streamsize remaining = size;
+
+  while (0 < remaining) {
+    if (pptr() == epptr()) {
+      nextPutArea();
+    }
+
+    const std::streamsize count = std::min<std::streamsize>(
+        remaining, epptr() - pptr());
+    memcpy(pptr(), data, count);
+    pbump(static_cast<int>(count));
+
+    data += count;
+    remaining -= count;
+  }
+
+  return size;
+}
+
+int OutputStreamBuffer::sync()
+{
+  commit();
+  return 0;
+}
+
+OutputStreamBuffer::pos_type
+OutputStreamBuffer::seekoff(off_type                off,
+                            std::ios_base::seekdir  direction,
+                            std::ios_base::openmode which)
+{
+  if (0 != off || std::ios_base::cur != direction ||
+      !(which & std::ios_base::out)) {
+    return pos_type(off_type(-1));
+  }
+
+  return pos_type(off_type(d_vector_p->size() + (pptr() - pbase())));
+}
+
+// CREATORS
+
+OutputStreamBuffer::~OutputStreamBuffer()
+{
+  commit();
+}
+
+// -----------------------
+// Class InputStreamBuffer
+// -----------------------
+
+// PROTECTED MANIPULATORS
+
+InputStreamBuffer::int_type InputStreamBuffer::underflow()
+{
+  d_vector_p->consume(egptr() - eback());
+
+  iovec iov;
+  if (0 == d_vector_p->iovecs(&iov, 1)) {
+    setg(0, 0, 0);
+    return traits_type::eof();
+  }
+
+  char *buffer = static_cast<char *>(iov.iov_base);
+  setg(buffer, buffer, buffer + iov.iov_len);
+
+  return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize InputStreamBuffer::showmanyc()
+{
+  const size_t available = d_vector_p->size() - (gptr() - eback());
+  return 0 == available ? -1 : static_cast<std::streamsize>(available);
+}
+
+int InputStreamBuffer::sync()
+{
+  consume();
+  return 0;
+}
+
+// CREATORS
+
+InputStreamBuffer::~InputStreamBuffer()
+{
+  consume();
+}
+
+} // namespace mdio
+} // namespace MvdS
@@ -0,0 +1,162 @@
+// mdio_streambuffer.h                                                  -*-c++-*-
+#ifndef __INCLUDED_MDIO_STREAMBUFFER
+#define __INCLUDED_MDIO_STREAMBUFFER
+
+#include <mdio_buffervector.h>
+
+#include <ios>
+#include <streambuf>
+
+namespace MvdS {
+namespace mdio {
+
+// ========================
+// Class OutputStreamBuffer
+// ========================
+
+class OutputStreamBuffer : public std::streambuf
+{
+  // Provides a 'std::streambuf' that writes directly into the free space of
+  // a 'BufferVector'.
+  //
+  // The put area is the free space of the tail buffer of the vector, so
+  // formatted output lands in its final place without an intermediate
+  // string. Written bytes are committed to the vector on 'pubsync' (and
+  // thereby on 'std::ostream::flush'), whenever the put area is exhausted
+  // and on destruction. Use a vector with a pooled allocator, see
+  // 'BufferPool::tierAllocator', to avoid heap allocations altogether. The
+  // vector must not be modified by other means while bytes are pending.
+
+  // DATA
+
+  BufferVector *d_vector_p;
+
+  // PRIVATE MANIPULATORS
+
+  void commit()
+  // Add the bytes written to the put area to the vector.
+  {
+    d_vector_p->commit(pptr() - pbase());
+    setp(pptr(), epptr());
+  }
+
+  void nextPutArea();
+  // Commit the pending bytes and make the free space of the vector the put
+  // area.
+
+protected:
+  // PROTECTED MANIPULATORS
+
+  virtual int_type overflow(int_type character);
+  // Commit the put area, obtain a new one and write the specified
+  // 'character' unless it is end of file. Return a value other than end of
+  // file.
+
+  virtual std::streamsize xsputn(const char_type *data, std::streamsize size);
+  // Copy the specified 'data' with the specified 'size' to the vector.
+  // Return 'size'.
+
+  virtual int sync();
+  // Commit the put area. Return 0.
+
+  virtual pos_type seekoff(off_type                off,
+                           std::ios_base::seekdir  direction,
+                           std::ios_base::openmode which);
+  // Return the number of bytes written to the vector if the specified 'off'
+  // is 0 relative to the current position of the output sequence, and an
+  // invalid position otherwise.
+
+public:
+  OutputStreamBuffer(const OutputStreamBuffer &) = delete;
+  OutputStreamBuffer &operator=(const OutputStreamBuffer &) = delete;
+
+  // CREATORS
+
+  explicit OutputStreamBuffer(BufferVector *vector)
+      // Create a stream buffer that appends to the specified 'vector'.
+      : d_vector_p(vector)
+  {}
+
+  ~OutputStreamBuffer();
+  // Commit the pending bytes.
+
+  // ACCESSORS
+
+  BufferVector *vector() const
+  // Return the vector written to.
+  {
+    return d_vector_p;
+  }
+};
+
+// =======================
+// Class InputStreamBuffer
+// =======================
+
+class InputStreamBuffer : public std::streambuf
+{
+  // Provides a 'std::streambuf' that reads directly from the buffers of a
+  // 'BufferVector'.
+  //
+  // The get area is one buffer of the vector at a time, so extraction reads
+  // the stored bytes in place. Bytes that have been read are consumed from
+  // the vector when the next buffer is needed, on 'pubsync' and on
+  // destruction. Data appended to the vector in the meantime is picked up
+  // by later reads. The vector must not be consumed by other means while
+  // the stream buffer is in use.
+
+  // DATA
+
+  BufferVector *d_vector_p;
+
+  // PRIVATE MANIPULATORS
+
+  void consume()
+  // Remove the bytes read from the get area from the vector.
+  {
+    d_vector_p->consume(gptr() - eback());
+    setg(gptr(), gptr(), egptr());
+  }
+
+protected:
+  // PROTECTED MANIPULATORS
+
+  virtual int_type underflow();
+  // Consume the get area and make the next buffer of the vector the get
+  // area. Return the next character, or end of file if the vector is empty.
+
+  virtual std::streamsize showmanyc();
+  // Return the number of bytes that can be read without blocking, or -1 if
+  // the vector is exhausted.
+
+  virtual int sync();
+  // Consume the bytes read so far. Return 0.
+
+public:
+  InputStreamBuffer(const InputStreamBuffer &) = delete;
+  InputStreamBuffer &operator=(const InputStreamBuffer &) = delete;
+
+  // CREATORS
+
+  explicit InputStreamBuffer(BufferVector *vector)
+      // Create a stream buffer that reads from the front of the specified
+      // 'vector'.
+      : d_vector_p(vector)
+  {}
+
+  ~InputStreamBuffer();
+  // Consume the bytes read so far.
+
+  // ACCESSORS
+
+  BufferVector *vector() const
+  // Return the vector read from.
+  {
+    return d_vector_p;
+  }
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_STREAMBUFFER
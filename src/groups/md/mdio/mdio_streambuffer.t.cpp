@@ -0,0 +1,183 @@
+// mdio_streambuffer.t.cpp                                              -*-c++-*-
+#include <mdio_streambuffer.h>
+
+#include <mdio_bufferpool.h>
+#include <mdmem_testallocator.h>
+
+#include <iostream>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+std::string str(const BufferVector& vector)
+{
+  std::string result(vector.size(), '\0');
+  vector.copyOut(&result[0], result.size());
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 4:
+    {
+      // Steady state formatting into pooled buffers does not allocate.
+      mdmem::TestAllocator ta;
+
+      {
+	BufferPool::Configuration conf;
+	conf.d_tiers = {{64, 4}};
+	BufferPool   pool(conf, &ta);
+	BufferVector vector(64, pool.tierAllocator(64));
+
+	vector.reserve(256);
+	vector.clear();
+
+	const size_t before = ta.allocationCount();
+
+	for (int i = 0; i < 100; ++i) {
+	  {
+	    OutputStreamBuffer sb(&vector);
+	    std::ostream       os(&sb);
+	    os << "message " << i << ' ' << 3.5 << std::flush;
+	  }
+	  vector.clear();
+	}
+
+	ASSERT(before == ta.allocationCount());
+	ASSERT(0 == pool.metrics(0).d_missCount);
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 3:
+    {
+      // Reading picks up data appended in the meantime and consumes what
+      // has been read.
+      BufferVector vector(8);
+      vector.append("12 34 ", 6);
+
+      {
+	InputStreamBuffer sb(&vector);
+	std::istream      is(&sb);
+
+	int value = 0;
+	ASSERT(is >> value);
+	ASSERT(12 == value);
+
+	vector.append("56789 abcdefghijklm ", 20);
+	ASSERT(is >> value);
+	ASSERT(34 == value);
+	ASSERT(is >> value);
+	ASSERT(56789 == value);
+
+	sb.pubsync();
+	ASSERT(" abcdefghijklm " == str(vector));
+
+	std::string word;
+	ASSERT(is >> word);
+	ASSERT("abcdefghijklm" == word);
+	ASSERT(!(is >> word));
+      }
+
+      ASSERT(vector.empty());
+    } break;
+
+  case 2:
+    {
+      // Round trip of formatted output across many buffers.
+      BufferVector vector(16);
+      std::ostringstream expected;
+
+      {
+	OutputStreamBuffer sb(&vector);
+	std::ostream       os(&sb);
+
+	for (int i = 0; i < 1000; ++i) {
+	  os << i << ' ';
+	  expected << i << ' ';
+	}
+	ASSERT(std::streamoff(expected.str().size()) == os.tellp());
+
+	os << std::string(100, 'x') << ' ';
+	expected << std::string(100, 'x') << ' ';
+      }
+
+      ASSERT(expected.str() == str(vector));
+      ASSERT(vector.bufferCount() == (vector.size() + 15) / 16);
+
+      InputStreamBuffer sb(&vector);
+      std::istream      is(&sb);
+
+      for (int i = 0; i < 1000; ++i) {
+	int value = -1;
+	is >> value;
+	ASSERT(i == value);
+      }
+
+      std::string x;
+      is >> x;
+      ASSERT(std::string(100, 'x') == x);
+    } break;
+
+  case 1:
+    {
+      // Breathing test.
+      BufferVector vector(4);
+
+      OutputStreamBuffer sb(&vector);
+      std::ostream       os(&sb);
+      ASSERT(&vector == sb.vector());
+
+      os << "Hello";
+      ASSERT(vector.size() < 5);
+
+      os << ", world!" << std::flush;
+      ASSERT("Hello, world!" == str(vector));
+
+      os.put('?');
+      os.flush();
+      ASSERT("Hello, world!?" == str(vector));
+
+      InputStreamBuffer isb(&vector);
+      std::istream      is(&isb);
+      std::string       line;
+      ASSERT(std::getline(is, line));
+      ASSERT("Hello, world!?" == line);
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,249 @@
+// mdio_transfer.cpp                                                    -*-c++-*-
+#include <mdio_transfer.h>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MvdS {
+namespace mdio {
+
+namespace {
+
+bool isRejected(int error)
+// Return true if the specified 'error' means that a method is not
+// applicable to the descriptors.
+{
+  return EINVAL == error || ENOSYS == error || EXDEV == error ||
+         EOPNOTSUPP == error || EBADF == error;
+}
+
+} // namespace
+
+// --------------
+// Class Transfer
+// --------------
+
+// PRIVATE MANIPULATORS
+
+ssize_t Transfer::transferOnce(size_t size, off_t *offset)
+{
+  switch (d_method) {
+  case e_copyFileRange:
+    return copy_file_range(d_inFd, offset, d_outFd, nullptr, size, 0);
+
+  case e_sendfile:
+    return sendfile(d_outFd, d_inFd, offset, size);
+
+  case e_splice: {
+    loff_t  position = offset ? *offset : 0;
+    ssize_t result   = splice(d_inFd,
+                            offset ? &position : nullptr,
+                            d_outFd,
+                            nullptr,
+                            size,
+                            SPLICE_F_MOVE);
+    if (offset && 0 < result) {
+      *offset = position;
+    }
+    return result;
+  }
+
+  case e_splicePipe: {
+    if (0 == d_pending) {
+      if (d_pipe[0] < 0 && 0 != pipe2(d_pipe, O_NONBLOCK | O_CLOEXEC)) {
+        return -1;
+      }
+
+      loff_t        position = offset ? *offset : 0;
+      const ssize_t result   = splice(d_inFd,
+                                    offset ? &position : nullptr,
+                                    d_pipe[1],
+                                    nullptr,
+                                    size,
+                                    SPLICE_F_MOVE);
+      if (result <= 0) {
+        return result;
+      }
+      if (offset) {
+        *offset = position;
+      }
+      d_pending = result;
+    }
+
+    // Bytes pending from an earlier call count against 'size' as well.
+    const ssize_t result = splice(d_pipe[0],
+                                  nullptr,
+                                  d_outFd,
+                                  nullptr,
+                                  size < d_pending ? size : d_pending,
+                                  SPLICE_F_MOVE);
+    if (0 < result) {
+      d_pending -= result;
+    }
+    return result;
+  }
+
+  case e_copy: {
+    if (0 == d_pending) {
+      if (!d_buffer.buffer()) {
+        d_buffer = d_pool_p ? d_pool_p->acquire(k_copyBufferSize)
+                            : Buffer(static_cast<char *>(d_allocator_p->allocate(
+                                         k_copyBufferSize)),
+                                     k_copyBufferSize,
+                                     d_allocator_p);
+      }
+
+      const size_t  count  = size < d_buffer.size() ? size : d_buffer.size();
+      const ssize_t result = offset
+                                 ? pread(d_inFd, d_buffer.buffer(), count, *offset)
+                                 : read(d_inFd, d_buffer.buffer(), count);
+      if (result <= 0) {
+        return result;
+      }
+      if (offset) {
+        *offset += result;
+      }
+      d_begin   = 0;
+      d_pending = result;
+    }
+
+    const ssize_t result = write(d_outFd,
+                                 d_buffer.buffer() + d_begin,
+                                 size < d_pending ? size : d_pending);
+    if (0 < result) {
+      d_begin += result;
+      d_pending -= result;
+    }
+    return result;
+  }
+  }
+
+  errno = EINVAL;
+  return -1;
+}
+
+bool Transfer::fallBack()
+{
+  switch (d_method) {
+  case e_copyFileRange:
+    d_method = e_sendfile;
+    return true;
+  case e_sendfile:
+  case e_splice:
+  case e_splicePipe:
+    d_method = e_copy;
+    return true;
+  case e_copy:
+    break;
+  }
+  return false;
+}
+
+// CREATORS
+
+Transfer::Transfer(int               inFd,
+                   int               outFd,
+                   BufferPool *      pool,
+                   mdmem::Allocator *allocator)
+    : d_inFd(inFd)
+    , d_outFd(outFd)
+    , d_method(e_copy)
+    , d_pipe{-1, -1}
+    , d_buffer(allocator)
+    , d_begin(0)
+    , d_pending(0)
+    , d_inputReady(false)
+    , d_pool_p(pool)
+    , d_allocator_p(mdmem::AllocatorUtil::defaultAllocator(allocator))
+{
+  struct stat in;
+  struct stat out;
+  if (0 != fstat(inFd, &in) || 0 != fstat(outFd, &out)) {
+    return;
+  }
+
+  d_inputReady = S_ISREG(in.st_mode) || S_ISBLK(in.st_mode);
+
+  if (S_ISREG(in.st_mode) && S_ISREG(out.st_mode)) {
+    d_method = e_copyFileRange;
+  } else if (S_ISREG(in.st_mode) || S_ISBLK(in.st_mode)) {
+    d_method = e_sendfile;
+  } else if (S_ISFIFO(in.st_mode) || S_ISFIFO(out.st_mode)) {
+    d_method = e_splice;
+  } else if (S_ISSOCK(in.st_mode)) {
+    d_method = e_splicePipe;
+  }
+}
+
+Transfer::~Transfer()
+{
+  if (0 <= d_pipe[0]) {
+    close(d_pipe[0]);
+    close(d_pipe[1]);
+  }
+}
+
+// MANIPULATORS
+
+ssize_t Transfer::transfer(size_t size, off_t *offset)
+{
+  while (true) {
+    const ssize_t result = transferOnce(size, offset);
+    if (0 <= result) {
+      return result;
+    }
+
+    const int error = errno;
+    if (EINTR == error) {
+      continue;
+    }
+    if (EWOULDBLOCK == error) {
+      return -EAGAIN;
+    }
+
+    // Methods are rejected on the first call, before bytes are pending.
+    if (0 == d_pending && isRejected(error) && fallBack()) {
+      continue;
+    }
+    return -error;
+  }
+}
+
+ssize_t Transfer::transferAll(size_t size, off_t *offset)
+{
+  size_t total = 0;
+
+  while (total < size) {
+    const ssize_t result = transfer(size - total, offset);
+    if (0 < result) {
+      total += result;
+      continue;
+    }
+    if (0 == result) {
+      break;
+    }
+    if (-EAGAIN != result) {
+      return result;
+    }
+
+    // Wait for the side that blocked. Polling an input that is always
+    // readable as well would spin while the output is full.
+    const bool output = 0 < d_pending || d_inputReady;
+    pollfd     fd     = {output ? d_outFd : d_inFd,
+                         static_cast<short>(output ? POLLOUT : POLLIN),
+                         0};
+    if (0 > poll(&fd, 1, -1) && EINTR != errno) {
+      return -errno;
+    }
+  }
+
+  return total;
+}
+
+} // namespace mdio
+} // namespace MvdS
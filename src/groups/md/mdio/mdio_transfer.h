@@ -0,0 +1,134 @@
+// mdio_transfer.h                                                      -*-c++-*-
+#ifndef __INCLUDED_MDIO_TRANSFER
+#define __INCLUDED_MDIO_TRANSFER
+
+#include <mdio_buffer.h>
+#include <mdio_bufferpool.h>
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <cstddef>
+
+#include <sys/types.h>
+
+namespace MvdS {
+namespace mdio {
+
+// ==============
+// Class Transfer
+// ==============
+
+class Transfer
+{
+  // Provides a transfer of bytes from one file descriptor to another that
+  // stays inside the kernel where possible.
+  //
+  // The method is chosen from the types of the descriptors:
+  //: o file to file: 'copy_file_range', which may share extents;
+  //: o file to anything else: 'sendfile';
+  //: o to or from a pipe: 'splice' between the descriptors;
+  //: o socket to anything else: 'splice' through an internal pipe pair;
+  //: o otherwise: 'read' and 'write' through a buffer of the pool.
+  // If the kernel rejects a method for the descriptors, the transfer falls
+  // back to the next applicable one, ending with the buffer copy.
+  //
+  // Non-blocking descriptors are supported, so a transfer can be driven
+  // from a reactor or a thread pool job: 'transfer' moves as much as
+  // possible and returns '-EAGAIN' when either side would block. Bytes
+  // already taken from the input, in the internal pipe or buffer, are
+  // delivered by the next calls and count against their sizes. To send a
+  // file on a 'ReactorConnection', transfer to its 'fd()' when its
+  // 'pendingOutput()' is 0.
+
+public:
+  // PUBLIC TYPES
+
+  enum Method
+  {
+    e_copyFileRange, // 'copy_file_range' between files.
+    e_sendfile,      // 'sendfile' from a file.
+    e_splice,        // 'splice' with a pipe at either end.
+    e_splicePipe,    // 'splice' through the internal pipe.
+    e_copy           // 'read' and 'write' through a buffer.
+  };
+
+  // PUBLIC CONSTANTS
+
+  enum
+  {
+    k_copyBufferSize = 65536 // Size of the buffer of 'e_copy'.
+  };
+
+private:
+  // DATA
+
+  int               d_inFd;
+  int               d_outFd;
+  Method            d_method;
+  int               d_pipe[2];  // Internal pipe of 'e_splicePipe'.
+  Buffer            d_buffer;   // Buffer of 'e_copy'.
+  size_t            d_begin;    // Start of the pending bytes in 'd_buffer'.
+  size_t            d_pending;  // Bytes taken from the input, not written.
+  bool              d_inputReady; // Input never blocks, e.g. a file.
+  BufferPool *      d_pool_p;
+  mdmem::Allocator *d_allocator_p;
+
+  // PRIVATE MANIPULATORS
+
+  ssize_t transferOnce(size_t size, off_t *offset);
+  // Perform one step with the current method.
+
+  bool fallBack();
+  // Switch to the next applicable method. Return false if there is none.
+
+public:
+  Transfer(const Transfer &) = delete;
+  Transfer &operator=(const Transfer &) = delete;
+
+  // CREATORS
+
+  Transfer(int               inFd,
+           int               outFd,
+           BufferPool *      pool      = 0,
+           mdmem::Allocator *allocator = 0);
+  // Create a transfer from the specified 'inFd' to the specified 'outFd'.
+  // Optionally the specified 'pool' provides the buffer of a copy and the
+  // specified 'allocator' is used for memory allocation otherwise. The
+  // descriptors are not owned.
+
+  ~Transfer();
+  // Close the internal pipe. Pending bytes are lost.
+
+  // MANIPULATORS
+
+  ssize_t transfer(size_t size, off_t *offset = nullptr);
+  // Move up to the specified 'size' bytes from the input to the output,
+  // reading the input at the optionally specified 'offset', which is
+  // advanced, instead of its file position. Return the number of bytes
+  // written to the output, 0 at the end of the input, or a negative
+  // 'errno' value, '-EAGAIN' if a non-blocking descriptor would block.
+
+  ssize_t transferAll(size_t size, off_t *offset = nullptr);
+  // Move the specified 'size' bytes, or up to the end of the input, waiting
+  // for non-blocking descriptors. Return the number of bytes written or a
+  // negative 'errno' value.
+
+  // ACCESSORS
+
+  Method method() const
+  // Return the method in use.
+  {
+    return d_method;
+  }
+
+  size_t pending() const
+  // Return the number of bytes taken from the input but not yet written.
+  {
+    return d_pending;
+  }
+};
+
+} // namespace mdio
+} // namespace MvdS
+
+#endif // __INCLUDED_MDIO_TRANSFER
@@ -0,0 +1,401 @@
+// mdio_transfer.t.cpp                                                  -*-c++-*-
+#include <mdio_transfer.h>
+
+#include <mdio_bufferpool.h>
+
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdio;
+
+typedef Transfer Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+class TemporaryFile {
+  // Creates a file with the given contents and removes it on destruction.
+
+  std::string d_path;
+  int         d_fd;
+
+public:
+  explicit TemporaryFile(const std::string& contents = std::string())
+    : d_path("/tmp/mdio_transfer.XXXXXX")
+  {
+    d_fd = mkstemp(&d_path[0]);
+    ASSERT(0 <= d_fd);
+    ASSERT(ssize_t(contents.size()) == write(d_fd, contents.data(), contents.size()));
+    lseek(d_fd, 0, SEEK_SET);
+  }
+
+  ~TemporaryFile()
+  {
+    close(d_fd);
+    unlink(d_path.c_str());
+  }
+
+  int fd() const { return d_fd; }
+
+  std::string contents() const
+  {
+    struct stat status;
+    fstat(d_fd, &status);
+    std::string result(status.st_size, '\0');
+    ASSERT(ssize_t(result.size()) == pread(d_fd, &result[0], result.size(), 0));
+    return result;
+  }
+};
+
+std::string payload(size_t size)
+{
+  std::string result(size, '\0');
+  for (size_t i = 0; i < size; ++i) {
+    result[i] = static_cast<char>('a' + i * 7 % 26);
+  }
+  return result;
+}
+
+std::string readAll(int fd, size_t size)
+{
+  std::string result;
+  char        buffer[65536];
+  while (result.size() < size) {
+    const ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n <= 0) {
+      break;
+    }
+    result.append(buffer, n);
+  }
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 6:
+    {
+      // Bytes left pending by 'transfer' count against the size of a
+      // following 'transferAll', through the pipe and the buffer.
+      int in[2];
+      int out[2];
+      ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, in));
+      ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, out));
+      fcntl(out[0], F_SETFL, O_NONBLOCK);
+
+      const std::string data = payload(4 << 20);
+      std::thread writer([&]() {
+	  ASSERT(ssize_t(data.size()) == write(in[0], data.data(), data.size()));
+	  shutdown(in[0], SHUT_WR);
+	});
+
+      {
+	Obj o(in[1], out[0]);
+	ASSERT(Obj::e_splicePipe == o.method());
+
+	// Until the output blocks; the input may be empty for a moment.
+	size_t sent = 0;
+	ssize_t result;
+	while (0 < (result = o.transfer(1 << 20)) ||
+	       (-EAGAIN == result && 0 == o.pending())) {
+	  sent += 0 < result ? result : 0;
+	}
+	ASSERT(-EAGAIN == result);
+	ASSERT(0 < o.pending());
+
+	std::string received;
+	std::thread reader([&]() { received = readAll(out[1], data.size()); });
+
+	const size_t pending = o.pending();
+	const size_t request = (pending + 1) / 2;
+	ASSERT(ssize_t(request) == o.transferAll(request));
+	ASSERT(pending - request == o.pending());
+	sent += request;
+
+	ASSERT(ssize_t(data.size() - sent) == o.transferAll(data.size() - sent));
+	ASSERT(0 == o.pending());
+	reader.join();
+	ASSERT(data == received);
+      }
+      writer.join();
+
+      const int zero = open("/dev/zero", O_RDONLY);
+      ASSERT(0 <= zero);
+      {
+	Obj o(zero, out[0]);
+	ASSERT(Obj::e_copy == o.method());
+
+	size_t sent = 0;
+	ssize_t result;
+	while (0 < (result = o.transfer(1 << 20))) {
+	  sent += result;
+	}
+	ASSERT(-EAGAIN == result);
+	ASSERT(0 < o.pending());
+
+	const size_t pending = o.pending();
+	const size_t request = (pending + 1) / 2;
+	std::string  received;
+	std::thread  reader([&]() {
+	    received = readAll(out[1], sent + request);
+	  });
+	ASSERT(ssize_t(request) == o.transferAll(request));
+	ASSERT(pending - request == o.pending());
+	reader.join();
+	ASSERT(std::string(sent + request, '\0') == received);
+      }
+      close(zero);
+
+      for (int fd : {in[0], in[1], out[0], out[1]}) {
+	close(fd);
+      }
+    } break;
+
+  case 5:
+    {
+      // A file to a full non-blocking socket waits for the socket only,
+      // without spinning on the always readable file.
+      const std::string data = payload(4 << 20);
+      TemporaryFile     file(data);
+
+      int sockets[2];
+      ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+      fcntl(sockets[0], F_SETFL, O_NONBLOCK);
+
+      std::string received;
+      std::thread reader([&]() {
+	  this_thread::sleep_for(std::chrono::milliseconds(300));
+	  received = readAll(sockets[1], data.size());
+	});
+
+      struct rusage before;
+      struct rusage after;
+      getrusage(RUSAGE_THREAD, &before);
+      {
+	Obj o(file.fd(), sockets[0]);
+	ASSERT(Obj::e_sendfile == o.method());
+	ASSERT(ssize_t(data.size()) == o.transferAll(data.size()));
+      }
+      getrusage(RUSAGE_THREAD, &after);
+      reader.join();
+      ASSERT(data == received);
+
+      const auto cpu = [](const struct rusage& usage) {
+	return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+	       usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+      };
+      ASSERT(cpu(after) - cpu(before) < 150000);
+
+      close(sockets[0]);
+      close(sockets[1]);
+    } break;
+
+  case 4:
+    {
+      // Non-blocking output: bytes taken from the input are kept until the
+      // output is writable again.
+      int sockets[2];
+      ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+      int relay[2];
+      ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, relay));
+      fcntl(relay[0], F_SETFL, O_NONBLOCK);
+
+      const std::string data = payload(4 << 20);
+      std::thread writer([&]() {
+	  ASSERT(ssize_t(data.size()) == write(sockets[0], data.data(), data.size()));
+	  shutdown(sockets[0], SHUT_WR);
+	});
+
+      Obj    o(sockets[1], relay[0]);
+      size_t sent    = 0;
+      bool   blocked = false;
+      while (true) {
+	const ssize_t result = o.transfer(1 << 20);
+	if (-EAGAIN == result) {
+	  blocked = true;
+	  ASSERT(sent + o.pending() <= data.size());
+	  break;
+	}
+	ASSERT(0 < result);
+	if (result <= 0) {
+	  break;
+	}
+	sent += result;
+      }
+      ASSERT(blocked);
+
+      std::string received;
+      std::thread reader([&]() { received = readAll(relay[1], data.size()); });
+
+      while (true) {
+	const ssize_t result = o.transfer(1 << 20);
+	if (0 == result) {
+	  break;
+	}
+	if (-EAGAIN == result) {
+	  this_thread::yield();
+	  continue;
+	}
+	ASSERT(0 < result);
+	if (result < 0) {
+	  break;
+	}
+	sent += result;
+      }
+      shutdown(relay[0], SHUT_WR);
+
+      writer.join();
+      reader.join();
+      ASSERT(data.size() == sent);
+      ASSERT(data == received);
+
+      for (int fd : {sockets[0], sockets[1], relay[0], relay[1]}) {
+	close(fd);
+      }
+    } break;
+
+  case 3:
+    {
+      // Socket to socket goes through the internal pipe; other descriptors
+      // are copied through a pooled buffer.
+      int in[2];
+      int out[2];
+      ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, in));
+      ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, out));
+
+      const std::string data = payload(1 << 20);
+      std::thread writer([&]() {
+	  ASSERT(ssize_t(data.size()) == write(in[0], data.data(), data.size()));
+	  shutdown(in[0], SHUT_WR);
+	});
+      std::string received;
+      std::thread reader([&]() { received = readAll(out[1], data.size()); });
+
+      {
+	Obj o(in[1], out[0]);
+	ASSERT(Obj::e_splicePipe == o.method());
+	ASSERT(ssize_t(data.size()) == o.transferAll(2 * data.size()));
+	ASSERT(0 == o.pending());
+      }
+
+      writer.join();
+      reader.join();
+      ASSERT(data == received);
+
+      const int zero = open("/dev/zero", O_RDONLY);
+      ASSERT(0 <= zero);
+      BufferPool pool;
+      {
+	Obj o(zero, out[0], &pool);
+	ASSERT(Obj::e_copy == o.method());
+	ASSERT(100000 == o.transferAll(100000));
+	ASSERT(std::string(100000, '\0') == readAll(out[1], 100000));
+      }
+      ASSERT(0 == pool.metrics(pool.tierCount() - 1).d_inUseCount);
+      close(zero);
+
+      for (int fd : {in[0], in[1], out[0], out[1]}) {
+	close(fd);
+      }
+    } break;
+
+  case 2:
+    {
+      // File to socket uses 'sendfile'; pipes use 'splice'.
+      const std::string data = payload(300000);
+      TemporaryFile     file(data);
+
+      int sockets[2];
+      ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+      std::string received;
+      std::thread reader([&]() { received = readAll(sockets[1], data.size() - 1000); });
+
+      off_t offset = 1000;
+      {
+	Obj o(file.fd(), sockets[0]);
+	ASSERT(Obj::e_sendfile == o.method());
+	ASSERT(ssize_t(data.size() - 1000) == o.transferAll(data.size(), &offset));
+	ASSERT(off_t(data.size()) == offset);
+      }
+      reader.join();
+      ASSERT(data.substr(1000) == received);
+
+      int pipes[2];
+      ASSERT(0 == pipe(pipes));
+      TemporaryFile copy;
+      std::thread writer([&]() {
+	  ASSERT(5 == write(pipes[1], "12345", 5));
+	  close(pipes[1]);
+	});
+      {
+	Obj o(pipes[0], copy.fd());
+	ASSERT(Obj::e_splice == o.method());
+	ASSERT(5 == o.transferAll(100));
+      }
+      writer.join();
+      ASSERT("12345" == copy.contents());
+
+      close(pipes[0]);
+      close(sockets[0]);
+      close(sockets[1]);
+    } break;
+
+  case 1:
+    {
+      // Breathing test: file to file.
+      const std::string data = payload(100000);
+      TemporaryFile     source(data);
+      TemporaryFile     target;
+
+      Obj o(source.fd(), target.fd());
+      ASSERT(Obj::e_copyFileRange == o.method());
+
+      ASSERT(ssize_t(data.size()) == o.transferAll(data.size()));
+      ASSERT(0 == o.transfer(100));
+      ASSERT(data == target.contents());
+      ASSERT(0 == o.pending());
+
+      off_t offset = 10;
+      ASSERT(20 == o.transferAll(20, &offset));
+      ASSERT(30 == offset);
+      ASSERT(data + data.substr(10, 20) == target.contents());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,246 @@
+// mdlog_binarylog.cpp                                                  -*-c++-*-
+#include <mdlog_binarylog.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <ostream>
+
+namespace MvdS {
+namespace mdlog {
+
+namespace {
+
+template <class TYPE>
+const char *load(TYPE *value, const char *data, const char *end)
+{
+  if (end - data < static_cast<ptrdiff_t>(sizeof(TYPE))) {
+    return nullptr;
+  }
+  memcpy(value, data, sizeof(TYPE));
+  return data + sizeof(TYPE);
+}
+
+const char *loadString(std::string_view *value, const char *data,
+                       const char *end)
+{
+  uint32_t length = 0;
+  data            = load(&length, data, end);
+  if (!data || static_cast<size_t>(end - data) < length) {
+    return nullptr;
+  }
+  *value = std::string_view(data, length);
+  return data + length;
+}
+
+std::atomic<uint32_t> s_nextSiteId(1);
+
+} // namespace
+
+// ------------------------
+// Struct BinaryLogArgument
+// ------------------------
+
+// CLASS METHODS
+
+const char *BinaryLogArgument::format(std::ostream &stream,
+                                      Type          type,
+                                      const char *  data,
+                                      const char *  end)
+{
+  switch (type) {
+  case e_bool: {
+    if (data == end) {
+      return nullptr;
+    }
+    stream << (*data ? "true" : "false");
+    return data + 1;
+  }
+  case e_char: {
+    if (data == end) {
+      return nullptr;
+    }
+    stream << *data;
+    return data + 1;
+  }
+  case e_signed: {
+    int64_t value = 0;
+    if ((data = load(&value, data, end))) {
+      stream << value;
+    }
+    return data;
+  }
+  case e_unsigned: {
+    uint64_t value = 0;
+    if ((data = load(&value, data, end))) {
+      stream << value;
+    }
+    return data;
+  }
+  case e_double: {
+    double value = 0;
+    if ((data = load(&value, data, end))) {
+      stream << value;
+    }
+    return data;
+  }
+  case e_string: {
+    std::string_view value;
+    if ((data = loadString(&value, data, end))) {
+      stream << value;
+    }
+    return data;
+  }
+  case e_pointer: {
+    uint64_t value = 0;
+    if ((data = load(&value, data, end))) {
+      // Without changing the flags of the stream.
+      char buffer[24];
+      snprintf(buffer, sizeof(buffer), "0x%" PRIx64, value);
+      stream << buffer;
+    }
+    return data;
+  }
+  }
+  return nullptr;
+}
+
+bool BinaryLogArgument::formatMessage(std::ostream &stream,
+                                      const char *  format,
+                                      const Type *  types,
+                                      size_t        count,
+                                      const char *  data,
+                                      const char *  end)
+{
+  size_t index = 0;
+
+  const char *text = format;
+  while (const char *placeholder = strstr(text, "{}")) {
+    if (index == count) {
+      break;
+    }
+    stream.write(text, placeholder - text);
+    if (!(data = BinaryLogArgument::format(stream, types[index++], data, end))) {
+      return false;
+    }
+    text = placeholder + 2;
+  }
+  stream << text;
+
+  for (; index < count; ++index) {
+    stream << ' ';
+    if (!(data = BinaryLogArgument::format(stream, types[index], data, end))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// -------------------
+// Class BinaryLogSite
+// -------------------
+
+// PRIVATE MANIPULATORS
+
+uint32_t BinaryLogSite::assignId()
+{
+  uint32_t       id       = 0;
+  const uint32_t assigned = s_nextSiteId++;
+  if (d_id.compare_exchange_strong(id, assigned)) {
+    return assigned;
+  }
+  return id; // Assigned by another thread, 'assigned' is unused.
+}
+
+// ----------------------
+// Class BinaryLogDecoder
+// ----------------------
+
+// CREATORS
+
+BinaryLogDecoder::BinaryLogDecoder(bool printTime)
+    : d_printTime(printTime)
+{}
+
+// MANIPULATORS
+
+size_t BinaryLogDecoder::decode(const char *data, size_t size,
+                                std::ostream &stream)
+{
+  const char *const begin = data;
+  const char *const end   = data + size;
+
+  while (end - data >= k_headerSize) {
+    uint32_t entrySize = 0;
+    uint32_t siteId    = 0;
+    int64_t  time      = 0;
+    memcpy(&entrySize, data, sizeof(entrySize));
+    memcpy(&siteId, data + 4, sizeof(siteId));
+    memcpy(&time, data + 8, sizeof(time));
+
+    if (entrySize < k_headerSize) {
+      // Corrupt, nothing after this can be trusted.
+      return size;
+    }
+    if (static_cast<size_t>(end - data) < entrySize) {
+      break;
+    }
+
+    const char *payload  = data + k_headerSize;
+    const char *entryEnd = data + entrySize;
+    data                 = entryEnd;
+
+    if (0 == siteId) {
+      uint32_t         id        = 0;
+      uint8_t          level     = 0;
+      uint8_t          typeCount = 0;
+      std::string_view category;
+      std::string_view format;
+
+      if (!(payload = load(&id, payload, entryEnd)) ||
+          !(payload = load(&level, payload, entryEnd)) ||
+          !(payload = load(&typeCount, payload, entryEnd)) ||
+          entryEnd - payload < typeCount) {
+        continue;
+      }
+      const char *types = payload;
+      if (!(payload = loadString(&category, payload + typeCount, entryEnd)) ||
+          !(payload = loadString(&format, payload, entryEnd))) {
+        continue;
+      }
+
+      Site &site      = d_sites[id];
+      site.d_level    = static_cast<Level::Value>(level);
+      site.d_category = category;
+      site.d_format   = format;
+      site.d_types.assign(
+          reinterpret_cast<const BinaryLogArgument::Type *>(types),
+          reinterpret_cast<const BinaryLogArgument::Type *>(types) + typeCount);
+      continue;
+    }
+
+    auto it = d_sites.find(siteId);
+    if (it == d_sites.end()) {
+      continue;
+    }
+    const Site &site = it->second;
+
+    if (d_printTime) {
+      char buffer[32];
+      snprintf(buffer, sizeof(buffer), "%" PRId64 ".%09" PRId64 " ",
+               time / 1000000000, time % 1000000000);
+      stream << buffer;
+    }
+    stream << '[' << Level::toAscii(site.d_level) << "] " << site.d_category
+           << ": ";
+    BinaryLogArgument::formatMessage(stream, site.d_format.c_str(),
+                                     site.d_types.data(), site.d_types.size(),
+                                     payload, entryEnd);
+    stream << '\n';
+  }
+
+  return data - begin;
+}
+
+} // namespace mdlog
+} // namespace MvdS
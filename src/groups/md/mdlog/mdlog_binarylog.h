@@ -0,0 +1,385 @@
+// mdlog_binarylog.h                                                    -*-c++-*-
+#ifndef __INCLUDED_MDLOG_BINARYLOG
+#define __INCLUDED_MDLOG_BINARYLOG
+
+#include <mdlog_category.h>
+#include <mdlog_level.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace MvdS {
+namespace mdlog {
+
+// ========================
+// Struct BinaryLogArgument
+// ========================
+
+struct BinaryLogArgument
+{
+  // Provides the encoding of the arguments of binary log statements.
+  // Numbers are stored as 8 byte values in host byte order, strings as a 4
+  // byte length followed by the bytes.
+
+  // TYPES
+
+  enum Type : uint8_t
+  {
+    e_bool,     // 1 byte.
+    e_char,     // 1 byte.
+    e_signed,   // int64_t.
+    e_unsigned, // uint64_t.
+    e_double,   // double.
+    e_string,   // uint32_t length and bytes.
+    e_pointer   // uintptr_t, printed in hexadecimal.
+  };
+
+  // CLASS METHODS
+
+  static const char *format(std::ostream &stream,
+                            Type          type,
+                            const char *  data,
+                            const char *  end);
+  // Print the argument of the specified 'type' at the specified 'data' to
+  // the specified 'stream'. Return the end of the argument, or null if it
+  // does not fit before the specified 'end'.
+
+  static bool formatMessage(std::ostream &stream,
+                            const char *  format,
+                            const Type *  types,
+                            size_t        count,
+                            const char *  data,
+                            const char *  end);
+  // Print the specified 'format' to the specified 'stream', replacing each
+  // '{}' with the next of the specified 'count' arguments of the specified
+  // 'types' encoded at the specified 'data'. Arguments left over are
+  // appended, separated by spaces. Return false if the arguments do not fit
+  // before the specified 'end'.
+};
+
+// ======================
+// Struct BinaryLogTraits
+// ======================
+
+template <class TYPE, class = void>
+struct BinaryLogTraits;
+// Provides 'k_type', 'size' and 'encode' for the argument types supported
+// by binary log statements. Unsupported types do not compile.
+
+template <>
+struct BinaryLogTraits<bool>
+{
+  static const BinaryLogArgument::Type k_type = BinaryLogArgument::e_bool;
+
+  static size_t size(bool) { return 1; }
+
+  static char *encode(char *buffer, bool value)
+  {
+    *buffer = value ? 1 : 0;
+    return buffer + 1;
+  }
+};
+
+template <>
+struct BinaryLogTraits<char>
+{
+  static const BinaryLogArgument::Type k_type = BinaryLogArgument::e_char;
+
+  static size_t size(char) { return 1; }
+
+  static char *encode(char *buffer, char value)
+  {
+    *buffer = value;
+    return buffer + 1;
+  }
+};
+
+template <class TYPE>
+struct BinaryLogTraits<
+    TYPE,
+    typename std::enable_if<(std::is_integral<TYPE>::value &&
+                             std::is_signed<TYPE>::value) ||
+                            std::is_enum<TYPE>::value>::type>
+{
+  static const BinaryLogArgument::Type k_type = BinaryLogArgument::e_signed;
+
+  static size_t size(TYPE) { return sizeof(int64_t); }
+
+  static char *encode(char *buffer, TYPE value)
+  {
+    const int64_t v = static_cast<int64_t>(value);
+    memcpy(buffer, &v, sizeof(v));
+    return buffer + sizeof(v);
+  }
+};
+
+template <class TYPE>
+struct BinaryLogTraits<
+    TYPE,
+    typename std::enable_if<std::is_integral<TYPE>::value &&
+                            std::is_unsigned<TYPE>::value>::type>
+{
+  static const BinaryLogArgument::Type k_type = BinaryLogArgument::e_unsigned;
+
+  static size_t size(TYPE) { return sizeof(uint64_t); }
+
+  static char *encode(char *buffer, TYPE value)
+  {
+    const uint64_t v = static_cast<uint64_t>(value);
+    memcpy(buffer, &v, sizeof(v));
+    return buffer + sizeof(v);
+  }
+};
+
+template <class TYPE>
+struct BinaryLogTraits<
+    TYPE,
+    typename std::enable_if<std::is_floating_point<TYPE>::value>::type>
+{
+  static const BinaryLogArgument::Type k_type = BinaryLogArgument::e_double;
+
+  static size_t size(TYPE) { return sizeof(double); }
+
+  static char *encode(char *buffer, TYPE value)
+  {
+    const double v = static_cast<double>(value);
+    memcpy(buffer, &v, sizeof(v));
+    return buffer + sizeof(v);
+  }
+};
+
+template <>
+struct BinaryLogTraits<std::string_view>
+{
+  static const BinaryLogArgument::Type k_type = BinaryLogArgument::e_string;
+
+  static size_t size(std::string_view value)
+  {
+    return sizeof(uint32_t) + value.size();
+  }
+
+  static char *encode(char *buffer, std::string_view value)
+  {
+    const uint32_t length = static_cast<uint32_t>(value.size());
+    memcpy(buffer, &length, sizeof(length));
+    memcpy(buffer + sizeof(length), value.data(), length);
+    return buffer + sizeof(length) + length;
+  }
+};
+
+template <>
+struct BinaryLogTraits<std::string> : BinaryLogTraits<std::string_view>
+{
+};
+
+template <>
+struct BinaryLogTraits<const char *> : BinaryLogTraits<std::string_view>
+{
+  static size_t size(const char *value)
+  {
+    return sizeof(uint32_t) + (value ? strlen(value) : 0);
+  }
+
+  static char *encode(char *buffer, const char *value)
+  {
+    return BinaryLogTraits<std::string_view>::encode(
+        buffer, value ? std::string_view(value) : std::string_view());
+  }
+};
+
+template <>
+struct BinaryLogTraits<char *> : BinaryLogTraits<const char *>
+{
+};
+
+template <class TYPE>
+struct BinaryLogTraits<TYPE *>
+{
+  static const BinaryLogArgument::Type k_type = BinaryLogArgument::e_pointer;
+
+  static size_t size(const TYPE *) { return sizeof(uint64_t); }
+
+  static char *encode(char *buffer, const TYPE *value)
+  {
+    const uint64_t v = reinterpret_cast<uintptr_t>(value);
+    memcpy(buffer, &v, sizeof(v));
+    return buffer + sizeof(v);
+  }
+};
+
+// =====================
+// Struct BinaryLogTypes
+// =====================
+
+template <class... ARGS>
+struct BinaryLogTypes
+{
+  // Provides a list of argument types, see 'BinaryLogSite::typesOf'.
+};
+
+// ===================
+// Class BinaryLogSite
+// ===================
+
+class BinaryLogSite
+{
+  // Provides the static description of a binary log statement: its level,
+  // category, format and argument types. Sites are constant initialized
+  // static objects, see 'MDLOG_BINARY'; an id is assigned on first use.
+
+  // DATA
+
+  Level::Value                   d_level;
+  const Category *               d_category_p;
+  const char *                   d_format;
+  const char *                   d_file;
+  int                            d_line;
+  const BinaryLogArgument::Type *d_types;
+  size_t                         d_typeCount;
+  std::atomic<uint32_t>          d_id; // 0 until first used.
+
+  // PRIVATE MANIPULATORS
+
+  uint32_t assignId();
+  // Assign a process wide unique id to this site, unless another thread
+  // did already, and return it.
+
+public:
+  BinaryLogSite(const BinaryLogSite &) = delete;
+  BinaryLogSite &operator=(const BinaryLogSite &) = delete;
+
+  // CLASS METHODS
+
+  template <class... ARGS>
+  static BinaryLogTypes<typename std::decay<ARGS>::type...>
+  typesOf(const ARGS &...);
+  // Return the decayed types of the specified arguments. Not defined, for
+  // use in 'decltype' only, so the arguments are not evaluated.
+
+  // CREATORS
+
+  template <class... ARGS>
+  constexpr BinaryLogSite(Level::Value    level,
+                          const Category *category,
+                          const char *    format,
+                          const char *    file,
+                          int             line,
+                          BinaryLogTypes<ARGS...>)
+      // Create a site with the specified 'level', 'category', 'format',
+      // 'file' and 'line' for arguments of the specified 'ARGS' types.
+      : d_level(level)
+      , d_category_p(category)
+      , d_format(format)
+      , d_file(file)
+      , d_line(line)
+      , d_types(s_types<ARGS...>)
+      , d_typeCount(sizeof...(ARGS))
+      , d_id(0)
+  {}
+
+  // MANIPULATORS
+
+  uint32_t id()
+  // Return the id of this site.
+  {
+    const uint32_t id = d_id.load(std::memory_order_relaxed);
+    return id ? id : assignId();
+  }
+
+  // ACCESSORS
+
+  Level::Value level() const { return d_level; }
+
+  const Category &category() const { return *d_category_p; }
+
+  const char *format() const { return d_format; }
+
+  const char *file() const { return d_file; }
+
+  int line() const { return d_line; }
+
+  const BinaryLogArgument::Type *types() const { return d_types; }
+
+  size_t typeCount() const { return d_typeCount; }
+
+private:
+  // PRIVATE CLASS DATA
+
+  template <class... ARGS>
+  static constexpr BinaryLogArgument::Type s_types[sizeof...(ARGS) + 1] = {
+      BinaryLogTraits<ARGS>::k_type...,
+      BinaryLogArgument::e_bool};
+  // The argument types, with an unused element so it is never empty.
+};
+
+// ======================
+// Class BinaryLogDecoder
+// ======================
+
+class BinaryLogDecoder
+{
+  // Provides the conversion of the binary log format written by a
+  // 'BinaryLogger' in raw mode back to text lines.
+  //
+  // The stream consists of entries of a 4 byte size, including this header,
+  // a 4 byte site id, an 8 byte timestamp in nanoseconds since the epoch
+  // and the encoded arguments. Entries with site id 0 define a site: its
+  // id, level, argument types, category and format. A site is defined
+  // before its first entry.
+
+  struct Site
+  {
+    Level::Value                         d_level;
+    std::string                          d_category;
+    std::string                          d_format;
+    std::vector<BinaryLogArgument::Type> d_types;
+  };
+
+  // DATA
+
+  std::map<uint32_t, Site> d_sites;
+  bool                     d_printTime;
+
+public:
+  // PUBLIC CONSTANTS
+
+  enum
+  {
+    k_headerSize = 16 // Size, site id and timestamp.
+  };
+
+  // CREATORS
+
+  explicit BinaryLogDecoder(bool printTime = false);
+  // Create a decoder without sites. Optionally the specified 'printTime'
+  // prefixes every line with the timestamp in seconds since the epoch.
+
+  // MANIPULATORS
+
+  size_t decode(const char *data, size_t size, std::ostream &stream);
+  // Print a line for every complete entry of the specified 'size' bytes at
+  // the specified 'data' to the specified 'stream'. Return the number of
+  // bytes used; a partial entry at the end is left for the next call.
+  // Entries of unknown sites are skipped.
+
+  // ACCESSORS
+
+  size_t siteCount() const
+  // Return the number of sites defined.
+  {
+    return d_sites.size();
+  }
+};
+
+} // namespace mdlog
+} // namespace MvdS
+
+#endif // __INCLUDED_MDLOG_BINARYLOG
@@ -0,0 +1,169 @@
+// mdlog_binarylog.t.cpp                                                -*-c++-*-
+#include <mdlog_binarylog.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdlog;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+enum Color { e_red, e_green };
+
+__constinit Category g_category("test::binarylog");
+
+template <class TYPE>
+std::string encode(const TYPE& value)
+{
+  typedef BinaryLogTraits<typename std::decay<TYPE>::type> Traits;
+  std::string data(Traits::size(value), '\0');
+  char *end = Traits::encode(&data[0], value);
+  ASSERT(end == data.data() + data.size());
+  return data;
+}
+
+std::string format(BinaryLogArgument::Type type, const std::string& data)
+{
+  std::ostringstream stream;
+  const char *end = BinaryLogArgument::format(stream, type, data.data(),
+                                              data.data() + data.size());
+  ASSERT(end == data.data() + data.size());
+  return stream.str();
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 3:
+    {
+      // Sites are constant initialized and get unique ids on first use.
+      int         i = 1;
+      std::string s("text");
+      static __constinit BinaryLogSite site(
+	  Level::e_warning, &g_category, "{} {} {}", __FILE__, __LINE__,
+	  decltype(BinaryLogSite::typesOf(i, s, "literal"))());
+      static __constinit BinaryLogSite empty(
+	  Level::e_info, &g_category, "none", __FILE__, __LINE__,
+	  decltype(BinaryLogSite::typesOf())());
+
+      ASSERT(Level::e_warning == site.level());
+      ASSERT(&g_category == &site.category());
+      ASSERT(std::string("{} {} {}") == site.format());
+      ASSERT(3 == site.typeCount());
+      ASSERT(BinaryLogArgument::e_signed == site.types()[0]);
+      ASSERT(BinaryLogArgument::e_string == site.types()[1]);
+      ASSERT(BinaryLogArgument::e_string == site.types()[2]);
+      ASSERT(0 == empty.typeCount());
+
+      const uint32_t id = site.id();
+      ASSERT(0 != id);
+      ASSERT(id == site.id());
+      ASSERT(id != empty.id());
+    } break;
+
+  case 2:
+    {
+      // Messages replace placeholders in order and append extra arguments.
+      const BinaryLogArgument::Type types[] = {BinaryLogArgument::e_signed,
+					       BinaryLogArgument::e_string,
+					       BinaryLogArgument::e_double};
+      const std::string data = encode(-3) + encode("abc") + encode(0.5);
+      const char *begin = data.data();
+      const char *end   = begin + data.size();
+
+      {
+	std::ostringstream stream;
+	ASSERT(BinaryLogArgument::formatMessage(stream, "a {} b {} c {}.",
+						types, 3, begin, end));
+	ASSERT("a -3 b abc c 0.5." == stream.str());
+      }
+      {
+	std::ostringstream stream;
+	ASSERT(BinaryLogArgument::formatMessage(stream, "only {}", types, 3,
+						begin, end));
+	ASSERT("only -3 abc 0.5" == stream.str());
+      }
+      {
+	std::ostringstream stream;
+	ASSERT(BinaryLogArgument::formatMessage(stream, "{} {} {} {}", types,
+						2, begin, end));
+	ASSERT("-3 abc {} {}" == stream.str());
+      }
+      {
+	// Truncated arguments are detected.
+	std::ostringstream stream;
+	ASSERT(!BinaryLogArgument::formatMessage(stream, "{} {} {}", types, 3,
+						 begin, end - 1));
+      }
+    } break;
+
+  case 1:
+    {
+      // Breathing test: every supported type round trips.
+      ASSERT(BinaryLogArgument::e_bool == BinaryLogTraits<bool>::k_type);
+      ASSERT(BinaryLogArgument::e_char == BinaryLogTraits<char>::k_type);
+      ASSERT(BinaryLogArgument::e_signed == BinaryLogTraits<short>::k_type);
+      ASSERT(BinaryLogArgument::e_signed == BinaryLogTraits<Color>::k_type);
+      ASSERT(BinaryLogArgument::e_unsigned ==
+	     BinaryLogTraits<unsigned char>::k_type);
+      ASSERT(BinaryLogArgument::e_double == BinaryLogTraits<float>::k_type);
+      ASSERT(BinaryLogArgument::e_string ==
+	     BinaryLogTraits<std::string>::k_type);
+      ASSERT(BinaryLogArgument::e_string == BinaryLogTraits<char *>::k_type);
+      ASSERT(BinaryLogArgument::e_pointer == BinaryLogTraits<int *>::k_type);
+
+      ASSERT("true" == format(BinaryLogArgument::e_bool, encode(true)));
+      ASSERT("x" == format(BinaryLogArgument::e_char, encode('x')));
+      ASSERT("-42" == format(BinaryLogArgument::e_signed, encode(-42)));
+      ASSERT("1" == format(BinaryLogArgument::e_signed, encode(e_green)));
+      ASSERT("18446744073709551615" ==
+	     format(BinaryLogArgument::e_unsigned, encode(~uint64_t(0))));
+      ASSERT("2.5" == format(BinaryLogArgument::e_double, encode(2.5f)));
+      ASSERT("text" ==
+	     format(BinaryLogArgument::e_string, encode(std::string("text"))));
+      ASSERT("view" == format(BinaryLogArgument::e_string,
+			      encode(std::string_view("view"))));
+      ASSERT("" == format(BinaryLogArgument::e_string,
+			  encode(static_cast<const char *>(nullptr))));
+      ASSERT("0x1000" == format(BinaryLogArgument::e_pointer,
+				encode(reinterpret_cast<int *>(0x1000))));
+
+      // A truncated argument is detected.
+      const std::string  data = encode(std::string("text"));
+      std::ostringstream stream;
+      ASSERT(!BinaryLogArgument::format(stream, BinaryLogArgument::e_string,
+					data.data(),
+					data.data() + data.size() - 1));
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,361 @@
+// mdlog_binarylogger.cpp                                               -*-c++-*-
+#include <mdlog_binarylogger.h>
+
+#include <mdio_buffervectorutil.h>
+#include <mdlog_record.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace MvdS {
+namespace mdlog {
+
+namespace {
+
+std::atomic<uint64_t> s_nextLoggerId(1);
+
+struct ThreadBuffers
+{
+  // The buffers of a thread, by logger id. Closed when the thread exits.
+
+  std::vector<std::pair<uint64_t, std::shared_ptr<BinaryLogger_ThreadBuffer>>>
+      d_buffers;
+
+  ~ThreadBuffers();
+};
+
+thread_local bool          t_exited = false;
+thread_local ThreadBuffers t_buffers;
+
+ThreadBuffers::~ThreadBuffers()
+{
+  for (auto &entry : d_buffers) {
+    entry.second->d_closed.store(true, std::memory_order_release);
+  }
+  BinaryLogger_ThreadCache::s_loggerId = 0;
+  BinaryLogger_ThreadCache::s_buffer_p = nullptr;
+  t_exited                             = true;
+}
+
+void appendString(mdio::BufferVector *output, std::string_view value)
+{
+  const uint32_t length = static_cast<uint32_t>(value.size());
+  output->append(reinterpret_cast<const char *>(&length), sizeof(length));
+  output->append(value.data(), value.size());
+}
+
+} // namespace
+
+// ------------------
+// Class BinaryLogger
+// ------------------
+
+// PRIVATE MANIPULATORS
+
+void BinaryLogger::run()
+{
+  while (true) {
+    drain();
+
+    std::unique_lock<std::mutex> lk(d_mutex);
+    if (d_stop) {
+      return;
+    }
+    d_condition.wait_for(lk, d_config.d_pollInterval);
+  }
+}
+
+void BinaryLogger::drain()
+{
+  std::lock_guard<std::mutex> drainLock(d_drainMutex);
+
+  {
+    std::lock_guard<std::mutex> lk(d_buffersMutex);
+    d_draining.assign(d_buffers.begin(), d_buffers.end());
+  }
+
+  RecordStreamBuffer *streamBuffer = nullptr;
+  std::ostream        stream(streamBuffer);
+
+  bool closed = false;
+  for (const BufferPtr &buffer : d_draining) {
+    // Checked first, so a closed buffer is empty after draining.
+    const bool isClosed = buffer->d_closed.load(std::memory_order_acquire);
+    closed              = closed || isClosed;
+
+    mdio::ConstBuffer data  = buffer->d_buffer.readable();
+    const char *      entry = data.buffer();
+    const char *      end   = entry + data.size();
+    while (entry != end) {
+      uint32_t size = 0;
+      memcpy(&size, entry, sizeof(size));
+      deliver(entry, size, &stream);
+      entry += size;
+    }
+    buffer->d_buffer.consume(data.size());
+  }
+  d_draining.clear();
+
+  if (0 <= d_config.d_fd) {
+    writeOutput();
+  }
+
+  if (closed) {
+    std::lock_guard<std::mutex> lk(d_buffersMutex);
+    d_buffers.erase(std::remove_if(d_buffers.begin(), d_buffers.end(),
+                                   [](const BufferPtr &buffer) {
+                                     return buffer->d_closed.load(
+                                                std::memory_order_acquire) &&
+                                            buffer->d_buffer.empty();
+                                   }),
+                    d_buffers.end());
+  }
+}
+
+void BinaryLogger::deliver(const char *entry, size_t size, std::ostream *stream)
+{
+  BinaryLogSite *site = nullptr;
+  int64_t        time = 0;
+  memcpy(&site, entry + 8, sizeof(site));
+  memcpy(&time, entry + 16, sizeof(time));
+
+  const char *arguments = entry + k_entryHeaderSize;
+  const char *end       = entry + size;
+
+  if (0 <= d_config.d_fd) {
+    const uint32_t id = site->id();
+    if (d_defined.size() <= id) {
+      d_defined.resize(id + 1);
+    }
+    if (!d_defined[id]) {
+      d_defined[id] = true;
+
+      const std::string_view category(site->category().name());
+      const std::string_view format(site->format());
+      const uint8_t          level     = static_cast<uint8_t>(site->level());
+      const uint8_t          typeCount = static_cast<uint8_t>(site->typeCount());
+      const uint32_t         definitionSize =
+          BinaryLogDecoder::k_headerSize + 4 + 1 + 1 + typeCount + 4 +
+          category.size() + 4 + format.size();
+      const uint32_t zero     = 0;
+      const int64_t  zeroTime = 0;
+
+      d_output.append(reinterpret_cast<const char *>(&definitionSize), 4);
+      d_output.append(reinterpret_cast<const char *>(&zero), 4);
+      d_output.append(reinterpret_cast<const char *>(&zeroTime), 8);
+      d_output.append(reinterpret_cast<const char *>(&id), 4);
+      d_output.append(reinterpret_cast<const char *>(&level), 1);
+      d_output.append(reinterpret_cast<const char *>(&typeCount), 1);
+      d_output.append(reinterpret_cast<const char *>(site->types()), typeCount);
+      appendString(&d_output, category);
+      appendString(&d_output, format);
+    }
+
+    const uint32_t entrySize = static_cast<uint32_t>(
+        BinaryLogDecoder::k_headerSize + (end - arguments));
+    d_output.append(reinterpret_cast<const char *>(&entrySize), 4);
+    d_output.append(reinterpret_cast<const char *>(&id), 4);
+    d_output.append(reinterpret_cast<const char *>(&time), 8);
+    d_output.append(arguments, end - arguments);
+    return;
+  }
+
+  typedef Record::time_point::duration Duration;
+  Record *record = d_logger_p->createRecord(
+      site->level(),
+      Record::time_point(
+          std::chrono::duration_cast<Duration>(std::chrono::nanoseconds(time))));
+
+  RecordStreamBuffer streamBuffer(record);
+  stream->rdbuf(&streamBuffer);
+  *stream << '[' << Level::toAscii(site->level()) << "] "
+          << site->category().name() << ": ";
+  BinaryLogArgument::formatMessage(*stream, site->format(), site->types(),
+                                   site->typeCount(), arguments, end);
+  streamBuffer.pubsync();
+  stream->rdbuf(nullptr);
+
+  d_logger_p->log(record);
+}
+
+void BinaryLogger::writeOutput()
+{
+  while (!d_output.empty()) {
+    if (mdio::BufferVectorUtil::writev(d_config.d_fd, &d_output) < 0 &&
+        EINTR != errno) {
+      // Nothing else to do with it.
+      d_output.clear();
+    }
+  }
+}
+
+BinaryLogger_ThreadBuffer *BinaryLogger::lookupThreadBuffer()
+{
+  if (t_exited) {
+    return nullptr;
+  }
+
+  auto &buffers = t_buffers.d_buffers;
+
+  // Release the buffers of destroyed loggers.
+  buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                               [](const auto &entry) {
+                                 return entry.second->d_orphaned.load();
+                               }),
+                buffers.end());
+
+  BinaryLogger_ThreadBuffer *result = nullptr;
+  for (auto &entry : buffers) {
+    if (entry.first == d_id) {
+      result = entry.second.get();
+    }
+  }
+
+  if (!result) {
+    // Not from the allocator, the thread may release it after the logger is
+    // destroyed.
+    BufferPtr buffer = std::make_shared<BinaryLogger_ThreadBuffer>();
+    if (0 != buffer->d_buffer.open(d_config.d_bufferSize)) {
+      return nullptr;
+    }
+
+    {
+      std::lock_guard<std::mutex> lk(d_buffersMutex);
+      d_buffers.push_back(buffer);
+    }
+
+    result = buffer.get();
+    buffers.emplace_back(d_id, std::move(buffer));
+  }
+
+  BinaryLogger_ThreadCache::s_loggerId = d_id;
+  BinaryLogger_ThreadCache::s_buffer_p = result;
+  return result;
+}
+
+char *BinaryLogger::reserve(BinaryLogger_ThreadBuffer *buffer, size_t size)
+{
+  mdio::RingBuffer &ring = buffer->d_buffer;
+
+  if (size > ring.capacity()) {
+    ++d_dropped;
+    return nullptr;
+  }
+
+  if (d_config.d_dropWhenFull) {
+    // Wake up the background thread instead of waiting for it to poll, so
+    // a burst drops as little as possible.
+    ++d_dropped;
+    d_condition.notify_one();
+    return nullptr;
+  }
+
+  while (true) {
+    size_t available = 0;
+    char * entry     = ring.writableBuffer(&available);
+    if (size <= available) {
+      return entry;
+    }
+
+    if (d_stop.load()) {
+      drain();
+    }
+    else {
+      d_condition.notify_one();
+      std::this_thread::yield();
+    }
+  }
+}
+
+// CLASS METHODS
+
+BinaryLogger &BinaryLogger::singleton()
+{
+  // Never destroyed, like 'Logger::singleton()', which it delivers to and
+  // which is stopped after it, since it is created first.
+  static BinaryLogger *s_logger = []() {
+    BinaryLogger *logger = new BinaryLogger(&Logger::singleton());
+    logger->start();
+    std::atexit([]() { BinaryLogger::singleton().stop(); });
+    return logger;
+  }();
+
+  return *s_logger;
+}
+
+// CREATORS
+
+BinaryLogger::BinaryLogger(Logger *logger, mdmem::Allocator *allocator)
+    : BinaryLogger(logger, Configuration(), allocator)
+{}
+
+BinaryLogger::BinaryLogger(Logger *             logger,
+                           const Configuration &config,
+                           mdmem::Allocator *   allocator)
+    : d_id(s_nextLoggerId++)
+    , d_config(config)
+    , d_logger_p(logger)
+    , d_stop(true)
+    , d_dropped(0)
+    , d_buffers(mdmem::AllocatorUtil::defaultAllocator(allocator))
+    , d_draining(mdmem::AllocatorUtil::defaultAllocator(allocator))
+    , d_output(4096, allocator)
+    , d_defined(mdmem::AllocatorUtil::defaultAllocator(allocator))
+    , d_allocator_p(mdmem::AllocatorUtil::defaultAllocator(allocator))
+{}
+
+BinaryLogger::~BinaryLogger()
+{
+  stop();
+  flush();
+
+  for (const BufferPtr &buffer : d_buffers) {
+    buffer->d_orphaned.store(true);
+  }
+}
+
+// MANIPULATORS
+
+void BinaryLogger::start()
+{
+  std::lock_guard<std::mutex> lk(d_mutex);
+  if (!d_stop) {
+    return;
+  }
+
+  d_stop.store(false);
+  d_thread = std::thread(&BinaryLogger::run, this);
+}
+
+void BinaryLogger::stop()
+{
+  {
+    std::lock_guard<std::mutex> lk(d_mutex);
+    if (d_stop) {
+      return;
+    }
+    d_stop.store(true);
+    d_condition.notify_all();
+  }
+
+  d_thread.join();
+
+  // Entries logged while the thread was exiting.
+  flush();
+}
+
+void BinaryLogger::flush()
+{
+  drain();
+
+  if (d_config.d_fd < 0) {
+    d_logger_p->flush();
+  }
+}
+
+} // namespace mdlog
+} // namespace MvdS
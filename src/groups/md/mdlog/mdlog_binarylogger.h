@@ -0,0 +1,286 @@
+// mdlog_binarylogger.h                                                 -*-c++-*-
+#ifndef __INCLUDED_MDLOG_BINARYLOGGER
+#define __INCLUDED_MDLOG_BINARYLOGGER
+
+#include <mdio_buffervector.h>
+#include <mdio_ringbuffer.h>
+#include <mdlog_binarylog.h>
+#include <mdlog_logger.h>
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <experimental/vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Binary log statements take a format with '{}' placeholders and the
+// arguments, for example:
+//
+//  MDLOG_BINARY_INFO("read {} bytes from {}", size, path);
+//
+// Only the arguments are copied on the calling thread, the text is formatted
+// by the background thread of 'BinaryLogger::singleton()'. Like the stream
+// statements they use the category set by 'MDLOG_SET_CATEGORY'.
+
+#define MDLOG_BINARY(level, format, ...)                                       \
+  do {                                                                         \
+    if (MDLOG_IS_ENABLED(level)) {                                             \
+      static MvdS::mdlog::BinaryLogSite __mdlog_binary_site(                   \
+          level, &__mdlog_logger_category, format, __FILE__, __LINE__,         \
+          decltype(MvdS::mdlog::BinaryLogSite::typesOf(__VA_ARGS__))());      \
+      MvdS::mdlog::BinaryLogger::singleton().log(&__mdlog_binary_site,         \
+                                                 ##__VA_ARGS__);               \
+    }                                                                          \
+  } while (false)
+
+#define MDLOG_BINARY_INFO(...)                                                 \
+  MDLOG_BINARY(MvdS::mdlog::Level::e_info, __VA_ARGS__)
+#define MDLOG_BINARY_DEBUG(...)                                                \
+  MDLOG_BINARY(MvdS::mdlog::Level::e_debug, __VA_ARGS__)
+#define MDLOG_BINARY_TRACE(...)                                                \
+  MDLOG_BINARY(MvdS::mdlog::Level::e_trace, __VA_ARGS__)
+#define MDLOG_BINARY_WARNING(...)                                              \
+  MDLOG_BINARY(MvdS::mdlog::Level::e_warning, __VA_ARGS__)
+#define MDLOG_BINARY_ERROR(...)                                                \
+  MDLOG_BINARY(MvdS::mdlog::Level::e_error, __VA_ARGS__)
+
+namespace MvdS {
+namespace mdlog {
+
+// ================================
+// Struct BinaryLogger_ThreadBuffer
+// ================================
+
+struct BinaryLogger_ThreadBuffer
+{
+  // The entries of one thread for one logger. Private to 'BinaryLogger'.
+
+  mdio::RingBuffer  d_buffer;
+  std::atomic<bool> d_closed;   // The thread exited.
+  std::atomic<bool> d_orphaned; // The logger was destroyed.
+
+  BinaryLogger_ThreadBuffer()
+      : d_closed(false)
+      , d_orphaned(false)
+  {}
+};
+
+// ===============================
+// Struct BinaryLogger_ThreadCache
+// ===============================
+
+struct BinaryLogger_ThreadCache
+{
+  // The buffer of the logger last used by the calling thread. Private to
+  // 'BinaryLogger'.
+
+  static inline thread_local uint64_t                   s_loggerId = 0;
+  static inline thread_local BinaryLogger_ThreadBuffer *s_buffer_p = nullptr;
+};
+
+// ==================
+// Class BinaryLogger
+// ==================
+
+class BinaryLogger
+{
+  // Provides binary log statements that are formatted in the background.
+  //
+  // A statement is described once by a static 'BinaryLogSite'. 'log' copies
+  // a pointer to the site, a timestamp and the raw arguments into a ring
+  // buffer owned by the calling thread, without locking or allocating. A
+  // background thread started by 'start' polls the buffers, and formats
+  // every entry into a record of the 'Logger', or, if a file descriptor is
+  // configured, writes the entries in the binary format of
+  // 'BinaryLogDecoder' to it, to be formatted offline. Entries of one thread
+  // are delivered in order. If the buffer of a thread is full, 'log' waits
+  // for the background thread, or drops the entry if 'd_dropWhenFull' is
+  // set. Without a running background thread, entries are delivered on the
+  // calling thread. This class is thread-safe.
+
+public:
+  // PUBLIC TYPES
+
+  struct Configuration
+  {
+    size_t d_bufferSize   = 64 << 10; // Per thread, rounded up.
+    bool   d_dropWhenFull = false;    // Else wait for the background thread.
+    std::chrono::microseconds d_pollInterval =
+        std::chrono::milliseconds(1);
+    int d_fd = -1; // If set, write binary entries to it instead.
+  };
+
+  // PUBLIC CONSTANTS
+
+  enum
+  {
+    k_entryHeaderSize = 24 // Size, unused, site and timestamp.
+  };
+
+private:
+  typedef std::shared_ptr<BinaryLogger_ThreadBuffer> BufferPtr;
+
+  // DATA
+
+  const uint64_t                            d_id;
+  Configuration                             d_config;
+  Logger *                                  d_logger_p;
+  std::atomic<bool>                         d_stop;
+  std::atomic<uint64_t>                     d_dropped;
+  std::thread                               d_thread;
+  std::mutex                                d_mutex;
+  std::condition_variable                   d_condition;
+  std::mutex                                d_drainMutex;
+  std::mutex                                d_buffersMutex;
+  std::experimental::pmr::vector<BufferPtr> d_buffers;
+  std::experimental::pmr::vector<BufferPtr> d_draining; // Copy of buffers.
+  mdio::BufferVector                        d_output;  // Binary mode.
+  std::experimental::pmr::vector<bool>      d_defined; // By site id.
+  mdmem::Allocator *                        d_allocator_p;
+
+  // PRIVATE MANIPULATORS
+
+  void run();
+  // Drain the buffers until stopped.
+
+  void drain();
+  // Deliver all entries in the buffers and release the buffers of exited
+  // threads.
+
+  void deliver(const char *entry, size_t size, std::ostream *stream);
+  // Deliver the specified 'entry' of the specified 'size', using the
+  // specified 'stream' to format.
+
+  void writeOutput();
+  // Write the binary output to the file descriptor.
+
+  BinaryLogger_ThreadBuffer *threadBuffer()
+  // Return the buffer of the calling thread, or null if none is available.
+  {
+    if (BinaryLogger_ThreadCache::s_loggerId == d_id) {
+      return BinaryLogger_ThreadCache::s_buffer_p;
+    }
+    return lookupThreadBuffer();
+  }
+
+  BinaryLogger_ThreadBuffer *lookupThreadBuffer();
+  // Return the buffer of the calling thread, creating it on first use, or
+  // null if none is available, and cache it.
+
+  char *reserve(BinaryLogger_ThreadBuffer *buffer, size_t size);
+  // Return space for an entry of the specified 'size' in the specified
+  // 'buffer', or null if the entry is dropped.
+
+public:
+  BinaryLogger(const BinaryLogger &) = delete;
+  BinaryLogger &operator=(const BinaryLogger &) = delete;
+
+  // CLASS METHODS
+
+  static BinaryLogger &singleton();
+  // Return the process wide binary logger used by the 'MDLOG_BINARY' macros.
+  // It is created on first use, started, and delivers to
+  // 'Logger::singleton()'. It is stopped, delivering all entries, when the
+  // process exits.
+
+  // CREATORS
+
+  explicit BinaryLogger(Logger *logger, mdmem::Allocator *allocator = 0);
+  // Create a logger with the default configuration that delivers to the
+  // specified 'logger' and is not started. Optionally the specified
+  // 'allocator' is used for memory allocation.
+
+  BinaryLogger(Logger *             logger,
+               const Configuration &config,
+               mdmem::Allocator *   allocator = 0);
+  // Create a logger with the specified 'config' that delivers to the
+  // specified 'logger', which is not used in binary mode, and is not
+  // started. Optionally the specified 'allocator' is used for memory
+  // allocation.
+
+  ~BinaryLogger();
+  // Stop the logger, delivering all entries.
+
+  // MANIPULATORS
+
+  void start();
+  // Start the background thread. Does nothing if already started.
+
+  void stop();
+  // Deliver all entries and stop the background thread. Entries logged
+  // afterwards are delivered on the calling thread.
+
+  template <class... ARGS>
+  void log(BinaryLogSite *site, const ARGS &... arguments)
+  // Log an entry of the specified 'site' with the specified 'arguments',
+  // which must match the argument types of the site.
+  {
+    const size_t size =
+        k_entryHeaderSize +
+        (size_t(0) + ... +
+         BinaryLogTraits<typename std::decay<ARGS>::type>::size(arguments));
+
+    BinaryLogger_ThreadBuffer *buffer = threadBuffer();
+    if (!buffer) {
+      ++d_dropped;
+      return;
+    }
+
+    size_t available = 0;
+    char * entry     = buffer->d_buffer.writableBuffer(&available);
+    if (available < size && !(entry = reserve(buffer, size))) {
+      return;
+    }
+
+    const uint32_t entrySize = static_cast<uint32_t>(size);
+    const int64_t  time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    memcpy(entry, &entrySize, sizeof(entrySize));
+    memcpy(entry + 8, &site, sizeof(site));
+    memcpy(entry + 16, &time, sizeof(time));
+
+    char *data = entry + k_entryHeaderSize;
+    ((data = BinaryLogTraits<typename std::decay<ARGS>::type>::encode(
+          data, arguments)),
+     ...);
+    (void)data;
+
+    buffer->d_buffer.commit(size);
+
+    if (d_stop.load(std::memory_order_relaxed)) {
+      flush();
+    }
+  }
+
+  void flush();
+  // Block until all entries logged before the call have been delivered, and
+  // the records have been published by the 'Logger'. Behavior is undefined
+  // if called from an observer.
+
+  // ACCESSORS
+
+  uint64_t droppedCount() const
+  // Return the number of entries dropped so far.
+  {
+    return d_dropped.load(std::memory_order_relaxed);
+  }
+
+  const Configuration &configuration() const
+  // Return the configuration.
+  {
+    return d_config;
+  }
+};
+
+} // namespace mdlog
+} // namespace MvdS
+
+#endif // __INCLUDED_MDLOG_BINARYLOGGER
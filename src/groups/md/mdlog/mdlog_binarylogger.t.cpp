@@ -0,0 +1,348 @@
+// mdlog_binarylogger.t.cpp                                             -*-c++-*-
+#include <mdlog_binarylogger.h>
+
+#include <mdmem_testallocator.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdlog;
+
+typedef BinaryLogger Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+__constinit Category g_category("test::binarylogger");
+
+class TestObserver : public Observer {
+  // Observer keeping the text of the records.
+
+public:
+  std::mutex               d_mutex;
+  std::vector<std::string> d_lines;
+  std::thread::id          d_thread;
+
+  virtual void publish(const Record& record)
+  {
+    std::string text(record.buffers().size(), '\0');
+    record.buffers().copyOut(&text[0], text.size());
+
+    std::lock_guard<std::mutex> lk(d_mutex);
+    d_lines.push_back(text);
+    d_thread = std::this_thread::get_id();
+  }
+};
+
+struct TemporaryFile {
+  std::string d_path;
+  int         d_fd;
+
+  TemporaryFile()
+    : d_path("/tmp/mdlog_binarylogger.XXXXXX")
+  {
+    d_fd = mkstemp(&d_path[0]);
+  }
+
+  ~TemporaryFile()
+  {
+    close(d_fd);
+    unlink(d_path.c_str());
+  }
+
+  std::string contents() const
+  {
+    std::string result;
+    char        buffer[4096];
+    ssize_t     rc;
+    off_t       offset = 0;
+    while (0 < (rc = pread(d_fd, buffer, sizeof(buffer), offset))) {
+      result.append(buffer, rc);
+      offset += rc;
+    }
+    return result;
+  }
+};
+
+BinaryLogSite g_valueSite(Level::e_info, &g_category, "value {} of {}",
+			  __FILE__, __LINE__,
+			  BinaryLogTypes<int, std::string>());
+BinaryLogSite g_threadSite(Level::e_debug, &g_category, "{} {}", __FILE__,
+			   __LINE__, BinaryLogTypes<int, int>());
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 5:
+    {
+      // The macros log to the singleton, if enabled for the category.
+      TestObserver observer;
+      Logger::singleton().addObserver(&observer);
+      Category::setThreshold("mdlog::BinaryLogger::test", Level::e_debug);
+
+      for (int i = 0; i < 2; ++i) {
+	MDLOG_SET_CATEGORY("mdlog::BinaryLogger::test");
+	MDLOG_BINARY_INFO("value {} of {}", i, "two");
+	MDLOG_BINARY_ERROR("no arguments");
+	MDLOG_BINARY_DEBUG("{}", 2.5, 'c', true);
+	MDLOG_BINARY_TRACE("{}", i);
+
+	Category::setThreshold("mdlog::BinaryLogger::test", Level::e_error);
+      }
+
+      Obj::singleton().flush();
+      Logger::singleton().removeObserver(&observer);
+
+      ASSERT(4 == observer.d_lines.size());
+      if (4 == observer.d_lines.size()) {
+	ASSERT("[INFO] mdlog::BinaryLogger::test: value 0 of two" ==
+	       observer.d_lines[0]);
+	ASSERT("[ERROR] mdlog::BinaryLogger::test: no arguments" ==
+	       observer.d_lines[1]);
+	ASSERT("[DEBUG] mdlog::BinaryLogger::test: 2.5 c true" ==
+	       observer.d_lines[2]);
+	ASSERT("[ERROR] mdlog::BinaryLogger::test: no arguments" ==
+	       observer.d_lines[3]);
+      }
+    } break;
+
+  case 4:
+    {
+      // In binary mode entries are written to the file descriptor, with a
+      // definition of every site before its first entry, for the decoder.
+      TemporaryFile        file;
+      mdmem::TestAllocator ta;
+      {
+	Obj::Configuration config;
+	config.d_fd = file.d_fd;
+
+	Obj o(nullptr, config, &ta);
+	o.start();
+	for (int i = 0; i < 3; ++i) {
+	  o.log(&g_valueSite, i, std::string("three"));
+	}
+	o.log(&g_threadSite, 7, 8);
+	o.flush();
+      }
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+
+      const std::string expected =
+	  "[INFO] test::binarylogger: value 0 of three\n"
+	  "[INFO] test::binarylogger: value 1 of three\n"
+	  "[INFO] test::binarylogger: value 2 of three\n"
+	  "[DEBUG] test::binarylogger: 7 8\n";
+      const std::string data = file.contents();
+
+      {
+	BinaryLogDecoder   decoder;
+	std::ostringstream stream;
+	ASSERT(data.size() == decoder.decode(data.data(), data.size(), stream));
+	ASSERT(expected == stream.str());
+	ASSERT(2 == decoder.siteCount());
+      }
+      {
+	// Fed in pieces, partial entries are left for the next call.
+	BinaryLogDecoder   decoder;
+	std::ostringstream stream;
+	std::string        pending;
+	for (char c : data) {
+	  pending += c;
+	  pending.erase(0, decoder.decode(pending.data(), pending.size(), stream));
+	}
+	ASSERT(pending.empty());
+	ASSERT(expected == stream.str());
+      }
+      {
+	// Entries of unknown sites are skipped.
+	BinaryLogDecoder   decoder(true);
+	std::ostringstream stream;
+	uint32_t           definitionSize = 0;
+	memcpy(&definitionSize, data.data(), sizeof(definitionSize));
+	decoder.decode(data.data() + definitionSize, data.size() - definitionSize,
+		       stream);
+	ASSERT(1 == decoder.siteCount());
+	const std::string text = stream.str();
+	ASSERT(std::string::npos == text.find("[INFO]"));
+	const std::string line(" [DEBUG] test::binarylogger: 7 8\n");
+	ASSERT(line.size() + 20 == text.size());
+	ASSERT('.' == text[10]);
+	ASSERT(line == text.substr(20));
+      }
+    } break;
+
+  case 3:
+    {
+      // If the buffer of a thread is full, entries are dropped if
+      // configured. Here the background thread blocks on a full pipe.
+      int fds[2];
+      ASSERT(0 == pipe(fds));
+
+      std::string data;
+      std::thread reader;
+
+      Obj::Configuration config;
+      config.d_bufferSize   = 4096;
+      config.d_dropWhenFull = true;
+      config.d_fd           = fds[1];
+
+      const int         k_entries = 10000;
+      const std::string text(1000, 'x');
+      {
+	Obj o(nullptr, config);
+	o.start();
+	for (int i = 0; i < k_entries; ++i) {
+	  o.log(&g_valueSite, i, text);
+	}
+	ASSERT(0 < o.droppedCount());
+
+	// Entries larger than the buffer are always dropped.
+	const uint64_t dropped = o.droppedCount();
+	o.log(&g_valueSite, 0, std::string(1 << 20, 'x'));
+	ASSERT(dropped + 1 == o.droppedCount());
+
+	reader = std::thread([&]() {
+	    char    buffer[65536];
+	    ssize_t rc;
+	    while (0 < (rc = read(fds[0], buffer, sizeof(buffer)))) {
+	      data.append(buffer, rc);
+	    }
+	  });
+
+	o.flush();
+	o.stop();
+	close(fds[1]);
+	reader.join();
+
+	BinaryLogDecoder   decoder;
+	std::ostringstream stream;
+	ASSERT(data.size() == decoder.decode(data.data(), data.size(), stream));
+	const std::string lines = stream.str();
+	ASSERT(uint64_t(k_entries + 1) ==
+	       std::count(lines.begin(), lines.end(), '\n') + o.droppedCount());
+      }
+      close(fds[0]);
+    } break;
+
+  case 2:
+    {
+      // Entries from several threads are delivered in order per thread,
+      // also when the buffers fill up.
+      TestObserver observer;
+      Logger       logger;
+      logger.addObserver(&observer);
+      logger.start();
+
+      Obj::Configuration config;
+      config.d_bufferSize = 4096;
+
+      Obj o(&logger, config);
+      o.start();
+      o.start();
+
+      const int                k_threads = 4;
+      const int                k_entries = 5000;
+      std::vector<std::thread> threads;
+      for (int t = 0; t < k_threads; ++t) {
+	threads.emplace_back([&o, t]() {
+	    for (int i = 0; i < k_entries; ++i) {
+	      o.log(&g_threadSite, t, i);
+	    }
+	  });
+      }
+      for (auto& thread : threads) {
+	thread.join();
+      }
+
+      o.flush();
+      ASSERT(0 == o.droppedCount());
+      ASSERT(size_t(k_threads * k_entries) == observer.d_lines.size());
+
+      const std::string  prefix("[DEBUG] test::binarylogger: ");
+      std::map<int, int> next;
+      bool               ordered = true;
+      for (const std::string& line : observer.d_lines) {
+	const char *text = line.c_str() + prefix.size();
+	const int   t    = std::atoi(text);
+	const int   i    = std::atoi(strchr(text, ' '));
+	ordered          = ordered && next[t] == i;
+	next[t]          = i + 1;
+      }
+      ASSERT(ordered);
+
+      // Entries logged before 'stop' are delivered by it, and afterwards on
+      // the calling thread.
+      o.log(&g_valueSite, 1, std::string("before"));
+      o.stop();
+      ASSERT("[INFO] test::binarylogger: value 1 of before" ==
+	     observer.d_lines.back());
+      o.log(&g_valueSite, 2, std::string("after"));
+      ASSERT("[INFO] test::binarylogger: value 2 of after" ==
+	     observer.d_lines.back());
+    } break;
+
+  case 1:
+    {
+      // Breathing test: without a background thread entries are formatted
+      // into records of the logger on the calling thread.
+      mdmem::TestAllocator ta;
+      TestObserver         observer;
+      {
+	Logger logger(&ta);
+	logger.addObserver(&observer);
+
+	Obj o(&logger, &ta);
+	o.log(&g_valueSite, 1, std::string("one"));
+	ASSERT(1 == observer.d_lines.size());
+	ASSERT(std::this_thread::get_id() == observer.d_thread);
+	o.log(&g_valueSite, 2, std::string("two"));
+
+	o.flush();
+	ASSERT(2 == observer.d_lines.size());
+	if (2 == observer.d_lines.size()) {
+	  ASSERT("[INFO] test::binarylogger: value 1 of one" ==
+		 observer.d_lines[0]);
+	  ASSERT("[INFO] test::binarylogger: value 2 of two" ==
+		 observer.d_lines[1]);
+	}
+	ASSERT(0 == o.droppedCount());
+      }
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
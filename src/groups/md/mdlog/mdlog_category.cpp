@@ -0,0 +1,93 @@
+// mdlog_category.cpp                                                   -*-c++-*-
+#include <mdlog_category.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace MvdS {
+namespace mdlog {
+
+namespace {
+
+struct Registry
+{
+  // Registered categories and the thresholds set by prefix.
+
+  std::mutex                          d_mutex;
+  std::map<std::string, Level::Value> d_thresholds; // By prefix.
+  Category *                          d_categories = nullptr;
+
+  Registry() { d_thresholds[std::string()] = Level::e_info; }
+
+  Level::Value lookup(std::string_view name) const
+  // Return the threshold of the longest prefix of the specified 'name'.
+  // The caller holds the mutex.
+  {
+    size_t       length = 0;
+    Level::Value result = Level::e_info;
+    for (const auto &entry : d_thresholds) {
+      if (length <= entry.first.size() &&
+          name.substr(0, entry.first.size()) == entry.first) {
+        length = entry.first.size();
+        result = entry.second;
+      }
+    }
+    return result;
+  }
+};
+
+Registry &registry()
+{
+  // Never destroyed, categories may be used by static destructors.
+  static Registry *s_registry = new Registry();
+  return *s_registry;
+}
+
+} // namespace
+
+// --------------
+// Class Category
+// --------------
+
+// PRIVATE MANIPULATORS
+
+bool Category::registerAndCheck(Level::Value level)
+{
+  Registry &                  r = registry();
+  std::lock_guard<std::mutex> lk(r.d_mutex);
+
+  if (k_unregistered == d_threshold.load(std::memory_order_relaxed)) {
+    d_next_p       = r.d_categories;
+    r.d_categories = this;
+    d_threshold.store(r.lookup(d_name), std::memory_order_relaxed);
+  }
+
+  return level <= d_threshold.load(std::memory_order_relaxed);
+}
+
+// CLASS METHODS
+
+void Category::setThreshold(std::string_view prefix, Level::Value threshold)
+{
+  Registry &                  r = registry();
+  std::lock_guard<std::mutex> lk(r.d_mutex);
+
+  r.d_thresholds[std::string(prefix)] = threshold;
+
+  for (Category *category = r.d_categories; category;
+       category           = category->d_next_p) {
+    category->d_threshold.store(r.lookup(category->d_name),
+                                std::memory_order_relaxed);
+  }
+}
+
+Level::Value Category::threshold(std::string_view name)
+{
+  Registry &                  r = registry();
+  std::lock_guard<std::mutex> lk(r.d_mutex);
+  return r.lookup(name);
+}
+
+} // namespace mdlog
+} // namespace MvdS
@@ -0,0 +1,98 @@
+// mdlog_category.h                                                     -*-c++-*-
+#ifndef __INCLUDED_MDLOG_CATEGORY
+#define __INCLUDED_MDLOG_CATEGORY
+
+#include <mdlog_level.h>
+
+#include <atomic>
+#include <string_view>
+
+namespace MvdS {
+namespace mdlog {
+
+// ==============
+// Class Category
+// ==============
+
+class Category
+{
+  // Provides a named log category with a runtime level threshold.
+  //
+  // Categories are meant to be static objects, see 'MDLOG_SET_CATEGORY'.
+  // The constructor is 'constexpr', so they are initialized at compile time
+  // without a guard or a string copy. A category registers itself on its
+  // first 'isEnabled' call and takes its threshold from the longest
+  // matching name prefix given to 'setThreshold', or from the default
+  // threshold. After that 'isEnabled' is a single relaxed load and compare.
+
+  // PRIVATE CONSTANTS
+
+  enum
+  {
+    k_unregistered = -1
+  };
+
+  // DATA
+
+  const char *     d_name;
+  std::atomic<int> d_threshold; // 'k_unregistered' until first used.
+  Category *       d_next_p;    // Next registered category.
+
+  // PRIVATE MANIPULATORS
+
+  bool registerAndCheck(Level::Value level);
+  // Register this category, if not done yet, and return true if the
+  // specified 'level' is enabled.
+
+public:
+  Category(const Category &) = delete;
+  Category &operator=(const Category &) = delete;
+
+  // CLASS METHODS
+
+  static void setThreshold(std::string_view prefix, Level::Value threshold);
+  // Enable the levels up to the specified 'threshold' for all categories
+  // whose name starts with the specified 'prefix', unless a longer prefix
+  // is set for them. An empty 'prefix' sets the default threshold, which is
+  // initially 'Level::e_info'.
+
+  static Level::Value threshold(std::string_view name);
+  // Return the threshold that applies to a category with the specified
+  // 'name'.
+
+  // CREATORS
+
+  constexpr explicit Category(const char *name)
+      // Create a category with the specified 'name', which must stay valid
+      // for the lifetime of the category, for example a string literal.
+      : d_name(name)
+      , d_threshold(k_unregistered)
+      , d_next_p(nullptr)
+  {}
+
+  // MANIPULATORS
+
+  bool isEnabled(Level::Value level)
+  // Return true if records of the specified 'level' are enabled for this
+  // category.
+  {
+    const int threshold = d_threshold.load(std::memory_order_relaxed);
+    if (k_unregistered != threshold) {
+      return level <= threshold;
+    }
+    return registerAndCheck(level);
+  }
+
+  // ACCESSORS
+
+  const char *name() const
+  // Return the name of the category.
+  {
+    return d_name;
+  }
+};
+
+} // namespace mdlog
+} // namespace MvdS
+
+#endif // __INCLUDED_MDLOG_CATEGORY
@@ -0,0 +1,102 @@
+// mdlog_category.t.cpp                                                 -*-c++-*-
+#include <mdlog_category.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdlog;
+
+typedef Category Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+// Constant initialized, no guard or constructor call at runtime.
+static_assert(std::is_trivially_destructible<Obj>::value, "");
+__constinit Obj g_category("test::global");
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 2:
+    {
+      // Concurrent first use.
+      static Obj               category("test::concurrent");
+      std::vector<std::thread> threads;
+      std::atomic<int>         enabled(0);
+      for (int i = 0; i < 4; ++i) {
+	threads.emplace_back([&]() {
+	    for (int j = 0; j < 1000; ++j) {
+	      enabled += category.isEnabled(Level::e_warning);
+	    }
+	  });
+      }
+      for (auto& thread : threads) {
+	thread.join();
+      }
+      ASSERT(4000 == enabled);
+    } break;
+
+  case 1:
+    {
+      // Breathing test.
+      ASSERT(std::string("test::global") == g_category.name());
+      ASSERT(Level::e_info == Obj::threshold("test::global"));
+
+      ASSERT(g_category.isEnabled(Level::e_error));
+      ASSERT(g_category.isEnabled(Level::e_info));
+      ASSERT(!g_category.isEnabled(Level::e_debug));
+
+      // Thresholds apply by the longest prefix, to registered categories
+      // and to categories registered later.
+      Obj::setThreshold("test::", Level::e_trace);
+      ASSERT(g_category.isEnabled(Level::e_trace));
+
+      Obj::setThreshold("test::glob", Level::e_error);
+      ASSERT(!g_category.isEnabled(Level::e_warning));
+      ASSERT(g_category.isEnabled(Level::e_error));
+
+      static Obj other("test::other");
+      ASSERT(other.isEnabled(Level::e_trace));
+      ASSERT(Level::e_trace == Obj::threshold("test::other"));
+
+      Obj::setThreshold("", Level::e_off);
+      ASSERT(Level::e_off == Obj::threshold("unrelated"));
+      ASSERT(other.isEnabled(Level::e_trace));
+
+      Obj::setThreshold("test::", Level::e_off);
+      ASSERT(!other.isEnabled(Level::e_error));
+      Obj::setThreshold("", Level::e_info);
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,75 @@
+// mdlog_fileobserver.cpp                                               -*-c++-*-
+#include <mdlog_fileobserver.h>
+
+#include <mdlog_record.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#include <limits.h>
+#include <unistd.h>
+
+namespace MvdS {
+namespace mdlog {
+
+namespace {
+
+char s_newline[] = "\n";
+
+} // namespace
+
+// ------------------
+// Class FileObserver
+// ------------------
+
+// CREATORS
+
+FileObserver::FileObserver(int fd, mdmem::Allocator *allocator)
+    : d_fd(fd)
+    , d_iovecs(mdmem::AllocatorUtil::defaultAllocator(allocator))
+{}
+
+FileObserver::~FileObserver() {}
+
+// MANIPULATORS
+
+void FileObserver::publish(const Record &record)
+{
+  record.buffers().forEachSegment([this](const char *data, size_t size) {
+    d_iovecs.push_back(iovec{const_cast<char *>(data), size});
+  });
+  d_iovecs.push_back(iovec{s_newline, 1});
+}
+
+void FileObserver::flush()
+{
+  iovec *      iovecs = d_iovecs.data();
+  const iovec *end    = iovecs + d_iovecs.size();
+
+  while (iovecs != end) {
+    const int count = static_cast<int>(std::min<size_t>(end - iovecs, IOV_MAX));
+
+    ssize_t rc = ::writev(d_fd, iovecs, count);
+    if (rc < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      break;
+    }
+
+    // Skip what has been written, the last iovec may be partially written.
+    while (iovecs != end && static_cast<size_t>(rc) >= iovecs->iov_len) {
+      rc -= iovecs->iov_len;
+      ++iovecs;
+    }
+    if (iovecs != end) {
+      iovecs->iov_base = static_cast<char *>(iovecs->iov_base) + rc;
+      iovecs->iov_len -= rc;
+    }
+  }
+
+  d_iovecs.clear();
+}
+
+} // namespace mdlog
+} // namespace MvdS
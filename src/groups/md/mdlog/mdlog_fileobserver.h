@@ -0,0 +1,75 @@
+// mdlog_fileobserver.h                                                 -*-c++-*-
+#ifndef __INCLUDED_MDLOG_FILEOBSERVER
+#define __INCLUDED_MDLOG_FILEOBSERVER
+
+#include <mdlog_observer.h>
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <experimental/vector>
+
+#include <sys/uio.h>
+
+namespace MvdS {
+namespace mdlog {
+
+// ==================
+// Class FileObserver
+// ==================
+
+class FileObserver : public Observer
+{
+  // Provides an observer that writes the text of every record as a line to
+  // a file descriptor, for example 'STDERR_FILENO'.
+  //
+  // 'publish' only collects the buffers of the record; 'flush' writes the
+  // lines of the whole batch with as few 'writev' calls as possible,
+  // without copying the text.
+
+  // DATA
+
+  int                                   d_fd;
+  std::experimental::pmr::vector<iovec> d_iovecs; // Pending output.
+
+protected:
+  // PROTECTED MANIPULATORS
+
+  void setFd(int fd)
+  // Write to the specified 'fd' from now on. Behavior is undefined if there
+  // is pending output.
+  {
+    d_fd = fd;
+  }
+
+public:
+  // CREATORS
+
+  explicit FileObserver(int fd, mdmem::Allocator *allocator = 0);
+  // Create an observer writing to the specified 'fd', which is not closed
+  // by the observer. Optionally the specified 'allocator' is used for
+  // memory allocation.
+
+  virtual ~FileObserver();
+
+  // MANIPULATORS
+
+  virtual void publish(const Record &record);
+  // Add the text of the specified 'record' and a newline to the pending
+  // output.
+
+  virtual void flush();
+  // Write the pending output. Output that cannot be written is dropped.
+
+  // ACCESSORS
+
+  int fd() const
+  // Return the file descriptor written to.
+  {
+    return d_fd;
+  }
+};
+
+} // namespace mdlog
+} // namespace MvdS
+
+#endif // __INCLUDED_MDLOG_FILEOBSERVER
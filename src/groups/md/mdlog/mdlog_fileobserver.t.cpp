@@ -0,0 +1,111 @@
+// mdlog_fileobserver.t.cpp                                             -*-c++-*-
+#include <mdlog_fileobserver.h>
+
+#include <mdlog_record.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdlog;
+
+typedef FileObserver Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+std::string readAll(int fd)
+{
+  std::string result;
+  char        buffer[4096];
+  ssize_t     rc;
+  while (0 < (rc = read(fd, buffer, sizeof(buffer)))) {
+    result.append(buffer, rc);
+  }
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 2:
+    {
+      // A batch larger than the iovec limit of one call.
+      std::string path = "/tmp/mdlog_fileobserver.XXXXXX";
+      const int   fd   = mkstemp(&path[0]);
+      ASSERT(0 <= fd);
+
+      std::vector<std::unique_ptr<Record>> records;
+      std::string                          expected;
+      Obj                                  o(fd);
+      for (int i = 0; i < 3000; ++i) {
+	records.emplace_back(new Record(Level::e_info, Record::time_point()));
+	const std::string line = "line " + std::to_string(i) + std::string(i % 600, '.');
+	records.back()->buffers().append(line.data(), line.size());
+	expected += line + '\n';
+	o.publish(*records.back());
+      }
+      o.flush();
+
+      lseek(fd, 0, SEEK_SET);
+      ASSERT(expected == readAll(fd));
+
+      close(fd);
+      unlink(path.c_str());
+    } break;
+
+  case 1:
+    {
+      // Breathing test.
+      int pipes[2];
+      ASSERT(0 == pipe(pipes));
+
+      Obj o(pipes[1]);
+      ASSERT(pipes[1] == o.fd());
+
+      Record first(Level::e_info, Record::time_point());
+      first.buffers().append("first", 5);
+      Record second(Level::e_error, Record::time_point());
+      second.buffers().append("second", 6);
+
+      o.publish(first);
+      o.publish(second);
+      o.flush();
+      o.flush();
+
+      close(pipes[1]);
+      ASSERT("first\nsecond\n" == readAll(pipes[0]));
+      close(pipes[0]);
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
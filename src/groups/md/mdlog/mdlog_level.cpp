@@ -0,0 +1,33 @@
+// mdlog_level.cpp                                                      -*-c++-*-
+#include <mdlog_level.h>
+
+namespace MvdS {
+namespace mdlog {
+
+// ------------
+// Struct Level
+// ------------
+
+// CLASS METHODS
+
+const char *Level::toAscii(Value value)
+{
+  switch (value) {
+  case e_off:
+    return "OFF";
+  case e_error:
+    return "ERROR";
+  case e_warning:
+    return "WARNING";
+  case e_info:
+    return "INFO";
+  case e_debug:
+    return "DEBUG";
+  case e_trace:
+    return "TRACE";
+  }
+  return "UNKNOWN";
+}
+
+} // namespace mdlog
+} // namespace MvdS
@@ -0,0 +1,38 @@
+// mdlog_level.h                                                        -*-c++-*-
+#ifndef __INCLUDED_MDLOG_LEVEL
+#define __INCLUDED_MDLOG_LEVEL
+
+namespace MvdS {
+namespace mdlog {
+
+// ============
+// Struct Level
+// ============
+
+struct Level
+{
+  // Provides the severity of log records. Lower values are more severe, so
+  // a threshold enables every level up to and including itself.
+
+  // TYPES
+
+  enum Value
+  {
+    e_off     = 0, // Threshold that disables all records.
+    e_error   = 1,
+    e_warning = 2,
+    e_info    = 3,
+    e_debug   = 4,
+    e_trace   = 5
+  };
+
+  // CLASS METHODS
+
+  static const char *toAscii(Value value);
+  // Return the upper case name of the specified 'value'.
+};
+
+} // namespace mdlog
+} // namespace MvdS
+
+#endif // __INCLUDED_MDLOG_LEVEL
@@ -0,0 +1,57 @@
+// mdlog_level.t.cpp                                                    -*-c++-*-
+#include <mdlog_level.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdlog;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 1:
+    {
+      // Breathing test.
+      ASSERT(std::string("OFF") == Level::toAscii(Level::e_off));
+      ASSERT(std::string("ERROR") == Level::toAscii(Level::e_error));
+      ASSERT(std::string("WARNING") == Level::toAscii(Level::e_warning));
+      ASSERT(std::string("INFO") == Level::toAscii(Level::e_info));
+      ASSERT(std::string("DEBUG") == Level::toAscii(Level::e_debug));
+      ASSERT(std::string("TRACE") == Level::toAscii(Level::e_trace));
+
+      // Lower values are more severe.
+      ASSERT(Level::e_error < Level::e_warning);
+      ASSERT(Level::e_debug < Level::e_trace);
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,33 @@
+// mdlog_limitsite.cpp                                                  -*-c++-*-
+#include <mdlog_limitsite.h>
+
+namespace MvdS {
+namespace mdlog {
+
+// ---------------
+// Class LimitSite
+// ---------------
+
+// CLASS DATA
+
+std::atomic<LimitSite *> LimitSite::s_sites(nullptr);
+
+// PRIVATE MANIPULATORS
+
+void LimitSite::registerSite()
+{
+  if (!d_category_p || d_registered.exchange(true)) {
+    return;
+  }
+
+  // Sites are only ever pushed, so there is no ABA problem; the release
+  // publishes 'd_next_p' to the walkers.
+  LimitSite *head = s_sites.load(std::memory_order_relaxed);
+  do {
+    d_next_p = head;
+  } while (!s_sites.compare_exchange_weak(
+      head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+} // namespace mdlog
+} // namespace MvdS
@@ -0,0 +1,114 @@
+// mdlog_limitsite.h                                                    -*-c++-*-
+#ifndef __INCLUDED_MDLOG_LIMITSITE
+#define __INCLUDED_MDLOG_LIMITSITE
+
+#include <mdlog_category.h>
+#include <mdlog_level.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace MvdS {
+namespace mdlog {
+
+// ===============
+// Class LimitSite
+// ===============
+
+class LimitSite
+{
+  // Provides the count of records suppressed by a limited log statement,
+  // see 'mdlog_ratelimit'.
+  //
+  // Sites are meant to be static objects and the constructor is
+  // 'constexpr'. A site with a category registers itself on its first
+  // suppressed record in a lock-free list that is never shrunk, so a
+  // logger can walk all sites and summarize the records they suppressed
+  // since the last record they let pass. This class is thread-safe.
+
+  // DATA
+
+  const Category *      d_category_p; // Null if not registered.
+  const Level::Value    d_level;
+  std::atomic<uint64_t> d_suppressed;
+  std::atomic<bool>     d_registered;
+  LimitSite *           d_next_p; // Next registered site.
+
+  static std::atomic<LimitSite *> s_sites; // Last registered site.
+
+  // PRIVATE MANIPULATORS
+
+  void registerSite();
+  // Register this site, if not done yet and it has a category.
+
+public:
+  LimitSite(const LimitSite &) = delete;
+  LimitSite &operator=(const LimitSite &) = delete;
+
+  // CLASS METHODS
+
+  static LimitSite *first()
+  // Return the last registered site, or null if there is none.
+  {
+    return s_sites.load(std::memory_order_acquire);
+  }
+
+  // CREATORS
+
+  constexpr LimitSite(const Category *category, Level::Value level)
+      // Create a site for statements of the specified 'level' in the
+      // specified 'category', which must outlive the site. A site without a
+      // 'category' is not registered.
+      : d_category_p(category)
+      , d_level(level)
+      , d_suppressed(0)
+      , d_registered(false)
+      , d_next_p(nullptr)
+  {}
+
+  // MANIPULATORS
+
+  void suppress()
+  // Count a suppressed record, registering the site on the first.
+  {
+    if (0 == d_suppressed.fetch_add(1, std::memory_order_relaxed) &&
+        !d_registered.load(std::memory_order_relaxed)) {
+      registerSite();
+    }
+  }
+
+  uint64_t takeSuppressed()
+  // Return the number of records suppressed since the last call and reset
+  // it.
+  {
+    // Only read-modify-write the count if something was suppressed.
+    return 0 == d_suppressed.load(std::memory_order_relaxed)
+               ? 0
+               : d_suppressed.exchange(0, std::memory_order_relaxed);
+  }
+
+  // ACCESSORS
+
+  const Category *category() const
+  // Return the category of the statement, null if none.
+  {
+    return d_category_p;
+  }
+
+  Level::Value level() const
+  // Return the level of the statement.
+  {
+    return d_level;
+  }
+
+  LimitSite *next() const
+  // Return the site registered before this one, or null if there is none.
+  {
+    return d_next_p;
+  }
+};
+
+} // namespace mdlog
+} // namespace MvdS
+
+#endif // __INCLUDED_MDLOG_LIMITSITE
@@ -0,0 +1,106 @@
+// mdlog_limitsite.t.cpp                                                -*-c++-*-
+#include <mdlog_limitsite.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdlog;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+size_t countSites(const LimitSite *site)
+{
+  size_t count = 0;
+  for (const LimitSite *s = LimitSite::first(); s; s = s->next()) {
+    if (s == site) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 2:
+    {
+      // Sites suppressing concurrently are each registered once.
+      static Category          category("mdlog::LimitSite::test");
+      static LimitSite         a(&category, Level::e_info);
+      static LimitSite         b(&category, Level::e_info);
+      std::vector<std::thread> threads;
+      for (int t = 0; t < 4; ++t) {
+	threads.emplace_back([]() {
+	    for (int i = 0; i < 1000; ++i) {
+	      a.suppress();
+	      b.suppress();
+	    }
+	  });
+      }
+      for (auto& thread : threads) {
+	thread.join();
+      }
+      ASSERT(1 == countSites(&a));
+      ASSERT(1 == countSites(&b));
+      ASSERT(4000 == a.takeSuppressed());
+      ASSERT(4000 == b.takeSuppressed());
+    } break;
+
+  case 1:
+    {
+      // Breathing test: a site registers on its first suppressed record
+      // and hands out the count once.
+      static Category  category("mdlog::LimitSite::test");
+      static LimitSite o(&category, Level::e_warning);
+      ASSERT(&category == o.category());
+      ASSERT(Level::e_warning == o.level());
+      ASSERT(0 == countSites(&o));
+      ASSERT(0 == o.takeSuppressed());
+
+      o.suppress();
+      o.suppress();
+      ASSERT(1 == countSites(&o));
+      ASSERT(2 == o.takeSuppressed());
+      ASSERT(0 == o.takeSuppressed());
+
+      o.suppress();
+      ASSERT(1 == countSites(&o));
+      ASSERT(1 == o.takeSuppressed());
+
+      // Sites without a category are not registered.
+      LimitSite anonymous(nullptr, Level::e_info);
+      anonymous.suppress();
+      ASSERT(0 == countSites(&anonymous));
+      ASSERT(1 == anonymous.takeSuppressed());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -1,2 +1,294 @@
 // mdlog_logger.cpp                                                     -*-c++-*-
 #include <mdlog_logger.h>
+
+#include <mdlog_fileobserver.h>
+#include <mdlog_limitsite.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include <unistd.h>
+
+namespace MvdS {
+namespace mdlog {
+
+// ------------
+// Class Logger
+// ------------
+
+// PRIVATE MANIPULATORS
+
+void Logger::run()
+{
+  typedef std::chrono::steady_clock clock;
+
+  clock::time_point summaryTime = clock::now();
+  while (true) {
+    // The summary records are published with the next batch.
+    const std::chrono::nanoseconds interval(d_summaryInterval.load());
+    if (0 < interval.count() && summaryTime + interval <= clock::now()) {
+      reportSuppressed();
+      summaryTime = clock::now();
+    }
+
+    Record *records = takeRecords();
+
+    if (!records) {
+      std::unique_lock<std::mutex> lk(d_mutex);
+      if (d_stop) {
+        return;
+      }
+
+      // 'log' only takes the mutex to notify if it sees the flag.
+      auto ready = [&]() {
+        return d_stop || d_queue.load() ||
+               interval.count() != d_summaryInterval.load();
+      };
+      d_waiting.store(true);
+      if (0 < interval.count()) {
+        d_condition.wait_until(lk, summaryTime + interval, ready);
+      }
+      else {
+        d_condition.wait(lk, ready);
+      }
+      d_waiting.store(false);
+      continue;
+    }
+
+    publish(records);
+  }
+}
+
+void Logger::reportSuppressed()
+{
+  for (LimitSite *site = LimitSite::first(); site; site = site->next()) {
+    const uint64_t count = site->takeSuppressed();
+    if (0 != count) {
+      RecordStream(site->level(), site->category()->name(), this).stream()
+          << "[suppressed " << count
+          << (1 == count ? " message]" : " messages]");
+    }
+  }
+}
+
+Record *Logger::takeRecords()
+{
+  Record *records = d_queue.exchange(nullptr);
+
+  // The queue is a stack, reverse it to publish the oldest record first.
+  Record *oldest = nullptr;
+  while (records) {
+    Record *next = records->next();
+    records->setNext(oldest);
+    oldest  = records;
+    records = next;
+  }
+
+  return oldest;
+}
+
+void Logger::publish(Record *records)
+{
+  uint64_t count = 0;
+
+  {
+    std::lock_guard<std::mutex> lk(d_observerMutex);
+
+    for (Record *record = records; record; record = record->next()) {
+      for (Observer *observer : d_observers) {
+        observer->publish(*record);
+      }
+      ++count;
+    }
+
+    for (Observer *observer : d_observers) {
+      observer->flush();
+    }
+  }
+
+  while (records) {
+    Record *next = records->next();
+    d_recordPool.recycle(records);
+    records = next;
+  }
+
+  std::lock_guard<std::mutex> lk(d_mutex);
+  d_published += count;
+  d_publishedCondition.notify_all();
+}
+
+// CLASS METHODS
+
+Logger &Logger::singleton()
+{
+  // The logger and its observer are never destroyed, so statements in
+  // destructors of other static objects still work after the exit handler
+  // stopped the logger.
+  static Logger *s_logger = []() {
+    Logger *logger = new Logger();
+    logger->addObserver(new FileObserver(STDERR_FILENO));
+    logger->setSummaryInterval(std::chrono::seconds(k_summaryInterval));
+    logger->start();
+    std::atexit([]() { Logger::singleton().stop(); });
+    return logger;
+  }();
+
+  return *s_logger;
+}
+
+// CREATORS
+
+Logger::Logger(mdmem::Allocator *allocator)
+    : d_queue(nullptr)
+    , d_waiting(false)
+    , d_logged(0)
+    , d_published(0)
+    , d_stop(true)
+    , d_summaryInterval(0)
+    , d_observers(mdmem::AllocatorUtil::defaultAllocator(allocator))
+    , d_allocator_p(mdmem::AllocatorUtil::defaultAllocator(allocator))
+    , d_bufferPool(k_bufferPoolSize,
+                   Record::k_defaultBufferSize,
+                   alignof(std::max_align_t),
+                   d_allocator_p)
+    , d_recordPool(k_recordPoolSize,
+                   [](Record *record) { record->clear(); },
+                   d_allocator_p)
+{}
+
+Logger::~Logger() { stop(); }
+
+// MANIPULATORS
+
+void Logger::start()
+{
+  std::lock_guard<std::mutex> lk(d_mutex);
+  if (!d_stop) {
+    return;
+  }
+
+  d_stop.store(false);
+  d_thread = std::thread(&Logger::run, this);
+}
+
+void Logger::stop()
+{
+  {
+    std::lock_guard<std::mutex> lk(d_mutex);
+    if (d_stop) {
+      return;
+    }
+    d_stop.store(true);
+    d_condition.notify_all();
+  }
+
+  d_thread.join();
+
+  if (0 < d_summaryInterval.load()) {
+    reportSuppressed();
+  }
+
+  // Records pushed while the thread was exiting.
+  flush();
+}
+
+void Logger::setSummaryInterval(std::chrono::nanoseconds interval)
+{
+  d_summaryInterval.store(interval.count());
+
+  // Wake the background thread to wait for the new interval.
+  std::lock_guard<std::mutex> lk(d_mutex);
+  d_condition.notify_one();
+}
+
+void Logger::addObserver(Observer *observer)
+{
+  std::lock_guard<std::mutex> lk(d_observerMutex);
+  d_observers.push_back(observer);
+}
+
+void Logger::removeObserver(Observer *observer)
+{
+  std::lock_guard<std::mutex> lk(d_observerMutex);
+  d_observers.erase(std::remove(d_observers.begin(), d_observers.end(), observer),
+                    d_observers.end());
+}
+
+Record *Logger::createRecord(Level::Value level)
+{
+  return createRecord(level, std::chrono::system_clock::now());
+}
+
+Record *Logger::createRecord(Level::Value              level,
+                             const Record::time_point &timePoint)
+{
+  Record *record =
+      d_recordPool.acquire(level, timePoint, &d_bufferPool).release();
+  record->setLevel(level);
+  record->setTimePoint(timePoint);
+  return record;
+}
+
+void Logger::log(Record *record)
+{
+  // Counting before pushing keeps 'd_published' from overtaking the count
+  // of the records 'flush' waits for.
+  ++d_logged;
+
+  Record *head = d_queue.load(std::memory_order_relaxed);
+  do {
+    record->setNext(head);
+  } while (!d_queue.compare_exchange_weak(head, record));
+
+  if (d_stop.load()) {
+    flush();
+  }
+  else if (d_waiting.load()) {
+    std::lock_guard<std::mutex> lk(d_mutex);
+    d_condition.notify_one();
+  }
+}
+
+void Logger::flush()
+{
+  const uint64_t target = d_logged.load();
+
+  if (d_stop.load()) {
+    // Publish on the calling thread. Records taken concurrently by another
+    // caller are published by that caller.
+    Record *records = takeRecords();
+    if (records) {
+      publish(records);
+    }
+  }
+
+  std::unique_lock<std::mutex> lk(d_mutex);
+  d_publishedCondition.wait(lk, [&]() { return target <= d_published; });
+}
+
+// ------------------
+// Class RecordStream
+// ------------------
+
+// CREATORS
+
+RecordStream::RecordStream(Level::Value     level,
+                           std::string_view category,
+                           Logger *         logger)
+    : d_logger_p(logger)
+    , d_record_p(logger->createRecord(level))
+    , d_streamBuffer(d_record_p)
+    , d_stream(&d_streamBuffer)
+{
+  d_stream << '[' << Level::toAscii(level) << "] " << category << ": ";
+}
+
+RecordStream::~RecordStream()
+{
+  d_streamBuffer.pubsync();
+  d_logger_p->log(d_record_p);
+}
+
+} // namespace mdlog
+} // namespace MvdS
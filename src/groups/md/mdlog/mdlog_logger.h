@@ -2,22 +2,252 @@
 #ifndef __INCLUDED_MDLOG_LOGGER
 #define __INCLUDED_MDLOG_LOGGER
 
-#include <iostream>
+#include <mdlog_category.h>
+#include <mdlog_level.h>
+#include <mdlog_observer.h>
+#include <mdlog_record.h>
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+#include <mdmem_fixedbufferpoolallocator.h>
+#include <mdmem_objectpool.h>
 
-#define MDLOG_SET_CATEGORY(x) const std::string __mdlog_logger_category = x
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <experimental/vector>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
 
-#define MDLOG_PRINT_HEADER(level) "[" level "] " <<  __mdlog_logger_category << ": "
-#define MDLOG_INFO std::cerr << MDLOG_PRINT_HEADER("INFO")
-#define MDLOG_DEBUG std::cerr << MDLOG_PRINT_HEADER("DEBUG")
-#define MDLOG_TRACE std::cerr << MDLOG_PRINT_HEADER("TRACE")
-#define MDLOG_ERROR std::cerr << MDLOG_PRINT_HEADER("ERROR")
+// The statements of levels above 'MDLOG_COMPILE_LEVEL' are compiled out,
+// define it to 'Level::e_info' (3) for example to remove debug and trace
+// statements from a build. Enabled statements check the threshold of their
+// category before any argument is evaluated.
 
-#define MDLOG_END std::endl
+#ifndef MDLOG_COMPILE_LEVEL
+#define MDLOG_COMPILE_LEVEL 5 // MvdS::mdlog::Level::e_trace
+#endif
+
+#define MDLOG_SET_CATEGORY(x)                                                  \
+  static MvdS::mdlog::Category __mdlog_logger_category(x)
+
+#define MDLOG_IS_ENABLED(level)                                                \
+  ((level) <= MDLOG_COMPILE_LEVEL &&                                           \
+   __mdlog_logger_category.isEnabled(level))
+
+#define MDLOG_STREAM(level)                                                    \
+  !MDLOG_IS_ENABLED(level)                                                     \
+      ? (void)0                                                                \
+      : MvdS::mdlog::RecordStreamVoidify() &                                   \
+            MvdS::mdlog::RecordStream(level, __mdlog_logger_category.name())   \
+                .stream()
+
+#define MDLOG_INFO MDLOG_STREAM(MvdS::mdlog::Level::e_info)
+#define MDLOG_DEBUG MDLOG_STREAM(MvdS::mdlog::Level::e_debug)
+#define MDLOG_TRACE MDLOG_STREAM(MvdS::mdlog::Level::e_trace)
+#define MDLOG_WARNING MDLOG_STREAM(MvdS::mdlog::Level::e_warning)
+#define MDLOG_ERROR MDLOG_STREAM(MvdS::mdlog::Level::e_error)
+
+#define MDLOG_END MvdS::mdlog::endRecord
 
 namespace MvdS {
-namespace mmt {
+namespace mdlog {
 
+// ============
+// Class Logger
+// ============
+
+class Logger
+{
+  // Provides asynchronous delivery of log records to observers.
+  //
+  // Callers format into a record from 'createRecord' and hand it over with
+  // 'log', which pushes it on a lock-free queue and returns; a background
+  // thread started by 'start' takes all queued records at once and
+  // publishes them as one batch, so observers can write a batch with a
+  // single system call. The calling thread only blocks if the background
+  // thread has to be woken up. Without a running background thread records
+  // are published on the calling thread instead. Records of one thread are
+  // published in order. Records and their buffers come from pools, so
+  // logging does not allocate in steady state. With a summary interval set,
+  // the background thread also logs one "[suppressed N messages]" record
+  // per limited statement that suppressed records since it last passed,
+  // see 'mdlog_ratelimit', every interval and when stopped. This class is
+  // thread-safe.
+
+public:
+  // PUBLIC CONSTANTS
+
+  enum
+  {
+    k_recordPoolSize = 512,  // Records kept for reuse.
+    k_bufferPoolSize = 1024, // Free record buffers kept for reuse.
+    k_summaryInterval = 5    // Seconds between summaries of 'singleton'.
+  };
+
+private:
+  // DATA
+
+  std::atomic<Record *>                     d_queue; // Newest record first.
+  std::atomic<bool>                         d_waiting;
+  std::atomic<uint64_t>                     d_logged;
+  uint64_t                                  d_published;
+  std::atomic<bool>                         d_stop;
+  std::atomic<int64_t>                      d_summaryInterval; // In ns.
+  std::thread                               d_thread;
+  std::mutex                                d_mutex;
+  std::condition_variable                   d_condition;
+  std::condition_variable                   d_publishedCondition;
+  std::mutex                                d_observerMutex;
+  std::experimental::pmr::vector<Observer *> d_observers;
+  mdmem::Allocator *                        d_allocator_p;
+  mdmem::FixedBufferPoolAllocator           d_bufferPool; // Before records.
+  mdmem::ObjectPool<Record>                 d_recordPool;
+
+  // PRIVATE MANIPULATORS
+
+  void run();
+  // Publish batches of records until stopped and the queue is empty.
+
+  Record *takeRecords();
+  // Remove all records from the queue and return them as a list, oldest
+  // first.
+
+  void publish(Record *records);
+  // Publish the specified list of 'records', oldest first, to the
+  // observers and return them to the pool.
+
+  void reportSuppressed();
+  // Log a record for each registered 'LimitSite' that suppressed records
+  // since they were last taken.
+
+public:
+  Logger(const Logger &) = delete;
+  Logger &operator=(const Logger &) = delete;
+
+  // CLASS METHODS
+
+  static Logger &singleton();
+  // Return the process wide logger used by the 'MDLOG_*' macros. It is
+  // created on first use, started, publishes to standard error and reports
+  // suppressed records every 'k_summaryInterval' seconds. It is stopped,
+  // publishing all records, when the process exits.
+
+  // CREATORS
+
+  explicit Logger(mdmem::Allocator *allocator = 0);
+  // Create a logger without observers that is not started. Optionally the
+  // specified 'allocator' is used for memory allocation.
+
+  ~Logger();
+  // Stop the logger, publishing all queued records.
+
+  // MANIPULATORS
+
+  void start();
+  // Start the background thread. Does nothing if already started.
+
+  void stop();
+  // Publish all queued records and stop the background thread. Records
+  // logged afterwards are published on the calling thread.
+
+  void setSummaryInterval(std::chrono::nanoseconds interval);
+  // Report the records suppressed by limited statements every specified
+  // 'interval' and when stopped, or never if 'interval' is zero, which is
+  // the default. Limited statements log to 'singleton', so only one logger
+  // should report them.
+
+  void addObserver(Observer *observer);
+  // Publish records to the specified 'observer' as well.
+
+  void removeObserver(Observer *observer);
+  // Stop publishing records to the specified 'observer'. It is not used
+  // anymore when this function returns.
+
+  Record *createRecord(Level::Value level);
+  // Return a new empty record with the specified 'level' and the current
+  // time, to be passed to 'log'.
+
+  Record *createRecord(Level::Value level, const Record::time_point &timePoint);
+  // Return a new empty record with the specified 'level' and 'timePoint', to
+  // be passed to 'log'.
+
+  void log(Record *record);
+  // Publish the specified 'record' and reuse it. The record must have
+  // been created by 'createRecord' of this logger.
+
+  void flush();
+  // Block until all records logged before the call have been published.
+  // Behavior is undefined if called from an observer.
+};
+
+// ==================
+// Class RecordStream
+// ==================
+
+class RecordStream
+{
+  // Provides the 'std::ostream' used by a log statement. The record is
+  // logged when the object is destroyed, at the end of the statement.
+
+  // DATA
+
+  Logger *           d_logger_p;
+  Record *           d_record_p;
+  RecordStreamBuffer d_streamBuffer;
+  std::ostream       d_stream;
+
+public:
+  RecordStream(const RecordStream &) = delete;
+  RecordStream &operator=(const RecordStream &) = delete;
+
+  // CREATORS
+
+  RecordStream(Level::Value     level,
+               std::string_view category,
+               Logger *         logger = &Logger::singleton());
+  // Create a stream for a record of the specified 'level' that starts with
+  // the level and the specified 'category'. The record is logged to the
+  // optionally specified 'logger'.
+
+  ~RecordStream();
+  // Log the record.
+
+  // MANIPULATORS
+
+  std::ostream &stream()
+  // Return the stream formatting into the record.
+  {
+    return d_stream;
+  }
+};
+
+// ==========================
+// Struct RecordStreamVoidify
+// ==========================
+
+struct RecordStreamVoidify
+{
+  // Provides the conversion of a log statement to 'void', so it can be the
+  // branch of a conditional expression. The '&' operator binds weaker than
+  // '<<' and stronger than '?:'.
+
+  void operator&(std::ostream &) {}
+};
+
+// FREE FUNCTIONS
+
+inline std::ostream &endRecord(std::ostream &stream)
+// Return the specified 'stream'. A record ends with its statement, so this
+// manipulator, used by 'MDLOG_END', does nothing.
+{
+  return stream;
 }
-}
+
+} // namespace mdlog
+} // namespace MvdS
 
 #endif // __INCLUDED_MDLOG_LOGGER
@@ -0,0 +1,245 @@
+// mdlog_logger.t.cpp                                                   -*-c++-*-
+
+// Compile out trace statements, see case 3.
+#define MDLOG_COMPILE_LEVEL 4
+
+#include <mdlog_logger.h>
+
+#include <mdmem_testallocator.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdlog;
+
+typedef Logger Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+class TestObserver : public Observer {
+  // Observer keeping the text of the records.
+
+public:
+  std::mutex               d_mutex;
+  std::vector<std::string> d_lines;
+  std::vector<Level::Value> d_levels;
+  size_t                   d_flushCount = 0;
+  std::thread::id          d_thread;
+
+  virtual void publish(const Record& record)
+  {
+    std::string text(record.buffers().size(), '\0');
+    record.buffers().copyOut(&text[0], text.size());
+
+    std::lock_guard<std::mutex> lk(d_mutex);
+    d_lines.push_back(text);
+    d_levels.push_back(record.level());
+    d_thread = std::this_thread::get_id();
+  }
+
+  virtual void flush()
+  {
+    std::lock_guard<std::mutex> lk(d_mutex);
+    ++d_flushCount;
+  }
+};
+
+void logLine(Obj *logger, Level::Value level, const std::string& text)
+{
+  Record *record = logger->createRecord(level);
+  record->buffers().append(text.data(), text.size());
+  logger->log(record);
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 4:
+    {
+      // Records and their buffers are reused, so once warmed up logging
+      // does not allocate, also for records longer than one buffer.
+      mdmem::TestAllocator ta;
+      TestObserver         observer;
+      {
+	Obj o(&ta);
+	o.addObserver(&observer);
+
+	const std::string longText(3 * Record::k_defaultBufferSize, 'x');
+	auto logRound = [&o, &longText]() {
+	  for (int i = 0; i < 100; ++i) {
+	    RecordStream stream(Level::e_info, "test", &o);
+	    stream.stream() << "value " << i << ' ' << 2.5;
+	    if (0 == i % 10) {
+	      stream.stream() << longText;
+	    }
+	  }
+	};
+
+	logRound();
+	const size_t allocations = ta.allocationCount();
+	logRound();
+	logRound();
+	ASSERT(allocations == ta.allocationCount());
+	ASSERT(300 == observer.d_lines.size());
+	ASSERT("[INFO] test: value 1 2.5" == observer.d_lines[201]);
+	ASSERT(std::string("[INFO] test: value 0 2.5") + longText ==
+	       observer.d_lines[200]);
+      }
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 3:
+    {
+      // The macros log to the singleton, if enabled at compile time and for
+      // the category.
+      TestObserver observer;
+      Obj::singleton().addObserver(&observer);
+      Category::setThreshold("mdlog::Logger::test", Level::e_trace);
+
+      int evaluated = 0;
+      for (int i = 0; i < 2; ++i) {
+	MDLOG_SET_CATEGORY("mdlog::Logger::test");
+	MDLOG_INFO << "value " << 42 << MDLOG_END;
+	MDLOG_ERROR << "error";
+	MDLOG_DEBUG << 1 << ' ' << 2.5;
+	MDLOG_TRACE << ++evaluated;
+
+	// A statement in an 'if' without braces keeps its 'else'.
+	if (0 == i)
+	  MDLOG_WARNING << "first";
+	else
+	  MDLOG_WARNING << "second";
+
+	Category::setThreshold("mdlog::Logger::test", Level::e_error);
+      }
+      ASSERT(0 == evaluated);
+
+      Obj::singleton().flush();
+      Obj::singleton().removeObserver(&observer);
+
+      ASSERT(5 == observer.d_lines.size());
+      if (5 == observer.d_lines.size()) {
+	ASSERT("[INFO] mdlog::Logger::test: value 42" == observer.d_lines[0]);
+	ASSERT("[ERROR] mdlog::Logger::test: error" == observer.d_lines[1]);
+	ASSERT("[DEBUG] mdlog::Logger::test: 1 2.5" == observer.d_lines[2]);
+	ASSERT("[WARNING] mdlog::Logger::test: first" == observer.d_lines[3]);
+	ASSERT("[ERROR] mdlog::Logger::test: error" == observer.d_lines[4]);
+	ASSERT(Level::e_error == observer.d_levels[1]);
+      }
+      ASSERT(std::this_thread::get_id() != observer.d_thread);
+    } break;
+
+  case 2:
+    {
+      // Records from several threads are published in order per thread,
+      // in batches.
+      mdmem::TestAllocator ta;
+      TestObserver         observer;
+      {
+	Obj o(&ta);
+	o.addObserver(&observer);
+	o.start();
+	o.start();
+
+	const int                k_threads = 4;
+	const int                k_records = 5000;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < k_threads; ++t) {
+	  threads.emplace_back([&o, t]() {
+	      for (int i = 0; i < k_records; ++i) {
+		logLine(&o, Level::e_info, std::to_string(t) + ' ' + std::to_string(i));
+	      }
+	    });
+	}
+	for (auto& thread : threads) {
+	  thread.join();
+	}
+
+	o.flush();
+	ASSERT(size_t(k_threads * k_records) == observer.d_lines.size());
+	ASSERT(observer.d_flushCount <= observer.d_lines.size());
+
+	std::map<int, int> next;
+	bool               ordered = true;
+	for (const std::string& line : observer.d_lines) {
+	  const int t = std::atoi(line.c_str());
+	  const int i = std::atoi(line.c_str() + line.find(' '));
+	  ordered     = ordered && next[t] == i;
+	  next[t]     = i + 1;
+	}
+	ASSERT(ordered);
+
+	// Records logged before 'stop' are published by it.
+	logLine(&o, Level::e_debug, "last");
+	o.stop();
+	ASSERT("last" == observer.d_lines.back());
+      }
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 1:
+    {
+      // Breathing test: without a background thread records are published
+      // on the calling thread.
+      mdmem::TestAllocator ta;
+      TestObserver         observer;
+      {
+	Obj o(&ta);
+	logLine(&o, Level::e_info, "nobody");
+
+	o.addObserver(&observer);
+	logLine(&o, Level::e_info, "first");
+	ASSERT(1 == observer.d_lines.size());
+	ASSERT(std::this_thread::get_id() == observer.d_thread);
+	ASSERT(1 == observer.d_flushCount);
+
+	{
+	  RecordStream stream(Level::e_warning, "category", &o);
+	  stream.stream() << "second " << 2;
+	}
+	ASSERT(2 == observer.d_lines.size());
+	ASSERT("[WARNING] category: second 2" == observer.d_lines.back());
+	ASSERT(Level::e_warning == observer.d_levels.back());
+
+	o.removeObserver(&observer);
+	logLine(&o, Level::e_info, "third");
+	ASSERT(2 == observer.d_lines.size());
+	o.flush();
+      }
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
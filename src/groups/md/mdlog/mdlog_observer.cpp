@@ -0,0 +1,20 @@
+// mdlog_observer.cpp                                                   -*-c++-*-
+#include <mdlog_observer.h>
+
+namespace MvdS {
+namespace mdlog {
+
+// --------------
+// Class Observer
+// --------------
+
+// CREATORS
+
+Observer::~Observer() {}
+
+// MANIPULATORS
+
+void Observer::flush() {}
+
+} // namespace mdlog
+} // namespace MvdS
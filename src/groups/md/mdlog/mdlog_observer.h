@@ -1,28 +1,41 @@
-// log_observer.h                                                     -*-c++-*-
-#ifndef __INCLUDED_LOG_OBSERVER
-#define __INCLUDED_LOG_OBSERVER
+// mdlog_observer.h                                                     -*-c++-*-
+#ifndef __INCLUDED_MDLOG_OBSERVER
+#define __INCLUDED_MDLOG_OBSERVER
 
 namespace MvdS {
-  namespace log {
+namespace mdlog {
 
-    class Record;
+class Record;
 
-			  // ==============
-			  // Class Observer
-			  // ==============
-    
-    class Observer {
-      // Provides the log observer base class.
+// ==============
+// Class Observer
+// ==============
 
-    public:
+class Observer
+{
+  // Provides the log observer base class.
+  //
+  // A logger publishes records in batches: 'publish' is called for every
+  // record of the batch, followed by one call to 'flush'. The records stay
+  // valid until 'flush' returns, so an observer can defer its output and
+  // write the whole batch at once. Calls are not concurrent.
 
-      virtual void publish(const std::shared_ptr<Record>& record) = 0;
-      // Publish the specified 'record' to the observer.
-      
-    };
+public:
+  // CREATORS
 
-  }
-}
+  virtual ~Observer();
 
+  // MANIPULATORS
 
-#endif // __INCLUDED_LOG_OBSERVER
+  virtual void publish(const Record &record) = 0;
+  // Publish the specified 'record' to the observer.
+
+  virtual void flush();
+  // Complete the output of the records published since the last call. The
+  // default implementation does nothing.
+};
+
+} // namespace mdlog
+} // namespace MvdS
+
+#endif // __INCLUDED_MDLOG_OBSERVER
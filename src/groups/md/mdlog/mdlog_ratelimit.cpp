@@ -0,0 +1,53 @@
+// mdlog_ratelimit.cpp                                                  -*-c++-*-
+#include <mdlog_ratelimit.h>
+
+#include <algorithm>
+
+namespace MvdS {
+namespace mdlog {
+
+// ---------------
+// Class RateLimit
+// ---------------
+
+// MANIPULATORS
+
+uint64_t RateLimit::pass(std::chrono::steady_clock::time_point now)
+{
+  const int64_t time =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          now.time_since_epoch())
+          .count();
+
+  int64_t fullTime = d_fullTime.load(std::memory_order_relaxed);
+  while (true) {
+    // Every token moves the time the bucket is full again one interval
+    // further; the bucket is empty if that is more than a burst away.
+    const int64_t start = std::max(fullTime, time);
+    if (d_tolerance < start - time) {
+      suppress();
+      return 0;
+    }
+
+    if (d_fullTime.compare_exchange_weak(
+            fullTime, start + d_interval, std::memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  return 1 + takeSuppressed();
+}
+
+// FREE OPERATORS
+
+std::ostream &operator<<(std::ostream &stream, const SuppressedCount &count)
+{
+  if (0 != count.d_count) {
+    stream << "[suppressed " << count.d_count
+           << (1 == count.d_count ? " message] " : " messages] ");
+  }
+  return stream;
+}
+
+} // namespace mdlog
+} // namespace MvdS
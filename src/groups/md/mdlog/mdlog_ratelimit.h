@@ -0,0 +1,197 @@
+// mdlog_ratelimit.h                                                    -*-c++-*-
+#ifndef __INCLUDED_MDLOG_RATELIMIT
+#define __INCLUDED_MDLOG_RATELIMIT
+
+#include <mdlog_category.h>
+#include <mdlog_level.h>
+#include <mdlog_limitsite.h>
+#include <mdlog_logger.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+// The limited statements keep the state of the limit in a static object per
+// statement, so a statement that fires in a loop cannot flood the
+// observers. The first statement that passes after others were suppressed
+// starts with the number of suppressed statements, and the logger reports
+// the ones not followed by a pass periodically, see 'Logger'. Use them
+// like the other statements, they are statements rather than expressions:
+//..
+//  MDLOG_ERROR_LIMITED(10) << "No thread with ID=" << id << MDLOG_END;
+//  MDLOG_DEBUG_SAMPLED(1000) << "Processed " << count << MDLOG_END;
+//..
+
+#define MDLOG_STREAM_LIMITED(level, LIMIT, n)                                  \
+  for (uint64_t __mdlog_pass =                                                 \
+           MDLOG_IS_ENABLED(level)                                             \
+               ? []() -> MvdS::mdlog::LIMIT & {                                \
+                   static MvdS::mdlog::LIMIT s_limit(                          \
+                       &__mdlog_logger_category, level, n);                    \
+                   return s_limit;                                             \
+                 }().pass()                                                    \
+               : 0;                                                            \
+       0 != __mdlog_pass;                                                      \
+       __mdlog_pass = 0)                                                       \
+  MvdS::mdlog::RecordStream(level, __mdlog_logger_category.name()).stream()    \
+      << MvdS::mdlog::SuppressedCount{__mdlog_pass - 1}
+
+#define MDLOG_INFO_LIMITED(n)                                                  \
+  MDLOG_STREAM_LIMITED(MvdS::mdlog::Level::e_info, RateLimit, n)
+#define MDLOG_DEBUG_LIMITED(n)                                                 \
+  MDLOG_STREAM_LIMITED(MvdS::mdlog::Level::e_debug, RateLimit, n)
+#define MDLOG_TRACE_LIMITED(n)                                                 \
+  MDLOG_STREAM_LIMITED(MvdS::mdlog::Level::e_trace, RateLimit, n)
+#define MDLOG_WARNING_LIMITED(n)                                               \
+  MDLOG_STREAM_LIMITED(MvdS::mdlog::Level::e_warning, RateLimit, n)
+#define MDLOG_ERROR_LIMITED(n)                                                 \
+  MDLOG_STREAM_LIMITED(MvdS::mdlog::Level::e_error, RateLimit, n)
+
+#define MDLOG_INFO_SAMPLED(n)                                                  \
+  MDLOG_STREAM_LIMITED(MvdS::mdlog::Level::e_info, Sampler, n)
+#define MDLOG_DEBUG_SAMPLED(n)                                                 \
+  MDLOG_STREAM_LIMITED(MvdS::mdlog::Level::e_debug, Sampler, n)
+#define MDLOG_TRACE_SAMPLED(n)                                                 \
+  MDLOG_STREAM_LIMITED(MvdS::mdlog::Level::e_trace, Sampler, n)
+#define MDLOG_WARNING_SAMPLED(n)                                               \
+  MDLOG_STREAM_LIMITED(MvdS::mdlog::Level::e_warning, Sampler, n)
+#define MDLOG_ERROR_SAMPLED(n)                                                 \
+  MDLOG_STREAM_LIMITED(MvdS::mdlog::Level::e_error, Sampler, n)
+
+namespace MvdS {
+namespace mdlog {
+
+// ===============
+// Class RateLimit
+// ===============
+
+class RateLimit : public LimitSite
+{
+  // Provides a lock-free token bucket that lets 'count' statements pass per
+  // 'period', in bursts of at most 'count'. The bucket is kept as the time
+  // at which it will be full again, so a check is a clock read and one
+  // compare-and-swap. This class is thread-safe.
+
+  // DATA
+
+  const int64_t        d_interval;  // Nanoseconds per token.
+  const int64_t        d_tolerance; // Nanoseconds of burst.
+  std::atomic<int64_t> d_fullTime;  // Nanoseconds of the steady clock.
+
+public:
+  RateLimit(const RateLimit &) = delete;
+  RateLimit &operator=(const RateLimit &) = delete;
+
+  // CREATORS
+
+  constexpr explicit RateLimit(
+      uint32_t                 count,
+      std::chrono::nanoseconds period = std::chrono::seconds(1))
+      // Create a limit that lets the specified 'count' statements pass per
+      // the optionally specified 'period', at least one. It is not
+      // registered as a 'LimitSite'.
+      : RateLimit(nullptr, Level::e_info, count, period)
+  {}
+
+  constexpr RateLimit(
+      const Category *         category,
+      Level::Value             level,
+      uint32_t                 count,
+      std::chrono::nanoseconds period = std::chrono::seconds(1))
+      // Create a limit for statements of the specified 'level' in the
+      // specified 'category' that lets the specified 'count' statements
+      // pass per the optionally specified 'period', at least one.
+      : LimitSite(category, level)
+      , d_interval(period.count() / (0 < count ? count : 1))
+      , d_tolerance(period.count() - d_interval)
+      , d_fullTime(0)
+  {}
+
+  // MANIPULATORS
+
+  uint64_t pass()
+  // Take a token at the current time. Return 0 if the bucket is empty,
+  // otherwise 1 plus the number of statements suppressed and not yet
+  // taken, see 'LimitSite::takeSuppressed'.
+  {
+    return pass(std::chrono::steady_clock::now());
+  }
+
+  uint64_t pass(std::chrono::steady_clock::time_point now);
+  // Take a token at the specified time 'now'. Return 0 if the bucket is
+  // empty, otherwise 1 plus the number of statements suppressed and not
+  // yet taken.
+};
+
+// =============
+// Class Sampler
+// =============
+
+class Sampler : public LimitSite
+{
+  // Provides a lock-free 1 in 'n' sampling of statements: the first and
+  // every 'n'-th statement after it pass. This class is thread-safe.
+
+  // DATA
+
+  const uint64_t        d_n;
+  std::atomic<uint64_t> d_count;
+
+public:
+  Sampler(const Sampler &) = delete;
+  Sampler &operator=(const Sampler &) = delete;
+
+  // CREATORS
+
+  constexpr explicit Sampler(uint64_t n)
+      // Create a sampler letting 1 in the specified 'n' statements pass. It
+      // is not registered as a 'LimitSite'.
+      : Sampler(nullptr, Level::e_info, n)
+  {}
+
+  constexpr Sampler(const Category *category, Level::Value level, uint64_t n)
+      // Create a sampler for statements of the specified 'level' in the
+      // specified 'category' letting 1 in the specified 'n' statements
+      // pass.
+      : LimitSite(category, level)
+      , d_n(0 < n ? n : 1)
+      , d_count(0)
+  {}
+
+  // MANIPULATORS
+
+  uint64_t pass()
+  // Count a statement. Return 0 if it is not sampled, otherwise 1 plus the
+  // number of statements suppressed and not yet taken.
+  {
+    if (0 != d_count.fetch_add(1, std::memory_order_relaxed) % d_n) {
+      suppress();
+      return 0;
+    }
+    return 1 + takeSuppressed();
+  }
+};
+
+// ======================
+// Struct SuppressedCount
+// ======================
+
+struct SuppressedCount
+{
+  // Provides the note on the number of suppressed statements that starts
+  // a limited statement.
+
+  uint64_t d_count;
+};
+
+// FREE OPERATORS
+
+std::ostream &operator<<(std::ostream &stream, const SuppressedCount &count);
+// Write a note on the specified suppressed 'count' to the specified
+// 'stream', nothing if it is zero, and return the stream.
+
+} // namespace mdlog
+} // namespace MvdS
+
+#endif // __INCLUDED_MDLOG_RATELIMIT
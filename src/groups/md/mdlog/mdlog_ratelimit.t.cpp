@@ -0,0 +1,235 @@
+// mdlog_ratelimit.t.cpp                                                -*-c++-*-
+#include <mdlog_ratelimit.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdlog;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+class TestObserver : public Observer {
+  // Observer keeping the text of the records.
+
+public:
+  std::mutex               d_mutex;
+  std::vector<std::string> d_lines;
+
+  virtual void publish(const Record& record)
+  {
+    std::string text(record.buffers().size(), '\0');
+    record.buffers().copyOut(&text[0], text.size());
+
+    std::lock_guard<std::mutex> lk(d_mutex);
+    d_lines.push_back(text);
+  }
+};
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 5:
+    {
+      // The logger reports what limited statements suppressed after a
+      // flood ended, periodically and when stopped.
+      TestObserver observer;
+      Logger&      logger = Logger::singleton();
+      logger.addObserver(&observer);
+      logger.setSummaryInterval(std::chrono::milliseconds(20));
+      Category::setThreshold("mdlog::RateLimit::summary", Level::e_info);
+
+      MDLOG_SET_CATEGORY("mdlog::RateLimit::summary");
+      for (int i = 0; i < 100; ++i) {
+	MDLOG_WARNING_LIMITED(1) << "flood " << i << MDLOG_END;
+      }
+      for (int i = 0; i < 15; ++i) {
+	MDLOG_INFO_SAMPLED(10) << "sampled " << i << MDLOG_END;
+      }
+
+      const std::string limited =
+	  "[WARNING] mdlog::RateLimit::summary: [suppressed 99 messages]";
+      const std::string sampled =
+	  "[INFO] mdlog::RateLimit::summary: [suppressed 4 messages]";
+      auto count = [&observer](const std::string& line) {
+	std::lock_guard<std::mutex> lk(observer.d_mutex);
+	return std::count(observer.d_lines.begin(), observer.d_lines.end(),
+			  line);
+      };
+      for (int i = 0; i < 500 && (0 == count(limited) || 0 == count(sampled));
+	   ++i) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      ASSERT(1 == count(limited));
+      ASSERT(1 == count(sampled));
+
+      // Nothing is reported twice.
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      logger.flush();
+      ASSERT(1 == count(limited));
+      ASSERT(1 == count(sampled));
+
+      // Stopping reports what was suppressed since.
+      logger.setSummaryInterval(std::chrono::hours(1));
+      for (int i = 0; i < 3; ++i) {
+	MDLOG_ERROR_LIMITED(1) << "stop " << i << MDLOG_END;
+      }
+      logger.stop();
+      ASSERT(1 == count("[ERROR] mdlog::RateLimit::summary: stop 0"));
+      ASSERT(1 == count("[ERROR] mdlog::RateLimit::summary: "
+			"[suppressed 2 messages]"));
+
+      logger.start();
+      logger.setSummaryInterval(
+	  std::chrono::seconds(Logger::k_summaryInterval));
+      logger.removeObserver(&observer);
+    } break;
+
+  case 4:
+    {
+      // The macros keep a limit per statement and note what was suppressed.
+      TestObserver observer;
+      Logger::singleton().addObserver(&observer);
+      Category::setThreshold("mdlog::RateLimit::test", Level::e_info);
+
+      MDLOG_SET_CATEGORY("mdlog::RateLimit::test");
+      for (int i = 0; i < 100; ++i) {
+	MDLOG_ERROR_LIMITED(2) << "limited " << i << MDLOG_END;
+      }
+      for (int i = 0; i < 100; ++i) {
+	MDLOG_ERROR_LIMITED(1) << "other " << i << MDLOG_END;
+      }
+      for (int i = 0; i < 25; ++i) {
+	if (0 <= i)
+	  MDLOG_INFO_SAMPLED(10) << "sampled " << i << MDLOG_END;
+	else
+	  ASSERT(false);
+      }
+      int evaluated = 0;
+      for (int i = 0; i < 10; ++i) {
+	MDLOG_DEBUG_SAMPLED(1) << ++evaluated << MDLOG_END;
+      }
+
+      Logger::singleton().flush();
+      Logger::singleton().removeObserver(&observer);
+
+      ASSERT(0 == evaluated);
+      ASSERT(6 == observer.d_lines.size());
+      if (6 == observer.d_lines.size()) {
+	ASSERT("[ERROR] mdlog::RateLimit::test: limited 0" ==
+	       observer.d_lines[0]);
+	ASSERT("[ERROR] mdlog::RateLimit::test: limited 1" ==
+	       observer.d_lines[1]);
+	ASSERT("[ERROR] mdlog::RateLimit::test: other 0" ==
+	       observer.d_lines[2]);
+	ASSERT("[INFO] mdlog::RateLimit::test: sampled 0" ==
+	       observer.d_lines[3]);
+	ASSERT("[INFO] mdlog::RateLimit::test: "
+	       "[suppressed 9 messages] sampled 10" == observer.d_lines[4]);
+	ASSERT("[INFO] mdlog::RateLimit::test: "
+	       "[suppressed 9 messages] sampled 20" == observer.d_lines[5]);
+      }
+    } break;
+
+  case 3:
+    {
+      // Concurrent statements never pass more often than the limit.
+      RateLimit                o(100, std::chrono::hours(1));
+      std::atomic<uint64_t>    passed(0);
+      std::vector<std::thread> threads;
+      for (int t = 0; t < 4; ++t) {
+	threads.emplace_back([&o, &passed]() {
+	    for (int i = 0; i < 10000; ++i) {
+	      if (o.pass()) {
+		++passed;
+	      }
+	    }
+	  });
+      }
+      for (auto& thread : threads) {
+	thread.join();
+      }
+      ASSERT(100 == passed);
+    } break;
+
+  case 2:
+    {
+      // The first and every n-th statement pass a sampler.
+      Sampler o(4);
+      std::ostringstream passes;
+      for (int i = 0; i < 9; ++i) {
+	passes << o.pass();
+      }
+      ASSERT("100040004" == passes.str());
+
+      Sampler all(0);
+      ASSERT(1 == all.pass());
+      ASSERT(1 == all.pass());
+    } break;
+
+  case 1:
+    {
+      // Breathing test: a burst passes, then one statement per interval,
+      // reporting the number suppressed in between.
+      typedef std::chrono::steady_clock clock;
+      const clock::time_point start = clock::now();
+
+      RateLimit o(3, std::chrono::seconds(3));
+      ASSERT(1 == o.pass(start));
+      ASSERT(1 == o.pass(start));
+      ASSERT(1 == o.pass(start));
+      ASSERT(0 == o.pass(start));
+      ASSERT(0 == o.pass(start + std::chrono::milliseconds(999)));
+      ASSERT(3 == o.pass(start + std::chrono::seconds(1)));
+      ASSERT(0 == o.pass(start + std::chrono::seconds(1)));
+      ASSERT(2 == o.pass(start + std::chrono::seconds(2)));
+
+      // After a quiet period the full burst is available again.
+      const clock::time_point later = start + std::chrono::seconds(10);
+      ASSERT(1 == o.pass(later));
+      ASSERT(1 == o.pass(later));
+      ASSERT(1 == o.pass(later));
+      ASSERT(0 == o.pass(later));
+
+      std::ostringstream stream;
+      stream << SuppressedCount{0} << '|' << SuppressedCount{1} << '|'
+	     << SuppressedCount{2};
+      ASSERT("|[suppressed 1 message] |[suppressed 2 messages] " ==
+	     stream.str());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
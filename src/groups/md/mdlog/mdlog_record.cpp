@@ -0,0 +1,2 @@
+// mdlog_record.cpp                                                     -*-c++-*-
+#include <mdlog_record.h>
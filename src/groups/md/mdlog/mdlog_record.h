@@ -1,149 +1,154 @@
-// log_record.h                                                       -*-c++-*-
-#ifndef __INCLUDED_LOG_RECORD
-#define __INCLUDED_LOG_RECORD
+// mdlog_record.h                                                       -*-c++-*-
+#ifndef __INCLUDED_MDLOG_RECORD
+#define __INCLUDED_MDLOG_RECORD
 
-#include <io_buffer.h>
-#include <io_buffervector.h>
-#include <mem_allocator.h>
+#include <mdio_buffervector.h>
+#include <mdio_streambuffer.h>
+#include <mdlog_level.h>
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
 
 #include <chrono>
 
 namespace MvdS {
-  namespace log {
-
-			   // ============
-			   // Class Record
-			   // ============
-    
-    class Record {
-      // Provides log record.
-      //
-      // TODO: Use FixedBufferPoolAllocator for the IO buffers.
-      
-    public:
-
-      // PUBLIC TYPES
-      
-      typedef std::chrono::steady_clock::time_point time_point;
-      
-    private:
-
-      // PRIVATE TYPES
-
-      enum {
-	k_defaultBufferSize = 256
-      };
-      
-      // PRIVATE DATA
-      
-      Level            d_level;       // Log level.
-      time_point       d_timePoint;   // Log time.
-      io::BufferVector d_buffers;     // Backing buffers.
-      mem::Allocator  *d_allocator_p;
-      
-    public:
-
-      Record(Level             level,
-	     const time_point& timePoint,
-	     mem::Allocator   *allocator)
-	: d_level(level)
-	, d_timePoint(timePoint)
-	, d_buffers(k_defaultBufferSize, allocator)
-	, d_allocator_p(allocator)
-      {}
-
-      ~Record()
-      {}
-      
-      // ACCESSORS
-
-      io::Buffer *nextBuffer()
-      // Allocate a new buffer and appends it to the buffer vector. Return the
-      // newly allocated buffer.
-      {
-	d_buffers.emplace_back();
-	return d_buffer.back();
-      }
-      
-      Level level() const
-      // Return log level for this record.
-      {
-	return d_level;
-      }
-
-      const time_point& timePoint() const
-      // Return log time.
-      {
-	return d_timePoint;
-      }
-      
-      const io::BufferVector& buffers() const
-      // Return the buffers encapsulating the record data.
-      {
-	return d_buffers;
-      }      
-      
-    };
-
-    class RecordStreamBuffer : public std::streambuf {
-      // Provides a streambuf for writing to a Record object.
-
-      // DATA
-      
-      Record     *d_record;   // The record object to write to.
-      io::Buffer *d_buffer;   // The current output buffer.
-      size_t      d_position; // Current position in the output buffer.
-
-      // PRIVATE MANIPULATORS
-      
-      void nextBuffer()
-      // Tells the record to allocate and push a new buffer for output.
-      {
-	d_buffer   = d_record->nextBuffer();
-	d_position = 0;
-      }
-      
-    protected:
-
-      // PROTECTED MANIPULATORS
-      
-      virtual std::streamsize xsputn(const char_type* src, std::streamsize size)
-      // Copy the specifried 'src' buffer with the specified 'size' to the
-      // record. Return number of characters written.
-      {
-	const char_type *srcEnd = src + size;
-	char_type *dst          = d_buffer.begin() + d_position;
-
-	while (srcEnd != src) {
-	  size_t count = std::min(d_buffer.end() - dst, srcEnd - src);
-	  
-	  memcpy(dst, src, count);
-	  
-	  dst += count;
-	  src += count;
-
-	  if (d_buffer.end() == dst) {
-	    nextBuffer();
-	    dst = d_buffer.begin() + d_position;
-	  }
-	}
-
-	d_position = dst - d_buffer.begin();
-      }
-      
-    public:
-
-      // CREATORS
-      
-      RecordStreamBuffer(Record *record);
-      // Create RecordStreamBuffer that writes to the specified 'record'.
+namespace mdlog {
+
+// ============
+// Class Record
+// ============
+
+class Record
+{
+  // Provides a log record: the level and time of a log statement and the
+  // formatted text, kept in a chain of small buffers.
+  //
+  // The buffers have 'k_defaultBufferSize' bytes, so with a
+  // 'mdmem::FixedBufferPoolAllocator' of that buffer size they come from a
+  // pool. A 'Logger' keeps its records in a 'mdmem::ObjectPool' and clears
+  // them for reuse, so building a record does not allocate in steady state.
+
+public:
+  // PUBLIC TYPES
+
+  typedef std::chrono::system_clock::time_point time_point;
+
+  // PUBLIC CONSTANTS
+
+  enum
+  {
+    k_defaultBufferSize = 256
+  };
+
+private:
+  // DATA
+
+  Level::Value       d_level;     // Log level.
+  time_point         d_timePoint; // Log time.
+  mdio::BufferVector d_buffers;   // Formatted text.
+  Record *           d_next_p;    // Link in the queue of a logger.
+
+public:
+  Record(const Record &) = delete;
+  Record &operator=(const Record &) = delete;
+
+  // CREATORS
+
+  Record(Level::Value      level,
+         const time_point &timePoint,
+         mdmem::Allocator *allocator = 0)
+      // Create an empty record with the specified 'level' and 'timePoint'.
+      // Optionally the specified 'allocator' is used for the buffers.
+      : d_level(level)
+      , d_timePoint(timePoint)
+      , d_buffers(k_defaultBufferSize, allocator)
+      , d_next_p(nullptr)
+  {}
+
+  // MANIPULATORS
+
+  mdio::BufferVector &buffers()
+  // Return the buffers holding the text of the record.
+  {
+    return d_buffers;
+  }
+
+  void setLevel(Level::Value level)
+  // Set the log level to the specified 'level'.
+  {
+    d_level = level;
+  }
 
-      ~RecordStreamBuffer();
-      
-    };
+  void setTimePoint(const time_point &timePoint)
+  // Set the log time to the specified 'timePoint'.
+  {
+    d_timePoint = timePoint;
+  }
 
+  void clear()
+  // Remove the text and the link, for reuse of the record. Buffers are kept
+  // if the text fitted in one, otherwise all are freed, so a pooled record
+  // does not hold on to the memory of one long text.
+  {
+    d_buffers.clear();
+    if (1 < d_buffers.bufferCount()) {
+      d_buffers.shrinkToFit();
+    }
+    d_next_p = nullptr;
   }
-}
 
+  void setNext(Record *next)
+  // Link the specified 'next' record after this one.
+  {
+    d_next_p = next;
+  }
+
+  // ACCESSORS
+
+  Level::Value level() const
+  // Return log level for this record.
+  {
+    return d_level;
+  }
+
+  const time_point &timePoint() const
+  // Return log time.
+  {
+    return d_timePoint;
+  }
+
+  const mdio::BufferVector &buffers() const
+  // Return the buffers holding the text of the record.
+  {
+    return d_buffers;
+  }
+
+  Record *next() const
+  // Return the record linked after this one, or null.
+  {
+    return d_next_p;
+  }
+};
+
+// ========================
+// Class RecordStreamBuffer
+// ========================
+
+class RecordStreamBuffer : public mdio::OutputStreamBuffer
+{
+  // Provides a streambuf for writing to a Record object. Characters are
+  // formatted directly into the buffers of the record and committed on
+  // 'pubsync' and on destruction.
+
+public:
+  // CREATORS
+
+  explicit RecordStreamBuffer(Record *record)
+      // Create RecordStreamBuffer that writes to the specified 'record'.
+      : mdio::OutputStreamBuffer(&record->buffers())
+  {}
+};
+
+} // namespace mdlog
+} // namespace MvdS
 
-#endif // __INCLUDED_LOG_RECORD
+#endif // __INCLUDED_MDLOG_RECORD
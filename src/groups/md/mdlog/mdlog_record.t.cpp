@@ -0,0 +1,103 @@
+// mdlog_record.t.cpp                                                   -*-c++-*-
+#include <mdlog_record.h>
+
+#include <mdmem_testallocator.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <ostream>
+#include <string>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdlog;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+std::string text(const Record& record)
+{
+  std::string result(record.buffers().size(), '\0');
+  record.buffers().copyOut(&result[0], result.size());
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 2:
+    {
+      // Streaming into a record spanning several buffers.
+      mdmem::TestAllocator ta;
+      {
+	Record o(Level::e_info, Record::time_point(), &ta);
+	{
+	  RecordStreamBuffer sb(&o);
+	  std::ostream       stream(&sb);
+	  for (int i = 0; i < 100; ++i) {
+	    stream << i << ',';
+	  }
+	}
+
+	std::string expected;
+	for (int i = 0; i < 100; ++i) {
+	  expected += std::to_string(i) + ',';
+	}
+	ASSERT(expected == text(o));
+	ASSERT(1 < o.buffers().bufferCount());
+	ASSERT(Record::k_defaultBufferSize == o.buffers().bufferSize());
+      }
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 1:
+    {
+      // Breathing test.
+      const Record::time_point now = std::chrono::system_clock::now();
+
+      Record o(Level::e_error, now);
+      ASSERT(Level::e_error == o.level());
+      ASSERT(now == o.timePoint());
+      ASSERT(o.buffers().empty());
+      ASSERT(nullptr == o.next());
+
+      {
+	RecordStreamBuffer sb(&o);
+	std::ostream       stream(&sb);
+	stream << "value " << 42;
+	stream.flush();
+	ASSERT("value 42" == text(o));
+	stream << '!';
+      }
+      ASSERT("value 42!" == text(o));
+
+      Record other(Level::e_trace, now);
+      o.setNext(&other);
+      ASSERT(&other == o.next());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
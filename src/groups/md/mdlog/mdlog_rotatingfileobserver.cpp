@@ -0,0 +1,132 @@
+// mdlog_rotatingfileobserver.cpp                                       -*-c++-*-
+#include <mdlog_rotatingfileobserver.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MvdS {
+namespace mdlog {
+
+// --------------------------
+// Class RotatingFileObserver
+// --------------------------
+
+// PRIVATE MANIPULATORS
+
+void RotatingFileObserver::sync(bool force)
+{
+  if (e_never == d_config.d_syncPolicy || fd() < 0) {
+    return;
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  if (!force && e_periodic == d_config.d_syncPolicy &&
+      now - d_syncTime < d_config.d_syncInterval) {
+    return;
+  }
+
+  ::fdatasync(fd());
+  d_syncTime = now;
+  ++d_syncCount;
+}
+
+// CREATORS
+
+RotatingFileObserver::RotatingFileObserver(const char *      path,
+                                           mdmem::Allocator *allocator)
+    : RotatingFileObserver(path, Configuration(), allocator)
+{}
+
+RotatingFileObserver::RotatingFileObserver(const char *         path,
+                                           const Configuration &config,
+                                           mdmem::Allocator *   allocator)
+    : FileObserver(-1, allocator)
+    , d_path(path)
+    , d_config(config)
+    , d_size(0)
+    , d_syncTime(std::chrono::steady_clock::now())
+    , d_rotationCount(0)
+    , d_syncCount(0)
+{
+  d_config.d_maximumFiles = std::max<size_t>(d_config.d_maximumFiles, 1);
+}
+
+RotatingFileObserver::~RotatingFileObserver() { close(); }
+
+// MANIPULATORS
+
+int RotatingFileObserver::open()
+{
+  close();
+
+  const int fd =
+      ::open(d_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return -errno;
+  }
+
+  struct stat st;
+  d_size     = 0 == ::fstat(fd, &st) ? st.st_size : 0;
+  d_openTime = std::chrono::system_clock::now();
+  setFd(fd);
+  return 0;
+}
+
+void RotatingFileObserver::close()
+{
+  FileObserver::flush();
+  if (fd() < 0) {
+    return;
+  }
+
+  sync(true);
+  ::close(fd());
+  setFd(-1);
+}
+
+int RotatingFileObserver::rotate()
+{
+  close();
+
+  // The oldest file is replaced by the rename before it.
+  for (size_t i = d_config.d_maximumFiles; i > 0; --i) {
+    const std::string from =
+        1 == i ? d_path : d_path + '.' + std::to_string(i - 1);
+    const std::string to = d_path + '.' + std::to_string(i);
+    ::rename(from.c_str(), to.c_str());
+  }
+  ++d_rotationCount;
+
+  return open();
+}
+
+void RotatingFileObserver::publish(const Record &record)
+{
+  const size_t size = record.buffers().size() + 1;
+
+  if (0 <= fd() && 0 < d_size &&
+      ((0 < d_config.d_maximumSize && d_config.d_maximumSize < d_size + size) ||
+       (0 < d_config.d_maximumAge.count() &&
+        d_openTime + d_config.d_maximumAge <= record.timePoint()))) {
+    rotate();
+  }
+
+  if (0 <= fd()) {
+    FileObserver::publish(record);
+    d_size += size;
+  }
+}
+
+void RotatingFileObserver::flush()
+{
+  FileObserver::flush();
+  sync(false);
+}
+
+} // namespace mdlog
+} // namespace MvdS
@@ -0,0 +1,152 @@
+// mdlog_rotatingfileobserver.h                                         -*-c++-*-
+#ifndef __INCLUDED_MDLOG_ROTATINGFILEOBSERVER
+#define __INCLUDED_MDLOG_ROTATINGFILEOBSERVER
+
+#include <mdlog_fileobserver.h>
+#include <mdlog_record.h>
+#include <mdmem_allocator.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace MvdS {
+namespace mdlog {
+
+// ==========================
+// Class RotatingFileObserver
+// ==========================
+
+class RotatingFileObserver : public FileObserver
+{
+  // Provides an observer that writes the lines of the records to a file,
+  // and rotates the file when it grows too large or too old.
+  //
+  // Like 'FileObserver' every batch is written with as few 'writev' calls
+  // as possible. Used with a 'Logger', publishing, writing, rotating and
+  // syncing all happen on the background thread of the logger, so threads
+  // logging records never wait for the disk. A rotation renames the file
+  // 'path' to 'path.1', 'path.1' to 'path.2' and so on, keeping
+  // 'd_maximumFiles' rotated files, and starts a new file at 'path'.
+  // Rotation happens between records, so every line is in one file. The
+  // data is synced to disk according to the sync policy.
+
+public:
+  // PUBLIC TYPES
+
+  enum SyncPolicy
+  {
+    e_never,      // Leave it to the kernel.
+    e_everyFlush, // 'fdatasync' after every batch.
+    e_periodic    // 'fdatasync' after a batch once per 'd_syncInterval'.
+  };
+
+  struct Configuration
+  {
+    // The limits are checked before every record, 0 means no limit.
+
+    size_t                    d_maximumSize  = 0; // Bytes per file.
+    std::chrono::seconds      d_maximumAge   = std::chrono::seconds(0);
+    size_t                    d_maximumFiles = 5; // Rotated, at least 1.
+    SyncPolicy                d_syncPolicy   = e_never;
+    std::chrono::milliseconds d_syncInterval = std::chrono::seconds(1);
+  };
+
+private:
+  // DATA
+
+  std::string                           d_path;
+  Configuration                         d_config;
+  uint64_t                              d_size;     // Of the current file.
+  Record::time_point                    d_openTime; // Of the current file.
+  std::chrono::steady_clock::time_point d_syncTime; // Of the last sync.
+  uint64_t                              d_rotationCount;
+  uint64_t                              d_syncCount;
+
+  // PRIVATE MANIPULATORS
+
+  void sync(bool force);
+  // Sync the file according to the sync policy, or if the specified 'force'
+  // is true and the policy is not 'e_never'.
+
+public:
+  // CREATORS
+
+  explicit RotatingFileObserver(const char *      path,
+                                mdmem::Allocator *allocator = 0);
+  // Create an observer for the file with the specified 'path' with the
+  // default configuration, which does not rotate. 'open' must be called
+  // before records are written. Optionally the specified 'allocator' is used
+  // for memory allocation.
+
+  RotatingFileObserver(const char *         path,
+                       const Configuration &config,
+                       mdmem::Allocator *   allocator = 0);
+  // Create an observer for the file with the specified 'path' with the
+  // specified 'config'. 'open' must be called before records are written.
+  // Optionally the specified 'allocator' is used for memory allocation.
+
+  virtual ~RotatingFileObserver();
+  // Close the file.
+
+  // MANIPULATORS
+
+  int open();
+  // Open the file, appending to it if it exists. Return 0 on success or a
+  // negative 'errno' value.
+
+  void close();
+  // Sync according to the sync policy and close the file.
+
+  int rotate();
+  // Write the pending output and rotate the file now. Return 0 on success
+  // or a negative 'errno' value; if the new file cannot be opened, output
+  // is dropped until the next successful rotation or 'open'.
+
+  virtual void publish(const Record &record);
+  // Add the text of the specified 'record' and a newline to the pending
+  // output, rotating the file first if the record would exceed the maximum
+  // size or is past the maximum age of the file.
+
+  virtual void flush();
+  // Write the pending output and sync according to the sync policy.
+
+  // ACCESSORS
+
+  const std::string &path() const
+  // Return the path of the current file.
+  {
+    return d_path;
+  }
+
+  uint64_t size() const
+  // Return the number of bytes in the current file, including the pending
+  // output.
+  {
+    return d_size;
+  }
+
+  uint64_t rotationCount() const
+  // Return the number of rotations so far.
+  {
+    return d_rotationCount;
+  }
+
+  uint64_t syncCount() const
+  // Return the number of syncs so far.
+  {
+    return d_syncCount;
+  }
+
+  const Configuration &configuration() const
+  // Return the configuration.
+  {
+    return d_config;
+  }
+};
+
+} // namespace mdlog
+} // namespace MvdS
+
+#endif // __INCLUDED_MDLOG_ROTATINGFILEOBSERVER
@@ -0,0 +1,238 @@
+// mdlog_rotatingfileobserver.t.cpp                                     -*-c++-*-
+#include <mdlog_rotatingfileobserver.h>
+
+#include <mdlog_logger.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdlog;
+
+typedef RotatingFileObserver Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+struct TemporaryDirectory {
+  std::string d_path;
+
+  TemporaryDirectory()
+    : d_path("/tmp/mdlog_rotatingfileobserver.XXXXXX")
+  {
+    ASSERT(mkdtemp(&d_path[0]));
+  }
+
+  ~TemporaryDirectory()
+  {
+    for (int i = 0; i < 10; ++i) {
+      unlink(file(i).c_str());
+    }
+    rmdir(d_path.c_str());
+  }
+
+  std::string file(int index) const
+  {
+    // Return the path of the log file, or of the rotated file 'index'.
+    return d_path + "/log" + (index ? '.' + std::to_string(index) : "");
+  }
+
+  std::string contents(int index) const
+  {
+    std::ifstream     stream(file(index));
+    std::stringstream result;
+    result << stream.rdbuf();
+    return result.str();
+  }
+};
+
+void publishLine(Obj                       *o,
+		 const std::string&         text,
+		 const Record::time_point&  time = Record::time_point())
+{
+  Record record(Level::e_info, time);
+  record.buffers().append(text.data(), text.size());
+  o->publish(record);
+  o->flush();
+}
+
+int main(int argc, char *argv[])
+{
+
+  int  testcase        = (argc > 1 ? std::atoi(argv[1]) : 0);
+  bool verbose         = argc > 1;
+  bool veryVerbose     = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 4:
+    {
+      // Used by a logger, the lines of all threads end up in the files.
+      TemporaryDirectory directory;
+      {
+	Obj::Configuration config;
+	config.d_maximumSize  = 4096;
+	config.d_maximumFiles = 9;
+
+	Obj o(directory.file(0).c_str(), config);
+	ASSERT(0 == o.open());
+
+	Logger logger;
+	logger.addObserver(&o);
+	logger.start();
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+	  threads.emplace_back([&logger, t]() {
+	      for (int i = 0; i < 100; ++i) {
+		RecordStream stream(Level::e_info, "test", &logger);
+		stream.stream() << t << ' ' << i;
+	      }
+	    });
+	}
+	for (auto& thread : threads) {
+	  thread.join();
+	}
+	logger.stop();
+	ASSERT(0 < o.rotationCount());
+      }
+
+      size_t lines = 0;
+      for (int i = 0; i < 10; ++i) {
+	const std::string text = directory.contents(i);
+	ASSERT(text.size() <= 4096);
+	lines += std::count(text.begin(), text.end(), '\n');
+      }
+      ASSERT(400 == lines);
+    } break;
+
+  case 3:
+    {
+      // Syncing follows the policy.
+      TemporaryDirectory directory;
+      Obj::Configuration config;
+      {
+	Obj o(directory.file(0).c_str(), config);
+	ASSERT(0 == o.open());
+	publishLine(&o, "never");
+	o.close();
+	ASSERT(0 == o.syncCount());
+      }
+
+      config.d_syncPolicy = Obj::e_everyFlush;
+      {
+	Obj o(directory.file(0).c_str(), config);
+	ASSERT(0 == o.open());
+	publishLine(&o, "one");
+	publishLine(&o, "two");
+	ASSERT(2 == o.syncCount());
+      }
+
+      config.d_syncPolicy   = Obj::e_periodic;
+      config.d_syncInterval = std::chrono::hours(1);
+      {
+	Obj o(directory.file(0).c_str(), config);
+	ASSERT(0 == o.open());
+	publishLine(&o, "three");
+	publishLine(&o, "four");
+	ASSERT(0 == o.syncCount());
+
+	// Rotating and closing always sync.
+	ASSERT(0 == o.rotate());
+	ASSERT(1 == o.syncCount());
+	o.close();
+	ASSERT(2 == o.syncCount());
+      }
+      ASSERT("never\none\ntwo\nthree\nfour\n" == directory.contents(1));
+    } break;
+
+  case 2:
+    {
+      // Rotation by age of the file, measured by the record time.
+      TemporaryDirectory directory;
+      Obj::Configuration config;
+      config.d_maximumAge = std::chrono::seconds(60);
+
+      Obj o(directory.file(0).c_str(), config);
+      ASSERT(0 == o.open());
+
+      const Record::time_point now = std::chrono::system_clock::now();
+      publishLine(&o, "first", now);
+      publishLine(&o, "second", now + std::chrono::seconds(59));
+      ASSERT(0 == o.rotationCount());
+      publishLine(&o, "third", now + std::chrono::seconds(61));
+      ASSERT(1 == o.rotationCount());
+
+      ASSERT("first\nsecond\n" == directory.contents(1));
+      ASSERT("third\n" == directory.contents(0));
+    } break;
+
+  case 1:
+    {
+      // Breathing test: rotation by size keeps the configured number of
+      // files and never splits a line.
+      TemporaryDirectory directory;
+      Obj::Configuration config;
+      config.d_maximumSize  = 20;
+      config.d_maximumFiles = 2;
+
+      {
+	Obj o(directory.file(0).c_str(), config);
+	ASSERT(directory.file(0) == o.path());
+	ASSERT(0 == o.open());
+
+	publishLine(&o, "line 1"); // 7 bytes each with the newline.
+	publishLine(&o, "line 2");
+	ASSERT(14 == o.size());
+	publishLine(&o, "line 3");
+	ASSERT(1 == o.rotationCount());
+	ASSERT(7 == o.size());
+	publishLine(&o, "line 4");
+	publishLine(&o, "line 5");
+	publishLine(&o, "line 6");
+	publishLine(&o, "line 7");
+
+	// Lines longer than the limit get a file of their own.
+	publishLine(&o, std::string(30, 'x'));
+	ASSERT(4 == o.rotationCount());
+      }
+
+      ASSERT(std::string(30, 'x') + '\n' == directory.contents(0));
+      ASSERT("line 7\n" == directory.contents(1));
+      ASSERT("line 5\nline 6\n" == directory.contents(2));
+      ASSERT("" == directory.contents(3));
+
+      // An existing file is appended to.
+      Obj o(directory.file(0).c_str(), config);
+      ASSERT(0 == o.open());
+      ASSERT(31 == o.size());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,382 @@
+// mdmem_epochmanager.cpp                                               -*-c++-*-
+#include <mdmem_epochmanager.h>
+
+#include <mdmem_threadregistry.h>
+
+#include <new>
+
+namespace MvdS {
+namespace mdmem {
+
+// ------------------
+// Class EpochManager
+// ------------------
+
+// PRIVATE TYPES
+
+struct EpochManager::Retired
+{
+  // Limbo list entry of a retired object.
+
+  void *   d_object_p;
+  Deleter  d_deleter;
+  void *   d_context_p;
+  Retired *d_next;
+};
+
+struct EpochManager::ThreadRecord
+{
+  // Epoch state of one thread.
+
+  alignas(64) std::atomic<uint64_t> d_localEpoch;
+  // Epoch observed when the current critical section was entered.
+
+  std::atomic<bool> d_active;
+  // True while the owning thread is inside a critical section.
+
+  unsigned d_nesting;
+  // Critical section nesting depth, only touched by the owning thread.
+
+  Retired *d_limbo[k_bucketCount];
+  uint64_t d_limboEpoch[k_bucketCount];
+  // Retired objects by epoch, only touched by the owning thread.
+
+  size_t d_retiredCount;
+  // Retirements since the last reclamation attempt.
+
+  bool d_inUse;
+  // True while owned by a live thread. Protected by the manager mutex.
+
+  ThreadRecord *d_next;
+  // Next record of the manager.
+
+  ThreadRecord()
+      : d_localEpoch(0)
+      , d_active(false)
+      , d_nesting(0)
+      , d_limbo()
+      , d_limboEpoch()
+      , d_retiredCount(0)
+      , d_inUse(false)
+      , d_next(nullptr)
+  {}
+};
+
+// PRIVATE CLASS METHODS
+
+void EpochManager::threadExit(void *owner, void *slot)
+{
+  EpochManager *manager = static_cast<EpochManager *>(owner);
+  ThreadRecord *record  = static_cast<ThreadRecord *>(slot);
+
+  record->d_nesting = 0;
+  record->d_active.store(false, std::memory_order_release);
+
+  std::lock_guard<std::mutex> lk(manager->d_mutex);
+  record->d_inUse = false;
+}
+
+// PRIVATE MANIPULATORS
+
+EpochManager::ThreadRecord *EpochManager::localRecord()
+{
+  void *slot = ThreadRegistry::lookup(d_ownerId);
+  if (slot) {
+    return static_cast<ThreadRecord *>(slot);
+  }
+
+  ThreadRecord *record = nullptr;
+
+  {
+    // Adopt the record, and the limbo lists, of a thread that has exited.
+    std::lock_guard<std::mutex> lk(d_mutex);
+    for (ThreadRecord *r = d_records.load(std::memory_order_relaxed); r;
+         r               = r->d_next) {
+      if (!r->d_inUse) {
+        r->d_inUse = true;
+        record     = r;
+        break;
+      }
+    }
+
+    if (!record) {
+      void *memory =
+          d_allocator_p->allocate(sizeof(ThreadRecord), alignof(ThreadRecord));
+      record          = new (memory) ThreadRecord();
+      record->d_inUse = true;
+      record->d_next  = d_records.load(std::memory_order_relaxed);
+      d_records.store(record, std::memory_order_release);
+    }
+  }
+
+  if (!ThreadRegistry::insert(d_ownerId, this, record, &threadExit)) {
+    std::lock_guard<std::mutex> lk(d_mutex);
+    record->d_inUse = false;
+    return nullptr;
+  }
+
+  return record;
+}
+
+void EpochManager::reclaim(ThreadRecord *record, uint64_t epoch)
+{
+  for (size_t bucket = 0; bucket < k_bucketCount; ++bucket) {
+    if (record->d_limbo[bucket] && record->d_limboEpoch[bucket] + 2 <= epoch) {
+      freeBucket(record, bucket);
+    }
+  }
+
+  reclaimShared(epoch);
+}
+
+void EpochManager::reclaimShared(uint64_t epoch)
+{
+  if (0 == d_sharedCount.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  // Deleters run without the mutex, they may retire objects themselves.
+  Retired *expired = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(d_mutex);
+    for (size_t bucket = 0; bucket < k_bucketCount; ++bucket) {
+      Retired *list = d_shared_p->d_limbo[bucket];
+      if (!list || epoch < d_shared_p->d_limboEpoch[bucket] + 2) {
+        continue;
+      }
+
+      d_shared_p->d_limbo[bucket] = nullptr;
+      Retired *tail               = list;
+      while (tail->d_next) {
+        tail = tail->d_next;
+      }
+      tail->d_next = expired;
+      expired      = list;
+    }
+  }
+
+  d_sharedCount.fetch_sub(freeList(expired), std::memory_order_relaxed);
+}
+
+void EpochManager::retireShared(Retired *retired)
+{
+  Retired *expired;
+  {
+    std::lock_guard<std::mutex> lk(d_mutex);
+    expired = addRetired(d_shared_p, retired);
+    d_sharedCount.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  d_sharedCount.fetch_sub(freeList(expired), std::memory_order_relaxed);
+}
+
+EpochManager::Retired *EpochManager::addRetired(ThreadRecord *record,
+                                                Retired *     retired)
+{
+  // The object is unlinked, so any thread that enters from now on observes
+  // at least this epoch.
+  const uint64_t epoch   = d_epoch.load();
+  const size_t   bucket  = epoch % k_bucketCount;
+  Retired *      expired = nullptr;
+
+  if (record->d_limbo[bucket] && record->d_limboEpoch[bucket] != epoch) {
+    // The bucket holds objects retired at least three epochs ago.
+    expired                 = record->d_limbo[bucket];
+    record->d_limbo[bucket] = nullptr;
+  }
+
+  retired->d_next              = record->d_limbo[bucket];
+  record->d_limbo[bucket]      = retired;
+  record->d_limboEpoch[bucket] = epoch;
+  d_pendingCount.fetch_add(1, std::memory_order_relaxed);
+
+  return expired;
+}
+
+void EpochManager::freeBucket(ThreadRecord *record, size_t bucket)
+{
+  // Detach the list first, deleters may retire objects themselves.
+  Retired *retired        = record->d_limbo[bucket];
+  record->d_limbo[bucket] = nullptr;
+
+  freeList(retired);
+}
+
+size_t EpochManager::freeList(Retired *retired)
+{
+  size_t count = 0;
+  while (retired) {
+    Retired *const next = retired->d_next;
+    retired->d_deleter(retired->d_object_p, retired->d_context_p);
+    d_allocator_p->deallocate(retired, sizeof(Retired), alignof(Retired));
+    retired = next;
+    ++count;
+  }
+
+  d_pendingCount.fetch_sub(count, std::memory_order_relaxed);
+  return count;
+}
+
+// CREATORS
+
+EpochManager::EpochManager(Allocator *allocator)
+    : EpochManager(Configuration(), allocator)
+{}
+
+EpochManager::EpochManager(const Configuration &config, Allocator *allocator)
+    : d_config(config)
+    , d_epoch(0)
+    , d_ownerId(ThreadRegistry::registerOwner())
+    , d_records(nullptr)
+    , d_shared_p(nullptr)
+    , d_sharedCount(0)
+    , d_exitingCount(0)
+    , d_pendingCount(0)
+    , d_allocator_p(AllocatorUtil::defaultAllocator(allocator))
+{
+  if (0 == d_config.d_reclaimThreshold) {
+    d_config.d_reclaimThreshold = 1;
+  }
+
+  d_shared_p = new (d_allocator_p->allocate(sizeof(ThreadRecord),
+                                            alignof(ThreadRecord)))
+      ThreadRecord();
+}
+
+EpochManager::~EpochManager()
+{
+  ThreadRegistry::deregisterOwner(d_ownerId);
+  ThreadRegistry::remove(d_ownerId);
+
+  ThreadRecord *record = d_records.load(std::memory_order_acquire);
+  while (record) {
+    ThreadRecord *const next = record->d_next;
+    for (size_t bucket = 0; bucket < k_bucketCount; ++bucket) {
+      freeBucket(record, bucket);
+    }
+    record->~ThreadRecord();
+    d_allocator_p->deallocate(record, sizeof(ThreadRecord), alignof(ThreadRecord));
+    record = next;
+  }
+
+  for (size_t bucket = 0; bucket < k_bucketCount; ++bucket) {
+    freeBucket(d_shared_p, bucket);
+  }
+  d_shared_p->~ThreadRecord();
+  d_allocator_p->deallocate(d_shared_p, sizeof(ThreadRecord), alignof(ThreadRecord));
+}
+
+// MANIPULATORS
+
+void EpochManager::enter()
+{
+  ThreadRecord *record = localRecord();
+
+  if (!record) {
+    // An exiting thread keeps the epoch from advancing instead.
+    d_exitingCount.fetch_add(1);
+    return;
+  }
+
+  if (0 != record->d_nesting++) {
+    return;
+  }
+
+  // Announce the critical section before publishing the epoch, and retry
+  // until the published epoch is current, so that 'tryAdvance' either sees
+  // this thread as inactive or sees the epoch it works in.
+  record->d_active.store(true);
+
+  uint64_t epoch = d_epoch.load();
+  while (true) {
+    record->d_localEpoch.store(epoch);
+    const uint64_t current = d_epoch.load();
+    if (current == epoch) {
+      break;
+    }
+    epoch = current;
+  }
+}
+
+void EpochManager::leave()
+{
+  ThreadRecord *record = static_cast<ThreadRecord *>(
+      ThreadRegistry::lookup(d_ownerId));
+
+  if (!record) {
+    d_exitingCount.fetch_sub(1);
+    return;
+  }
+
+  if (0 == --record->d_nesting) {
+    record->d_active.store(false, std::memory_order_release);
+  }
+}
+
+void EpochManager::retire(void *object, Deleter deleter, void *context)
+{
+  ThreadRecord *record = localRecord();
+
+  Retired *retired = static_cast<Retired *>(
+      d_allocator_p->allocate(sizeof(Retired), alignof(Retired)));
+  retired->d_object_p  = object;
+  retired->d_deleter   = deleter;
+  retired->d_context_p = context;
+
+  if (!record) {
+    retireShared(retired);
+    tryAdvance();
+    reclaimShared(d_epoch.load());
+    return;
+  }
+
+  freeList(addRetired(record, retired));
+
+  if (++record->d_retiredCount >= d_config.d_reclaimThreshold) {
+    record->d_retiredCount = 0;
+    tryAdvance();
+    reclaim(record, d_epoch.load());
+  }
+}
+
+void EpochManager::quiescent()
+{
+  ThreadRecord *record = localRecord();
+  if (!record || 0 != record->d_nesting) {
+    return;
+  }
+
+  bool pending = 0 != d_sharedCount.load(std::memory_order_relaxed);
+  for (size_t bucket = 0; bucket < k_bucketCount; ++bucket) {
+    pending = pending || record->d_limbo[bucket];
+  }
+
+  if (!pending) {
+    return;
+  }
+
+  record->d_retiredCount = 0;
+  tryAdvance();
+  reclaim(record, d_epoch.load());
+}
+
+bool EpochManager::tryAdvance()
+{
+  uint64_t epoch = d_epoch.load();
+
+  if (0 != d_exitingCount.load()) {
+    return false;
+  }
+
+  for (ThreadRecord *record = d_records.load(std::memory_order_acquire); record;
+       record               = record->d_next) {
+    if (record->d_active.load() && record->d_localEpoch.load() != epoch) {
+      return false;
+    }
+  }
+
+  return d_epoch.compare_exchange_strong(epoch, epoch + 1);
+}
+
+} // namespace mdmem
+} // namespace MvdS
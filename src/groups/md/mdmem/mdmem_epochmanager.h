@@ -0,0 +1,261 @@
+// mdmem_epochmanager.h                                                 -*-c++-*-
+#ifndef __INCLUDED_MDMEM_EPOCHMANAGER
+#define __INCLUDED_MDMEM_EPOCHMANAGER
+
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace MvdS {
+namespace mdmem {
+
+// ==================
+// Class EpochManager
+// ==================
+
+class EpochManager
+{
+  // Provides epoch based reclamation of memory that is shared through
+  // lock-free data structures.
+  //
+  // Readers access shared objects between 'enter' and 'leave' (or within
+  // the scope of a 'Guard'). A writer that unlinks an object hands it to
+  // 'retire' instead of destroying it. Retired objects are kept on a limbo
+  // list of the retiring thread, tagged with the global epoch, and are only
+  // destroyed once the global epoch has advanced twice: at that point no
+  // thread can still be inside a critical section that started before the
+  // object was unlinked. The global epoch only advances when every thread
+  // that is inside a critical section has observed the current epoch.
+  //
+  // Reclamation is batched: a thread tries to advance the epoch and frees
+  // its own expired limbo lists every 'd_reclaimThreshold' retirements, and
+  // on every call to 'quiescent'. Threads that hold no references between
+  // units of work, such as thread pool workers between jobs, should call
+  // 'quiescent' at those points. Limbo list entries are allocated from the
+  // allocator of the manager. Limbo lists of exited threads are picked up by
+  // the next thread that starts using the manager, or freed on destruction.
+  //
+  // A thread that is already exiting, e.g. running thread-local destructors,
+  // cannot get a record of its own. Its critical sections are counted in a
+  // shared counter that keeps the epoch from advancing, and objects it
+  // retires go to a shared limbo list protected by a mutex, which is freed
+  // by 'quiescent' and reclamation attempts of other threads.
+
+public:
+  // PUBLIC TYPES
+
+  typedef void (*Deleter)(void *object, void *context);
+  // Function that destroys a retired 'object'. The 'context' is the value
+  // passed to 'retire'.
+
+  struct Configuration
+  {
+    size_t d_reclaimThreshold; // Retirements between reclamation attempts.
+
+    Configuration()
+        : d_reclaimThreshold(64)
+    {}
+  };
+
+  class Guard;
+
+private:
+  // PRIVATE TYPES
+
+  struct Retired;
+  struct ThreadRecord;
+
+  enum
+  {
+    k_bucketCount = 3 // Limbo lists per thread, one per live epoch.
+  };
+
+  // DATA
+
+  Configuration               d_config;
+  std::atomic<uint64_t>       d_epoch;        // Global epoch.
+  uint64_t                    d_ownerId;      // Id in the 'ThreadRegistry'.
+  std::mutex                  d_mutex;        // Protects adoption of records
+                                              // and 'd_shared_p'.
+  std::atomic<ThreadRecord *> d_records;      // All records, never removed.
+  ThreadRecord *              d_shared_p;     // Limbo of exiting threads.
+  std::atomic<size_t>         d_sharedCount;  // Objects on 'd_shared_p'.
+  std::atomic<size_t>         d_exitingCount; // Critical sections of exiting
+                                              // threads.
+  std::atomic<size_t>         d_pendingCount;
+  mdmem::Allocator *          d_allocator_p;
+
+  // PRIVATE CLASS METHODS
+
+  static void threadExit(void *owner, void *slot);
+
+  // PRIVATE MANIPULATORS
+
+  ThreadRecord *localRecord();
+  // Return the record of the calling thread, creating or adopting one if
+  // needed. Return null if the thread is exiting.
+
+  void reclaim(ThreadRecord *record, uint64_t epoch);
+  // Free the limbo lists of the specified 'record', and the shared limbo
+  // lists, that expired in the specified global 'epoch'.
+
+  void reclaimShared(uint64_t epoch);
+  // Free the shared limbo lists that expired in the specified global
+  // 'epoch'.
+
+  void retireShared(Retired *retired);
+  // Add the specified 'retired' entry of an exiting thread to the shared
+  // limbo lists.
+
+  Retired *addRetired(ThreadRecord *record, Retired *retired);
+  // Add the specified 'retired' entry to the limbo list of the current
+  // epoch of the specified 'record'. Return the expired list the entry's
+  // bucket held before, to be freed by the caller, or null.
+
+  void freeBucket(ThreadRecord *record, size_t bucket);
+  // Destroy all objects on the specified 'bucket' of the specified
+  // 'record'.
+
+  size_t freeList(Retired *retired);
+  // Destroy all objects on the specified 'retired' list and return their
+  // number.
+
+  template <class TYPE>
+  static void deleteObject(void *object, void *allocator);
+
+public:
+  EpochManager(const EpochManager &) = delete;
+  EpochManager &operator=(const EpochManager &) = delete;
+
+  // CREATORS
+
+  explicit EpochManager(Allocator *allocator = 0);
+  // Create an epoch manager using the default configuration. Optionally
+  // the specified 'allocator' is used for memory allocation.
+
+  explicit EpochManager(const Configuration &config, Allocator *allocator = 0);
+  // Create an epoch manager with the specified 'config'. Optionally the
+  // specified 'allocator' is used for memory allocation.
+
+  ~EpochManager();
+  // Destroy the manager and all objects that are still retired. Behavior is
+  // undefined if a thread is inside a critical section.
+
+  // MANIPULATORS
+
+  void enter();
+  // Enter a critical section on the calling thread. Critical sections may
+  // be nested.
+
+  void leave();
+  // Leave the innermost critical section of the calling thread. Behavior is
+  // undefined unless the thread is inside a critical section.
+
+  void retire(void *object, Deleter deleter, void *context = nullptr);
+  // Retire the specified 'object', which must no longer be reachable for
+  // threads that enter a critical section from now on. The specified
+  // 'deleter' is invoked with 'object' and the optionally specified
+  // 'context' once no thread can hold a reference anymore.
+
+  template <class TYPE>
+  void retire(TYPE *object, Allocator *allocator);
+  // Retire the specified 'object' that was created in memory from the
+  // specified 'allocator'. The object is destroyed and its memory returned
+  // to 'allocator' once no thread can hold a reference anymore.
+
+  void quiescent();
+  // Announce that the calling thread holds no references to shared objects
+  // and give the manager a chance to advance the epoch and free expired
+  // objects of this thread. Has no effect inside a critical section.
+
+  bool tryAdvance();
+  // Advance the global epoch if all threads inside a critical section have
+  // observed the current epoch. Return true on success.
+
+  // ACCESSORS
+
+  uint64_t epoch() const;
+  // Return the current global epoch.
+
+  size_t pendingCount() const;
+  // Return the number of objects retired but not yet destroyed.
+};
+
+// =========================
+// Class EpochManager::Guard
+// =========================
+
+class EpochManager::Guard
+{
+  // Provides a scoped critical section of an 'EpochManager'.
+
+  EpochManager *d_manager_p;
+
+public:
+  Guard(const Guard &) = delete;
+  Guard &operator=(const Guard &) = delete;
+
+  // CREATORS
+
+  explicit Guard(EpochManager *manager)
+      // Enter a critical section of the specified 'manager'.
+      : d_manager_p(manager)
+  {
+    d_manager_p->enter();
+  }
+
+  ~Guard()
+  // Leave the critical section.
+  {
+    d_manager_p->leave();
+  }
+};
+
+// ============================================================================
+//                            INLINE DEFINITIONS
+// ============================================================================
+
+// ------------------
+// Class EpochManager
+// ------------------
+
+// PRIVATE CLASS METHODS
+
+template <class TYPE>
+void EpochManager::deleteObject(void *object, void *allocator)
+{
+  static_cast<TYPE *>(object)->~TYPE();
+  static_cast<Allocator *>(allocator)->deallocate(
+      object, sizeof(TYPE), alignof(TYPE));
+}
+
+// MANIPULATORS
+
+template <class TYPE>
+void EpochManager::retire(TYPE *object, Allocator *allocator)
+{
+  retire(object,
+         &deleteObject<TYPE>,
+         AllocatorUtil::defaultAllocator(allocator));
+}
+
+// ACCESSORS
+
+inline uint64_t EpochManager::epoch() const
+{
+  return d_epoch.load(std::memory_order_acquire);
+}
+
+inline size_t EpochManager::pendingCount() const
+{
+  return d_pendingCount.load(std::memory_order_relaxed);
+}
+
+} // namespace mdmem
+} // namespace MvdS
+
+#endif // __INCLUDED_MDMEM_EPOCHMANAGER
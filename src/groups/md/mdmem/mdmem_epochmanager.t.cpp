@@ -0,0 +1,324 @@
+// mdmem_epochmanager.t.cpp                                             -*-c++-*-
+#include <mdmem_epochmanager.h>
+
+#include <mdmem_testallocator.h>
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdmem;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+struct Node
+{
+  static std::atomic<int> s_destroyed;
+
+  enum { k_alive = 0x600d, k_dead = 0xdead };
+
+  int d_magic;
+  int d_value;
+
+  explicit Node(int value)
+      : d_magic(k_alive)
+      , d_value(value)
+  {}
+
+  ~Node()
+  {
+    d_magic = k_dead;
+    ++s_destroyed;
+  }
+};
+
+std::atomic<int> Node::s_destroyed(0);
+
+void countDeleter(void *object, void *context)
+{
+  (void)object;
+  ++*static_cast<int *>(context);
+}
+
+struct ExitRetirer
+{
+  // Retires an object from a thread-local destructor, which runs after the
+  // thread registry of the thread is gone if constructed before its first
+  // use.
+
+  static EpochManager *s_manager;
+  static int           s_deleted;
+  static bool          s_blocked;
+
+  int d_object;
+
+  ~ExitRetirer()
+  {
+    EpochManager::Guard guard(s_manager);
+    s_blocked = !s_manager->tryAdvance();
+    s_manager->retire(&d_object, &countDeleter, &s_deleted);
+  }
+};
+
+EpochManager *ExitRetirer::s_manager = nullptr;
+int           ExitRetirer::s_deleted = 0;
+bool          ExitRetirer::s_blocked = false;
+
+int main(int argc, char *argv[])
+{
+
+  int testcase = (argc > 1?std::atoi(argv[1]):0);
+
+  bool verbose = argc > 1;
+  bool veryVerbose = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 5:
+    {
+      // Exiting threads have no record: their critical sections block the
+      // epoch and their retired objects go to the shared limbo list.
+      TestAllocator ta;
+
+      {
+	EpochManager em(&ta);
+	ExitRetirer::s_manager = &em;
+
+	std::thread([&]() {
+	    thread_local ExitRetirer retirer;
+	    (void)retirer;
+	    em.enter();
+	    em.leave();
+	  }).join();
+
+	ASSERT(ExitRetirer::s_blocked);
+	ASSERT(1 == em.pendingCount());
+
+	for (int i = 0; i < 3 && 0 == ExitRetirer::s_deleted; ++i) {
+	  em.tryAdvance();
+	  em.quiescent();
+	}
+	ASSERT(1 == ExitRetirer::s_deleted);
+	ASSERT(0 == em.pendingCount());
+
+	// Objects still pending are freed with the manager.
+	std::thread([&]() {
+	    thread_local ExitRetirer retirer;
+	    (void)retirer;
+	    em.enter();
+	    em.leave();
+	  }).join();
+	ASSERT(1 == em.pendingCount());
+      }
+
+      ASSERT(2 == ExitRetirer::s_deleted);
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 4:
+    {
+      // Readers never observe a reclaimed node while writers keep replacing
+      // the shared pointer.
+      TestAllocator ta;
+      Node::s_destroyed = 0;
+
+      {
+	EpochManager::Configuration config;
+	config.d_reclaimThreshold = 8;
+	EpochManager em(config, &ta);
+
+	std::atomic<Node *> shared(
+	    new (ta.allocate(sizeof(Node), alignof(Node))) Node(0));
+	std::atomic<bool>   done(false);
+	std::atomic<size_t> corruptions(0);
+
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 3; ++t) {
+	  readers.emplace_back([&]() {
+	      while (!done) {
+		EpochManager::Guard guard(&em);
+		Node *node = shared.load(std::memory_order_acquire);
+		std::this_thread::yield();
+		if (Node::k_alive != node->d_magic) {
+		  ++corruptions;
+		}
+	      }
+	      em.quiescent();
+	    });
+	}
+
+	std::vector<std::thread> writers;
+	for (int t = 0; t < 2; ++t) {
+	  writers.emplace_back([&]() {
+	      for (int i = 1; i <= 5000; ++i) {
+		Node *node = new (ta.allocate(sizeof(Node), alignof(Node))) Node(i);
+		Node *old  = shared.exchange(node, std::memory_order_acq_rel);
+		em.retire(old, &ta);
+		if (0 == i % 64) {
+		  em.quiescent();
+		  std::this_thread::yield();
+		}
+	      }
+	    });
+	}
+
+	for (auto& thread : writers) {
+	  thread.join();
+	}
+	done = true;
+	for (auto& thread : readers) {
+	  thread.join();
+	}
+
+	ASSERT(0 == corruptions);
+
+	em.retire(shared.load(), &ta);
+      }
+
+      ASSERT(10001 == Node::s_destroyed);
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 3:
+    {
+      // Limbo lists of an exited thread are adopted by the next thread.
+      TestAllocator ta;
+      int           deleted = 0;
+      int           objects[10];
+
+      {
+	EpochManager em(&ta);
+
+	std::thread([&]() {
+	    for (int i = 0; i < 10; ++i) {
+	      em.retire(objects + i, &countDeleter, &deleted);
+	    }
+	  }).join();
+
+	ASSERT(10 == em.pendingCount());
+	ASSERT(0 == deleted);
+
+	std::thread([&]() {
+	    for (int i = 0; i < 3; ++i) {
+	      em.tryAdvance();
+	      em.quiescent();
+	    }
+	  }).join();
+
+	ASSERT(10 == deleted);
+	ASSERT(0 == em.pendingCount());
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 2:
+    {
+      // A thread inside a critical section blocks reclamation.
+      int deleted = 0;
+      EpochManager em;
+
+      std::atomic<int> state(0);
+      std::thread reader([&]() {
+	  em.enter();
+	  state = 1;
+	  while (2 != state) {
+	    std::this_thread::yield();
+	  }
+	  em.leave();
+	  state = 3;
+	});
+
+      while (1 != state) {
+	std::this_thread::yield();
+      }
+
+      em.retire(&deleted, &countDeleter, &deleted);
+      for (int i = 0; i < 10; ++i) {
+	em.quiescent();
+      }
+      ASSERT(0 == deleted);
+      ASSERT(1 == em.pendingCount());
+
+      state = 2;
+      while (3 != state) {
+	std::this_thread::yield();
+      }
+
+      for (int i = 0; i < 3; ++i) {
+	em.quiescent();
+      }
+      ASSERT(1 == deleted);
+
+      reader.join();
+    } break;
+
+  case 1:
+    {
+      // Retired objects are destroyed after two epochs, with their memory
+      // returned to the allocator.
+      TestAllocator ta;
+      Node::s_destroyed = 0;
+
+      {
+	EpochManager em(&ta);
+	ASSERT(0 == em.epoch());
+
+	Node *node = new (ta.allocate(sizeof(Node), alignof(Node))) Node(1);
+	{
+	  EpochManager::Guard guard(&em);
+	  ASSERT(1 == node->d_value);
+	}
+
+	em.retire(node, &ta);
+	ASSERT(1 == em.pendingCount());
+	ASSERT(0 == Node::s_destroyed);
+
+	em.quiescent();
+	ASSERT(1 == em.epoch());
+	ASSERT(0 == Node::s_destroyed);
+
+	em.quiescent();
+	ASSERT(2 == em.epoch());
+	ASSERT(1 == Node::s_destroyed);
+	ASSERT(0 == em.pendingCount());
+
+	// A thread inside a critical section lets the epoch advance once.
+	em.enter();
+	em.enter();
+	em.leave();
+	ASSERT(em.tryAdvance());
+	ASSERT(!em.tryAdvance());
+	em.leave();
+	ASSERT(em.tryAdvance());
+
+	em.retire(new (ta.allocate(sizeof(Node), alignof(Node))) Node(2), &ta);
+      }
+
+      ASSERT(2 == Node::s_destroyed);
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
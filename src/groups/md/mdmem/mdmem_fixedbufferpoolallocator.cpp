@@ -0,0 +1,2 @@
+// mdmem_fixedbufferpoolallocator.cpp                                   -*-c++-*-
+#include <mdmem_fixedbufferpoolallocator.h>
@@ -1,4 +1,4 @@
-// mdmem_fixedbufferpoolallocator.h                                                -*-c++-*-
+// mdmem_fixedbufferpoolallocator.h                                     -*-c++-*-
 #ifndef __INCLUDED_MDMEM_FIXEDBUFFERPOOLALLOCATOR
 #define __INCLUDED_MDMEM_FIXEDBUFFERPOOLALLOCATOR
 
@@ -6,6 +6,9 @@
 #include <mdmem_allocatorutil.h>
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
 
 namespace MvdS {
   namespace mdmem {
@@ -15,59 +18,100 @@ namespace MvdS {
       // which it uses to allocate from. If the allocation request is larger
       // than the size of the buffers or there are no free buffers in the pool
       // the provided backing allocator is used instead.
+      //
+      // The pool is a bounded lock-free multi-producer/multi-consumer queue of
+      // free buffers. Each cell carries a sequence number that tells whether
+      // it is ready to be written or read for the current lap, so pushing and
+      // popping only contend on a single compare-and-swap.
+
+      // PRIVATE TYPES
+      struct Cell {
+	std::atomic<size_t>  d_sequence;
+	void                *d_buffer;
+      };
 
       // DATA
-      std::pmr::vector<void *>  d_pool;
+      Cell                     *d_pool;
+      size_t                    d_poolSize;
       size_t                    d_bufferSize;
       size_t                    d_alignment;
-      std::atomic<size_t>       d_head;
-      std::atomic<int>          d_rCount, d_wCount;
       size_t                    d_sizeMask;
-      mdmem::Allocator           *d_allocator_p;
+      std::atomic<size_t>       d_head;
+      std::atomic<size_t>       d_tail;
+      mdmem::Allocator         *d_allocator_p;
+
+      // PRIVATE CLASS METHODS
+      static size_t roundUpToPowerOfTwo(size_t value)
+      {
+	size_t result = 1;
+	while (result < value) {
+	  result <<= 1;
+	}
+	return result;
+      }
 
       // PRIVATE MANIPULATORS
       void *popBuffer()
       {
-	// Note that there is no guarranteed that 'popBuffer' works immediately
-	// after a 'pushBuffer', but we don't need that guarrantee here.
-	int prev = d_rCount.fetch_sub(1);
-	if (0 >= prev) {
-	  // Queue was empty, repair and return false.
-	  ++d_rCount;
-	  return nullptr;
+	size_t position = d_head.load(std::memory_order_relaxed);
+	Cell  *cell;
+
+	while (true) {
+	  cell = d_pool + (position & d_sizeMask);
+	  const size_t sequence = cell->d_sequence.load(std::memory_order_acquire);
+	  const intptr_t diff = static_cast<intptr_t>(sequence)
+	    - static_cast<intptr_t>(position + 1);
+
+	  if (0 == diff) {
+	    if (d_head.compare_exchange_weak(position,
+					     position + 1,
+					     std::memory_order_relaxed)) {
+	      break;
+	    }
+	  } else if (0 > diff) {
+	    // Pool is empty.
+	    return nullptr;
+	  } else {
+	    position = d_head.load(std::memory_order_relaxed);
+	  }
 	}
 
-	// If 'prev' > 0 we have reserved a pop index, so now we have all the
-	// time in the world to claim it.
-	
-	size_t index = d_head.fetch_add(1) & d_sizeMask;
-	void *result = d_pool[index];
-
-	// Modulo the head so we don't overflow it.
-	// TODO: optimize this by only do this when at 2*size or something like
-	// that.
-	d_head &= d_sizeMask;
-
-	// We load the index, so now we can release it for writing.
-	--d_wCount;
+	void *result = cell->d_buffer;
+	cell->d_sequence.store(position + d_sizeMask + 1,
+			       std::memory_order_release);
 	return result;
       }
 
       bool pushBuffer(void *buffer)
       {
-	int prev = d_wCount.fetch_add(1);
-	if (d_pool.size() <= prev) {
-	  // Queue was full, repair and return false.
-	  --d_wCount;
-	  return false;
+	size_t position = d_tail.load(std::memory_order_relaxed);
+	Cell  *cell;
+
+	while (true) {
+	  cell = d_pool + (position & d_sizeMask);
+	  const size_t sequence = cell->d_sequence.load(std::memory_order_acquire);
+	  const intptr_t diff = static_cast<intptr_t>(sequence)
+	    - static_cast<intptr_t>(position);
+
+	  if (0 == diff) {
+	    if (d_tail.compare_exchange_weak(position,
+					     position + 1,
+					     std::memory_order_relaxed)) {
+	      break;
+	    }
+	  } else if (0 > diff) {
+	    // Pool is full.
+	    return false;
+	  } else {
+	    position = d_tail.load(std::memory_order_relaxed);
+	  }
 	}
 
-	size_t index = (d_head.load() + prev) & d_sizeMask;
-	d_pool[index] = buffer;
-	++d_rCount;
+	cell->d_buffer = buffer;
+	cell->d_sequence.store(position + 1, std::memory_order_release);
 	return true;
       }
-      
+
       virtual void *do_allocate(std::size_t bytes, std::size_t alignment)
       {
 	void *result = (bytes == d_bufferSize
@@ -86,7 +130,7 @@ namespace MvdS {
       {
 	if (bytes != d_bufferSize
 	    || alignment != d_alignment
-	    || pushBuffer(p)) {
+	    || !pushBuffer(p)) {
 	  d_allocator_p->deallocate(p, bytes, alignment);
 	}
       }
@@ -95,31 +139,88 @@ namespace MvdS {
       {
 	return this == &other;
       }
-      
+
     public:
 
+      FixedBufferPoolAllocator(const FixedBufferPoolAllocator&) = delete;
+      FixedBufferPoolAllocator& operator=(const FixedBufferPoolAllocator&) = delete;
+
       // CREATORS
 
-      // TODO: make poolSize always 2^i.
       FixedBufferPoolAllocator(size_t     poolSize,
 			       size_t     bufferSize,
-			       size_t     alignment,
+			       size_t     alignment = alignof(std::max_align_t),
 			       Allocator *allocator = 0)
-	// Create FixedBufferPool allocator that used the specified 'allocator' for
-	// memory allocation.
-	: d_pool(poolSize, allocator)
+	// Create FixedBufferPool allocator that keeps at most the specified
+	// 'poolSize' free buffers of the specified 'bufferSize' and
+	// 'alignment'. Note that 'poolSize' is rounded up to the next power of
+	// two. Optionally the specified 'allocator' is used for memory
+	// allocation.
+	: d_pool(nullptr)
+	, d_poolSize(roundUpToPowerOfTwo(poolSize))
 	, d_bufferSize(bufferSize)
 	, d_alignment(alignment)
+	, d_sizeMask(d_poolSize - 1)
+	, d_head(0)
+	, d_tail(0)
 	, d_allocator_p(AllocatorUtil::defaultAllocator(allocator))
       {
+	d_pool = reinterpret_cast<Cell *>(
+	    d_allocator_p->allocate(sizeof(Cell) * d_poolSize, alignof(Cell)));
+
+	for (size_t i = 0; i < d_poolSize; ++i) {
+	  new (d_pool + i) Cell();
+	  d_pool[i].d_sequence.store(i, std::memory_order_relaxed);
+	}
       }
 
       ~FixedBufferPoolAllocator()
+      // Destroy the allocator and return all pooled buffers to the backing
+      // allocator. Behavior is undefined if buffers allocated from this
+      // allocator are still in use.
+      {
+	void *buffer;
+	while (nullptr != (buffer = popBuffer())) {
+	  d_allocator_p->deallocate(buffer, d_bufferSize, d_alignment);
+	}
+
+	for (size_t i = 0; i < d_poolSize; ++i) {
+	  d_pool[i].~Cell();
+	}
+
+	d_allocator_p->deallocate(
+	    d_pool, sizeof(Cell) * d_poolSize, alignof(Cell));
+      }
+
+      // ACCESSORS
+
+      size_t poolSize() const
+      // Return the maximum number of free buffers kept by the pool.
+      {
+	return d_poolSize;
+      }
+
+      size_t bufferSize() const
+      // Return the size of the pooled buffers.
+      {
+	return d_bufferSize;
+      }
+
+      size_t alignment() const
+      // Return the alignment of the pooled buffers.
       {
+	return d_alignment;
       }
-      
-      // ACCESSORS      
-      
+
+      size_t available() const
+      // Return an estimate of the number of free buffers currently in the
+      // pool.
+      {
+	const size_t tail = d_tail.load(std::memory_order_relaxed);
+	const size_t head = d_head.load(std::memory_order_relaxed);
+	return (tail > head ? tail - head : 0);
+      }
+
     };
 
   }
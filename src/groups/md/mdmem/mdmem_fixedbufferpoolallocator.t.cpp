@@ -0,0 +1,154 @@
+// mdmem_fixedbufferpoolallocator.t.cpp                                 -*-c++-*-
+#include <mdmem_fixedbufferpoolallocator.h>
+
+#include <mdmem_testallocator.h>
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdmem;
+
+typedef FixedBufferPoolAllocator Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+int main(int argc, char *argv[])
+{
+
+  int testcase = (argc > 1?std::atoi(argv[1]):0);
+
+  bool verbose = argc > 1;
+  bool veryVerbose = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 4:
+    {
+      // Concurrent allocate/deallocate must never hand out the same buffer
+      // twice and must return every buffer to the backing allocator.
+      TestAllocator ta;
+
+      {
+	Obj o(64, 128, alignof(std::max_align_t), &ta);
+
+	std::vector<std::thread> threads;
+	std::atomic<size_t>      corruptions(0);
+
+	for (size_t t = 0; t < 4; ++t) {
+	  threads.emplace_back([&o, &corruptions, t]() {
+	      for (size_t i = 0; i < 20000; ++i) {
+		unsigned char *p = reinterpret_cast<unsigned char *>(o.allocate(128));
+		p[0] = static_cast<unsigned char>(t);
+		std::this_thread::yield();
+		if (p[0] != static_cast<unsigned char>(t)) {
+		  ++corruptions;
+		}
+		o.deallocate(p, 128);
+	      }
+	    });
+	}
+
+	for (auto& thread : threads) {
+	  thread.join();
+	}
+
+	ASSERT(0 == corruptions);
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+      ASSERT(ta.totalBytesAllocated() == ta.totalBytesDeallocated());
+    } break;
+
+  case 3:
+    {
+      // The pool keeps at most 'poolSize' buffers, surplus buffers go back
+      // to the backing allocator.
+      TestAllocator ta;
+
+      {
+	Obj o(2, 32, alignof(std::max_align_t), &ta);
+
+	void *a = o.allocate(32);
+	void *b = o.allocate(32);
+	void *c = o.allocate(32);
+	const size_t before = ta.deallocationCount();
+
+	o.deallocate(a, 32);
+	o.deallocate(b, 32);
+	ASSERT(before == ta.deallocationCount());
+	ASSERT(2 == o.available());
+
+	o.deallocate(c, 32);
+	ASSERT(before + 1 == ta.deallocationCount());
+	ASSERT(2 == o.available());
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 2:
+    {
+      // Buffers of the pooled size are recycled, other sizes are not.
+      TestAllocator ta;
+
+      {
+	Obj o(4, 64, alignof(std::max_align_t), &ta);
+	const size_t base = ta.allocationCount();
+
+	void *a = o.allocate(64);
+	ASSERT(base + 1 == ta.allocationCount());
+	o.deallocate(a, 64);
+	ASSERT(1 == o.available());
+
+	void *b = o.allocate(64);
+	ASSERT(a == b);
+	ASSERT(base + 1 == ta.allocationCount());
+	ASSERT(0 == o.available());
+	o.deallocate(b, 64);
+
+	void *c = o.allocate(100);
+	ASSERT(base + 2 == ta.allocationCount());
+	o.deallocate(c, 100);
+	ASSERT(1 == o.available());
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 1:
+    {
+      TestAllocator ta;
+
+      {
+	Obj o(5, 64, alignof(std::max_align_t), &ta);
+	ASSERT(8 == o.poolSize());
+	ASSERT(64 == o.bufferSize());
+	ASSERT(0 == o.available());
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,2 @@
+// mdmem_objectpool.cpp                                                 -*-c++-*-
+#include <mdmem_objectpool.h>
@@ -0,0 +1,438 @@
+// mdmem_objectpool.h                                                   -*-c++-*-
+#ifndef __INCLUDED_MDMEM_OBJECTPOOL
+#define __INCLUDED_MDMEM_OBJECTPOOL
+
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <utility>
+
+namespace MvdS {
+namespace mdmem {
+
+// ================
+// Class ObjectPool
+// ================
+
+template <class TYPE>
+class ObjectPool
+{
+  // Provides a fixed capacity pool of 'TYPE' objects that are handed out
+  // through RAII handles and recycled through a lock-free free list.
+  //
+  // By default only the storage is recycled: objects are constructed on
+  // 'acquire' and destroyed when their handle is released. A pool created
+  // with a 'Resetter' keeps released objects constructed instead and calls
+  // the resetter on them, so expensive constructors (reserved capacity, open
+  // resources) are paid once per slot. If all slots are in use objects are
+  // allocated from the backing allocator, similar to the
+  // 'FixedBufferPoolAllocator'. This class is thread-safe.
+
+public:
+  // PUBLIC TYPES
+
+  typedef std::function<void(TYPE *)> Resetter;
+  // Called on a released object before it is made available again.
+
+  class Handle;
+
+private:
+  // PRIVATE TYPES
+
+  enum : uint32_t
+  {
+    k_nil = 0xffffffff // End of the free list, or not a pooled object.
+  };
+
+  struct Slot
+  {
+    alignas(TYPE) unsigned char d_storage[sizeof(TYPE)];
+    std::atomic<uint32_t>       d_next;
+    bool                        d_constructed;
+
+    TYPE *object() { return reinterpret_cast<TYPE *>(d_storage); }
+  };
+
+  // DATA
+
+  Slot *                d_slots;
+  uint32_t              d_capacity;
+  std::atomic<uint64_t> d_freeHead;  // Tag in the upper, index in the lower
+                                     // 32 bits.
+  std::atomic<size_t>   d_available;
+  bool                  d_keepConstructed;
+  Resetter              d_resetter;
+  mdmem::Allocator *    d_allocator_p;
+
+  // PRIVATE MANIPULATORS
+
+  uint32_t popSlot()
+  {
+    uint64_t head = d_freeHead.load(std::memory_order_acquire);
+
+    while (true) {
+      const uint32_t index = static_cast<uint32_t>(head);
+      if (k_nil == index) {
+        return k_nil;
+      }
+
+      const uint64_t next = d_slots[index].d_next.load(std::memory_order_relaxed);
+      const uint64_t newHead = ((head >> 32) + 1) << 32 | next;
+
+      if (d_freeHead.compare_exchange_weak(
+              head, newHead, std::memory_order_acquire)) {
+        --d_available;
+        return index;
+      }
+    }
+  }
+
+  void pushSlot(uint32_t index)
+  {
+    uint64_t head = d_freeHead.load(std::memory_order_relaxed);
+
+    while (true) {
+      d_slots[index].d_next.store(static_cast<uint32_t>(head),
+                                  std::memory_order_relaxed);
+      const uint64_t newHead = ((head >> 32) + 1) << 32 | index;
+
+      if (d_freeHead.compare_exchange_weak(
+              head, newHead, std::memory_order_release)) {
+        ++d_available;
+        return;
+      }
+    }
+  }
+
+  void release(TYPE *object, uint32_t index);
+  // Return the specified 'object' with the specified slot 'index' to the
+  // pool.
+
+  void initialize(size_t capacity);
+
+public:
+  ObjectPool(const ObjectPool &) = delete;
+  ObjectPool &operator=(const ObjectPool &) = delete;
+
+  // CREATORS
+
+  explicit ObjectPool(size_t capacity, Allocator *allocator = 0);
+  // Create a pool of the specified 'capacity' that recycles storage only.
+  // Optionally the specified 'allocator' is used for memory allocation.
+
+  ObjectPool(size_t capacity, const Resetter &resetter, Allocator *allocator = 0);
+  // Create a pool of the specified 'capacity' that keeps released objects
+  // constructed and calls the specified 'resetter', if not empty, on them.
+  // Optionally the specified 'allocator' is used for memory allocation.
+
+  ~ObjectPool();
+  // Destroy the pool and all objects it keeps constructed. Behavior is
+  // undefined if handles of this pool are still alive.
+
+  // MANIPULATORS
+
+  template <class... ARGS>
+  Handle acquire(ARGS &&... args);
+  // Return a handle to an object. If a constructed object is available it
+  // is returned as is, otherwise a new object is constructed with the
+  // specified 'args'.
+
+  void recycle(TYPE *object);
+  // Return the specified 'object', taken from a handle of this pool with
+  // 'Handle::release', to the pool, like resetting its handle would.
+
+  template <class... ARGS>
+  void reserve(const ARGS &... args);
+  // Construct, with the specified 'args', every free pooled object that is
+  // not constructed yet. This method has no effect unless the pool keeps
+  // objects constructed. Note that this method is not thread-safe.
+
+  // ACCESSORS
+
+  size_t capacity() const
+  // Return the number of pooled objects.
+  {
+    return d_capacity;
+  }
+
+  size_t available() const
+  // Return the number of pooled objects that are not in use.
+  {
+    return d_available.load(std::memory_order_relaxed);
+  }
+
+  bool keepsConstructed() const
+  // Return true if released objects are kept constructed.
+  {
+    return d_keepConstructed;
+  }
+};
+
+// ========================
+// Class ObjectPool::Handle
+// ========================
+
+template <class TYPE>
+class ObjectPool<TYPE>::Handle
+{
+  // Provides unique ownership of an object from an 'ObjectPool'. The object
+  // is returned to the pool when the handle is destroyed or reset.
+
+  friend class ObjectPool;
+
+  // DATA
+
+  ObjectPool *d_pool_p;
+  TYPE *      d_object_p;
+  uint32_t    d_index;
+
+  // PRIVATE CREATORS
+
+  Handle(ObjectPool *pool, TYPE *object, uint32_t index)
+      : d_pool_p(pool)
+      , d_object_p(object)
+      , d_index(index)
+  {}
+
+public:
+  Handle(const Handle &) = delete;
+  Handle &operator=(const Handle &) = delete;
+
+  // CREATORS
+
+  Handle()
+      // Create an empty handle.
+      : d_pool_p(nullptr)
+      , d_object_p(nullptr)
+      , d_index(k_nil)
+  {}
+
+  Handle(Handle &&other)
+      // Take ownership of the object of the specified 'other' handle.
+      : d_pool_p(other.d_pool_p)
+      , d_object_p(other.d_object_p)
+      , d_index(other.d_index)
+  {
+    other.d_object_p = nullptr;
+  }
+
+  ~Handle() { reset(); }
+
+  // MANIPULATORS
+
+  Handle &operator=(Handle &&other)
+  // Release the current object and take ownership of the object of the
+  // specified 'other' handle.
+  {
+    if (this != &other) {
+      reset();
+      d_pool_p         = other.d_pool_p;
+      d_object_p       = other.d_object_p;
+      d_index          = other.d_index;
+      other.d_object_p = nullptr;
+    }
+    return *this;
+  }
+
+  void reset()
+  // Return the object to its pool and make this handle empty.
+  {
+    if (d_object_p) {
+      d_pool_p->release(d_object_p, d_index);
+      d_object_p = nullptr;
+    }
+  }
+
+  TYPE *release()
+  // Return the object and make this handle empty without returning the
+  // object to the pool. The object must be returned with 'recycle' of the
+  // pool instead, so it can be owned by a raw pointer, e.g. in an intrusive
+  // list.
+  {
+    TYPE *object = d_object_p;
+    d_object_p   = nullptr;
+    return object;
+  }
+
+  // ACCESSORS
+
+  TYPE *get() const { return d_object_p; }
+
+  TYPE *operator->() const { return d_object_p; }
+
+  TYPE &operator*() const { return *d_object_p; }
+
+  explicit operator bool() const { return nullptr != d_object_p; }
+
+  bool isPooled() const
+  // Return true if the object lives in the pool rather than in memory from
+  // the backing allocator.
+  {
+    return d_object_p && k_nil != d_index;
+  }
+};
+
+// ============================================================================
+//                            INLINE DEFINITIONS
+// ============================================================================
+
+// ----------------
+// Class ObjectPool
+// ----------------
+
+// PRIVATE MANIPULATORS
+
+template <class TYPE>
+void ObjectPool<TYPE>::release(TYPE *object, uint32_t index)
+{
+  if (k_nil == index) {
+    object->~TYPE();
+    d_allocator_p->deallocate(object, sizeof(TYPE), alignof(TYPE));
+    return;
+  }
+
+  if (d_keepConstructed) {
+    if (d_resetter) {
+      d_resetter(object);
+    }
+  } else {
+    object->~TYPE();
+    d_slots[index].d_constructed = false;
+  }
+
+  pushSlot(index);
+}
+
+template <class TYPE>
+void ObjectPool<TYPE>::initialize(size_t capacity)
+{
+  d_slots = reinterpret_cast<Slot *>(
+      d_allocator_p->allocate(sizeof(Slot) * capacity, alignof(Slot)));
+
+  for (uint32_t i = 0; i < d_capacity; ++i) {
+    Slot *slot = new (d_slots + i) Slot();
+    slot->d_next.store(i + 1 < d_capacity ? i + 1 : uint32_t(k_nil),
+                       std::memory_order_relaxed);
+    slot->d_constructed = false;
+  }
+
+  d_freeHead.store(0 < d_capacity ? 0 : uint32_t(k_nil));
+  d_available.store(d_capacity);
+}
+
+// CREATORS
+
+template <class TYPE>
+ObjectPool<TYPE>::ObjectPool(size_t capacity, Allocator *allocator)
+    : d_slots(nullptr)
+    , d_capacity(static_cast<uint32_t>(capacity))
+    , d_freeHead(k_nil)
+    , d_available(0)
+    , d_keepConstructed(false)
+    , d_resetter()
+    , d_allocator_p(AllocatorUtil::defaultAllocator(allocator))
+{
+  initialize(capacity);
+}
+
+template <class TYPE>
+ObjectPool<TYPE>::ObjectPool(size_t          capacity,
+                             const Resetter &resetter,
+                             Allocator *     allocator)
+    : d_slots(nullptr)
+    , d_capacity(static_cast<uint32_t>(capacity))
+    , d_freeHead(k_nil)
+    , d_available(0)
+    , d_keepConstructed(true)
+    , d_resetter(resetter)
+    , d_allocator_p(AllocatorUtil::defaultAllocator(allocator))
+{
+  initialize(capacity);
+}
+
+template <class TYPE>
+ObjectPool<TYPE>::~ObjectPool()
+{
+  for (uint32_t i = 0; i < d_capacity; ++i) {
+    if (d_slots[i].d_constructed) {
+      d_slots[i].object()->~TYPE();
+    }
+    d_slots[i].~Slot();
+  }
+
+  d_allocator_p->deallocate(d_slots, sizeof(Slot) * d_capacity, alignof(Slot));
+}
+
+// MANIPULATORS
+
+template <class TYPE>
+template <class... ARGS>
+typename ObjectPool<TYPE>::Handle ObjectPool<TYPE>::acquire(ARGS &&... args)
+{
+  const uint32_t index = popSlot();
+
+  if (k_nil == index) {
+    void *memory = d_allocator_p->allocate(sizeof(TYPE), alignof(TYPE));
+    try {
+      return Handle(this, new (memory) TYPE(std::forward<ARGS>(args)...), k_nil);
+    } catch (...) {
+      d_allocator_p->deallocate(memory, sizeof(TYPE), alignof(TYPE));
+      throw;
+    }
+  }
+
+  Slot &slot = d_slots[index];
+  if (!slot.d_constructed) {
+    try {
+      new (slot.d_storage) TYPE(std::forward<ARGS>(args)...);
+    } catch (...) {
+      pushSlot(index);
+      throw;
+    }
+    slot.d_constructed = true;
+  }
+
+  return Handle(this, slot.object(), index);
+}
+
+template <class TYPE>
+void ObjectPool<TYPE>::recycle(TYPE *object)
+{
+  // The storage is the first member of a slot, so a pooled object has the
+  // address of its slot.
+  const std::less<const void *> less;
+  Slot *                        slot = reinterpret_cast<Slot *>(object);
+
+  if (!less(slot, d_slots) && less(slot, d_slots + d_capacity)) {
+    release(object, static_cast<uint32_t>(slot - d_slots));
+  } else {
+    release(object, k_nil);
+  }
+}
+
+template <class TYPE>
+template <class... ARGS>
+void ObjectPool<TYPE>::reserve(const ARGS &... args)
+{
+  if (!d_keepConstructed) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < d_capacity; ++i) {
+    // Slots in use are always constructed, so only free slots are touched.
+    Slot &slot = d_slots[i];
+    if (!slot.d_constructed) {
+      new (slot.d_storage) TYPE(args...);
+      slot.d_constructed = true;
+    }
+  }
+}
+
+} // namespace mdmem
+} // namespace MvdS
+
+#endif // __INCLUDED_MDMEM_OBJECTPOOL
@@ -0,0 +1,276 @@
+// mdmem_objectpool.t.cpp                                               -*-c++-*-
+#include <mdmem_objectpool.h>
+
+#include <mdmem_testallocator.h>
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdmem;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+struct Counted
+{
+  static std::atomic<int> s_constructed;
+  static std::atomic<int> s_destroyed;
+
+  int              d_value;
+  std::vector<int> d_data;
+
+  explicit Counted(int value = 0)
+      : d_value(value)
+  {
+    ++s_constructed;
+    d_data.reserve(64);
+  }
+
+  ~Counted() { ++s_destroyed; }
+};
+
+std::atomic<int> Counted::s_constructed(0);
+std::atomic<int> Counted::s_destroyed(0);
+
+typedef ObjectPool<Counted> Obj;
+
+void resetCounts()
+{
+  Counted::s_constructed = 0;
+  Counted::s_destroyed   = 0;
+}
+
+int main(int argc, char *argv[])
+{
+
+  int testcase = (argc > 1?std::atoi(argv[1]):0);
+
+  bool verbose = argc > 1;
+  bool veryVerbose = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 6:
+    {
+      // Objects released from their handles are returned with 'recycle',
+      // pooled or not.
+      TestAllocator ta;
+      resetCounts();
+
+      {
+	int resets = 0;
+	Obj o(1, [&resets](Counted *) { ++resets; }, &ta);
+
+	Obj::Handle a = o.acquire(1);
+	Obj::Handle b = o.acquire(2);
+	Counted    *pooled    = a.release();
+	Counted    *allocated = b.release();
+	ASSERT(!a);
+	ASSERT(!b);
+	ASSERT(0 == o.available());
+
+	o.recycle(pooled);
+	ASSERT(1 == resets);
+	ASSERT(1 == o.available());
+	ASSERT(0 == Counted::s_destroyed);
+
+	o.recycle(allocated);
+	ASSERT(1 == resets);
+	ASSERT(1 == Counted::s_destroyed);
+
+	Obj::Handle c = o.acquire();
+	ASSERT(pooled == c.get());
+	ASSERT(c.isPooled());
+      }
+
+      ASSERT(2 == Counted::s_destroyed);
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 5:
+    {
+      // Concurrent acquire and release never hands out an object twice.
+      TestAllocator ta;
+      resetCounts();
+
+      {
+	Obj o(8, Obj::Resetter(), &ta);
+
+	std::vector<std::thread> threads;
+	std::atomic<size_t>      corruptions(0);
+
+	for (int t = 0; t < 4; ++t) {
+	  threads.emplace_back([&o, &corruptions, t]() {
+	      for (int i = 0; i < 20000; ++i) {
+		Obj::Handle h = o.acquire();
+		h->d_value    = t;
+		std::this_thread::yield();
+		if (h->d_value != t) {
+		  ++corruptions;
+		}
+	      }
+	    });
+	}
+
+	for (auto& thread : threads) {
+	  thread.join();
+	}
+
+	ASSERT(0 == corruptions);
+	ASSERT(8 == o.available());
+      }
+
+      ASSERT(Counted::s_constructed == Counted::s_destroyed);
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 4:
+    {
+      // Handles are movable and 'reset' returns the object early.
+      resetCounts();
+      Obj o(2);
+
+      Obj::Handle a = o.acquire(1);
+      Obj::Handle b(std::move(a));
+      ASSERT(!a);
+      ASSERT(b);
+      ASSERT(1 == b->d_value);
+      ASSERT(1 == o.available());
+
+      Obj::Handle c;
+      c = std::move(b);
+      ASSERT(!b);
+      ASSERT(1 == (*c).d_value);
+
+      c.reset();
+      ASSERT(!c);
+      ASSERT(2 == o.available());
+      ASSERT(1 == Counted::s_destroyed);
+    } break;
+
+  case 3:
+    {
+      // When the pool is exhausted objects come from the allocator.
+      TestAllocator ta;
+      resetCounts();
+
+      {
+	Obj o(1, &ta);
+	const size_t base = ta.allocationCount();
+
+	Obj::Handle a = o.acquire(1);
+	Obj::Handle b = o.acquire(2);
+	ASSERT(a.isPooled());
+	ASSERT(!b.isPooled());
+	ASSERT(base + 1 == ta.allocationCount());
+	ASSERT(0 == o.available());
+
+	b.reset();
+	ASSERT(ta.allocationCount() == ta.deallocationCount() + 1);
+      }
+
+      ASSERT(2 == Counted::s_constructed);
+      ASSERT(2 == Counted::s_destroyed);
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 2:
+    {
+      // A pool with a resetter keeps objects constructed.
+      resetCounts();
+      int resets = 0;
+
+      {
+	Obj o(2, [&resets](Counted *c) { c->d_value = 0; ++resets; });
+	ASSERT(o.keepsConstructed());
+
+	o.reserve(7);
+	ASSERT(2 == Counted::s_constructed);
+
+	Counted *first;
+	{
+	  Obj::Handle h = o.acquire(42);
+	  ASSERT(7 == h->d_value);
+	  h->d_value = 13;
+	  first      = h.get();
+	}
+	ASSERT(1 == resets);
+	ASSERT(0 == Counted::s_destroyed);
+
+	{
+	  Obj::Handle h = o.acquire();
+	  ASSERT(first == h.get());
+	  ASSERT(0 == h->d_value);
+	  ASSERT(64 <= h->d_data.capacity());
+	}
+	ASSERT(2 == Counted::s_constructed);
+      }
+
+      ASSERT(2 == Counted::s_destroyed);
+    } break;
+
+  case 1:
+    {
+      // By default objects are constructed on acquire and destroyed on
+      // release, storage is reused.
+      TestAllocator ta;
+      resetCounts();
+
+      {
+	Obj o(4, &ta);
+	ASSERT(4 == o.capacity());
+	ASSERT(4 == o.available());
+	ASSERT(!o.keepsConstructed());
+
+	const size_t allocations = ta.allocationCount();
+	Counted     *first;
+	{
+	  Obj::Handle h = o.acquire(5);
+	  ASSERT(h);
+	  ASSERT(5 == h->d_value);
+	  ASSERT(3 == o.available());
+	  first = h.get();
+	}
+	ASSERT(4 == o.available());
+	ASSERT(1 == Counted::s_destroyed);
+
+	{
+	  Obj::Handle h = o.acquire(6);
+	  ASSERT(first == h.get());
+	  ASSERT(6 == h->d_value);
+	}
+
+	// 'Counted' reserves its vector from the global heap, the pool
+	// itself allocated nothing more.
+	ASSERT(allocations == ta.allocationCount());
+      }
+
+      ASSERT(2 == Counted::s_constructed);
+      ASSERT(2 == Counted::s_destroyed);
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
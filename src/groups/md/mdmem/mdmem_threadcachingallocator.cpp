@@ -0,0 +1,340 @@
+// mdmem_threadcachingallocator.cpp                                     -*-c++-*-
+#include <mdmem_threadcachingallocator.h>
+
+#include <mdmem_threadregistry.h>
+
+#include <new>
+
+namespace MvdS {
+namespace mdmem {
+
+namespace {
+
+struct BlockHeader
+{
+  // Header in front of every cached block.
+
+  void * d_owner_p;   // Thread cache that handed out the block, or null.
+  size_t d_sizeClass; // Size class of the block.
+};
+
+static_assert(sizeof(BlockHeader) <= ThreadCachingAllocator::k_blockAlignment,
+              "Block header must fit in the block alignment.");
+
+inline BlockHeader *header(void *payload)
+{
+  return reinterpret_cast<BlockHeader *>(
+      static_cast<char *>(payload) - ThreadCachingAllocator::k_blockAlignment);
+}
+
+} // namespace
+
+// ----------------------------
+// Class ThreadCachingAllocator
+// ----------------------------
+
+// PRIVATE TYPES
+
+struct ThreadCachingAllocator::Block
+{
+  // Overlay on the payload of a free block.
+
+  Block *d_next;
+};
+
+struct ThreadCachingAllocator::ThreadCache
+{
+  // Free lists of one thread.
+
+  struct FreeList
+  {
+    Block *d_head  = nullptr;
+    size_t d_count = 0;
+  };
+
+  FreeList d_lists[k_sizeClassCount];
+  // Free lists, only touched by the owning thread.
+
+  alignas(64) std::atomic<Block *> d_returned;
+  // Blocks freed by other threads.
+
+  bool d_inUse;
+  // True while owned by a live thread. Protected by the allocator mutex.
+
+  ThreadCache *d_next;
+  // Next cache of the allocator.
+
+  ThreadCache()
+      : d_returned(nullptr)
+      , d_inUse(false)
+      , d_next(nullptr)
+  {}
+
+  void push(Block *block, size_t sizeClass)
+  {
+    FreeList &list = d_lists[sizeClass];
+    block->d_next  = list.d_head;
+    list.d_head    = block;
+    ++list.d_count;
+  }
+
+  Block *pop(size_t sizeClass)
+  {
+    FreeList &list  = d_lists[sizeClass];
+    Block *   block = list.d_head;
+    list.d_head     = block->d_next;
+    --list.d_count;
+    return block;
+  }
+};
+
+// PRIVATE CLASS METHODS
+
+size_t ThreadCachingAllocator::sizeClass(size_t bytes)
+{
+  if (bytes <= 256) {
+    return (bytes + 15) / 16 - (bytes ? 1 : 0);
+  }
+
+  // Powers of two from 512 up to 'k_maximumCachedSize'.
+  const size_t log2 = 64 - __builtin_clzl(bytes - 1);
+  return 16 + (log2 - 9);
+}
+
+size_t ThreadCachingAllocator::classSize(size_t sizeClass)
+{
+  if (sizeClass < 16) {
+    return (sizeClass + 1) * 16;
+  }
+  return size_t(512) << (sizeClass - 16);
+}
+
+void ThreadCachingAllocator::threadExit(void *owner, void *slot)
+{
+  ThreadCachingAllocator *allocator = static_cast<ThreadCachingAllocator *>(owner);
+  ThreadCache *           cache     = static_cast<ThreadCache *>(slot);
+
+  allocator->drain(cache);
+
+  std::lock_guard<std::mutex> lk(allocator->d_mutex);
+  cache->d_inUse = false;
+}
+
+// PRIVATE MANIPULATORS
+
+ThreadCachingAllocator::ThreadCache *ThreadCachingAllocator::localCache()
+{
+  void *slot = ThreadRegistry::lookup(d_ownerId);
+  if (slot) {
+    return static_cast<ThreadCache *>(slot);
+  }
+
+  ThreadCache *cache = nullptr;
+
+  {
+    // Adopt the cache of a thread that has exited.
+    std::lock_guard<std::mutex> lk(d_mutex);
+    for (ThreadCache *c = d_caches; c; c = c->d_next) {
+      if (!c->d_inUse) {
+        c->d_inUse = true;
+        cache      = c;
+        break;
+      }
+    }
+  }
+
+  if (!cache) {
+    void *memory =
+        d_allocator_p->allocate(sizeof(ThreadCache), alignof(ThreadCache));
+    cache          = new (memory) ThreadCache();
+    cache->d_inUse = true;
+
+    std::lock_guard<std::mutex> lk(d_mutex);
+    cache->d_next = d_caches;
+    d_caches      = cache;
+    ++d_cacheCount;
+  }
+
+  if (!ThreadRegistry::insert(d_ownerId, this, cache, &threadExit)) {
+    std::lock_guard<std::mutex> lk(d_mutex);
+    cache->d_inUse = false;
+    return nullptr;
+  }
+
+  return cache;
+}
+
+void ThreadCachingAllocator::refill(ThreadCache *cache, size_t sizeClass)
+{
+  collectReturned(cache);
+
+  if (cache->d_lists[sizeClass].d_head) {
+    return;
+  }
+
+  for (size_t i = 0; i < d_config.d_batchSize; ++i) {
+    cache->push(static_cast<Block *>(allocateBlock(sizeClass)), sizeClass);
+  }
+}
+
+void ThreadCachingAllocator::release(ThreadCache *cache,
+                                     size_t       sizeClass,
+                                     size_t       count)
+{
+  for (size_t i = 0; i < count && cache->d_lists[sizeClass].d_head; ++i) {
+    deallocateBlock(cache->pop(sizeClass), sizeClass);
+  }
+}
+
+void ThreadCachingAllocator::collectReturned(ThreadCache *cache)
+{
+  Block *block = cache->d_returned.exchange(nullptr, std::memory_order_acquire);
+
+  while (block) {
+    Block *const next      = block->d_next;
+    const size_t sizeClass = header(block)->d_sizeClass;
+
+    if (cache->d_lists[sizeClass].d_count < d_config.d_maximumCachedBlocks) {
+      cache->push(block, sizeClass);
+    } else {
+      deallocateBlock(block, sizeClass);
+    }
+
+    block = next;
+  }
+}
+
+void ThreadCachingAllocator::drain(ThreadCache *cache)
+{
+  for (size_t sizeClass = 0; sizeClass < k_sizeClassCount; ++sizeClass) {
+    release(cache, sizeClass, cache->d_lists[sizeClass].d_count);
+  }
+
+  Block *block = cache->d_returned.exchange(nullptr, std::memory_order_acquire);
+  while (block) {
+    Block *const next = block->d_next;
+    deallocateBlock(block, header(block)->d_sizeClass);
+    block = next;
+  }
+}
+
+void *ThreadCachingAllocator::allocateBlock(size_t sizeClass)
+{
+  char *raw = static_cast<char *>(d_allocator_p->allocate(
+      k_blockAlignment + classSize(sizeClass), k_blockAlignment));
+
+  void *payload                  = raw + k_blockAlignment;
+  header(payload)->d_owner_p     = nullptr;
+  header(payload)->d_sizeClass   = sizeClass;
+  return payload;
+}
+
+void ThreadCachingAllocator::deallocateBlock(Block *block, size_t sizeClass)
+{
+  d_allocator_p->deallocate(reinterpret_cast<char *>(block) - k_blockAlignment,
+                            k_blockAlignment + classSize(sizeClass),
+                            k_blockAlignment);
+}
+
+void *ThreadCachingAllocator::do_allocate(std::size_t bytes,
+                                          std::size_t alignment)
+{
+  if (alignment > k_blockAlignment || bytes > k_maximumCachedSize) {
+    return d_allocator_p->allocate(bytes, alignment);
+  }
+
+  const size_t cls   = sizeClass(bytes);
+  ThreadCache *cache = localCache();
+
+  if (!cache) {
+    // The calling thread is exiting, bypass the caches.
+    return allocateBlock(cls);
+  }
+
+  if (!cache->d_lists[cls].d_head) {
+    refill(cache, cls);
+  }
+
+  Block *block               = cache->pop(cls);
+  header(block)->d_owner_p   = cache;
+  return block;
+}
+
+void ThreadCachingAllocator::do_deallocate(void *      p,
+                                           std::size_t bytes,
+                                           std::size_t alignment)
+{
+  if (alignment > k_blockAlignment || bytes > k_maximumCachedSize) {
+    d_allocator_p->deallocate(p, bytes, alignment);
+    return;
+  }
+
+  BlockHeader *const h     = header(p);
+  Block *const       block = static_cast<Block *>(p);
+  ThreadCache *const owner = static_cast<ThreadCache *>(h->d_owner_p);
+
+  if (!owner) {
+    deallocateBlock(block, h->d_sizeClass);
+    return;
+  }
+
+  if (owner == ThreadRegistry::lookup(d_ownerId)) {
+    owner->push(block, h->d_sizeClass);
+    if (owner->d_lists[h->d_sizeClass].d_count >
+        d_config.d_maximumCachedBlocks) {
+      release(owner, h->d_sizeClass, d_config.d_batchSize);
+    }
+    return;
+  }
+
+  // Remote free: hand the block back to the thread that owns it.
+  block->d_next = owner->d_returned.load(std::memory_order_relaxed);
+  while (!owner->d_returned.compare_exchange_weak(block->d_next,
+                                                  block,
+                                                  std::memory_order_release,
+                                                  std::memory_order_relaxed)) {
+  }
+}
+
+bool ThreadCachingAllocator::do_is_equal(
+    const std::experimental::pmr::memory_resource &other) const noexcept
+{
+  return this == &other;
+}
+
+// CREATORS
+
+ThreadCachingAllocator::ThreadCachingAllocator(Allocator *allocator)
+    : ThreadCachingAllocator(Configuration(), allocator)
+{}
+
+ThreadCachingAllocator::ThreadCachingAllocator(const Configuration &config,
+                                               Allocator *          allocator)
+    : d_config(config)
+    , d_ownerId(ThreadRegistry::registerOwner())
+    , d_caches(nullptr)
+    , d_cacheCount(0)
+    , d_allocator_p(AllocatorUtil::defaultAllocator(allocator))
+{
+  if (0 == d_config.d_batchSize) {
+    d_config.d_batchSize = 1;
+  }
+}
+
+ThreadCachingAllocator::~ThreadCachingAllocator()
+{
+  ThreadRegistry::deregisterOwner(d_ownerId);
+  ThreadRegistry::remove(d_ownerId);
+
+  ThreadCache *cache = d_caches;
+  while (cache) {
+    ThreadCache *const next = cache->d_next;
+    drain(cache);
+    cache->~ThreadCache();
+    d_allocator_p->deallocate(cache, sizeof(ThreadCache), alignof(ThreadCache));
+    cache = next;
+  }
+}
+
+} // namespace mdmem
+} // namespace MvdS
@@ -0,0 +1,175 @@
+// mdmem_threadcachingallocator.h                                       -*-c++-*-
+#ifndef __INCLUDED_MDMEM_THREADCACHINGALLOCATOR
+#define __INCLUDED_MDMEM_THREADCACHINGALLOCATOR
+
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace MvdS {
+namespace mdmem {
+
+// ============================
+// Class ThreadCachingAllocator
+// ============================
+
+class ThreadCachingAllocator : public Allocator
+{
+  // Provides an allocator that keeps bounded per-thread free lists of small
+  // blocks in front of a backing allocator, so threads that allocate
+  // concurrently do not serialize on the backing allocator.
+  //
+  // Requests up to 'k_maximumCachedSize' bytes with an alignment of at most
+  // 'k_blockAlignment' are rounded up to a size class and served from the
+  // free list of the calling thread. Empty free lists are refilled from the
+  // backing allocator in batches, and free lists that grow beyond their
+  // bound release half of their blocks. Every cached block remembers the
+  // thread cache it was handed out by: a block freed by another thread is
+  // pushed onto the lock-free return list of that cache and picked up by its
+  // owner on a later miss. When a thread exits its cache is drained into the
+  // backing allocator and kept for adoption by a new thread. Other requests
+  // go to the backing allocator directly.
+  //
+  // The backing allocator must be safe to use from multiple threads.
+
+public:
+  // PUBLIC TYPES
+
+  enum
+  {
+    k_blockAlignment    = 16,    // Alignment of cached blocks.
+    k_maximumCachedSize = 32768, // Largest request served by the caches.
+    k_sizeClassCount    = 23     // Number of size classes.
+  };
+
+  struct Configuration
+  {
+    size_t d_maximumCachedBlocks; // Bound on blocks per size class per thread.
+    size_t d_batchSize;           // Blocks moved per refill or release.
+
+    Configuration()
+        : d_maximumCachedBlocks(64)
+        , d_batchSize(16)
+    {}
+  };
+
+private:
+  // PRIVATE TYPES
+
+  struct Block;
+  struct ThreadCache;
+
+  // DATA
+
+  Configuration        d_config;
+  uint64_t             d_ownerId;   // Id in the 'ThreadRegistry'.
+  std::mutex           d_mutex;     // Protects 'd_caches'.
+  ThreadCache *        d_caches;    // All thread caches, live or orphaned.
+  std::atomic<size_t>  d_cacheCount;
+  mdmem::Allocator *   d_allocator_p;
+
+  // PRIVATE CLASS METHODS
+
+  static size_t sizeClass(size_t bytes);
+  // Return the size class for a request of the specified 'bytes'.
+
+  static size_t classSize(size_t sizeClass);
+  // Return the block size of the specified 'sizeClass'.
+
+  static void threadExit(void *owner, void *slot);
+  // Drain the cache 'slot' of the allocator 'owner' on thread exit.
+
+  // PRIVATE MANIPULATORS
+
+  ThreadCache *localCache();
+  // Return the cache of the calling thread, creating or adopting one if
+  // needed. Return null if the thread is exiting.
+
+  void refill(ThreadCache *cache, size_t sizeClass);
+  // Refill the free list of the specified 'sizeClass' in the specified
+  // 'cache' from its return list or the backing allocator.
+
+  void release(ThreadCache *cache, size_t sizeClass, size_t count);
+  // Release the specified 'count' blocks from the free list of the specified
+  // 'sizeClass' in the specified 'cache' to the backing allocator.
+
+  void collectReturned(ThreadCache *cache);
+  // Move all blocks on the return list of the specified 'cache' to its free
+  // lists.
+
+  void drain(ThreadCache *cache);
+  // Release all blocks held by the specified 'cache'.
+
+  void *allocateBlock(size_t sizeClass);
+  void  deallocateBlock(Block *block, size_t sizeClass);
+  // Allocate or deallocate a block of the specified 'sizeClass' from the
+  // backing allocator.
+
+  virtual void *do_allocate(std::size_t bytes, std::size_t alignment);
+
+  virtual void
+  do_deallocate(void *p, std::size_t bytes, std::size_t alignment);
+
+  virtual bool
+  do_is_equal(const std::experimental::pmr::memory_resource &other) const
+      noexcept;
+
+public:
+  ThreadCachingAllocator(const ThreadCachingAllocator &) = delete;
+  ThreadCachingAllocator &operator=(const ThreadCachingAllocator &) = delete;
+
+  // CREATORS
+
+  explicit ThreadCachingAllocator(Allocator *allocator = 0);
+  // Create a thread caching allocator in front of the specified 'allocator'
+  // using the default configuration. If 'allocator' is null the default
+  // allocator is used.
+
+  explicit ThreadCachingAllocator(const Configuration &config,
+                                  Allocator *          allocator = 0);
+  // Create a thread caching allocator with the specified 'config' in front
+  // of the specified 'allocator'. If 'allocator' is null the default
+  // allocator is used.
+
+  ~ThreadCachingAllocator();
+  // Destroy the allocator and release all cached blocks. Behavior is
+  // undefined if blocks allocated from this allocator are still in use or
+  // other threads are still using the allocator.
+
+  // ACCESSORS
+
+  size_t threadCacheCount() const;
+  // Return the number of thread caches created by this allocator.
+
+  Allocator *upstream() const;
+  // Return the backing allocator.
+};
+
+// ============================================================================
+//                            INLINE DEFINITIONS
+// ============================================================================
+
+// ----------------------------
+// Class ThreadCachingAllocator
+// ----------------------------
+
+// ACCESSORS
+
+inline size_t ThreadCachingAllocator::threadCacheCount() const
+{
+  return d_cacheCount.load(std::memory_order_relaxed);
+}
+
+inline Allocator *ThreadCachingAllocator::upstream() const
+{
+  return d_allocator_p;
+}
+
+} // namespace mdmem
+} // namespace MvdS
+
+#endif // __INCLUDED_MDMEM_THREADCACHINGALLOCATOR
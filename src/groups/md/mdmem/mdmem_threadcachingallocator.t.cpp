@@ -0,0 +1,265 @@
+// mdmem_threadcachingallocator.t.cpp                                   -*-c++-*-
+#include <mdmem_threadcachingallocator.h>
+
+#include <mdmem_testallocator.h>
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdmem;
+
+typedef ThreadCachingAllocator Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+int main(int argc, char *argv[])
+{
+
+  int testcase = (argc > 1?std::atoi(argv[1]):0);
+
+  bool verbose = argc > 1;
+  bool veryVerbose = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 6:
+    {
+      // Stress: threads allocate mixed sizes and free both their own and
+      // each other's blocks. Everything is returned on destruction.
+      TestAllocator ta;
+
+      {
+	Obj o(&ta);
+
+	const size_t             threadCount = 4;
+	const size_t             rounds      = 20000;
+	std::vector<std::thread> threads;
+	std::vector<std::atomic<void *>> mailbox(threadCount);
+	std::atomic<size_t>      corruptions(0);
+
+	for (auto& slot : mailbox) {
+	  slot = nullptr;
+	}
+
+	for (size_t t = 0; t < threadCount; ++t) {
+	  threads.emplace_back([&, t]() {
+	      for (size_t i = 0; i < rounds; ++i) {
+		const size_t size = 16 + (i * 37) % 2000;
+		char *p = static_cast<char *>(o.allocate(size));
+		memset(p, static_cast<int>(t), size);
+
+		// Sizes are only known by the allocating thread, so stash
+		// the size in the block itself.
+		*reinterpret_cast<size_t *>(p) = size;
+
+		// Swap with the mailbox of the next thread and free what
+		// was there.
+		void *other = mailbox[(t + 1) % threadCount].exchange(p);
+		if (other) {
+		  const size_t otherSize = *static_cast<size_t *>(other);
+		  const char  *q         = static_cast<const char *>(other);
+		  if (q[8] != q[otherSize - 1]) {
+		    ++corruptions;
+		  }
+		  o.deallocate(other, otherSize);
+		}
+	      }
+	    });
+	}
+
+	for (auto& thread : threads) {
+	  thread.join();
+	}
+
+	for (auto& slot : mailbox) {
+	  void *p = slot.load();
+	  if (p) {
+	    o.deallocate(p, *static_cast<size_t *>(p));
+	  }
+	}
+
+	ASSERT(0 == corruptions);
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+      ASSERT(ta.totalBytesAllocated() == ta.totalBytesDeallocated());
+    } break;
+
+  case 5:
+    {
+      // A cache of an exited thread is drained and adopted by a new thread.
+      TestAllocator ta;
+
+      {
+	Obj o(&ta);
+
+	std::thread t1([&]() { o.deallocate(o.allocate(100), 100); });
+	t1.join();
+	ASSERT(1 == o.threadCacheCount());
+	// Only the thread cache itself is still allocated.
+	ASSERT(1 == ta.allocationCount() - ta.deallocationCount());
+
+	std::thread t2([&]() { o.deallocate(o.allocate(100), 100); });
+	t2.join();
+	ASSERT(1 == o.threadCacheCount());
+	ASSERT(1 == ta.allocationCount() - ta.deallocationCount());
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 4:
+    {
+      // Blocks freed by another thread go back to the owning thread.
+      TestAllocator ta;
+      Obj::Configuration config;
+      config.d_batchSize = 4;
+
+      {
+	Obj o(config, &ta);
+
+	std::vector<void *> blocks;
+	std::atomic<int>    phase(0);
+	size_t              allocationsAfterReturn = 0;
+	bool                reused = true;
+
+	std::thread owner([&]() {
+	    for (size_t i = 0; i < 4; ++i) {
+	      blocks.push_back(o.allocate(64));
+	    }
+	    phase = 1;
+	    while (2 != phase) {
+	      std::this_thread::yield();
+	    }
+
+	    const size_t before = ta.allocationCount();
+	    for (size_t i = 0; i < 4; ++i) {
+	      void *p = o.allocate(64);
+	      bool found = false;
+	      for (void *b : blocks) {
+		found = found || b == p;
+	      }
+	      reused = reused && found;
+	      o.deallocate(p, 64);
+	    }
+	    allocationsAfterReturn = ta.allocationCount() - before;
+	  });
+
+	while (1 != phase) {
+	  std::this_thread::yield();
+	}
+	for (void *p : blocks) {
+	  o.deallocate(p, 64);
+	}
+	phase = 2;
+	owner.join();
+
+	ASSERT(reused);
+	ASSERT(0 == allocationsAfterReturn);
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 3:
+    {
+      // Large and over-aligned requests bypass the caches.
+      TestAllocator ta;
+
+      {
+	Obj o(&ta);
+
+	void *a = o.allocate(Obj::k_maximumCachedSize + 1);
+	ASSERT(1 == ta.allocationCount());
+	o.deallocate(a, Obj::k_maximumCachedSize + 1);
+	ASSERT(1 == ta.deallocationCount());
+
+	void *b = o.allocate(64, 64);
+	ASSERT(0 == reinterpret_cast<uintptr_t>(b) % 64);
+	ASSERT(2 == ta.allocationCount());
+	o.deallocate(b, 64, 64);
+	ASSERT(2 == ta.deallocationCount());
+	ASSERT(0 == o.threadCacheCount());
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 2:
+    {
+      // The number of cached blocks per size class is bounded.
+      TestAllocator      ta;
+      Obj::Configuration config;
+      config.d_maximumCachedBlocks = 8;
+      config.d_batchSize           = 4;
+
+      {
+	Obj o(config, &ta);
+
+	std::vector<void *> blocks;
+	for (size_t i = 0; i < 100; ++i) {
+	  blocks.push_back(o.allocate(48));
+	}
+	for (void *p : blocks) {
+	  o.deallocate(p, 48);
+	}
+
+	// The thread cache and at most 'd_maximumCachedBlocks' blocks remain.
+	ASSERT(ta.allocationCount() - ta.deallocationCount() <= 1 + 8);
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
+  case 1:
+    {
+      TestAllocator ta;
+
+      {
+	Obj o(&ta);
+	ASSERT(&ta == o.upstream());
+	ASSERT(0 == o.threadCacheCount());
+
+	char *p = static_cast<char *>(o.allocate(5));
+	ASSERT(0 == reinterpret_cast<uintptr_t>(p) % Obj::k_blockAlignment);
+	strcpy(p, "abcd");
+	ASSERT(1 == o.threadCacheCount());
+	o.deallocate(p, 5);
+
+	// Freed blocks are reused without going to the backing allocator.
+	const size_t count = ta.allocationCount();
+	void *q = o.allocate(16);
+	ASSERT(p == q);
+	ASSERT(count == ta.allocationCount());
+	o.deallocate(q, 16);
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+      ASSERT(ta.totalBytesAllocated() == ta.totalBytesDeallocated());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,163 @@
+// mdmem_threadregistry.cpp                                             -*-c++-*-
+#include <mdmem_threadregistry.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace MvdS {
+namespace mdmem {
+
+struct ThreadRegistry_Entry
+{
+  uint64_t                     d_ownerId;
+  void *                       d_owner_p;
+  void *                       d_slot_p;
+  ThreadRegistry::ExitCallback d_callback;
+};
+
+namespace {
+
+std::recursive_mutex &registryMutex()
+{
+  static std::recursive_mutex mutex;
+  return mutex;
+}
+
+std::unordered_set<uint64_t> &liveOwners()
+// Return the set of registered owner ids. Behavior is undefined unless the
+// registry mutex is locked.
+{
+  static std::unordered_set<uint64_t> owners;
+  return owners;
+}
+
+std::atomic<uint64_t> s_nextOwnerId(1);
+
+thread_local bool t_exiting = false;
+
+} // namespace
+
+struct ThreadRegistry_ThreadEntries
+{
+  // Slots of the current thread. Runs the exit callbacks on destruction.
+
+  std::vector<ThreadRegistry_Entry> d_entries;
+
+  ~ThreadRegistry_ThreadEntries();
+};
+
+namespace {
+
+thread_local ThreadRegistry_ThreadEntries t_entries;
+
+} // namespace
+
+// ---------------------
+// Class: ThreadRegistry
+// ---------------------
+
+thread_local uint64_t ThreadRegistry::s_lastOwnerId = 0;
+thread_local void *   ThreadRegistry::s_lastSlot    = nullptr;
+
+ThreadRegistry_ThreadEntries::~ThreadRegistry_ThreadEntries()
+{
+  t_exiting                     = true;
+  ThreadRegistry::s_lastOwnerId = 0;
+  ThreadRegistry::s_lastSlot    = nullptr;
+
+  std::lock_guard<std::recursive_mutex> lk(registryMutex());
+  for (const ThreadRegistry_Entry &entry : d_entries) {
+    if (liveOwners().count(entry.d_ownerId)) {
+      entry.d_callback(entry.d_owner_p, entry.d_slot_p);
+    }
+  }
+  d_entries.clear();
+}
+
+// CLASS METHODS
+
+uint64_t ThreadRegistry::registerOwner()
+{
+  const uint64_t                        id = s_nextOwnerId++;
+  std::lock_guard<std::recursive_mutex> lk(registryMutex());
+  liveOwners().insert(id);
+  return id;
+}
+
+void ThreadRegistry::deregisterOwner(uint64_t ownerId)
+{
+  std::lock_guard<std::recursive_mutex> lk(registryMutex());
+  liveOwners().erase(ownerId);
+}
+
+void *ThreadRegistry::lookupSlow(uint64_t ownerId)
+{
+  if (t_exiting) {
+    return nullptr;
+  }
+
+  for (const ThreadRegistry_Entry &entry : t_entries.d_entries) {
+    if (entry.d_ownerId == ownerId) {
+      s_lastOwnerId = ownerId;
+      s_lastSlot    = entry.d_slot_p;
+      return entry.d_slot_p;
+    }
+  }
+  return nullptr;
+}
+
+bool ThreadRegistry::insert(uint64_t     ownerId,
+                            void *       owner,
+                            void *       slot,
+                            ExitCallback callback)
+{
+  if (t_exiting) {
+    return false;
+  }
+
+  std::vector<ThreadRegistry_Entry> &entries = t_entries.d_entries;
+
+  {
+    // Prune slots of owners that are gone, so threads that outlive many
+    // owners do not accumulate entries.
+    std::lock_guard<std::recursive_mutex> lk(registryMutex());
+    entries.erase(std::remove_if(entries.begin(),
+                                 entries.end(),
+                                 [](const ThreadRegistry_Entry &entry) {
+                                   return 0 ==
+                                          liveOwners().count(entry.d_ownerId);
+                                 }),
+                  entries.end());
+  }
+
+  entries.push_back(ThreadRegistry_Entry{ownerId, owner, slot, callback});
+  s_lastOwnerId = ownerId;
+  s_lastSlot    = slot;
+  return true;
+}
+
+void ThreadRegistry::remove(uint64_t ownerId)
+{
+  if (t_exiting) {
+    return;
+  }
+
+  std::vector<ThreadRegistry_Entry> &entries = t_entries.d_entries;
+  entries.erase(std::remove_if(entries.begin(),
+                               entries.end(),
+                               [ownerId](const ThreadRegistry_Entry &entry) {
+                                 return entry.d_ownerId == ownerId;
+                               }),
+                entries.end());
+
+  if (s_lastOwnerId == ownerId) {
+    s_lastOwnerId = 0;
+    s_lastSlot    = nullptr;
+  }
+}
+
+} // namespace mdmem
+} // namespace MvdS
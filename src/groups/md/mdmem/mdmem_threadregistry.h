@@ -0,0 +1,84 @@
+// mdmem_threadregistry.h                                               -*-c++-*-
+#ifndef __INCLUDED_MDMEM_THREADREGISTRY
+#define __INCLUDED_MDMEM_THREADREGISTRY
+
+#include <cstdint>
+
+namespace MvdS {
+namespace mdmem {
+
+// ====================
+// Class ThreadRegistry
+// ====================
+
+struct ThreadRegistry_ThreadEntries;
+
+class ThreadRegistry
+{
+  // Provides per-thread slots keyed by an owner, so that objects such as
+  // allocators can keep state for every thread that uses them and are told
+  // when such a thread exits.
+  //
+  // An owner obtains a unique id with 'registerOwner' and stores a slot for
+  // the calling thread with 'insert'. When the thread exits the registered
+  // callback is invoked for every slot of an owner that is still registered.
+  // 'deregisterOwner' waits for callbacks that are in progress, after it
+  // returns no callback will be invoked for that owner anymore. Owner ids are
+  // never reused.
+
+public:
+  // PUBLIC TYPES
+
+  typedef void (*ExitCallback)(void *owner, void *slot);
+  // Callback invoked on thread exit with the owner and slot that were
+  // passed to 'insert'.
+
+private:
+  friend struct ThreadRegistry_ThreadEntries;
+
+  // PRIVATE CLASS DATA
+
+  static thread_local uint64_t s_lastOwnerId;
+  static thread_local void *   s_lastSlot;
+
+  // PRIVATE CLASS METHODS
+
+  static void *lookupSlow(uint64_t ownerId);
+
+public:
+  // CLASS METHODS
+
+  static uint64_t registerOwner();
+  // Return a new, unique owner id.
+
+  static void deregisterOwner(uint64_t ownerId);
+  // Deregister the specified 'ownerId'. Block until exit callbacks for this
+  // owner that are running on other threads have returned.
+
+  static void *lookup(uint64_t ownerId)
+  // Return the slot of the calling thread for the specified 'ownerId', or
+  // null if there is none.
+  {
+    if (s_lastOwnerId == ownerId) {
+      return s_lastSlot;
+    }
+    return lookupSlow(ownerId);
+  }
+
+  static bool
+  insert(uint64_t ownerId, void *owner, void *slot, ExitCallback callback);
+  // Store the specified 'slot' for the calling thread under the specified
+  // 'ownerId' and arrange for the specified 'callback' to be invoked with
+  // the specified 'owner' and 'slot' when the thread exits. Return false,
+  // without storing anything, if the calling thread is already exiting.
+  // Behavior is undefined if the thread already has a slot for 'ownerId'.
+
+  static void remove(uint64_t ownerId);
+  // Remove the slot of the calling thread for the specified 'ownerId'
+  // without invoking its callback.
+};
+
+} // namespace mdmem
+} // namespace MvdS
+
+#endif // __INCLUDED_MDMEM_THREADREGISTRY
@@ -0,0 +1,127 @@
+// mdmem_threadregistry.t.cpp                                           -*-c++-*-
+#include <mdmem_threadregistry.h>
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdmem;
+
+typedef ThreadRegistry Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+std::atomic<size_t> g_exitCount(0);
+
+void countExit(void *owner, void *slot)
+{
+  ASSERT(owner == slot);
+  ++g_exitCount;
+}
+
+int main(int argc, char *argv[])
+{
+
+  int testcase = (argc > 1?std::atoi(argv[1]):0);
+
+  bool verbose = argc > 1;
+  bool veryVerbose = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 3:
+    {
+      // No callback is invoked for owners that deregistered before the
+      // thread exits.
+      int            owner = 0;
+      const uint64_t id    = Obj::registerOwner();
+
+      g_exitCount = 0;
+      std::thread t([&]() {
+	  ASSERT(Obj::insert(id, &owner, &owner, &countExit));
+	});
+      t.join();
+      ASSERT(1 == g_exitCount);
+
+      std::atomic<bool> inserted(false);
+      std::atomic<bool> deregistered(false);
+      std::thread t2([&]() {
+	  ASSERT(Obj::insert(id, &owner, &owner, &countExit));
+	  inserted = true;
+	  while (!deregistered) {
+	    std::this_thread::yield();
+	  }
+	});
+      while (!inserted) {
+	std::this_thread::yield();
+      }
+      Obj::deregisterOwner(id);
+      deregistered = true;
+      t2.join();
+      ASSERT(1 == g_exitCount);
+    } break;
+
+  case 2:
+    {
+      // Slots are per thread and the callback runs on thread exit.
+      int            owner = 0;
+      const uint64_t id    = Obj::registerOwner();
+
+      g_exitCount = 0;
+      std::thread t([&]() {
+	  ASSERT(nullptr == Obj::lookup(id));
+	  ASSERT(Obj::insert(id, &owner, &owner, &countExit));
+	  ASSERT(&owner == Obj::lookup(id));
+	});
+      t.join();
+
+      ASSERT(1 == g_exitCount);
+      ASSERT(nullptr == Obj::lookup(id));
+      Obj::deregisterOwner(id);
+    } break;
+
+  case 1:
+    {
+      int a = 0, b = 0;
+      const uint64_t idA = Obj::registerOwner();
+      const uint64_t idB = Obj::registerOwner();
+      ASSERT(idA != idB);
+
+      ASSERT(nullptr == Obj::lookup(idA));
+      ASSERT(Obj::insert(idA, &a, &a, &countExit));
+      ASSERT(Obj::insert(idB, &b, &b, &countExit));
+      ASSERT(&a == Obj::lookup(idA));
+      ASSERT(&b == Obj::lookup(idB));
+      ASSERT(&a == Obj::lookup(idA));
+
+      Obj::remove(idA);
+      ASSERT(nullptr == Obj::lookup(idA));
+      ASSERT(&b == Obj::lookup(idB));
+
+      Obj::remove(idB);
+      Obj::deregisterOwner(idA);
+      Obj::deregisterOwner(idB);
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
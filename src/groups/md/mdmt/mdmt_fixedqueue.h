@@ -7,6 +7,7 @@
 
 #include <condition_variable>
 #include <mutex>
+#include <utility>
 
 namespace MvdS {
 namespace mdmt {
@@ -55,17 +56,19 @@ private:
         d_data, sizeof(ValueType) * d_capacity, alignof(ValueType));
   }
 
-  void push(const ValueType &value)
+  template <class VALUE>
+  void push(VALUE &&value)
   {
     size_t index = (d_start + d_count++) % d_capacity;
-    new (d_data + index) ValueType(value);
+    new (d_data + index) ValueType(std::forward<VALUE>(value));
   }
 
   void pop(ValueType *value)
   {
     size_t index = d_start % d_capacity;
-    *value       = d_data[index];
-    d_start      = (d_start + 1) % d_capacity;
+    *value       = std::move(d_data[index]);
+    d_data[index].~ValueType();
+    d_start = (d_start + 1) % d_capacity;
     --d_count;
   }
 
@@ -93,7 +96,13 @@ public:
     allocateData();
   }
 
-  ~FixedQueue() { deallocateData(); }
+  ~FixedQueue()
+  {
+    for (size_t i = 0; i < d_count; ++i) {
+      d_data[(d_start + i) % d_capacity].~ValueType();
+    }
+    deallocateData();
+  }
 
   // MANIPULATORS
 
@@ -121,6 +130,22 @@ public:
     return true;
   }
 
+  bool tryPush(ValueType &&value)
+  {
+    {
+      std::lock_guard<std::mutex> lk(d_mutex);
+
+      if (full()) {
+        return false;
+      }
+
+      push(std::move(value));
+    }
+    d_cond.notify_one();
+
+    return true;
+  }
+
   bool pushWait(const ValueType &value)
   {
     {
@@ -1,6 +1,8 @@
 // mdmt_threadpool.cpp                                                 -*-c++-*-
 #include <mdmt_threadpool.h>
 
+#include <mdlog_ratelimit.h>
+
 #include <iostream>
 
 namespace MvdS {
@@ -28,11 +30,11 @@ void ThreadPoolBase::removeThisThread() {
   std::lock_guard<std::mutex> lk(d_mutex);
   auto i = d_threads.find(std::this_thread::get_id());
   if (d_threads.end() == i) {
-    MDLOG_ERROR << "No thread with ID=" << std::this_thread::get_id() << MDLOG_END;
+    MDLOG_ERROR_LIMITED(10) << "No thread with ID=" << std::this_thread::get_id() << MDLOG_END;
     return;
   }
 
-  i->second->detach();
+  i->second.detach();
   d_threads.erase(i);
 
   d_metrics.threadDecrease();
@@ -41,16 +43,16 @@ void ThreadPoolBase::removeThisThread() {
 void ThreadPoolBase::increaseThreads() {
   std::lock_guard<std::mutex> lk(d_mutex);
   if (d_threads.size() < d_maximumThreadCount) {
-    std::unique_ptr<std::thread> t =
-        std::make_unique<std::thread>(&ThreadPoolBase::threadMain, this);
-    d_threads.emplace(std::make_pair(t->get_id(), std::move(t)));
+    std::thread t(&ThreadPoolBase::threadMain, this);
+    const std::thread::id id = t.get_id();
+    d_threads.emplace(id, std::move(t));
 
     d_metrics.threadIncrease();
   }
 }
 
 void ThreadPoolBase::stopAllThreads() {
-  ThreadMap threads; //(d_allocator_p);
+  ThreadMap threads(d_allocator_p);
 
   {
     std::lock_guard<std::mutex> lk(d_mutex);
@@ -61,9 +63,9 @@ void ThreadPoolBase::stopAllThreads() {
     if (std::this_thread::get_id() == id) {
       // TBD: This might not be safe when the pool is destroyed soon
       //      afterwards.
-      thread->detach();
+      thread.detach();
     } else {
-      thread->join();
+      thread.join();
     }
   }
 }
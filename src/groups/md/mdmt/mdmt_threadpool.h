@@ -4,20 +4,22 @@
 
 #include <mdlog_logger.h>
 #include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+#include <mdmem_epochmanager.h>
+#include <mdmt_threadpooljob.h>
 
 #include <atomic>
+#include <experimental/memory_resource>
 #include <functional>
 #include <iosfwd>
 #include <mutex>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
 
 namespace MvdS {
 namespace mdmt {
 
-typedef std::function<void()> ThreadPoolJob;
-// ThreadPool job type.
-
 // =============================
 // Class ThreadPoolConfiguration
 // =============================
@@ -25,6 +27,12 @@ typedef std::function<void()> ThreadPoolJob;
 struct ThreadPoolConfiguration
 {
   // Provides configuration for a thread pool
+
+  // DATA
+
+  mdmem::EpochManager *d_epochManager_p = nullptr;
+  // If set, worker threads report a quiescent state to this epoch manager
+  // after every job and whenever they wait for work without result.
 };
 
 // ========================
@@ -111,7 +119,13 @@ private:
 protected:
   // PROTECTED TYPES
 
-  typedef std::unordered_map<std::thread::id, std::unique_ptr<std::thread>>
+  typedef std::unordered_map<
+      std::thread::id,
+      std::thread,
+      std::hash<std::thread::id>,
+      std::equal_to<std::thread::id>,
+      std::experimental::pmr::polymorphic_allocator<
+          std::pair<const std::thread::id, std::thread>>>
       ThreadMap;
 
   // PROTECTED DATA
@@ -131,7 +145,11 @@ protected:
   ThreadPoolMetrics d_metrics;
   // Metrics on threadpool queues and operations.
 
+  mdmem::EpochManager *d_epochManager_p;
+  // Epoch manager notified of quiescent states, or null.
+
   mdmem::Allocator *d_allocator_p;
+  // Allocator used for the thread map, the queue and jobs.
 
   // PROTECTED CREATORS
 
@@ -142,8 +160,9 @@ protected:
       mdmem::Allocator *             allocator = 0)
       : d_maximumThreadCount(maximumThreadCount)
       , d_minimumThreadCount(std::min(minimumThreadCount, maximumThreadCount))
-      , d_threads()
-      , d_allocator_p(allocator)
+      , d_threads(mdmem::AllocatorUtil::defaultAllocator(allocator))
+      , d_epochManager_p(config.d_epochManager_p)
+      , d_allocator_p(mdmem::AllocatorUtil::defaultAllocator(allocator))
   {}
 
   // PROTECTED MANIPULATORS
@@ -157,6 +176,14 @@ protected:
   void stopAllThreads();
   // Stop all threads.
 
+  void quiescent()
+  // Report a quiescent state of the calling worker thread, if configured.
+  {
+    if (d_epochManager_p) {
+      d_epochManager_p->quiescent();
+    }
+  }
+
   void checkLoad()
   // Checks the load of the thread pool and adds a thread if necessary.
   {
@@ -174,6 +201,12 @@ public:
   {
     return d_metrics;
   }
+
+  mdmem::Allocator *allocator() const
+  // Return the allocator used by the thread pool.
+  {
+    return d_allocator_p;
+  }
 };
 
 // ================
@@ -203,8 +236,9 @@ private:
     MDLOG_TRACE << "Starting thread " << std::this_thread::get_id()
                 << MDLOG_END;
 
+    ThreadPoolJob job(d_allocator_p);
+
     while (true) {
-      ThreadPoolJob job;
       auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(2);
 
       const auto result = d_queue.popWaitUntil(&job, timeout);
@@ -212,11 +246,14 @@ private:
       if (QueueType::e_success == result) {
         d_metrics.beginJob();
         job();
+        job.reset();
         d_metrics.endJob();
+        quiescent();
         continue;
       }
 
       if (QueueType::e_timeout == result) {
+        quiescent();
         removeThisThread();
       }
 
@@ -241,10 +278,11 @@ public:
       // Create thread pool with the specified 'maximumThreadCount' and the
       // specified 'minimumThreadCount'. Optionally with the specified
       // 'config' and the specified 'queueConfig'. Optionally the provided
-      // 'allocator' is used for memory allocations.
+      // 'allocator' is used for memory allocations, including the queue
+      // storage, the thread bookkeeping and jobs that do not fit inline.
       : ThreadPoolBase(
             maximumThreadCount, minimumThreadCount, config, allocator)
-      , d_queue(queueConfig)
+      , d_queue(queueConfig, d_allocator_p)
   {}
 
   ~ThreadPool()
@@ -276,8 +314,6 @@ public:
   // Enqueue the specified 'job' to the thread pool. This method is thread
   // safe and can be called from multiple threads concurently.
   {
-    MDLOG_SET_CATEGORY("mdmt::ThreadPool::enqueue");
-
     d_metrics.enqueueJob();
 
     if (!d_queue.tryPush(job)) {
@@ -288,6 +324,34 @@ public:
 
     return true;
   }
+
+  bool enqueue(ThreadPoolJob &&job)
+  // Enqueue the specified 'job' to the thread pool. This method is thread
+  // safe and can be called from multiple threads concurently.
+  {
+    d_metrics.enqueueJob();
+
+    if (!d_queue.tryPush(std::move(job))) {
+      return false;
+    }
+
+    checkLoad();
+
+    return true;
+  }
+
+  template <class FUNCTION,
+            class = typename std::enable_if<!std::is_same<
+                typename std::decay<FUNCTION>::type,
+                ThreadPoolJob>::value>::type>
+  bool enqueue(FUNCTION &&function)
+  // Enqueue a job that invokes the specified 'function' to the thread pool.
+  // The job is stored using the allocator of the thread pool. This method
+  // is thread safe and can be called from multiple threads concurently.
+  {
+    return enqueue(
+        ThreadPoolJob(std::forward<FUNCTION>(function), d_allocator_p));
+  }
 };
 
 } // namespace mdmt
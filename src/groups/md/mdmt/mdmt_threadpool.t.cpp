@@ -2,14 +2,20 @@
 #include <mdmt_threadpool.h>
 #include <mdmt_fixedqueue.h>
 
+#include <mdmem_testallocator.h>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
+#include <new>
 #include <thread>
 
 using namespace std;
 using namespace MvdS;
 using namespace MvdS::mdmt;
 
-typedef ThreadPool<FixedQueue<std::function<void()>>> Obj;
+typedef ThreadPool<FixedQueue<ThreadPoolJob>> Obj;
 typedef ThreadPoolConfiguration Conf;
 
 size_t g_errorCount = 0;
@@ -17,14 +23,62 @@ size_t g_errorCount = 0;
 #define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
 
 
+#define P(x) { cerr << #x << " = " << (x) << "\n"; }
+
 size_t g_executionCount = 0;
 
+std::atomic<size_t> g_globalAllocationCount(0);
+// Number of allocations through the global 'operator new'.
+
+void *operator new(size_t size)
+{
+  ++g_globalAllocationCount;
+  void *p = std::malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+class MallocAllocator : public mdmem::Allocator {
+  // Allocator that bypasses the global 'operator new'.
+
+  virtual void *do_allocate(std::size_t bytes, std::size_t alignment)
+  {
+    void *p = std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+    if (!p) {
+      throw std::bad_alloc();
+    }
+    return p;
+  }
+
+  virtual void do_deallocate(void *p, std::size_t, std::size_t)
+  {
+    std::free(p);
+  }
+
+  virtual bool do_is_equal(const std::experimental::pmr::memory_resource& other) const noexcept
+  {
+    return this == &other;
+  }
+};
+
 thread_local size_t g_localInt = 0;
 
 int main(int argc, char *argv[])
 {
 
-  int testcase = (argc > 0?std::atoi(*argv):0);
+  int testcase = (argc > 1 ? std::atoi(argv[1]) : 0);
 
   bool verbose = argc > 1;
   bool veryVerbose = argc > 2;
@@ -40,6 +94,113 @@ int main(int argc, char *argv[])
   switch (testcase) {
   case 0: // ALWAYS LAST TEST CASE
 
+  case 5:
+    {
+      // Workers report quiescent states to the configured epoch manager, so
+      // objects retired by jobs are reclaimed without explicit calls.
+      std::atomic<size_t> deleted(0);
+      mdmem::EpochManager em;
+
+      {
+	Conf conf;
+	conf.d_epochManager_p = &em;
+	Obj o(1, 0, conf);
+	std::atomic<size_t> executed(0);
+
+	o.start();
+
+	for (size_t i = 0; i < 100; ++i) {
+	  while (!o.enqueue([&em, &deleted, &executed]() {
+		em.retire(&executed, [](void *, void *context) {
+		    ++*static_cast<std::atomic<size_t> *>(context);
+		  }, &deleted);
+		++executed;
+	      })) {
+	    this_thread::yield();
+	  }
+	}
+
+	while (100 != executed) {
+	  this_thread::yield();
+	}
+
+	for (size_t i = 0; i < 3; ++i) {
+	  while (!o.enqueue([&executed]() { ++executed; })) {
+	    this_thread::yield();
+	  }
+	}
+
+	while (103 != executed) {
+	  this_thread::yield();
+	}
+
+	o.stop();
+      }
+
+      ASSERT(100 == deleted);
+      ASSERT(0 == em.pendingCount());
+    } break;
+
+  case 4:
+    {
+      // Steady state enqueue and execution only allocates from the supplied
+      // allocator, never from the global heap.
+      MallocAllocator      ma;
+      mdmem::TestAllocator ta(&ma);
+
+      {
+	Conf                conf;
+	Obj                 o(1, 0, conf, Obj::QueueConfig(), &ta);
+	std::atomic<size_t> executed(0);
+
+	o.start();
+
+	// Warm up: start the worker thread.
+	ASSERT(o.enqueue([&executed]() { ++executed; }));
+	while (1 != executed) {
+	  this_thread::yield();
+	}
+
+	const size_t globalBefore = g_globalAllocationCount;
+	const size_t localBefore  = ta.allocationCount();
+
+	std::array<size_t, 16> payload;
+	payload.fill(1);
+
+	for (size_t i = 0; i < 1000; ++i) {
+	  if (0 == i % 10) {
+	    // Too large to be stored inline. Note that a job is only moved
+	    // into the queue when 'enqueue' succeeds.
+	    ThreadPoolJob job([&executed, payload]() {
+		executed += payload[0];
+	      }, o.allocator());
+	    while (!o.enqueue(std::move(job))) {
+	      this_thread::yield();
+	    }
+	  } else {
+	    while (!o.enqueue([&executed]() { ++executed; })) {
+	      this_thread::yield();
+	    }
+	  }
+	}
+
+	while (1001 != executed) {
+	  this_thread::yield();
+	}
+
+	ASSERT(globalBefore == g_globalAllocationCount);
+	if (verbose) {
+	  P(g_globalAllocationCount - globalBefore);
+	  P(ta.allocationCount() - localBefore);
+	}
+	ASSERT(localBefore + 100 == ta.allocationCount());
+
+	o.stop();
+      }
+
+      ASSERT(ta.allocationCount() == ta.deallocationCount());
+    } break;
+
   case 3:
     {
       Conf conf;
@@ -0,0 +1,2 @@
+// mdmt_threadpoolexecutor.cpp                                          -*-c++-*-
+#include <mdmt_threadpoolexecutor.h>
@@ -0,0 +1,49 @@
+// mdmt_threadpoolexecutor.h                                            -*-c++-*-
+#ifndef __INCLUDED_MDMT_THREADPOOLEXECUTOR
+#define __INCLUDED_MDMT_THREADPOOLEXECUTOR
+
+#include <mdio_executor.h>
+#include <mdmt_threadpooljob.h>
+
+#include <utility>
+
+namespace MvdS {
+namespace mdmt {
+
+// ========================
+// Class ThreadPoolExecutor
+// ========================
+
+template <class THREADPOOL>
+class ThreadPoolExecutor : public mdio::Executor
+{
+  // Provides an 'mdio::Executor' that enqueues jobs to a 'ThreadPool', so
+  // I/O completions are delivered to the pool workers.
+
+  // DATA
+
+  THREADPOOL *d_pool_p;
+
+public:
+  // CREATORS
+
+  explicit ThreadPoolExecutor(THREADPOOL *pool)
+      // Create an executor for the specified 'pool'.
+      : d_pool_p(pool)
+  {}
+
+  // MANIPULATORS
+
+  virtual bool execute(Job &&job)
+  // Enqueue the specified 'job' to the pool. Return false if the pool
+  // rejected it.
+  {
+    return d_pool_p->enqueue(
+        ThreadPoolJob(std::move(job), d_pool_p->allocator()));
+  }
+};
+
+} // namespace mdmt
+} // namespace MvdS
+
+#endif // __INCLUDED_MDMT_THREADPOOLEXECUTOR
@@ -0,0 +1,121 @@
+// mdmt_threadpoolexecutor.t.cpp                                        -*-c++-*-
+#include <mdmt_threadpoolexecutor.h>
+
+#include <mdio_fileengine.h>
+#include <mdmt_fixedqueue.h>
+#include <mdmt_threadpool.h>
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdmt;
+
+typedef ThreadPool<FixedQueue<ThreadPoolJob>> Pool;
+typedef ThreadPoolExecutor<Pool> Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+int main(int argc, char *argv[])
+{
+
+  int testcase = (argc > 1?std::atoi(argv[1]):0);
+
+  bool verbose = argc > 1;
+  bool veryVerbose = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 2:
+    {
+      // File engine completions are delivered to the pool workers.
+      std::string path = "/tmp/mdmt_threadpoolexecutor.XXXXXX";
+      const int   fd   = mkstemp(&path[0]);
+      ASSERT(0 <= fd);
+
+      Pool pool(2, 0);
+      pool.start();
+      Obj executor(&pool);
+
+      std::mutex                 mutex;
+      std::set<std::thread::id>  threads;
+      std::atomic<int>           written(0);
+
+      {
+	mdio::FileEngine engine(&executor);
+
+	for (int i = 0; i < 50; ++i) {
+	  engine.write(fd, i * 4, "abcd", 4, [&](ssize_t result) {
+	      std::lock_guard<std::mutex> lk(mutex);
+	      threads.insert(std::this_thread::get_id());
+	      written += static_cast<int>(result);
+	    });
+	}
+	engine.submit();
+	engine.drain();
+      }
+
+      ASSERT(200 == written);
+      ASSERT(0 == threads.count(std::this_thread::get_id()));
+
+      pool.stop();
+      close(fd);
+      unlink(path.c_str());
+    } break;
+
+  case 1:
+    {
+      // Jobs run on the pool.
+      Pool pool(1, 0);
+      pool.start();
+
+      Obj              executor(&pool);
+      mdio::Executor  *base = &executor;
+      std::atomic<int> count(0);
+      std::thread::id  id;
+
+      for (int i = 0; i < 10; ++i) {
+	while (!base->execute([&count, &id]() {
+	      id = std::this_thread::get_id();
+	      ++count;
+	    })) {
+	  this_thread::yield();
+	}
+      }
+
+      while (10 != count) {
+	this_thread::yield();
+      }
+      ASSERT(std::this_thread::get_id() != id);
+
+      pool.stop();
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}
@@ -0,0 +1,2 @@
+// mdmt_threadpooljob.cpp                                               -*-c++-*-
+#include <mdmt_threadpooljob.h>
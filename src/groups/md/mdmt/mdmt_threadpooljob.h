@@ -0,0 +1,306 @@
+// mdmt_threadpooljob.h                                                 -*-c++-*-
+#ifndef __INCLUDED_MDMT_THREADPOOLJOB
+#define __INCLUDED_MDMT_THREADPOOLJOB
+
+#include <mdmem_allocator.h>
+#include <mdmem_allocatorutil.h>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace MvdS {
+namespace mdmt {
+
+// ===================
+// Class ThreadPoolJob
+// ===================
+
+class ThreadPoolJob
+{
+  // Provides a copyable 'void()' callable for thread pool jobs. Unlike
+  // 'std::function' it never uses the global heap: callables of up to
+  // 'k_inlineSize' bytes are stored inline and larger ones are allocated
+  // from the allocator the job was created with.
+
+public:
+  // PUBLIC TYPES
+
+  enum
+  {
+    k_inlineSize = 48 // Largest callable stored without allocation.
+  };
+
+private:
+  // PRIVATE TYPES
+
+  struct Operations
+  {
+    void (*d_invoke)(const ThreadPoolJob &job);
+    void (*d_copy)(ThreadPoolJob *destination, const ThreadPoolJob &source);
+    void (*d_move)(ThreadPoolJob *destination, ThreadPoolJob *source);
+    void (*d_destroy)(ThreadPoolJob *job);
+  };
+
+  template <class FUNCTION>
+  struct InlineOperations;
+
+  template <class FUNCTION>
+  struct AllocatedOperations;
+
+  template <class FUNCTION>
+  using IsInline = std::integral_constant<
+      bool,
+      sizeof(FUNCTION) <= k_inlineSize &&
+          alignof(FUNCTION) <= alignof(std::max_align_t) &&
+          std::is_nothrow_move_constructible<FUNCTION>::value>;
+
+  // DATA
+
+  union
+  {
+    alignas(std::max_align_t) unsigned char d_inline[k_inlineSize];
+    void *d_allocated_p;
+  };
+
+  const Operations *d_operations_p;
+  mdmem::Allocator *d_allocator_p;
+
+  // PRIVATE MANIPULATORS
+
+  template <class FUNCTION>
+  void construct(FUNCTION &&function, std::true_type);
+
+  template <class FUNCTION>
+  void construct(FUNCTION &&function, std::false_type);
+
+public:
+  // CREATORS
+
+  explicit ThreadPoolJob(mdmem::Allocator *allocator = 0)
+      // Create an empty job. Optionally the specified 'allocator' is used
+      // for memory allocation.
+      : d_operations_p(nullptr)
+      , d_allocator_p(mdmem::AllocatorUtil::defaultAllocator(allocator))
+  {}
+
+  template <class FUNCTION,
+            class = typename std::enable_if<
+                !std::is_same<typename std::decay<FUNCTION>::type,
+                              ThreadPoolJob>::value &&
+                std::is_invocable<
+                    typename std::decay<FUNCTION>::type &>::value>::type>
+  ThreadPoolJob(FUNCTION &&function, mdmem::Allocator *allocator = 0)
+      // Create a job that invokes the specified 'function'. Optionally the
+      // specified 'allocator' is used for memory allocation.
+      : d_operations_p(nullptr)
+      , d_allocator_p(mdmem::AllocatorUtil::defaultAllocator(allocator))
+  {
+    typedef typename std::decay<FUNCTION>::type Function;
+    construct(std::forward<FUNCTION>(function), IsInline<Function>());
+  }
+
+  ThreadPoolJob(const ThreadPoolJob &other)
+      // Create a copy of the specified 'other' job using the same allocator.
+      : d_operations_p(nullptr)
+      , d_allocator_p(other.d_allocator_p)
+  {
+    if (other.d_operations_p) {
+      other.d_operations_p->d_copy(this, other);
+    }
+  }
+
+  ThreadPoolJob(ThreadPoolJob &&other) noexcept
+      // Create a job that takes over the callable of the specified 'other'
+      // job, leaving 'other' empty.
+      : d_operations_p(nullptr)
+      , d_allocator_p(other.d_allocator_p)
+  {
+    if (other.d_operations_p) {
+      other.d_operations_p->d_move(this, &other);
+    }
+  }
+
+  ~ThreadPoolJob() { reset(); }
+
+  // MANIPULATORS
+
+  ThreadPoolJob &operator=(const ThreadPoolJob &other)
+  {
+    if (this != &other) {
+      reset();
+      d_allocator_p = other.d_allocator_p;
+      if (other.d_operations_p) {
+        other.d_operations_p->d_copy(this, other);
+      }
+    }
+    return *this;
+  }
+
+  ThreadPoolJob &operator=(ThreadPoolJob &&other) noexcept
+  {
+    if (this != &other) {
+      reset();
+      d_allocator_p = other.d_allocator_p;
+      if (other.d_operations_p) {
+        other.d_operations_p->d_move(this, &other);
+      }
+    }
+    return *this;
+  }
+
+  void reset()
+  // Destroy the callable, if any, and make this job empty.
+  {
+    if (d_operations_p) {
+      d_operations_p->d_destroy(this);
+      d_operations_p = nullptr;
+    }
+  }
+
+  // ACCESSORS
+
+  void operator()() const
+  // Invoke the callable. Behavior is undefined if this job is empty.
+  {
+    d_operations_p->d_invoke(*this);
+  }
+
+  explicit operator bool() const
+  // Return true if this job holds a callable.
+  {
+    return nullptr != d_operations_p;
+  }
+
+  mdmem::Allocator *allocator() const
+  // Return the allocator used by this job.
+  {
+    return d_allocator_p;
+  }
+};
+
+// ============================================================================
+//                            INLINE DEFINITIONS
+// ============================================================================
+
+// --------------------------------------
+// Struct ThreadPoolJob::InlineOperations
+// --------------------------------------
+
+template <class FUNCTION>
+struct ThreadPoolJob::InlineOperations
+{
+  static FUNCTION *get(const ThreadPoolJob &job)
+  {
+    return reinterpret_cast<FUNCTION *>(
+        const_cast<unsigned char *>(job.d_inline));
+  }
+
+  static void invoke(const ThreadPoolJob &job) { (*get(job))(); }
+
+  static void copy(ThreadPoolJob *destination, const ThreadPoolJob &source)
+  {
+    new (destination->d_inline) FUNCTION(*get(source));
+    destination->d_operations_p = &s_operations;
+  }
+
+  static void move(ThreadPoolJob *destination, ThreadPoolJob *source)
+  {
+    new (destination->d_inline) FUNCTION(std::move(*get(*source)));
+    destination->d_operations_p = &s_operations;
+    source->reset();
+  }
+
+  static void destroy(ThreadPoolJob *job) { get(*job)->~FUNCTION(); }
+
+  static const Operations s_operations;
+};
+
+template <class FUNCTION>
+const ThreadPoolJob::Operations
+    ThreadPoolJob::InlineOperations<FUNCTION>::s_operations = {
+        &invoke, &copy, &move, &destroy};
+
+// -----------------------------------------
+// Struct ThreadPoolJob::AllocatedOperations
+// -----------------------------------------
+
+template <class FUNCTION>
+struct ThreadPoolJob::AllocatedOperations
+{
+  static FUNCTION *get(const ThreadPoolJob &job)
+  {
+    return static_cast<FUNCTION *>(job.d_allocated_p);
+  }
+
+  static void invoke(const ThreadPoolJob &job) { (*get(job))(); }
+
+  static void copy(ThreadPoolJob *destination, const ThreadPoolJob &source)
+  {
+    void *memory =
+        destination->d_allocator_p->allocate(sizeof(FUNCTION), alignof(FUNCTION));
+    try {
+      destination->d_allocated_p = new (memory) FUNCTION(*get(source));
+    } catch (...) {
+      destination->d_allocator_p->deallocate(
+          memory, sizeof(FUNCTION), alignof(FUNCTION));
+      throw;
+    }
+    destination->d_operations_p = &s_operations;
+  }
+
+  static void move(ThreadPoolJob *destination, ThreadPoolJob *source)
+  {
+    // The destination took over the allocator of the source, so the
+    // allocation can simply change hands.
+    destination->d_allocated_p  = source->d_allocated_p;
+    destination->d_operations_p = &s_operations;
+    source->d_operations_p      = nullptr;
+  }
+
+  static void destroy(ThreadPoolJob *job)
+  {
+    get(*job)->~FUNCTION();
+    job->d_allocator_p->deallocate(
+        job->d_allocated_p, sizeof(FUNCTION), alignof(FUNCTION));
+  }
+
+  static const Operations s_operations;
+};
+
+template <class FUNCTION>
+const ThreadPoolJob::Operations
+    ThreadPoolJob::AllocatedOperations<FUNCTION>::s_operations = {
+        &invoke, &copy, &move, &destroy};
+
+// -------------------
+// Class ThreadPoolJob
+// -------------------
+
+template <class FUNCTION>
+void ThreadPoolJob::construct(FUNCTION &&function, std::true_type)
+{
+  typedef typename std::decay<FUNCTION>::type Function;
+  new (d_inline) Function(std::forward<FUNCTION>(function));
+  d_operations_p = &InlineOperations<Function>::s_operations;
+}
+
+template <class FUNCTION>
+void ThreadPoolJob::construct(FUNCTION &&function, std::false_type)
+{
+  typedef typename std::decay<FUNCTION>::type Function;
+  void *memory = d_allocator_p->allocate(sizeof(Function), alignof(Function));
+  try {
+    d_allocated_p = new (memory) Function(std::forward<FUNCTION>(function));
+  } catch (...) {
+    d_allocator_p->deallocate(memory, sizeof(Function), alignof(Function));
+    throw;
+  }
+  d_operations_p = &AllocatedOperations<Function>::s_operations;
+}
+
+} // namespace mdmt
+} // namespace MvdS
+
+#endif // __INCLUDED_MDMT_THREADPOOLJOB
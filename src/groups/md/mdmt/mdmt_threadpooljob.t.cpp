@@ -0,0 +1,132 @@
+// mdmt_threadpooljob.t.cpp                                             -*-c++-*-
+#include <mdmt_threadpooljob.h>
+
+#include <mdmem_testallocator.h>
+
+#include <array>
+#include <iostream>
+#include <memory>
+
+using namespace std;
+using namespace MvdS;
+using namespace MvdS::mdmt;
+
+typedef ThreadPoolJob Obj;
+
+size_t g_errorCount = 0;
+
+#define ASSERT(x) if (!(x)) { ++g_errorCount; cerr << "Error on line " << __LINE__ << " assert(" << #x << ")." << endl; }
+
+int main(int argc, char *argv[])
+{
+
+  int testcase = (argc > 1?std::atoi(argv[1]):0);
+
+  bool verbose = argc > 1;
+  bool veryVerbose = argc > 2;
+  bool veryVeryVerbose = argc > 3;
+
+  (void)verbose;
+  (void)veryVerbose;
+  (void)veryVeryVerbose;
+
+  switch (testcase) {
+  case 0: // ALWAYS LAST TEST CASE
+
+  case 3:
+    {
+      // Captured state is destroyed with the job.
+      std::shared_ptr<int> counter = std::make_shared<int>(0);
+
+      {
+	Obj job([counter]() { ++*counter; });
+	ASSERT(2 == counter.use_count());
+
+	Obj copy(job);
+	ASSERT(3 == counter.use_count());
+
+	job.reset();
+	ASSERT(!job);
+	ASSERT(2 == counter.use_count());
+
+	copy();
+	ASSERT(1 == *counter);
+      }
+
+      ASSERT(1 == counter.use_count());
+    } break;
+
+  case 2:
+    {
+      // Large callables are allocated from the job allocator, moves do not
+      // allocate.
+      mdmem::TestAllocator ta;
+      size_t               sum = 0;
+
+      {
+	std::array<size_t, 32> values;
+	values.fill(1);
+
+	Obj job([values, &sum]() { for (size_t v : values) sum += v; }, &ta);
+	ASSERT(1 == ta.allocationCount());
+	ASSERT(&ta == job.allocator());
+
+	Obj moved(std::move(job));
+	ASSERT(!job);
+	ASSERT(1 == ta.allocationCount());
+
+	Obj copy(moved);
+	ASSERT(2 == ta.allocationCount());
+
+	moved();
+	copy();
+	ASSERT(64 == sum);
+
+	Obj assigned;
+	assigned = std::move(copy);
+	ASSERT(2 == ta.allocationCount());
+	assigned();
+	ASSERT(96 == sum);
+      }
+
+      ASSERT(2 == ta.deallocationCount());
+    } break;
+
+  case 1:
+    {
+      // Small callables are stored inline.
+      mdmem::TestAllocator ta;
+      int                  value = 0;
+
+      Obj empty(&ta);
+      ASSERT(!empty);
+
+      Obj job([&value]() { ++value; }, &ta);
+      ASSERT(job);
+      job();
+      ASSERT(1 == value);
+
+      Obj copy(job);
+      copy();
+      ASSERT(2 == value);
+
+      Obj moved(std::move(copy));
+      ASSERT(!copy);
+      moved();
+      ASSERT(3 == value);
+
+      ASSERT(0 == ta.allocationCount());
+    } break;
+
+  default:
+    cerr << "Unknown testcase: " << testcase << endl;
+    return -1;
+
+  };
+
+  if (g_errorCount) {
+    cerr << "There were error." << endl;
+  }
+
+  return static_cast<int>(g_errorCount);
+}